@@ -3,6 +3,8 @@
 #include "AgoraVideoChatProvider.h"
 
 #include "PassageUtils.h"
+#include "VideoFramePool.h"
+#include "AudioJitterBuffer.h"
 #include "DirectoryProvider.h"
 #include "LogThreadId.h"
 #include "Components/AudioComponent.h"
@@ -14,6 +16,13 @@
 
 DEFINE_LOG_CATEGORY(LogAgora);
 
+namespace
+{
+	/** We ask Agora for remote audio as 48 kHz mono 16-bit PCM */
+	constexpr int32 AgoraSampleRate = 48000;
+	constexpr int32 AgoraChannels = 1;
+}
+
 UAgoraVideoChatProvider::UAgoraVideoChatProvider()
 {
 	FrameObserver = new FFrameObserver();
@@ -115,15 +124,15 @@ void UAgoraVideoChatProvider::AttachAudio(const FString& AgoraUid, UAudioCompone
 	UE_LOG(LogAgora, Verbose, TEXT("UAgoraVideoChatProvider::AttachAudio() for uid %d"), Uid);
 
 	const auto SoundStream = NewObject<USoundWaveProcedural>(AudioComponent);
-	SoundStream->SetSampleRate(48000);
-	SoundStream->NumChannels = 1;
+	SoundStream->SetSampleRate(AgoraSampleRate);
+	SoundStream->NumChannels = AgoraChannels;
 	SoundStream->Duration = INDEFINITELY_LOOPING_DURATION;
 	SoundStream->SoundGroup = SOUNDGROUP_Default;
 	SoundStream->bLooping = false;
 	SoundStream->OnSoundWaveProceduralUnderflow.BindUObject(this, &UAgoraVideoChatProvider::FillAudio);
 	AudioComponent->SetSound(SoundStream);
 
-	const auto AudioBuffer = MakeShared< TQueue< TSharedPtr<TArray<uint8>> > >();
+	const auto AudioBuffer = MakeShared<FAudioJitterBuffer, ESPMode::ThreadSafe>(AgoraSampleRate);
 
 	BuffersByUid.Add(Uid, AudioBuffer);
 	BuffersBySoundWave.Add(SoundStream, AudioBuffer);
@@ -158,6 +167,15 @@ void UAgoraVideoChatProvider::DetachAudio(const FString& AgoraUid)
 
 	if (BuffersByUid.Contains(Uid))
 	{
+		const FAudioJitterBufferStats Stats = BuffersByUid[Uid]->GetStats();
+		UE_LOG(LogAgora, Log,
+			TEXT("UAgoraVideoChatProvider::DetachAudio() Audio for uid %u: latency %.1fms, %u underruns, %llu dropped, %llu stretched, %llu concealed samples"),
+			Uid,
+			Stats.LatencyMs,
+			Stats.Underruns,
+			Stats.DroppedSamples,
+			Stats.StretchedSamples,
+			Stats.ConcealedSamples);
 		BuffersByUid.Remove(Uid);
 	}
 	else
@@ -361,6 +379,16 @@ void UAgoraVideoChatProvider::Initialize()
 		OnWarningEvent.Broadcast(TEXT("Audio did not connect"));
 	}
 
+	// The observer's params don't cover the per-user frames we buffer, so ask
+	// the engine to hand those over in the format our sound waves play.
+	if(const auto ErrorCode = RtcEngine->setPlaybackAudioFrameBeforeMixingParameters(
+		AgoraSampleRate, AgoraChannels);
+		ErrorCode < 0)
+	{
+		LogError(ErrorCode,
+			TEXT("UAgoraVideoChatProvider::Initialize() Unable to set the audio format before mixing"));
+	}
+
 	if(const auto ErrorCode = MediaEngine->registerVideoFrameObserver(FrameObserver);
 		ErrorCode < 0)
 	{
@@ -658,9 +686,8 @@ void UAgoraVideoChatProvider::onRemoteAudioStateChanged(agora::rtc::uid_t Uid,
 					if (IsValid(AudioComponent))
 					{
 						AudioComponent->Deactivate();
-						// Since the main thread is the buffer consumer, we can
-						// empty it here. If we didn't we'd accumulate a delay.
-						Buffer->Empty();
+						// Start over at the target latency when audio resumes.
+						Buffer->Reset();
 					}
 				});
 		}
@@ -838,6 +865,11 @@ void UAgoraVideoChatProvider::onUserOffline(agora::rtc::uid_t Uid, agora::rtc::U
 		TEXT("UAgoraVideoChatProvider::onUserOffline() Remote user with Uid %u LEFT because %s"),
 		Uid,
 		*ReasonString);
+
+	if (FrameObserver != nullptr)
+	{
+		FrameObserver->RemoveFramePool(Uid);
+	}
 }
 
 void UAgoraVideoChatProvider::onJoinChannelSuccess(
@@ -945,17 +977,14 @@ void UAgoraVideoChatProvider::FillAudio(USoundWaveProcedural* Wave, const int32
 	if(BuffersBySoundWave.Contains(Wave))
 	{
 		const auto Buffer = BuffersBySoundWave[Wave];
-		if (TSharedPtr<TArray<uint8>> ByteArray; Buffer->Dequeue(ByteArray))
-		{
-			const auto ByteCount = ByteArray->Num();
-			Wave->QueueAudio(ByteArray->GetData(), ByteCount);
-		}
-		else
-		{
-			UE_LOG(LogAgora, Verbose,
-				TEXT("UAgoraVideoChatProvider::FillAudio() Unable to dequeue audio for Wave with address %p"), 
-				Wave);
-		}
+
+		// The jitter buffer always gives us exactly what was asked for, with
+		// silence standing in for anything that hasn't arrived yet, so the
+		// wave never gets ahead of or behind the buffer's idea of latency.
+		TArray<int16, TInlineAllocator<2048>> Samples;
+		Samples.SetNumUninitialized(SamplesNeeded);
+		Buffer->Pop(Samples.GetData(), SamplesNeeded);
+		Wave->QueueAudio(reinterpret_cast<const uint8*>(Samples.GetData()), SamplesNeeded * sizeof(int16));
 	}
 	else
 	{
@@ -1131,7 +1160,11 @@ int FFrameObserver::getObservedAudioFramePosition()
 agora::media::IAudioFrameObserverBase::AudioParams FFrameObserver::getPlaybackAudioParams()
 {
 	UE_LOG(LogAgora, VeryVerbose, TEXT("FFrameObserver::getPlaybackAudioParams()"));
-	return {};
+	return AudioParams(
+		AgoraSampleRate,
+		AgoraChannels,
+		agora::rtc::RAW_AUDIO_FRAME_OP_MODE_TYPE::RAW_AUDIO_FRAME_OP_MODE_READ_ONLY,
+		1024);
 }
 
 agora::media::IAudioFrameObserverBase::AudioParams FFrameObserver::getRecordAudioParams()
@@ -1144,8 +1177,8 @@ agora::media::IAudioFrameObserverBase::AudioParams FFrameObserver::getMixedAudio
 {
 	UE_LOG(LogAgora, VeryVerbose, TEXT("FFrameObserver::getMixedAudioParams()"));
 	return AudioParams(
-		48000, 
-		1,
+		AgoraSampleRate,
+		AgoraChannels,
 		agora::rtc::RAW_AUDIO_FRAME_OP_MODE_TYPE::RAW_AUDIO_FRAME_OP_MODE_READ_ONLY,
 		1024);
 }
@@ -1171,14 +1204,47 @@ bool FFrameObserver::onPlaybackAudioFrameBeforeMixing(const char* ChannelId, ago
 
 	if(IsValid(Parent))
 	{
-		if (Parent->BuffersByUid.Contains(Uid))
+		if (AudioFrame.bytesPerSample != sizeof(int16))
 		{
-			const auto Data = MakeShared< TArray<uint8> >();
-			const auto Count =
-				AudioFrame.channels * AudioFrame.bytesPerSample * AudioFrame.samplesPerChannel;
-			Data->AddUninitialized(Count);
-			FMemory::Memcpy(Data->GetData(), AudioFrame.buffer, Count);
-			Parent->BuffersByUid[Uid]->Enqueue(Data);
+			UE_LOG(LogAgora, Warning,
+				TEXT("FFrameObserver::onPlaybackAudioFrameBeforeMixing() Unsupported bytesPerSample %d for Uid %u"),
+				AudioFrame.bytesPerSample,
+				Uid);
+		}
+		else if (AudioFrame.samplesPerSec != AgoraSampleRate || AudioFrame.channels < 1)
+		{
+			// The jitter buffer and sound wave play at a fixed rate, so a
+			// frame at any other rate would play at the wrong pitch.
+			UE_LOG(LogAgora, Warning,
+				TEXT("FFrameObserver::onPlaybackAudioFrameBeforeMixing() Unsupported format %d Hz %d channels for Uid %u"),
+				AudioFrame.samplesPerSec,
+				AudioFrame.channels,
+				Uid);
+		}
+		else if (Parent->BuffersByUid.Contains(Uid))
+		{
+			const int16* Samples = static_cast<const int16*>(AudioFrame.buffer);
+			if (AudioFrame.channels == AgoraChannels)
+			{
+				Parent->BuffersByUid[Uid]->Push(Samples, AudioFrame.samplesPerChannel);
+			}
+			else
+			{
+				// Average interleaved channels down to mono. 10 ms at 48 kHz
+				// fits inline.
+				TArray<int16, TInlineAllocator<AgoraSampleRate / 100>> Mono;
+				Mono.SetNumUninitialized(AudioFrame.samplesPerChannel);
+				for (int32 Index = 0; Index < Mono.Num(); Index++)
+				{
+					int32 Sum = 0;
+					for (int32 Channel = 0; Channel < AudioFrame.channels; Channel++)
+					{
+						Sum += Samples[Index * AudioFrame.channels + Channel];
+					}
+					Mono[Index] = StaticCast<int16>(Sum / AudioFrame.channels);
+				}
+				Parent->BuffersByUid[Uid]->Push(Mono.GetData(), Mono.Num());
+			}
 		}
 		else
 		{
@@ -1215,11 +1281,15 @@ bool FFrameObserver::getRotationApplied()
 
 /**
  * @brief Sets our non-default preference to match the format we use with WebRTC.
- * @return VIDEO_PIXEL_BGRA
+ * @return VIDEO_PIXEL_BGRA, or VIDEO_PIXEL_I420 when the Parent uploads I420
  */
 agora::media::base::VIDEO_PIXEL_FORMAT FFrameObserver::getVideoFormatPreference()
 {
 	UE_LOG(LogAgora, VeryVerbose, TEXT("FFrameObserver::getVideoFormatPreference()"));
+	if (IsValid(Parent) && Parent->bUploadI420)
+	{
+		return agora::media::base::VIDEO_PIXEL_FORMAT::VIDEO_PIXEL_I420;
+	}
 	return agora::media::base::VIDEO_PIXEL_FORMAT::VIDEO_PIXEL_BGRA;
 }
 
@@ -1250,64 +1320,191 @@ bool FFrameObserver::onRenderVideoFrame(
 			VideoFrame.type);
 	}
 
-	const auto FrameWidth = VideoFrame.width;
-	const auto FrameHeight = VideoFrame.height;
-
-	const auto Count = FrameWidth * FrameHeight * 4;
-	// the ImgData will be deleted by UpdateVideoTexture in the lambda
-	uint8* ImgData = new uint8[Count];
-	// I believe we're doing this copy because Agora may reclaim VideoFrame.yBuffer after this method exits
-	FMemory::Memcpy(ImgData, VideoFrame.yBuffer, Count);
+	const auto Pool = GetFramePool(RemoteUid);
 
-	Async(EAsyncExecution::TaskGraphMainThread, [this, RemoteUid, ImgData, FrameWidth, FrameHeight]()
+	// We copy because Agora may reclaim VideoFrame.yBuffer after this method
+	// exits, but into a recycled buffer rather than a fresh allocation.
+	FVideoFrame* Frame;
+	if (VideoFrame.type == agora::media::base::VIDEO_PIXEL_I420 &&
+		(VideoFrame.width % 2 != 0 || VideoFrame.height % 2 != 0))
+	{
+		// The packed I420 texture needs an even size, so convert these on
+		// the CPU like the BGRA path would have delivered them
+		if (FirstOddSizedFrame(RemoteUid))
 		{
-			if(IsValid(Parent))
-			{
-				UTexture2D* Texture;
-
-				// Update the Texture if the size has changed or if we simply don't have a texture yet
-				if (Parent->Textures.Contains(RemoteUid))
-				{
-					Texture = Parent->Textures[RemoteUid];
+			UE_LOG(LogAgora, Warning,
+				TEXT("FFrameObserver::onRenderVideoFrame() Uid %u sends %dx%d video, converting it to BGRA since I420 needs an even size"),
+				RemoteUid, VideoFrame.width, VideoFrame.height);
+		}
 
-					const auto Width = Texture->GetSizeX();
-					const auto Height = Texture->GetSizeY();
+		Frame = Pool->Acquire(VideoFrame.width, VideoFrame.height);
+		UPassageUtils::ConvertI420ToBGRA(
+			VideoFrame.yBuffer, VideoFrame.yStride,
+			VideoFrame.uBuffer, VideoFrame.uStride,
+			VideoFrame.vBuffer, VideoFrame.vStride,
+			VideoFrame.width, VideoFrame.height, Frame->Data.GetData());
+	}
+	else if (VideoFrame.type == agora::media::base::VIDEO_PIXEL_I420)
+	{
+		Frame = Pool->Acquire(VideoFrame.width, VideoFrame.height, EVideoFrameFormat::I420);
+		UPassageUtils::PackI420(
+			VideoFrame.yBuffer, VideoFrame.yStride,
+			VideoFrame.uBuffer, VideoFrame.uStride,
+			VideoFrame.vBuffer, VideoFrame.vStride,
+			VideoFrame.width, VideoFrame.height, Frame->Data.GetData());
+	}
+	else
+	{
+		Frame = Pool->Acquire(VideoFrame.width, VideoFrame.height);
+		FMemory::Memcpy(Frame->Data.GetData(), VideoFrame.yBuffer, Frame->Data.Num());
+	}
 
-					if (Width != FrameWidth || Height != FrameHeight)
-					{
-						Texture = UPassageUtils::CreateVideoTexture(FrameWidth, FrameHeight);
-					}
-					Parent->Textures[RemoteUid] = Texture;
-				}
-				else
-				{
-					Texture = UPassageUtils::CreateVideoTexture(FrameWidth, FrameHeight);
-					Parent->Textures.Add(RemoteUid, Texture);
-				}
-				if(Parent->MaterialsByUid.Contains(RemoteUid))
-				{
-					const auto Material = Parent->MaterialsByUid[RemoteUid];
-					const auto ParameterName = Parent->ParameterNamesByUid[RemoteUid];
-					Material->SetTextureParameterValue(FName(ParameterName), Texture);
+	if (!Pool->Publish(Frame))
+	{
+		// The game thread hasn't got to the previous frame yet. The update
+		// that's already on its way will pick this one up instead.
+		UE_LOG(LogAgora, VeryVerbose,
+			TEXT("FFrameObserver::onRenderVideoFrame() Dropped a stale frame for Uid %u (%u dropped so far)"),
+			RemoteUid, Pool->GetDroppedCount());
+		return true;
+	}
 
-					UPassageUtils::UpdateVideoTexture(
-						Parent->Textures[RemoteUid], ImgData,
-						FrameWidth, FrameHeight);
-				}
+	if (!IsValid(Parent))
+	{
+		// Nobody will take the frame we just published, and while it's
+		// pending every later Publish() fails, so take it back ourselves.
+		UE_LOG(LogAgora, Verbose,
+			TEXT("FFrameObserver::onRenderVideoFrame() Invalid Parent, releasing the frame for Uid %u"),
+			RemoteUid);
+		if (FVideoFrame* Unwanted = Pool->TakeLatest())
+		{
+			Pool->Release(Unwanted);
+		}
+		return true;
+	}
 
-			} else
-			{
-				// This happens when we stop and clean up but there's still pending
-				// updates on the render thread. There may be other circumstances where
-				// this is an error, but it is normal to see this 0 or 1 times after
-				// stopping.
-				UE_LOG(LogAgora, Verbose, TEXT("FFrameObserver::onRenderVideoFrame() Async UpdateVideoTexture. Invalid Parent or Texture pointer (may happen normally when stopping)"));
-			}
+	TWeakObjectPtr<UAgoraVideoChatProvider> WeakParent = Parent;
+	Async(EAsyncExecution::TaskGraphMainThread, [WeakParent, RemoteUid, Pool]()
+		{
+			UpdateTexture(WeakParent.Get(), RemoteUid, Pool);
 		});
 
 	return true;
 }
 
+void FFrameObserver::UpdateTexture(UAgoraVideoChatProvider* Provider, const uint32 Uid,
+	const TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe>& Pool)
+{
+	FVideoFrame* Frame = Pool->TakeLatest();
+	if (Frame == nullptr)
+	{
+		return;
+	}
+
+	if(!IsValid(Provider))
+	{
+		// This happens when we stop and clean up but there's still pending
+		// updates on the render thread. There may be other circumstances where
+		// this is an error, but it is normal to see this 0 or 1 times after
+		// stopping.
+		UE_LOG(LogAgora, Verbose, TEXT("FFrameObserver::UpdateTexture() Invalid Provider pointer (may happen normally when stopping)"));
+		Pool->Release(Frame);
+		return;
+	}
+
+	const uint32 FrameWidth = Frame->Width;
+	const uint32 FrameHeight = Frame->Height;
+	const bool bI420 = Frame->Format == EVideoFrameFormat::I420;
+	const uint32 TextureHeight = bI420 ? FrameHeight * 3 / 2 : FrameHeight;
+	const EPixelFormat PixelFormat = bI420 ? PF_G8 : PF_B8G8R8A8;
+	const auto CreateTexture = [&]()
+	{
+		return bI420
+			? UPassageUtils::CreateI420VideoTexture(FrameWidth, FrameHeight)
+			: UPassageUtils::CreateVideoTexture(FrameWidth, FrameHeight);
+	};
+	UTexture2D* Texture;
+
+	// Update the Texture if the size or format has changed or if we simply don't have a texture yet
+	if (Provider->Textures.Contains(Uid))
+	{
+		Texture = Provider->Textures[Uid];
+
+		const auto Width = Texture->GetSizeX();
+		const auto Height = Texture->GetSizeY();
+
+		if (Width != FrameWidth || Height != TextureHeight ||
+			Texture->GetPixelFormat() != PixelFormat)
+		{
+			Texture = CreateTexture();
+		}
+		Provider->Textures[Uid] = Texture;
+	}
+	else
+	{
+		Texture = CreateTexture();
+		Provider->Textures.Add(Uid, Texture);
+	}
+
+	if(Provider->MaterialsByUid.Contains(Uid))
+	{
+		const auto Material = Provider->MaterialsByUid[Uid];
+		const auto ParameterName = Provider->ParameterNamesByUid[Uid];
+		Material->SetTextureParameterValue(FName(ParameterName), Texture);
+
+		// The frame goes back to the pool once the render thread has copied it
+		auto OnUpdated = [Pool, Frame]()
+		{
+			Pool->Release(Frame);
+		};
+		if (bI420)
+		{
+			UPassageUtils::UpdateI420VideoTexture(Texture, Frame->Data.GetData(),
+				FrameWidth, FrameHeight, OnUpdated);
+		}
+		else
+		{
+			UPassageUtils::UpdateVideoTexture(Texture, Frame->Data.GetData(),
+				FrameWidth, FrameHeight, OnUpdated);
+		}
+	}
+	else
+	{
+		Pool->Release(Frame);
+	}
+}
+
+TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe> FFrameObserver::GetFramePool(const agora::rtc::uid_t Uid)
+{
+	FScopeLock ScopeLock(&FramePoolsLock);
+	if (const auto* Pool = FramePools.Find(Uid))
+	{
+		return *Pool;
+	}
+	return FramePools.Add(Uid, MakeShared<FVideoFramePool, ESPMode::ThreadSafe>());
+}
+
+void FFrameObserver::RemoveFramePool(const agora::rtc::uid_t Uid)
+{
+	FScopeLock ScopeLock(&FramePoolsLock);
+	if (const auto* Pool = FramePools.Find(Uid))
+	{
+		UE_LOG(LogAgora, Verbose,
+			TEXT("FFrameObserver::RemoveFramePool() Uid %u published %u frames, dropped %u"),
+			Uid, (*Pool)->GetPublishedCount(), (*Pool)->GetDroppedCount());
+		FramePools.Remove(Uid);
+	}
+	OddSizedUids.Remove(Uid);
+}
+
+bool FFrameObserver::FirstOddSizedFrame(const agora::rtc::uid_t Uid)
+{
+	FScopeLock ScopeLock(&FramePoolsLock);
+	bool bAlreadyInSet = false;
+	OddSizedUids.Add(Uid, &bAlreadyInSet);
+	return !bAlreadyInSet;
+}
+
 
 bool FFrameObserver::onTranscodedVideoFrame(VideoFrame& videoFrame)
 {
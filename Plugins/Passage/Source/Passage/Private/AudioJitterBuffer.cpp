@@ -0,0 +1,174 @@
+// Copyright Enva Division
+
+#include "AudioJitterBuffer.h"
+
+FAudioJitterBuffer::FAudioJitterBuffer(
+	const int32 InSampleRate,
+	const int32 TargetLatencyMs,
+	const int32 MaxLatencyMs) :
+	SampleRate(FMath::Max(InSampleRate, 1)),
+	TargetSamples(FMath::Max(SampleRate * TargetLatencyMs / 1000, 1))
+{
+	const int32 Capacity = FMath::Max(SampleRate * MaxLatencyMs / 1000, TargetSamples);
+	Ring.SetNumZeroed(Capacity);
+}
+
+void FAudioJitterBuffer::Push(const int16* Samples, const int32 Num)
+{
+	if (Num <= 0)
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	const int32 Capacity = Ring.Num();
+
+	// Only the newest Capacity samples of a huge push can survive anyway
+	int32 Skipped = 0;
+	if (Num > Capacity)
+	{
+		Skipped = Num - Capacity;
+	}
+	const int32 ToWrite = Num - Skipped;
+
+	if (const int32 Overflow = Count + ToWrite - Capacity; Overflow > 0)
+	{
+		Head = (Head + Overflow) % Capacity;
+		Count -= Overflow;
+		Skipped += Overflow;
+	}
+	Stats.DroppedSamples += Skipped;
+
+	const int32 Tail = (Head + Count) % Capacity;
+	const int32 FirstPart = FMath::Min(ToWrite, Capacity - Tail);
+	FMemory::Memcpy(&Ring[Tail], Samples + Num - ToWrite, FirstPart * sizeof(int16));
+	if (FirstPart < ToWrite)
+	{
+		FMemory::Memcpy(&Ring[0], Samples + Num - ToWrite + FirstPart, (ToWrite - FirstPart) * sizeof(int16));
+	}
+	Count += ToWrite;
+}
+
+void FAudioJitterBuffer::Pop(int16* Out, const int32 Num)
+{
+	if (Num <= 0)
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	if (bPriming)
+	{
+		if (Count < TargetSamples)
+		{
+			Conceal(Out, Num);
+			return;
+		}
+		bPriming = false;
+	}
+
+	if (Count < Num)
+	{
+		const int32 Available = Count;
+		Read(Out, Available);
+		Conceal(Out + Available, Num - Available);
+		++Stats.Underruns;
+		bPriming = true;
+		return;
+	}
+
+	// Catch up a little if we'd still be over the target after this pop
+	const int32 Excess = Count - Num - TargetSamples;
+	if (const int32 Skip = FMath::Min(Excess, Num / StretchRatio); Skip > 0)
+	{
+		ReadStretched(Out, Num, Skip);
+		Stats.StretchedSamples += Skip;
+	}
+	else
+	{
+		Read(Out, Num);
+	}
+}
+
+void FAudioJitterBuffer::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+	Head = 0;
+	Count = 0;
+	bPriming = true;
+	LastSample = 0;
+	FadePosition = FadeOutSamples;
+}
+
+FAudioJitterBufferStats FAudioJitterBuffer::GetStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+	FAudioJitterBufferStats Result = Stats;
+	Result.DepthSamples = Count;
+	Result.LatencyMs = Count * 1000.f / SampleRate;
+	return Result;
+}
+
+void FAudioJitterBuffer::Read(int16* Out, const int32 Num)
+{
+	if (Num <= 0)
+	{
+		return;
+	}
+
+	const int32 Capacity = Ring.Num();
+	const int32 FirstPart = FMath::Min(Num, Capacity - Head);
+	FMemory::Memcpy(Out, &Ring[Head], FirstPart * sizeof(int16));
+	if (FirstPart < Num)
+	{
+		FMemory::Memcpy(Out + FirstPart, &Ring[0], (Num - FirstPart) * sizeof(int16));
+	}
+	Head = (Head + Num) % Capacity;
+	Count -= Num;
+
+	LastSample = Out[Num - 1];
+	FadePosition = 0;
+}
+
+void FAudioJitterBuffer::ReadStretched(int16* Out, const int32 Num, const int32 Skip)
+{
+	const int32 Capacity = Ring.Num();
+	const int32 InNum = Num + Skip;
+
+	// Maps the first and last output samples onto the first and last input
+	// samples, so consecutive pops join up without a click.
+	const float Step = Num > 1 ? float(InNum - 1) / float(Num - 1) : 0.f;
+	for (int32 i = 0; i < Num; ++i)
+	{
+		const float Position = i * Step;
+		const int32 Index = FMath::Min(FMath::FloorToInt(Position), InNum - 1);
+		const int32 Next = FMath::Min(Index + 1, InNum - 1);
+		const float Alpha = Position - Index;
+		const float A = Ring[(Head + Index) % Capacity];
+		const float B = Ring[(Head + Next) % Capacity];
+		Out[i] = (int16)FMath::RoundToInt(FMath::Lerp(A, B, Alpha));
+	}
+	Head = (Head + InNum) % Capacity;
+	Count -= InNum;
+
+	LastSample = Out[Num - 1];
+	FadePosition = 0;
+}
+
+void FAudioJitterBuffer::Conceal(int16* Out, const int32 Num)
+{
+	for (int32 i = 0; i < Num; ++i)
+	{
+		if (FadePosition < FadeOutSamples)
+		{
+			++FadePosition;
+			Out[i] = (int16)(LastSample * (FadeOutSamples - FadePosition) / FadeOutSamples);
+		}
+		else
+		{
+			Out[i] = 0;
+		}
+	}
+	Stats.ConcealedSamples += Num;
+}
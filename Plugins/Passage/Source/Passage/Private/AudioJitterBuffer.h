@@ -0,0 +1,123 @@
+// Copyright Enva Division
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** A snapshot of an FAudioJitterBuffer's depth and counters. */
+struct FAudioJitterBufferStats
+{
+	/** The number of samples currently buffered */
+	int32 DepthSamples = 0;
+
+	/** How long the buffered samples take to play out */
+	float LatencyMs = 0.f;
+
+	/** The number of Pop() calls that ran out of samples */
+	uint32 Underruns = 0;
+
+	/** Samples thrown away because the buffer was over its maximum depth */
+	uint64 DroppedSamples = 0;
+
+	/** Samples skipped by time-compressing playout to get back to the target */
+	uint64 StretchedSamples = 0;
+
+	/** Samples we made up to cover underruns */
+	uint64 ConcealedSamples = 0;
+};
+
+/**
+ * The FAudioJitterBuffer sits between Agora's audio thread, which pushes
+ * 10 ms chunks of 16-bit PCM for one remote uid, and the audio mixer, which
+ * pops whatever it needs whenever it needs it. The two clocks never quite
+ * agree, so rather than queueing chunks forever we keep the samples in a
+ * ring that's allocated once and hold its depth near a target:
+ *
+ * - Above the target, playout is gently time-compressed by a few percent
+ *   until the extra latency is gone.
+ * - Above the maximum, the oldest samples are dropped outright.
+ * - On underrun, the last sample fades out to silence and we wait until the
+ *   target depth has built up again before playing.
+ *
+ * Push() and Pop() may be called from different threads.
+ */
+class FAudioJitterBuffer
+{
+public:
+
+	/** The default depth we try to keep, in milliseconds */
+	static constexpr int32 DefaultTargetLatencyMs = 60;
+
+	/** The default depth past which we drop samples, in milliseconds */
+	static constexpr int32 DefaultMaxLatencyMs = 200;
+
+	/**
+	 * The fastest we'll play out while catching up, as the number of output
+	 * samples per extra input sample. 50 is 2% fast, which isn't noticeable
+	 * in speech but covers far more clock skew than we see in practice.
+	 */
+	static constexpr int32 StretchRatio = 50;
+
+	/** How many samples it takes to fade out to silence on underrun */
+	static constexpr int32 FadeOutSamples = 64;
+
+	/**
+	 * @param InSampleRate Samples per second, counting every channel.
+	 * @param TargetLatencyMs The depth we try to keep.
+	 * @param MaxLatencyMs The depth past which the oldest samples are dropped,
+	 * and the size of the ring.
+	 */
+	FAudioJitterBuffer(
+		const int32 InSampleRate,
+		const int32 TargetLatencyMs = DefaultTargetLatencyMs,
+		const int32 MaxLatencyMs = DefaultMaxLatencyMs);
+
+	/** Adds Num samples to the buffer, dropping the oldest if it's full. */
+	void Push(const int16* Samples, const int32 Num);
+
+	/**
+	 * Fills Out with exactly Num samples, concealing with silence whatever the
+	 * buffer can't provide.
+	 */
+	void Pop(int16* Out, const int32 Num);
+
+	/** Empties the buffer, so the next samples are played at the target depth. */
+	void Reset();
+
+	FAudioJitterBufferStats GetStats() const;
+
+	int32 GetTargetSamples() const { return TargetSamples; }
+	int32 GetCapacity() const { return Ring.Num(); }
+
+private:
+
+	/** Copies Num samples from the head of the ring and advances it. */
+	void Read(int16* Out, const int32 Num);
+
+	/**
+	 * Reads Num + Skip samples from the head of the ring and linearly
+	 * resamples them into Num samples of Out.
+	 */
+	void ReadStretched(int16* Out, const int32 Num, const int32 Skip);
+
+	void Conceal(int16* Out, const int32 Num);
+
+	const int32 SampleRate;
+	const int32 TargetSamples;
+
+	mutable FCriticalSection Lock;
+	TArray<int16> Ring;
+	int32 Head = 0;
+	int32 Count = 0;
+
+	// We hold off playing until the buffer reaches the target depth, both at
+	// first and after every underrun, so a late packet costs one gap rather
+	// than a stutter on every pop.
+	bool bPriming = true;
+
+	// The last sample we played, which we fade out from on underrun
+	int16 LastSample = 0;
+	int32 FadePosition = FadeOutSamples;
+
+	FAudioJitterBufferStats Stats;
+};
@@ -1,6 +1,9 @@
 // Copyright Enva Division
 
 #include "JsonRpc.h"
+#include "JsonRpcEnvelope.h"
+#include "JsonRpcMessagePack.h"
+#include "JsonRpcPendingTable.h"
 
 // UE4 JSON module
 #include "Dom/JsonValue.h"
@@ -10,20 +13,82 @@
 // UE4 WebSocket module
 #include "IWebSocket.h"
 
+#include "Async/Async.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Serialization/MemoryWriter.h"
 
-DEFINE_LOG_CATEGORY(LogJsonRpc);
 
+DEFINE_LOG_CATEGORY(LogJsonRpc);
 
-FJsonRpcWebSocketChannel::FJsonRpcWebSocketChannel(const TSharedPtr<IWebSocket> InWS)
+namespace
 {
-    WS = InWS;
-    WS->OnMessage().AddLambda([this](const FString& Message)
+    FCriticalSection DispatchPoolLock;
+    FQueuedThreadPool* DispatchPool = nullptr;
+
+    /** Decodes UTF-8 text straight into the buffer of a new string. */
+    FString Utf8ToString(const UTF8CHAR* Data, const int32 Size)
+    {
+        FString Result;
+        const int32 Length = FPlatformString::ConvertedLength<TCHAR>(Data, Size);
+        if (Length > 0)
         {
-            UE_LOG(LogJsonRpc, VeryVerbose,
-				TEXT("FJsonRpcWebSocketChannel::WS->OnMessage()"));
-            OnMessage.Broadcast(Message);
+            TArray<TCHAR>& Chars = Result.GetCharArray();
+            Chars.SetNumUninitialized(Length + 1);
+            FPlatformString::Convert(Chars.GetData(), Length, Data, Size);
+            Chars[Length] = TEXT('\0');
         }
-    );
+        return Result;
+    }
+}
+
+
+FJsonRpcWebSocketChannel::FJsonRpcWebSocketChannel(const TSharedPtr<IWebSocket> InWS,
+    const EJsonRpcEncoding InEncoding)
+    : Encoding(InEncoding), bPeerSentBinary(false)
+{
+    WS = InWS;
+    if (Encoding == EJsonRpcEncoding::Json)
+    {
+        // Decode the UTF-8 ourselves, so that the string FJsonRpc keeps is
+        // the only copy of the message rather than a copy of the socket's.
+        WS->OnUtf8Message().AddLambda([this](const UTF8CHAR* Data, SIZE_T Size)
+            {
+                UE_LOG(LogJsonRpc, VeryVerbose,
+                    TEXT("FJsonRpcWebSocketChannel::WS->OnUtf8Message() %d bytes"), StaticCast<int32>(Size));
+                BroadcastMessage(Utf8ToString(Data, StaticCast<int32>(Size)));
+            }
+        );
+    }
+    else
+    {
+        // Not every backend tells us whether a frame was text or binary, and
+        // some only raise OnMessage for text, so in binary mode we read raw
+        // frames and look at the payload instead.
+        WS->OnRawMessage().AddRaw(this, &FJsonRpcWebSocketChannel::OnRawMessage);
+    }
+}
+
+void FJsonRpcWebSocketChannel::OnRawMessage(const void* Data, SIZE_T Size, SIZE_T BytesRemaining)
+{
+    RawBuffer.Append(static_cast<const uint8*>(Data), Size);
+    if (BytesRemaining > 0)
+    {
+        return;
+    }
+
+    UE_LOG(LogJsonRpc, VeryVerbose,
+        TEXT("FJsonRpcWebSocketChannel::OnRawMessage() %d bytes"), RawBuffer.Num());
+    if (RawBuffer.Num() > 0 && FJsonRpcMessagePack::IsMessagePack(RawBuffer[0]))
+    {
+        bPeerSentBinary = true;
+        OnBinaryMessage.Broadcast(RawBuffer);
+    }
+    else
+    {
+        BroadcastMessage(Utf8ToString(reinterpret_cast<const UTF8CHAR*>(RawBuffer.GetData()), RawBuffer.Num()));
+    }
+    RawBuffer.Reset();
 }
 
 void FJsonRpcWebSocketChannel::Send(const FString& Message)
@@ -33,17 +98,43 @@ void FJsonRpcWebSocketChannel::Send(const FString& Message)
     WS->Send(Message);
 }
 
+void FJsonRpcWebSocketChannel::SendUtf8(const TArray<uint8>& Message)
+{
+    UE_LOG(LogJsonRpc, VeryVerbose,
+        TEXT("FJsonRpcWebSocketChannel::SendUtf8() %d bytes"), Message.Num());
+    WS->Send(Message.GetData(), Message.Num(), false);
+}
+
 void FJsonRpcWebSocketChannel::Close(const int32 Code, const FString& Reason)
 {
 	UE_LOG(LogJsonRpc, Verbose, TEXT("FJsonRpcWebSocketChannel::Close() %d %s"), Code, *Reason);
     WS->Close(Code, Reason);
 }
 
-FJsonRpcPairedChannel::FPair FJsonRpcPairedChannel::Create()
+EJsonRpcEncoding FJsonRpcWebSocketChannel::GetEncoding() const
+{
+    if (Encoding == EJsonRpcEncoding::MessagePack
+        || (Encoding == EJsonRpcEncoding::MatchPeer && bPeerSentBinary))
+    {
+        return EJsonRpcEncoding::MessagePack;
+    }
+    return EJsonRpcEncoding::Json;
+}
+
+void FJsonRpcWebSocketChannel::SendBinary(const TArray<uint8>& Message)
+{
+    UE_LOG(LogJsonRpc, VeryVerbose,
+        TEXT("FJsonRpcWebSocketChannel::SendBinary() %d bytes"), Message.Num());
+    WS->Send(Message.GetData(), Message.Num(), true);
+}
+
+FJsonRpcPairedChannel::FPair FJsonRpcPairedChannel::Create(const EJsonRpcEncoding Encoding)
 {
     auto Local = MakeShared<FJsonRpcPairedChannel>();
     const auto Remote = MakeShared<FJsonRpcPairedChannel>(Local);
     Local->Other = Remote;
+    Local->Encoding = Encoding;
+    Remote->Encoding = Encoding;
     return { Local, Remote };
 }
 
@@ -54,14 +145,36 @@ FJsonRpcPairedChannel::FJsonRpcPairedChannel(TSharedPtr<FJsonRpcPairedChannel> I
 
 void FJsonRpcPairedChannel::Send(const FString& Message)
 {
+    // Deliver on the shared pool rather than a fresh thread per message, so
+    // that stress tests with thousands of calls don't exhaust OS threads.
     auto OtherPtr = Other;
-    Async(EAsyncExecution::Thread, [OtherPtr, Message]()
+    Async(EAsyncExecution::ThreadPool, [OtherPtr, Message]() mutable
         {
-            OtherPtr->OnMessage.Broadcast(Message);
+            OtherPtr->BroadcastMessage(MoveTemp(Message));
         });
     
 }
 
+EJsonRpcEncoding FJsonRpcPairedChannel::GetEncoding() const
+{
+    if (Encoding == EJsonRpcEncoding::MessagePack
+        || (Encoding == EJsonRpcEncoding::MatchPeer && bPeerSentBinary))
+    {
+        return EJsonRpcEncoding::MessagePack;
+    }
+    return EJsonRpcEncoding::Json;
+}
+
+void FJsonRpcPairedChannel::SendBinary(const TArray<uint8>& Message)
+{
+    auto OtherPtr = Other;
+    Async(EAsyncExecution::ThreadPool, [OtherPtr, Message]()
+        {
+            OtherPtr->bPeerSentBinary = true;
+            OtherPtr->OnBinaryMessage.Broadcast(Message);
+        });
+}
+
 FJsonRpcHeartbeatChannel::FJsonRpcHeartbeatChannel()
 	: World(nullptr), Inner(nullptr), Cadence(-1)
 {
@@ -87,13 +200,21 @@ void FJsonRpcHeartbeatChannel::Start()
     World->GetTimerManager().SetTimer(
         TimerHandle, FTimerDelegate::CreateLambda(Heartbeat), Cadence, true);
 
-    Inner->OnMessage.AddLambda([this](const FString& Message)
+    Inner->OnSharedMessage.AddLambda([this](const TSharedRef<const FString>& Message)
         {
 			UE_LOG(LogJsonRpc, Verbose, TEXT("FJsonRpcHeartbeatChannel::OnMessage()"));
             if (Inner.IsValid())
             {
                 UE_LOG(LogJsonRpc, Verbose, TEXT("FJsonRpcHeartbeatChannel::OnMessage() Inner.IsValid() succeded"));
-                OnMessage.Broadcast(Message);
+                BroadcastMessage(Message);
+            }
+        });
+
+    Inner->OnBinaryMessage.AddLambda([this](const TArray<uint8>& Message)
+        {
+            if (Inner.IsValid())
+            {
+                OnBinaryMessage.Broadcast(Message);
             }
         });
 }
@@ -127,6 +248,50 @@ void FJsonRpcHeartbeatChannel::Send(const FString& Message)
     }
 }
 
+bool FJsonRpcHeartbeatChannel::PrefersUtf8() const
+{
+    return Inner.IsValid() && Inner->PrefersUtf8();
+}
+
+void FJsonRpcHeartbeatChannel::SendUtf8(const TArray<uint8>& Message)
+{
+    if (IsInGameThread()) {
+        Inner->SendUtf8(Message);
+        FTimerManager& TimerManager = World->GetTimerManager();
+        TimerManager.ClearTimer(TimerHandle);
+        TimerManager.SetTimer(TimerHandle, FTimerDelegate::CreateLambda(Heartbeat), Cadence, true);
+    }
+    else
+    {
+		Async(EAsyncExecution::TaskGraphMainThread, [this, Message]()
+			{
+				SendUtf8(Message);
+			});
+    }
+}
+
+EJsonRpcEncoding FJsonRpcHeartbeatChannel::GetEncoding() const
+{
+    return Inner.IsValid() ? Inner->GetEncoding() : EJsonRpcEncoding::Json;
+}
+
+void FJsonRpcHeartbeatChannel::SendBinary(const TArray<uint8>& Message)
+{
+    if (IsInGameThread()) {
+        Inner->SendBinary(Message);
+        FTimerManager& TimerManager = World->GetTimerManager();
+        TimerManager.ClearTimer(TimerHandle);
+        TimerManager.SetTimer(TimerHandle, FTimerDelegate::CreateLambda(Heartbeat), Cadence, true);
+    }
+    else
+    {
+		Async(EAsyncExecution::TaskGraphMainThread, [this, Message]()
+			{
+				SendBinary(Message);
+			});
+    }
+}
+
 void FJsonRpcHeartbeatChannel::Close(const int32 Code, const FString& Reason)
 {
     // May not be valid, if, for example, the Inner was never initialized
@@ -147,35 +312,166 @@ TSharedFuture<FJsonRpcResponse> FJsonRpcEmptyHandler::Handle(
     return Promise.GetFuture().Share();
 }
 
-FJsonRpc::FJsonRpc(const TSharedPtr<FJsonRpcChannel> InChannel, const TSharedPtr<FJsonRpcHandler> InHandler)
-    : PendingCounter(0)
+FJsonRpc::FJsonRpc(const TSharedPtr<FJsonRpcChannel> InChannel, const TSharedPtr<FJsonRpcHandler> InHandler,
+    const EJsonRpcDispatch InDispatch)
+    : Pending(MakeUnique<FJsonRpcPendingTable>()), Dispatch(InDispatch)
 {
     Channel = InChannel;
     Handler = InHandler;
-    Channel->OnMessage.AddLambda([this](const FString& Message){
+    Channel->OnSharedMessage.AddLambda([this](const TSharedRef<const FString>& Message){
             ProcessIncoming(Message);
         });
+    Channel->OnBinaryMessage.AddLambda([this](const TArray<uint8>& Message){
+            ProcessIncomingBinary(Message);
+        });
+
+    ExpireTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateLambda([this](float DeltaTime)
+        {
+            ExpirePending();
+            return true;
+        }),
+        ExpireIntervalSeconds);
+
+    PollTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateLambda([this](float DeltaTime)
+        {
+            PollHandlers();
+            return true;
+        }));
+}
+
+FJsonRpc::~FJsonRpc()
+{
+    FTSTicker::GetCoreTicker().RemoveTicker(ExpireTickerHandle);
+    FTSTicker::GetCoreTicker().RemoveTicker(PollTickerHandle);
+}
+
+
+FQueuedThreadPool& FJsonRpc::GetDispatchPool()
+{
+    FScopeLock Lock(&DispatchPoolLock);
+    if (DispatchPool == nullptr)
+    {
+        int32 NumThreads = 4;
+        GConfig->GetInt(TEXT("JsonRpc"), TEXT("DispatchThreads"), NumThreads, GEngineIni);
+        NumThreads = FMath::Max(NumThreads, 1);
+
+        UE_LOG(LogJsonRpc, Verbose, TEXT("FJsonRpc::GetDispatchPool() creating %d threads"), NumThreads);
+        DispatchPool = FQueuedThreadPool::Allocate();
+        verify(DispatchPool->Create(NumThreads, 64 * 1024, TPri_Normal, TEXT("JsonRpcDispatch")));
+    }
+    return *DispatchPool;
+}
+
+void FJsonRpc::ShutdownDispatchPool()
+{
+    FScopeLock Lock(&DispatchPoolLock);
+    if (DispatchPool != nullptr)
+    {
+        DispatchPool->Destroy();
+        delete DispatchPool;
+        DispatchPool = nullptr;
+    }
+}
+
+void FJsonRpc::Await(const TSharedFuture<FJsonRpcResponse>& Future, FJsonRpcRespond Respond)
+{
+    // Synchronous handlers hand back futures that are already resolved, so
+    // we can answer straight away without involving another thread.
+    if (Future.IsReady())
+    {
+        Respond(Future.Get());
+        return;
+    }
+
+    // Anything else is polled, so that slow handlers don't tie up a thread
+    FScopeLock Lock(&AwaitedLock);
+    Awaited.Add({ Future, MoveTemp(Respond),
+        FPlatformTime::Seconds() + HandlerTimeout.GetTotalSeconds() });
 }
 
+void FJsonRpc::PollHandlers()
+{
+    TArray<TPair<FJsonRpcRespond, FJsonRpcResponse>> Ready;
+    {
+        FScopeLock Lock(&AwaitedLock);
+        if (Awaited.Num() == 0)
+        {
+            return;
+        }
+
+        const double Now = FPlatformTime::Seconds();
+        for (int32 Index = Awaited.Num() - 1; Index >= 0; --Index)
+        {
+            FAwaitedResponse& Entry = Awaited[Index];
+            if (Entry.Future.IsReady())
+            {
+                Ready.Emplace(MoveTemp(Entry.Respond), Entry.Future.Get());
+            }
+            else if (Now >= Entry.Deadline)
+            {
+                UE_LOG(LogJsonRpc, Error,
+                    TEXT("FJsonRpc::PollHandlers() Timed out waiting for the handler's response"));
+                Ready.Emplace(MoveTemp(Entry.Respond), FJsonRpc::Error(TimedOut,
+                    FString::Printf(TEXT("The handler did not respond within %.0f seconds"),
+                        HandlerTimeout.GetTotalSeconds())));
+            }
+            else
+            {
+                continue;
+            }
+            Awaited.RemoveAtSwap(Index, 1, false);
+        }
+    }
+
+    for (TPair<FJsonRpcRespond, FJsonRpcResponse>& Item : Ready)
+    {
+        auto Send = [Respond = MoveTemp(Item.Key), Response = MoveTemp(Item.Value)]()
+        {
+            Respond(Response);
+        };
+
+        switch (Dispatch)
+        {
+        case EJsonRpcDispatch::WorkerPool:
+            AsyncPool(GetDispatchPool(), MoveTemp(Send));
+            break;
+        case EJsonRpcDispatch::TaskGraph:
+            Async(EAsyncExecution::TaskGraph, MoveTemp(Send));
+            break;
+        case EJsonRpcDispatch::Thread:
+            Async(EAsyncExecution::Thread, MoveTemp(Send));
+            break;
+        }
+    }
+}
 
 void FJsonRpc::Close()
 {
     // We have to unwind all these promises or we end up with a crash on exit
     // from play-in-editor.
-    const auto Error = FJsonRpc::Error(Closed,
-        TEXT("No response received before FJsonRpc.Close()"));
-    // We frequently see a memory access violation in the condition of this for
-    // loop. Not exactly sure what could be invalid here. Is it possibly a race
-    // condition on `this` itself if we're being deleted from another thread?
-    for(auto& Entry : Pending)
-    {
-        Entry.Value.SetValue(Error);
-    }
-    
-    Pending.Empty();
+    Pending->ResolveAll(FJsonRpc::Error(Closed,
+        TEXT("No response received before FJsonRpc.Close()")));
     UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::Close()"));
 }
 
+void FJsonRpc::ExpirePending()
+{
+    Pending->Expire(FPlatformTime::Seconds());
+}
+
+int32 FJsonRpc::GetPendingCount() const
+{
+    return Pending->Num();
+}
+
+FTimespan FJsonRpc::GetOldestPendingAge() const
+{
+    const double Oldest = Pending->GetOldestStartTime();
+    return Oldest > 0 ? FTimespan::FromSeconds(FPlatformTime::Seconds() - Oldest) : FTimespan::Zero();
+}
+
 void FJsonRpc::Notify(const FString Method, const TSharedPtr<FJsonValue> Params) const
 {
     const auto MsgObject = MakeShared<FJsonObject>();
@@ -185,25 +481,16 @@ void FJsonRpc::Notify(const FString Method, const TSharedPtr<FJsonValue> Params)
     MsgObject->SetStringField("method", Method);
     MsgObject->SetField("params", Params);
 
-    FString Message;
-    const auto Writer = TJsonWriterFactory<>::Create(&Message);
-    FJsonSerializer::Serialize(MsgObject, Writer);
-    
-    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::Notify() sending JSON: %s"), *Message);
-
-    Channel->Send(Message);
+    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::Notify() sending method '%s'"), *Method);
+    SendObject(Channel, MsgObject);
 }
 
 TSharedFuture<FJsonRpcResponse> FJsonRpc::Call(
-        const FString Method, const TSharedPtr<FJsonValue> Params)
+        const FString Method, const TSharedPtr<FJsonValue> Params,
+        const FTimespan Timeout, const TSharedPtr<FJsonRpcCancellation> Cancellation)
 {
     UE_LOG(LogJsonRpc, Verbose, TEXT("FJsonRpc::Call() method = '%s'"), *Method);
-    FString Id;
-    {
-        FScopeLock Lock(&CriticalSection);
-        PendingCounter++;
-        Id = FString::Printf(TEXT("%d"), PendingCounter);
-    }
+    const uint32 Id = Pending->NextId();
 
     const auto MsgObject = MakeShared<FJsonObject>();
 
@@ -211,18 +498,20 @@ TSharedFuture<FJsonRpcResponse> FJsonRpc::Call(
     MsgObject->SetStringField("jsonrpc", "2.0");
     MsgObject->SetStringField("method", Method);
     MsgObject->SetField("params", Params);
-    MsgObject->SetStringField("id", Id);
+    // Ids go out as strings, as they always have, since that's what the
+    // servers we talk to echo back and key on. Replies parse either way.
+    MsgObject->SetStringField("id", FString::Printf(TEXT("%u"), Id));
 
-    FString Message;
-    const auto Writer = TJsonWriterFactory<>::Create(&Message);
-    FJsonSerializer::Serialize(MsgObject, Writer);
+    // The entry has to exist before we send, or a fast reply could arrive
+    // before there's anything for it to resolve.
+    const double Deadline = Timeout > FTimespan::Zero()
+        ? FPlatformTime::Seconds() + Timeout.GetTotalSeconds() : 0;
+    auto Future = Pending->Add(Id, Deadline, Cancellation);
 
-    UE_LOG(LogJsonRpc, VeryVerbose, 
-        TEXT("FJsonRpc::Call() sending call with Id '%s' JSON:\n%s"), *Id, *Message);
-    Channel->Send(Message);
+    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::Call() sending call with Id '%u'"), Id);
+    SendObject(Channel, MsgObject);
 
-    Pending.Add(Id, TPromise<FJsonRpcResponse>());
-    return Pending[Id].GetFuture().Share();
+    return Future;
 }
 
 FJsonRpcResponse FJsonRpc::Error(EJsonRpcError Code, const FString& Message)
@@ -264,51 +553,86 @@ void FJsonRpc::Log(const FString& Message, const TSharedPtr<FJsonObject> Value)
  * it's not a full implementation of the JSON RPC protocol. But it's enough to
  * handle the subset used by Ion.
  */
-void FJsonRpc::ProcessIncoming(const FString& Message)
+void FJsonRpc::ProcessIncoming(const TSharedRef<const FString>& Message)
 {
     UE_LOG(LogJsonRpc, VeryVerbose,
         TEXT("FJsonRpc::ProcessIncoming() received %d chars:\n%s"),
-        (Message.Len()), // the parens help JetBrains understand the method call
-        *Message);
+        (Message->Len()), // the parens help JetBrains understand the method call
+        **Message);
+
+    // Single messages are by far the common case, and the envelope scanner
+    // gets through them without building a DOM. The payload fields share the
+    // channel's text until they're done with it.
+    if (FJsonRpcEnvelope Envelope; FJsonRpcEnvelope::Parse(Message, Envelope))
+    {
+        ProcessEnvelope(Envelope);
+        return;
+    }
 
-    const auto Reader = TJsonReaderFactory<>::Create(Message);
+    // Batches, and anything the scanner couldn't make sense of, go through
+    // the DOM parser so that errors are reported properly.
+    const auto Reader = TJsonReaderFactory<>::Create(*Message);
 
     if(TSharedPtr<FJsonValue> MsgValue; !FJsonSerializer::Deserialize(Reader, MsgValue))
     {
         // I belive we're supposed to send back a error with code -32700 (parse
         // error), with a null "id" property.
         UE_LOG(LogJsonRpc, Error,
-            TEXT("FJsonRpc::ProcessIncoming(): Unable to deserialize JSON RPC message: '%s'"), *Message);
+            TEXT("FJsonRpc::ProcessIncoming(): Unable to deserialize JSON RPC message: '%s'"), **Message);
         SendError(ParseError, TEXT("Unable to deserialize request JSON"));
     }
     else 
     {
-        TArray< TSharedPtr<FJsonValue> > const* Batch;
-        TSharedPtr<FJsonObject> const* SingleMsg;
-        if (MsgValue->TryGetArray(Batch)) {
-            for (auto Item : *Batch) {
-                auto MsgObject = Item->AsObject();
-                ProcessSingle(MsgObject);
-            }
-        }
-        else if (MsgValue->TryGetObject(SingleMsg))
-        {
-            ProcessSingle(*SingleMsg);
-        }
-        else
-        {
-            FString ErrMessage = TEXT("JSON-RPC request is neither an array nor an object");
-            UE_LOG(LogJsonRpc, Error, TEXT("%s"), *ErrMessage);
-            SendError(InvalidRequest, ErrMessage);
+        ProcessValue(MsgValue);
+    }
+}
+
+void FJsonRpc::ProcessIncomingBinary(const TArray<uint8>& Message)
+{
+    UE_LOG(LogJsonRpc, VeryVerbose,
+        TEXT("FJsonRpc::ProcessIncomingBinary() received %d bytes"), Message.Num());
+
+    const auto MsgValue = FJsonRpcMessagePack::Decode(Message.GetData(), Message.Num());
+    if (!MsgValue.IsValid())
+    {
+        UE_LOG(LogJsonRpc, Error,
+            TEXT("FJsonRpc::ProcessIncomingBinary(): Unable to decode %d byte MessagePack message"), Message.Num());
+        SendError(ParseError, TEXT("Unable to decode request MessagePack"));
+        return;
+    }
+    ProcessValue(MsgValue);
+}
+
+void FJsonRpc::ProcessValue(const TSharedPtr<FJsonValue>& MsgValue)
+{
+    TArray< TSharedPtr<FJsonValue> > const* Batch;
+    TSharedPtr<FJsonObject> const* SingleMsg;
+    if (MsgValue->TryGetArray(Batch)) {
+        for (auto Item : *Batch) {
+            auto MsgObject = Item->AsObject();
+            ProcessSingle(MsgObject);
         }
-        
+    }
+    else if (MsgValue->TryGetObject(SingleMsg))
+    {
+        ProcessSingle(*SingleMsg);
+    }
+    else
+    {
+        FString ErrMessage = TEXT("JSON-RPC request is neither an array nor an object");
+        UE_LOG(LogJsonRpc, Error, TEXT("%s"), *ErrMessage);
+        SendError(InvalidRequest, ErrMessage);
     }
 }
 
 void FJsonRpc::ProcessSingle(TSharedPtr<FJsonObject> MsgObject)
 {
     FJsonRpc::Log(TEXT("FJsonRpc::ProcessSingle() got MsgObject"), MsgObject);
+    ProcessEnvelope(FJsonRpcEnvelope::FromObject(MsgObject));
+}
 
+void FJsonRpc::ProcessEnvelope(const FJsonRpcEnvelope& Envelope)
+{
     // This method uses early return, so be aware that the checks are
     // sequential and so have a kind of priority order.
     // 
@@ -317,43 +641,55 @@ void FJsonRpc::ProcessSingle(TSharedPtr<FJsonObject> MsgObject)
     // no id, we have a notify. If we have a method with a valid id, then we
     // have a call, and we pass it to the Handler.
 
-    if (MsgObject->HasField(TEXT("error")))
+    if (Envelope.Error.IsSet())
     {
-        // Will it be any help to also log the id?
-        auto Error = MsgObject->GetObjectField("error");
-        FJsonRpc::Log({ true, nullptr, Error });
+        const auto ErrorValue = Envelope.Error.Materialize();
+        const TSharedPtr<FJsonObject>* Error;
+        if (!ErrorValue.IsValid() || !ErrorValue->TryGetObject(Error))
+        {
+            UE_LOG(LogJsonRpc, Error, TEXT("FJsonRpc::ProcessEnvelope() error field is not an object"));
+            return;
+        }
+        const FJsonRpcResponse Response = { true, nullptr, *Error };
+        FJsonRpc::Log(Response);
+
+        // An error with an id is the reply to one of our calls, so the caller
+        // gets to see it. With a null id it can't be correlated to anything.
+        if (Envelope.Id.IsSet() && !Envelope.Id.IsNull())
+        {
+            uint32 Id;
+            if (!Envelope.GetCallId(Id) || !Pending->Resolve(Id, Response))
+            {
+                UE_LOG(LogJsonRpc, Warning, TEXT("Error response for unknown id=%s"),
+                    *Envelope.Id.ToString());
+            }
+        }
         return;
     }
 
-    // We have to use this more awkward syntax because we don't know the type
-    // of the result field. We can't use the FJsonValue::GetField template.
-    //const TSharedPtr<FJsonObject>* Result = nullptr;
-    //if (MsgObject->TryGetObjectField(TEXT("result"), Result))
-    if(MsgObject->HasField("result"))
+    if (Envelope.Result.IsSet())
     {
-        const auto Result= MsgObject->Values["result"];
-        if (MsgObject->HasField("id"))
+        if (Envelope.Id.IsSet())
         {
-            const FString Id = FJsonRpc::GetIdAsString(MsgObject);
-
-            if (Pending.Contains(Id))
+            uint32 Id;
+            if (Envelope.GetCallId(Id))
             {
                 const FJsonRpcResponse Response = {
                     false,
-                    Result,
+                    Envelope.Result.Materialize(),
                     nullptr,
                 };
-                Pending[Id].SetValue(Response);
-                Pending.Remove(Id);
-                return;
-            }
-            else
-            {
-                const FString Message = FString::Printf(TEXT("Unmatched response id=%s"), *Id);
-                UE_LOG(LogJsonRpc, Error, TEXT("%s"), *Message);
-                SendError(InvalidRequest, Message);
-                return;
+                if (Pending->Resolve(Id, Response))
+                {
+                    return;
+                }
             }
+
+            const FString Message = FString::Printf(TEXT("Unmatched response id=%s"),
+                *Envelope.Id.ToString());
+            UE_LOG(LogJsonRpc, Error, TEXT("%s"), *Message);
+            SendError(InvalidRequest, Message);
+            return;
         }
         else
         {
@@ -366,62 +702,47 @@ void FJsonRpc::ProcessSingle(TSharedPtr<FJsonObject> MsgObject)
 
     // If there's no `id` field, check for a method because we're handling
     // a notify instead.
-    if (MsgObject->HasField(TEXT("method")))
+    if (Envelope.bHasMethod)
     {
-        auto Method = MsgObject->GetStringField("method");
+        const FString& Method = Envelope.Method;
         // If we have an Id, then it's a call
-        if (MsgObject->HasField("id"))
+        if (Envelope.Id.IsSet())
         {
             UE_LOG(LogJsonRpc, Verbose, TEXT("Got CALL with method name '%s'"), *Method);
-            auto Params = MsgObject->TryGetField("params");
-            auto Id = MsgObject->TryGetField("id");
-            if (Params)
+            if (Envelope.Params.IsSet())
             {
-                auto Future = Handler->Handle(Method, Params);
-
                 // A copy of the channel shared pointer so that the channel
-                // won't be freed while awaiting the Future
+                // won't be freed while the handler is still working
                 auto ChannelPtr = Channel;
+                TSharedPtr<FJsonValue> Id = Envelope.Id.Materialize();
+                if (!Id.IsValid())
+                {
+                    Id = MakeShared<FJsonValueNull>();
+                }
+                FJsonRpcRespond Respond = [ChannelPtr, Id](const FJsonRpcResponse& Response)
+                {
+                    SendResponseStatic(ChannelPtr, Response, Id);
+                };
 
-                // setup an Async to send this when the promise resolves
-                Async(EAsyncExecution::Thread, [Future, ChannelPtr, Id]() {
-
-                    FJsonRpcResponse Response;
-                    if(Future.WaitFor({0, 0, 30}))
-                    {
-                        Response = Future.Get();
-                    }
-                    else
-                    {
-                        UE_LOG(LogJsonRpc, Error,
-                            TEXT("FJsonRpc::ProcessSingle() Async lambda: Timed out waiting for response"));
-                        return;
-                    }
-
-                    if (Response.IsError)
-                    {
-                        FJsonRpc::Log(Response);
-						SendErrorStatic(ChannelPtr, Response, Id);
-                    }
-                    else
-                    {
-                        auto MsgObject = MakeShared<FJsonObject>();
-
-                        MsgObject->SetStringField(TEXT("jsonrpc"), "2.0");
-                        MsgObject->SetField(TEXT("id"), Id);
-                        MsgObject->SetField(TEXT("result"), Response.Result);
-
-                        FString Payload;
-                        auto Writer = TJsonWriterFactory<>::Create(&Payload);
-                        FJsonSerializer::Serialize(MsgObject, Writer);
-
-                        ChannelPtr->Send(Payload);
-                    }
-                });
+                if (Handler->HandleLazy(Method, Envelope.Params, Respond))
+                {
+                    return;
+                }
+
+                const auto Params = Envelope.Params.Materialize();
+                if (!Params.IsValid())
+                {
+                    UE_LOG(LogJsonRpc, Error, TEXT("FJsonRpc::ProcessEnvelope() Unable to parse params of the call"));
+                    SendError(ParseError, TEXT("Unable to parse params"), Id);
+                }
+                else if (!Handler->HandleAsync(Method, Params, Respond))
+                {
+                    Await(Handler->Handle(Method, Params), MoveTemp(Respond));
+                }
             }
             else
             {
-				UE_LOG(LogJsonRpc, Error, TEXT("FJsonRpc::ProcessSingle() No params field in the call"));
+				UE_LOG(LogJsonRpc, Error, TEXT("FJsonRpc::ProcessEnvelope() No params field in the call"));
 				SendError(InvalidRequest, TEXT("No params field in the call"));
             }
         }
@@ -429,10 +750,23 @@ void FJsonRpc::ProcessSingle(TSharedPtr<FJsonObject> MsgObject)
         else
         {
             UE_LOG(LogJsonRpc, Verbose,
-                TEXT("FJsonRpc::ProcessSingle() Got NOTIFY with method name '%s'"), *Method);
-            if (const auto Params = MsgObject->TryGetField("params"))
+                TEXT("FJsonRpc::ProcessEnvelope() Got NOTIFY with method name '%s'"), *Method);
+            if (Envelope.Params.IsSet())
             {
-                OnNotify().Broadcast(Method, Params);
+                JsonRpcNotifyLazy.Broadcast(Method, Envelope.Params);
+
+                // Only pay for the DOM if somebody wants it
+                if (JsonRpcNotify.IsBound())
+                {
+                    if (const auto Params = Envelope.Params.Materialize())
+                    {
+                        OnNotify().Broadcast(Method, Params);
+                    }
+                    else
+                    {
+                        SendError(ParseError, TEXT("Unable to parse params"));
+                    }
+                }
             }
             else
             {
@@ -443,7 +777,7 @@ void FJsonRpc::ProcessSingle(TSharedPtr<FJsonObject> MsgObject)
     else
     {
         UE_LOG(LogJsonRpc, Error,
-            TEXT("FJsonRpc::ProcessSingle() no method field in message that is neither error nor response"));
+            TEXT("FJsonRpc::ProcessEnvelope() no method field in message that is neither error nor response"));
     }
 }
 
@@ -478,12 +812,8 @@ void FJsonRpc::SendError(EJsonRpcError Code, const FString& Message, TSharedPtr<
     MsgObject->SetField("id", Id);
     MsgObject->SetObjectField("error", Error);
 
-    FString Payload;
-    auto Writer = TJsonWriterFactory<>::Create(&Payload);
-    FJsonSerializer::Serialize(MsgObject, Writer);
-
-    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::SendError() sending JSON: %s"), *Payload);
-    Channel->Send(Payload);
+    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::SendError() sending error %d: %s"), Code, *Message);
+    SendObject(Channel, MsgObject);
 }
 
 
@@ -518,11 +848,55 @@ void FJsonRpc::SendErrorStatic(TSharedPtr<FJsonRpcChannel> Channel, FJsonRpcResp
     MsgObject->SetField("id", Id);
     MsgObject->SetObjectField("error", Response.Error);
 
+    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::SendErrorStatic() sending error"));
+    SendObject(Channel, MsgObject);
+}
+
+void FJsonRpc::SendResponseStatic(TSharedPtr<FJsonRpcChannel> Channel, const FJsonRpcResponse& Response, TSharedPtr<FJsonValue> Id)
+{
+    if (Response.IsError)
+    {
+        FJsonRpc::Log(Response);
+        SendErrorStatic(Channel, Response, Id);
+        return;
+    }
+
+    auto MsgObject = MakeShared<FJsonObject>();
+
+    MsgObject->SetStringField(TEXT("jsonrpc"), "2.0");
+    MsgObject->SetField(TEXT("id"), Id);
+    MsgObject->SetField(TEXT("result"), Response.Result);
+
+    SendObject(Channel, MsgObject);
+}
+
+void FJsonRpc::SendObject(const TSharedPtr<FJsonRpcChannel>& Channel, const TSharedRef<FJsonObject>& MsgObject)
+{
+    if (Channel->GetEncoding() == EJsonRpcEncoding::MessagePack)
+    {
+        TArray<uint8> Payload;
+        FJsonRpcMessagePack::Encode(MakeShared<FJsonValueObject>(MsgObject), Payload);
+        Channel->SendBinary(Payload);
+        return;
+    }
+
+    if (Channel->PrefersUtf8())
+    {
+        TArray<uint8> Payload;
+        FMemoryWriter Archive(Payload);
+        auto Writer = TJsonWriterFactory<UTF8CHAR>::Create(&Archive);
+        FJsonSerializer::Serialize(MsgObject, Writer);
+
+        UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::SendObject() sending %d bytes of JSON"), Payload.Num());
+        Channel->SendUtf8(Payload);
+        return;
+    }
+
     FString Payload;
     auto Writer = TJsonWriterFactory<>::Create(&Payload);
     FJsonSerializer::Serialize(MsgObject, Writer);
 
-    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::SendError() sending JSON: %s"), *Payload);
+    UE_LOG(LogJsonRpc, VeryVerbose, TEXT("FJsonRpc::SendObject() sending JSON: %s"), *Payload);
     Channel->Send(Payload);
 }
 
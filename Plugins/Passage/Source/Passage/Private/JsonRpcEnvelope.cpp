@@ -0,0 +1,474 @@
+// Copyright Enva Division
+
+#include "JsonRpcEnvelope.h"
+#include "JsonRpcPendingTable.h"
+
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+
+namespace
+{
+	/*
+	 * A minimal scanner over JSON text. It only knows enough about JSON to
+	 * find where each value starts and ends; the values themselves are
+	 * checked by TJsonReader if they're ever materialized.
+	 */
+	class FEnvelopeScanner
+	{
+	public:
+		explicit FEnvelopeScanner(const FString& InText)
+			: Text(*InText), Len(InText.Len()), Pos(0) {}
+
+		/* Scans Count characters of InText from Start on. */
+		FEnvelopeScanner(const FString& InText, const int32 Start, const int32 Count)
+			: Text(*InText), Len(Start + Count), Pos(Start) {}
+
+		const TCHAR* const Text;
+		const int32 Len;
+		int32 Pos;
+
+		bool AtEnd() const { return Pos >= Len; }
+
+		TCHAR Peek() const { return AtEnd() ? TCHAR(0) : Text[Pos]; }
+
+		void SkipWhitespace()
+		{
+			while (!AtEnd() && FChar::IsWhitespace(Text[Pos]))
+			{
+				Pos++;
+			}
+		}
+
+		bool Expect(const TCHAR Char)
+		{
+			SkipWhitespace();
+			if (Peek() != Char)
+			{
+				return false;
+			}
+			Pos++;
+			return true;
+		}
+
+		/* Skips a string starting at the opening quote. */
+		bool SkipString()
+		{
+			Pos++;
+			while (!AtEnd())
+			{
+				const TCHAR Char = Text[Pos++];
+				if (Char == TEXT('\\'))
+				{
+					Pos++;
+				}
+				else if (Char == TEXT('"'))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/* Skips any value, leaving Pos just past its last character. */
+		bool SkipValue()
+		{
+			SkipWhitespace();
+			const TCHAR First = Peek();
+			if (First == TEXT('"'))
+			{
+				return SkipString();
+			}
+			if (First == TEXT('{') || First == TEXT('['))
+			{
+				int32 Depth = 0;
+				while (!AtEnd())
+				{
+					const TCHAR Char = Text[Pos];
+					if (Char == TEXT('"'))
+					{
+						if (!SkipString())
+						{
+							return false;
+						}
+						continue;
+					}
+					Pos++;
+					if (Char == TEXT('{') || Char == TEXT('['))
+					{
+						Depth++;
+					}
+					else if (Char == TEXT('}') || Char == TEXT(']'))
+					{
+						if (--Depth == 0)
+						{
+							return true;
+						}
+					}
+				}
+				return false;
+			}
+
+			// A number or a literal runs until the next delimiter
+			const int32 Start = Pos;
+			while (!AtEnd())
+			{
+				const TCHAR Char = Text[Pos];
+				if (Char == TEXT(',') || Char == TEXT('}') || Char == TEXT(']') || FChar::IsWhitespace(Char))
+				{
+					break;
+				}
+				Pos++;
+			}
+			return Pos > Start;
+		}
+	};
+
+	/* Parses a run of decimal digits as a call id. */
+	bool ParseDigits(const FStringView Digits, uint32& OutId)
+	{
+		if (Digits.Len() == 0 || Digits.Len() > 10)
+		{
+			return false;
+		}
+		uint64 Id = 0;
+		for (const TCHAR Char : Digits)
+		{
+			if (!FChar::IsDigit(Char))
+			{
+				return false;
+			}
+			Id = Id * 10 + (Char - TEXT('0'));
+		}
+		if (Id == 0 || Id > MAX_uint32)
+		{
+			return false;
+		}
+		OutId = StaticCast<uint32>(Id);
+		return true;
+	}
+}
+
+
+bool FJsonRpcLazyValue::IsNull() const
+{
+	if (Value.IsValid())
+	{
+		return Value->IsNull();
+	}
+	return Source.IsValid() && GetView() == TEXTVIEW("null");
+}
+
+FStringView FJsonRpcLazyValue::GetView() const
+{
+	if (!Source.IsValid())
+	{
+		return FStringView();
+	}
+	return FStringView(**Source + Start, Len);
+}
+
+TSharedPtr<FJsonValue> FJsonRpcLazyValue::Materialize() const
+{
+	if (Value.IsValid() || !Source.IsValid())
+	{
+		return Value;
+	}
+
+	// TJsonReader wants an object or an array at the root, and the value may
+	// be a scalar, so wrap it in an array and take the single element back.
+	FString Wrapped;
+	Wrapped.Reserve(Len + 2);
+	Wrapped.AppendChar(TEXT('['));
+	Wrapped.Append(GetView().GetData(), Len);
+	Wrapped.AppendChar(TEXT(']'));
+
+	TSharedPtr<FJsonValue> Array;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Wrapped), Array)
+		|| !Array.IsValid() || Array->Type != EJson::Array || Array->AsArray().Num() != 1)
+	{
+		return nullptr;
+	}
+	return Array->AsArray()[0];
+}
+
+bool FJsonRpcLazyValue::TryGetString(FString& OutString) const
+{
+	if (!Source.IsValid())
+	{
+		return Value.IsValid() && Value->TryGetString(OutString);
+	}
+
+	const FStringView View = GetView();
+	if (View.Len() < 2 || View[0] != TEXT('"'))
+	{
+		return false;
+	}
+	int32 Backslash;
+	if (View.FindChar(TEXT('\\'), Backslash))
+	{
+		const auto Parsed = Materialize();
+		return Parsed.IsValid() && Parsed->TryGetString(OutString);
+	}
+	OutString = FString(View.Mid(1, View.Len() - 2));
+	return true;
+}
+
+bool FJsonRpcLazyValue::GetArrayElements(TArray<FJsonRpcLazyValue>& OutElements) const
+{
+	OutElements.Reset();
+	if (!Source.IsValid())
+	{
+		const TArray<TSharedPtr<FJsonValue>>* Array;
+		if (!Value.IsValid() || !Value->TryGetArray(Array))
+		{
+			return false;
+		}
+		for (const TSharedPtr<FJsonValue>& Element : *Array)
+		{
+			OutElements.Emplace(Element);
+		}
+		return true;
+	}
+
+	FEnvelopeScanner Scanner(*Source, Start, Len);
+	if (!Scanner.Expect(TEXT('[')))
+	{
+		return false;
+	}
+	if (Scanner.Expect(TEXT(']')))
+	{
+		return true;
+	}
+	const TSharedRef<const FString> SourceRef = Source.ToSharedRef();
+	while (true)
+	{
+		Scanner.SkipWhitespace();
+		const int32 ElementStart = Scanner.Pos;
+		if (!Scanner.SkipValue())
+		{
+			OutElements.Reset();
+			return false;
+		}
+		OutElements.Emplace(SourceRef, ElementStart, Scanner.Pos - ElementStart);
+
+		if (Scanner.Expect(TEXT(',')))
+		{
+			continue;
+		}
+		if (Scanner.Expect(TEXT(']')))
+		{
+			return true;
+		}
+		OutElements.Reset();
+		return false;
+	}
+}
+
+FJsonRpcLazyValue FJsonRpcLazyValue::GetField(const FStringView Name) const
+{
+	if (!Source.IsValid())
+	{
+		const TSharedPtr<FJsonObject>* Object;
+		if (!Value.IsValid() || !Value->TryGetObject(Object))
+		{
+			return FJsonRpcLazyValue();
+		}
+		return FJsonRpcLazyValue((*Object)->TryGetField(FString(Name)));
+	}
+
+	FEnvelopeScanner Scanner(*Source, Start, Len);
+	if (!Scanner.Expect(TEXT('{')) || Scanner.Expect(TEXT('}')))
+	{
+		return FJsonRpcLazyValue();
+	}
+	while (true)
+	{
+		Scanner.SkipWhitespace();
+		if (Scanner.Peek() != TEXT('"'))
+		{
+			return FJsonRpcLazyValue();
+		}
+		const int32 KeyStart = Scanner.Pos + 1;
+		if (!Scanner.SkipString())
+		{
+			return FJsonRpcLazyValue();
+		}
+		const FStringView Key(Scanner.Text + KeyStart, Scanner.Pos - KeyStart - 1);
+
+		if (!Scanner.Expect(TEXT(':')))
+		{
+			return FJsonRpcLazyValue();
+		}
+		Scanner.SkipWhitespace();
+		const int32 ValueStart = Scanner.Pos;
+		if (!Scanner.SkipValue())
+		{
+			return FJsonRpcLazyValue();
+		}
+		if (Key.Equals(Name, ESearchCase::IgnoreCase))
+		{
+			return FJsonRpcLazyValue(Source.ToSharedRef(), ValueStart, Scanner.Pos - ValueStart);
+		}
+
+		if (!Scanner.Expect(TEXT(',')))
+		{
+			return FJsonRpcLazyValue();
+		}
+	}
+}
+
+FString FJsonRpcLazyValue::ToString() const
+{
+	if (Source.IsValid())
+	{
+		return FString(GetView());
+	}
+	FString String;
+	if (Value.IsValid() && Value->TryGetString(String))
+	{
+		return String;
+	}
+	return TEXT("");
+}
+
+
+bool FJsonRpcEnvelope::Parse(const TSharedRef<const FString>& Source, FJsonRpcEnvelope& OutEnvelope)
+{
+	FEnvelopeScanner Scanner(*Source);
+
+	if (!Scanner.Expect(TEXT('{')))
+	{
+		return false;
+	}
+
+	Scanner.SkipWhitespace();
+	if (Scanner.Peek() == TEXT('}'))
+	{
+		Scanner.Pos++;
+	}
+	else
+	{
+		while (true)
+		{
+			Scanner.SkipWhitespace();
+			if (Scanner.Peek() != TEXT('"'))
+			{
+				return false;
+			}
+			const int32 KeyStart = Scanner.Pos + 1;
+			if (!Scanner.SkipString())
+			{
+				return false;
+			}
+			const FStringView Key(Scanner.Text + KeyStart, Scanner.Pos - KeyStart - 1);
+
+			if (!Scanner.Expect(TEXT(':')))
+			{
+				return false;
+			}
+			Scanner.SkipWhitespace();
+			const int32 ValueStart = Scanner.Pos;
+			if (!Scanner.SkipValue())
+			{
+				return false;
+			}
+			const FJsonRpcLazyValue Value(Source, ValueStart, Scanner.Pos - ValueStart);
+
+			if (Key == TEXTVIEW("method"))
+			{
+				const FStringView View = Value.GetView();
+				if (View.Len() < 2 || View[0] != TEXT('"'))
+				{
+					return false;
+				}
+				int32 Backslash;
+				if (View.FindChar(TEXT('\\'), Backslash))
+				{
+					// Rare enough that it's not worth unescaping by hand
+					const auto Parsed = Value.Materialize();
+					if (!Parsed.IsValid())
+					{
+						return false;
+					}
+					OutEnvelope.Method = Parsed->AsString();
+				}
+				else
+				{
+					OutEnvelope.Method = FString(View.Mid(1, View.Len() - 2));
+				}
+				OutEnvelope.bHasMethod = true;
+			}
+			else if (Key == TEXTVIEW("id"))
+			{
+				OutEnvelope.Id = Value;
+			}
+			else if (Key == TEXTVIEW("params"))
+			{
+				OutEnvelope.Params = Value;
+			}
+			else if (Key == TEXTVIEW("result"))
+			{
+				OutEnvelope.Result = Value;
+			}
+			else if (Key == TEXTVIEW("error"))
+			{
+				OutEnvelope.Error = Value;
+			}
+
+			Scanner.SkipWhitespace();
+			if (Scanner.Peek() == TEXT(','))
+			{
+				Scanner.Pos++;
+				continue;
+			}
+			if (Scanner.Peek() == TEXT('}'))
+			{
+				Scanner.Pos++;
+				break;
+			}
+			return false;
+		}
+	}
+
+	// Nothing but whitespace may follow the object
+	Scanner.SkipWhitespace();
+	return Scanner.AtEnd();
+}
+
+FJsonRpcEnvelope FJsonRpcEnvelope::FromObject(const TSharedPtr<FJsonObject>& Object)
+{
+	FJsonRpcEnvelope Envelope;
+	if (!Object.IsValid())
+	{
+		return Envelope;
+	}
+
+	Envelope.bHasMethod = Object->TryGetStringField(TEXT("method"), Envelope.Method);
+	Envelope.Id = FJsonRpcLazyValue(Object->TryGetField(TEXT("id")));
+	Envelope.Params = FJsonRpcLazyValue(Object->TryGetField(TEXT("params")));
+	Envelope.Result = FJsonRpcLazyValue(Object->TryGetField(TEXT("result")));
+	Envelope.Error = FJsonRpcLazyValue(Object->TryGetField(TEXT("error")));
+	return Envelope;
+}
+
+bool FJsonRpcEnvelope::GetCallId(uint32& OutId) const
+{
+	if (!Id.IsSet() || Id.IsNull())
+	{
+		return false;
+	}
+
+	if (!Id.HasView())
+	{
+		return FJsonRpcPendingTable::ParseId(Id.Materialize(), OutId);
+	}
+
+	FStringView View = Id.GetView();
+	if (View.Len() >= 2 && View[0] == TEXT('"'))
+	{
+		View = View.Mid(1, View.Len() - 2);
+	}
+	return ParseDigits(View, OutId);
+}
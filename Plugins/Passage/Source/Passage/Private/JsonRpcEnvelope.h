@@ -0,0 +1,41 @@
+// Copyright Enva Division
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonRpc.h"
+
+/**
+ * The fields of a single JSON-RPC message. Parse() scans the message text
+ * once, without building a DOM: it reads the method name and keeps "id",
+ * "params", "result" and "error" as lazy views into the text, so that
+ * large payloads are only parsed if and when somebody asks for them.
+ */
+struct FJsonRpcEnvelope
+{
+	/** Empty if the message has no "method" field */
+	FString Method;
+	bool bHasMethod = false;
+
+	FJsonRpcLazyValue Id;
+	FJsonRpcLazyValue Params;
+	FJsonRpcLazyValue Result;
+	FJsonRpcLazyValue Error;
+
+	/**
+	 * Scans a message that holds a single JSON object. Returns false for
+	 * anything else, including batches and malformed text, which the caller
+	 * should hand to the DOM parser to get the usual error handling.
+	 */
+	static bool Parse(const TSharedRef<const FString>& Source, FJsonRpcEnvelope& OutEnvelope);
+
+	/** Wraps a message that has already been parsed, e.g. a batch entry. */
+	static FJsonRpcEnvelope FromObject(const TSharedPtr<FJsonObject>& Object);
+
+	/**
+	 * Reads the "id" field as one of our call ids, without allocating when it
+	 * is backed by text. Returns false if it is absent, null, or not a
+	 * positive integer.
+	 */
+	bool GetCallId(uint32& OutId) const;
+};
@@ -0,0 +1,384 @@
+// Copyright Enva Division
+
+#include "JsonRpcMessagePack.h"
+
+#include "Dom/JsonObject.h"
+
+
+namespace
+{
+	/* Guards the decoder against maliciously deep nesting */
+	constexpr int32 MaxDepth = 128;
+
+	void WriteBigEndian(TArray<uint8>& Out, const uint64 Value, const int32 NumBytes)
+	{
+		for (int32 Shift = (NumBytes - 1) * 8; Shift >= 0; Shift -= 8)
+		{
+			Out.Add(StaticCast<uint8>(Value >> Shift));
+		}
+	}
+
+	/* Writes the header for a str, array or map of the given length. */
+	void WriteLength(TArray<uint8>& Out, const uint32 Length,
+		const uint8 FixBase, const uint32 FixMax, const uint8 Marker8, const uint8 Marker16, const uint8 Marker32)
+	{
+		if (Length <= FixMax)
+		{
+			Out.Add(FixBase | StaticCast<uint8>(Length));
+		}
+		else if (Marker8 != 0 && Length <= MAX_uint8)
+		{
+			Out.Add(Marker8);
+			WriteBigEndian(Out, Length, 1);
+		}
+		else if (Length <= MAX_uint16)
+		{
+			Out.Add(Marker16);
+			WriteBigEndian(Out, Length, 2);
+		}
+		else
+		{
+			Out.Add(Marker32);
+			WriteBigEndian(Out, Length, 4);
+		}
+	}
+
+	void WriteString(TArray<uint8>& Out, const FString& String)
+	{
+		const FTCHARToUTF8 Utf8(*String);
+		WriteLength(Out, Utf8.Length(), 0xa0, 31, 0xd9, 0xda, 0xdb);
+		Out.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+	}
+
+	void WriteNumber(TArray<uint8>& Out, const double Number)
+	{
+		// JSON has one number type, so integral values get the compact
+		// integer encodings and everything else is a float64.
+		if (Number == FMath::RoundToDouble(Number) && Number >= -9223372036854775808.0 && Number < 18446744073709551616.0)
+		{
+			if (Number >= 0)
+			{
+				const uint64 Value = StaticCast<uint64>(Number);
+				if (Value <= 0x7f)
+				{
+					Out.Add(StaticCast<uint8>(Value));
+				}
+				else if (Value <= MAX_uint8)
+				{
+					Out.Add(0xcc);
+					WriteBigEndian(Out, Value, 1);
+				}
+				else if (Value <= MAX_uint16)
+				{
+					Out.Add(0xcd);
+					WriteBigEndian(Out, Value, 2);
+				}
+				else if (Value <= MAX_uint32)
+				{
+					Out.Add(0xce);
+					WriteBigEndian(Out, Value, 4);
+				}
+				else
+				{
+					Out.Add(0xcf);
+					WriteBigEndian(Out, Value, 8);
+				}
+			}
+			else
+			{
+				const int64 Value = StaticCast<int64>(Number);
+				if (Value >= -32)
+				{
+					Out.Add(StaticCast<uint8>(Value));
+				}
+				else if (Value >= MIN_int8)
+				{
+					Out.Add(0xd0);
+					WriteBigEndian(Out, StaticCast<uint64>(Value), 1);
+				}
+				else if (Value >= MIN_int16)
+				{
+					Out.Add(0xd1);
+					WriteBigEndian(Out, StaticCast<uint64>(Value), 2);
+				}
+				else if (Value >= MIN_int32)
+				{
+					Out.Add(0xd2);
+					WriteBigEndian(Out, StaticCast<uint64>(Value), 4);
+				}
+				else
+				{
+					Out.Add(0xd3);
+					WriteBigEndian(Out, StaticCast<uint64>(Value), 8);
+				}
+			}
+			return;
+		}
+
+		uint64 Bits;
+		FMemory::Memcpy(&Bits, &Number, sizeof(Bits));
+		Out.Add(0xcb);
+		WriteBigEndian(Out, Bits, 8);
+	}
+
+	class FDecoder
+	{
+	public:
+		FDecoder(const uint8* InData, const int32 InSize)
+			: Data(InData), Size(InSize), Pos(0) {}
+
+		const uint8* const Data;
+		const int32 Size;
+		int32 Pos;
+
+		bool ReadBigEndian(const int32 NumBytes, uint64& OutValue)
+		{
+			if (Size - Pos < NumBytes)
+			{
+				return false;
+			}
+			OutValue = 0;
+			for (int32 Index = 0; Index < NumBytes; Index++)
+			{
+				OutValue = (OutValue << 8) | Data[Pos++];
+			}
+			return true;
+		}
+
+		TSharedPtr<FJsonValue> ReadString(const uint64 Length)
+		{
+			if (Length > StaticCast<uint64>(Size - Pos))
+			{
+				return nullptr;
+			}
+			const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data + Pos), StaticCast<int32>(Length));
+			Pos += StaticCast<int32>(Length);
+			return MakeShared<FJsonValueString>(FString(Converted.Length(), Converted.Get()));
+		}
+
+		TSharedPtr<FJsonValue> ReadArray(const uint64 Length, const int32 Depth)
+		{
+			// Every element takes at least a byte, which bounds the reserve
+			if (Length > StaticCast<uint64>(Size - Pos))
+			{
+				return nullptr;
+			}
+			TArray<TSharedPtr<FJsonValue>> Array;
+			Array.Reserve(StaticCast<int32>(Length));
+			for (uint64 Index = 0; Index < Length; Index++)
+			{
+				auto Element = Read(Depth + 1);
+				if (!Element.IsValid())
+				{
+					return nullptr;
+				}
+				Array.Add(Element);
+			}
+			return MakeShared<FJsonValueArray>(Array);
+		}
+
+		TSharedPtr<FJsonValue> ReadMap(const uint64 Length, const int32 Depth)
+		{
+			if (Length > StaticCast<uint64>(Size - Pos))
+			{
+				return nullptr;
+			}
+			auto Object = MakeShared<FJsonObject>();
+			for (uint64 Index = 0; Index < Length; Index++)
+			{
+				const auto Key = Read(Depth + 1);
+				FString KeyString;
+				if (!Key.IsValid() || Key->Type != EJson::String || !Key->TryGetString(KeyString))
+				{
+					return nullptr;
+				}
+				auto Value = Read(Depth + 1);
+				if (!Value.IsValid())
+				{
+					return nullptr;
+				}
+				Object->SetField(KeyString, Value);
+			}
+			return MakeShared<FJsonValueObject>(Object);
+		}
+
+		TSharedPtr<FJsonValue> Read(const int32 Depth)
+		{
+			if (Depth > MaxDepth || Pos >= Size)
+			{
+				return nullptr;
+			}
+
+			const uint8 Marker = Data[Pos++];
+			uint64 Value;
+
+			if (Marker <= 0x7f)
+			{
+				return MakeShared<FJsonValueNumber>(Marker);
+			}
+			if (Marker >= 0xe0)
+			{
+				return MakeShared<FJsonValueNumber>(StaticCast<int8>(Marker));
+			}
+			if ((Marker & 0xe0) == 0xa0)
+			{
+				return ReadString(Marker & 0x1f);
+			}
+			if ((Marker & 0xf0) == 0x90)
+			{
+				return ReadArray(Marker & 0x0f, Depth);
+			}
+			if ((Marker & 0xf0) == 0x80)
+			{
+				return ReadMap(Marker & 0x0f, Depth);
+			}
+
+			switch (Marker)
+			{
+			case 0xc0:
+				return MakeShared<FJsonValueNull>();
+			case 0xc2:
+				return MakeShared<FJsonValueBoolean>(false);
+			case 0xc3:
+				return MakeShared<FJsonValueBoolean>(true);
+
+			case 0xca:
+			{
+				if (!ReadBigEndian(4, Value))
+				{
+					return nullptr;
+				}
+				const uint32 Bits = StaticCast<uint32>(Value);
+				float Float;
+				FMemory::Memcpy(&Float, &Bits, sizeof(Float));
+				return MakeShared<FJsonValueNumber>(Float);
+			}
+			case 0xcb:
+			{
+				if (!ReadBigEndian(8, Value))
+				{
+					return nullptr;
+				}
+				double Double;
+				FMemory::Memcpy(&Double, &Value, sizeof(Double));
+				return MakeShared<FJsonValueNumber>(Double);
+			}
+
+			case 0xcc: case 0xcd: case 0xce: case 0xcf:
+				if (!ReadBigEndian(1 << (Marker - 0xcc), Value))
+				{
+					return nullptr;
+				}
+				return MakeShared<FJsonValueNumber>(StaticCast<double>(Value));
+
+			case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+			{
+				const int32 NumBytes = 1 << (Marker - 0xd0);
+				if (!ReadBigEndian(NumBytes, Value))
+				{
+					return nullptr;
+				}
+				// Sign extend from the top bit of the value that was read
+				const int32 Unused = 64 - NumBytes * 8;
+				const int64 Signed = StaticCast<int64>(Value << Unused) >> Unused;
+				return MakeShared<FJsonValueNumber>(StaticCast<double>(Signed));
+			}
+
+			case 0xd9: case 0xda: case 0xdb:
+				if (!ReadBigEndian(1 << (Marker - 0xd9), Value))
+				{
+					return nullptr;
+				}
+				return ReadString(Value);
+
+			case 0xdc: case 0xdd:
+				if (!ReadBigEndian(Marker == 0xdc ? 2 : 4, Value))
+				{
+					return nullptr;
+				}
+				return ReadArray(Value, Depth);
+
+			case 0xde: case 0xdf:
+				if (!ReadBigEndian(Marker == 0xde ? 2 : 4, Value))
+				{
+					return nullptr;
+				}
+				return ReadMap(Value, Depth);
+
+			default:
+				// bin, ext and the reserved marker have no JSON equivalent
+				return nullptr;
+			}
+		}
+	};
+}
+
+
+void FJsonRpcMessagePack::Encode(const TSharedPtr<FJsonValue>& Value, TArray<uint8>& OutBytes)
+{
+	if (!Value.IsValid())
+	{
+		OutBytes.Add(0xc0);
+		return;
+	}
+
+	switch (Value->Type)
+	{
+	case EJson::None:
+	case EJson::Null:
+		OutBytes.Add(0xc0);
+		break;
+
+	case EJson::Boolean:
+		OutBytes.Add(Value->AsBool() ? 0xc3 : 0xc2);
+		break;
+
+	case EJson::Number:
+		WriteNumber(OutBytes, Value->AsNumber());
+		break;
+
+	case EJson::String:
+		WriteString(OutBytes, Value->AsString());
+		break;
+
+	case EJson::Array:
+	{
+		const auto& Array = Value->AsArray();
+		WriteLength(OutBytes, Array.Num(), 0x90, 15, 0, 0xdc, 0xdd);
+		for (const auto& Element : Array)
+		{
+			Encode(Element, OutBytes);
+		}
+		break;
+	}
+
+	case EJson::Object:
+	{
+		const auto Object = Value->AsObject();
+		WriteLength(OutBytes, Object->Values.Num(), 0x80, 15, 0, 0xde, 0xdf);
+		for (const auto& Pair : Object->Values)
+		{
+			WriteString(OutBytes, Pair.Key);
+			Encode(Pair.Value, OutBytes);
+		}
+		break;
+	}
+	}
+}
+
+TSharedPtr<FJsonValue> FJsonRpcMessagePack::Decode(const uint8* Data, const int32 Size)
+{
+	FDecoder Decoder(Data, Size);
+	auto Value = Decoder.Read(0);
+	if (Decoder.Pos != Size)
+	{
+		return nullptr;
+	}
+	return Value;
+}
+
+bool FJsonRpcMessagePack::IsMessagePack(const uint8 FirstByte)
+{
+	// fixmap, fixarray, array 16/32 and map 16/32
+	return (FirstByte >= 0x80 && FirstByte <= 0x9f) || (FirstByte >= 0xdc && FirstByte <= 0xdf);
+}
@@ -0,0 +1,35 @@
+// Copyright Enva Division
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonValue.h"
+
+/**
+ * Converts between FJsonValue trees and MessagePack (https://msgpack.org),
+ * the binary encoding FJsonRpc can use in place of JSON text. Only the
+ * types that have a JSON equivalent are supported: nil, booleans, integers,
+ * floats, strings, arrays and maps with string keys.
+ */
+class FJsonRpcMessagePack
+{
+public:
+
+	/** Appends the encoding of Value to OutBytes. */
+	static void Encode(const TSharedPtr<FJsonValue>& Value, TArray<uint8>& OutBytes);
+
+	/**
+	 * Decodes a single value that spans exactly Size bytes. Returns nullptr
+	 * if the data is truncated, has trailing bytes, nests too deeply or uses
+	 * a type with no JSON equivalent.
+	 */
+	static TSharedPtr<FJsonValue> Decode(const uint8* Data, const int32 Size);
+
+	/**
+	 * Whether a message starting with this byte is MessagePack rather than
+	 * JSON text. JSON-RPC messages are always a map or an array, and none of
+	 * their MessagePack lead bytes are printable ASCII, so the first byte of
+	 * a frame is enough to tell the two apart.
+	 */
+	static bool IsMessagePack(const uint8 FirstByte);
+};
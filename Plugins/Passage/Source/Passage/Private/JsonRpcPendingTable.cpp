@@ -0,0 +1,167 @@
+// Copyright Enva Division
+
+#include "JsonRpcPendingTable.h"
+
+#include "Dom/JsonValue.h"
+
+
+FJsonRpcPendingTable::FJsonRpcPendingTable(const int32 ExpectedCalls)
+	: Counter(0), Count(0)
+{
+	const int32 PerShard = FMath::Max(ExpectedCalls / NumShards, 1);
+	for (FShard& Shard : Shards)
+	{
+		Shard.Calls.Reserve(PerShard);
+	}
+}
+
+FJsonRpcPendingTable::~FJsonRpcPendingTable()
+{
+	// Anyone still waiting would otherwise wait forever
+	ResolveAll(FJsonRpc::Error(Closed, TEXT("FJsonRpc was destroyed before a response was received")));
+}
+
+uint32 FJsonRpcPendingTable::NextId()
+{
+	uint32 Id;
+	do
+	{
+		Id = ++Counter;
+	} while (Id == 0);
+	return Id;
+}
+
+TSharedFuture<FJsonRpcResponse> FJsonRpcPendingTable::Add(const uint32 Id, const double Deadline,
+	const TSharedPtr<FJsonRpcCancellation>& Cancellation)
+{
+	FShard& Shard = GetShard(Id);
+	FScopeLock Lock(&Shard.Lock);
+	FEntry& Entry = Shard.Calls.Add(Id, FEntry {
+		TPromise<FJsonRpcResponse>(),
+		FPlatformTime::Seconds(),
+		Deadline,
+		Cancellation,
+	});
+	++Count;
+	return Entry.Promise.GetFuture().Share();
+}
+
+bool FJsonRpcPendingTable::Resolve(const uint32 Id, const FJsonRpcResponse& Response)
+{
+	// Resolve outside the lock, since a continuation on the future may well
+	// turn around and make another call.
+	TOptional<TPromise<FJsonRpcResponse>> Promise;
+	{
+		FShard& Shard = GetShard(Id);
+		FScopeLock Lock(&Shard.Lock);
+		FEntry* Entry = Shard.Calls.Find(Id);
+		if (Entry == nullptr)
+		{
+			return false;
+		}
+		Promise.Emplace(MoveTemp(Entry->Promise));
+		Shard.Calls.Remove(Id);
+		--Count;
+	}
+	Promise->SetValue(Response);
+	return true;
+}
+
+void FJsonRpcPendingTable::ResolveAll(const FJsonRpcResponse& Response)
+{
+	for (FShard& Shard : Shards)
+	{
+		TMap<uint32, FEntry> Unwound;
+		{
+			FScopeLock Lock(&Shard.Lock);
+			Unwound = MoveTemp(Shard.Calls);
+			Shard.Calls.Reset();
+			Count -= Unwound.Num();
+		}
+		for (auto& Pair : Unwound)
+		{
+			Pair.Value.Promise.SetValue(Response);
+		}
+	}
+}
+
+void FJsonRpcPendingTable::Expire(const double Now)
+{
+	if (Count == 0)
+	{
+		return;
+	}
+
+	for (FShard& Shard : Shards)
+	{
+		TArray<TPair<TPromise<FJsonRpcResponse>, FJsonRpcResponse>> Expired;
+		{
+			FScopeLock Lock(&Shard.Lock);
+			for (auto It = Shard.Calls.CreateIterator(); It; ++It)
+			{
+				FEntry& Entry = It.Value();
+				if (Entry.Cancellation.IsValid() && Entry.Cancellation->IsCancelled())
+				{
+					Expired.Emplace(MoveTemp(Entry.Promise), FJsonRpc::Error(Cancelled,
+						FString::Printf(TEXT("Call %u was cancelled"), It.Key())));
+					It.RemoveCurrent();
+				}
+				else if (Entry.Deadline > 0 && Now >= Entry.Deadline)
+				{
+					UE_LOG(LogJsonRpc, Warning, TEXT("FJsonRpcPendingTable::Expire() call %u timed out"), It.Key());
+					Expired.Emplace(MoveTemp(Entry.Promise), FJsonRpc::Error(TimedOut,
+						FString::Printf(TEXT("No response to call %u before the timeout"), It.Key())));
+					It.RemoveCurrent();
+				}
+			}
+			Count -= Expired.Num();
+		}
+
+		for (auto& Pair : Expired)
+		{
+			Pair.Key.SetValue(Pair.Value);
+		}
+	}
+}
+
+double FJsonRpcPendingTable::GetOldestStartTime() const
+{
+	double Oldest = 0;
+	for (const FShard& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard.Lock);
+		for (const auto& Pair : Shard.Calls)
+		{
+			if (Oldest == 0 || Pair.Value.StartTime < Oldest)
+			{
+				Oldest = Pair.Value.StartTime;
+			}
+		}
+	}
+	return Oldest;
+}
+
+bool FJsonRpcPendingTable::ParseId(const TSharedPtr<FJsonValue>& Value, uint32& OutId)
+{
+	if (!Value.IsValid())
+	{
+		return false;
+	}
+
+	if (double Number; Value->TryGetNumber(Number))
+	{
+		if (Number < 1 || Number > MAX_uint32 || Number != FMath::FloorToDouble(Number))
+		{
+			return false;
+		}
+		OutId = StaticCast<uint32>(Number);
+		return true;
+	}
+
+	if (FString String; Value->TryGetString(String))
+	{
+		return LexTryParseString(OutId, *String) && OutId != 0;
+	}
+
+	return false;
+}
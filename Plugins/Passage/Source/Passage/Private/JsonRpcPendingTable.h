@@ -0,0 +1,96 @@
+// Copyright Enva Division
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonRpc.h"
+
+/**
+ * The FJsonRpcPendingTable tracks the calls an FJsonRpc instance has sent
+ * and is still waiting on. Ids are plain integers handed out by NextId(), and
+ * the table is split into shards by the low bits of the id, each with its own
+ * lock and a map that is reserved up front. That way a reply arriving on the
+ * socket thread only contends with the handful of calls that share its shard,
+ * rather than with every Call() in flight.
+ *
+ * Entries must be added before the call is sent, so that a reply that comes
+ * back before Send() returns still finds its promise.
+ */
+class FJsonRpcPendingTable
+{
+public:
+
+	explicit FJsonRpcPendingTable(const int32 ExpectedCalls = 64);
+	~FJsonRpcPendingTable();
+
+	/** Hands out the next call id. Never returns zero. */
+	uint32 NextId();
+
+	/**
+	 * Registers a call and returns the future its reply will resolve.
+	 * @param Deadline FPlatformTime::Seconds() after which the call times out,
+	 * or zero for no deadline.
+	 */
+	TSharedFuture<FJsonRpcResponse> Add(const uint32 Id, const double Deadline,
+		const TSharedPtr<FJsonRpcCancellation>& Cancellation);
+
+	/**
+	 * Removes the call with the given id and resolves it with Response.
+	 * Returns false if there is no such call, e.g. it already timed out.
+	 */
+	bool Resolve(const uint32 Id, const FJsonRpcResponse& Response);
+
+	/** Removes every call and resolves each with Response. */
+	void ResolveAll(const FJsonRpcResponse& Response);
+
+	/**
+	 * Resolves the calls that are cancelled or whose deadline is at or before
+	 * Now, with Cancelled and TimedOut errors respectively.
+	 */
+	void Expire(const double Now);
+
+	/** The number of calls in the table. Doesn't take any locks. */
+	int32 Num() const { return Count; }
+
+	/**
+	 * The FPlatformTime::Seconds() at which the oldest call in the table was
+	 * added, or zero if the table is empty.
+	 */
+	double GetOldestStartTime() const;
+
+	/**
+	 * Reads a call id out of a reply's "id" value. Numeric ids, which is what
+	 * we send, are read without allocating. String ids holding a decimal
+	 * number are accepted as well for peers that stringify them.
+	 */
+	static bool ParseId(const TSharedPtr<FJsonValue>& Value, uint32& OutId);
+
+private:
+
+	struct FEntry {
+		TPromise<FJsonRpcResponse> Promise;
+
+		/** FPlatformTime::Seconds() when the call was added */
+		double StartTime;
+
+		/** FPlatformTime::Seconds() after which the call times out, or zero */
+		double Deadline;
+
+		TSharedPtr<FJsonRpcCancellation> Cancellation;
+	};
+
+	struct FShard {
+		mutable FCriticalSection Lock;
+		TMap<uint32, FEntry> Calls;
+	};
+
+	/** Must be a power of two */
+	static constexpr int32 NumShards = 16;
+
+	FShard Shards[NumShards];
+
+	TAtomic<uint32> Counter;
+	TAtomic<int32> Count;
+
+	FShard& GetShard(const uint32 Id) { return Shards[Id & (NumShards - 1)]; }
+};
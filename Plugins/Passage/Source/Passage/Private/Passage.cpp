@@ -1,6 +1,7 @@
 // Copyright Enva Division
 
 #include "Passage.h"
+#include "JsonRpc.h"
 #include "Kismet/GameplayStatics.h"
 
 #define LOCTEXT_NAMESPACE "FPassageModule"
@@ -16,6 +17,7 @@ void FPassageModule::StartupModule()
 void FPassageModule::ShutdownModule()
 {
 	UE_LOG(LogPassage, Verbose, TEXT("FPassageModule::StartupModule()"));
+	FJsonRpc::ShutdownDispatchPool();
 }
 
 
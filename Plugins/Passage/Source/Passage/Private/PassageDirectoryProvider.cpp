@@ -107,13 +107,13 @@ FJsonRpcResponse UPassageDirectoryProvider::Joined(const TSharedPtr<FJsonObject>
     return { false, Result, nullptr };
 }
 
-FJsonRpcResponse UPassageDirectoryProvider::AddParticipants(const TArray< TSharedPtr<FJsonValue> > Data)
+FJsonRpcResponse UPassageDirectoryProvider::AddParticipants(const TArray<FJsonRpcLazyValue>& Data)
 {
 	UE_LOG(LogPassageDirectoryProvider, Verbose, TEXT("UPassageDirectoryProvider::AddParticipants()"));
-    for(const auto Value : Data)
+    for(const auto& Item : Data)
     {
-        
-        if(Value->Type == EJson::Object)
+        const auto Value = Item.Materialize();
+        if(Value.IsValid() && Value->Type == EJson::Object)
         {
             const TSharedPtr<FJsonObject> Object = Value->AsObject();
             const auto Id = Object->GetStringField("id");
@@ -132,12 +132,12 @@ FJsonRpcResponse UPassageDirectoryProvider::AddParticipants(const TArray< TShare
     return { false, Result, nullptr };
 }
 
-FJsonRpcResponse UPassageDirectoryProvider::RemoveParticipants(TArray< TSharedPtr<FJsonValue> > Data)
+FJsonRpcResponse UPassageDirectoryProvider::RemoveParticipants(const TArray<FJsonRpcLazyValue>& Data)
 {
     TArray<FString> IdsNotFound;
-    for(const auto Item : Data)
+    for(const auto& Item : Data)
     {
-        if(const auto Id = Item->AsString(); ParticipantsById.Contains(Id))
+        if(FString Id; Item.TryGetString(Id) && ParticipantsById.Contains(Id))
         {
             const auto Participant = ParticipantsById[Id];
             ParticipantsById.Remove(Id);
@@ -162,17 +162,17 @@ FJsonRpcResponse UPassageDirectoryProvider::RemoveParticipants(TArray< TSharedPt
 }
 
 FJsonRpcResponse UPassageDirectoryProvider::UpdateParticipants(
-    TArray< TSharedPtr<FJsonValue> > ParticipantObjects)
+    const TArray<FJsonRpcLazyValue>& ParticipantObjects)
 {
     TArray<FString> IdsNotFound;
-    for(const auto Item : ParticipantObjects)
+    for(const auto& Item : ParticipantObjects)
     {
-
-        if (const auto Id = Item->AsObject()->GetStringField("Id"); ParticipantsById.Contains(Id))
+        // Only the participants we know about are worth parsing
+        if (FString Id; Item.GetField(TEXT("id")).TryGetString(Id) && ParticipantsById.Contains(Id))
         {
-            if (Item->Type == EJson::Object)
+            if (const auto Value = Item.Materialize(); Value.IsValid() && Value->Type == EJson::Object)
             {
-                const auto Object = Item->AsObject();
+                const auto Object = Value->AsObject();
                 const auto Participant = ParticipantsById[Id];
 
                 UpdateParticipant(Participant, Object);
@@ -246,40 +246,64 @@ TSharedFuture<FJsonRpcResponse> UPassageDirectoryProvider::FRpcHandler::Handle(
 {
     UE_LOG(LogPassageDirectoryProvider, Verbose, TEXT("UPassageDirectoryProvider::FRpcHandler::Handle()"));
 
-    // In our case all our implementations are synchronous, so these promises
+    // In our case all our implementations are synchronous, so this promise
     // will be resolved immediately.
     TPromise<FJsonRpcResponse> Promise;
+    HandleLazy(Method, FJsonRpcLazyValue(Params), [&Promise](const FJsonRpcResponse& Response)
+    {
+        Promise.SetValue(Response);
+    });
+    return Promise.GetFuture().Share();
+}
+
+bool UPassageDirectoryProvider::FRpcHandler::HandleLazy(
+    FString Method, const FJsonRpcLazyValue& Params, const FJsonRpcRespond& Respond)
+{
+    UE_LOG(LogPassageDirectoryProvider, Verbose, TEXT("UPassageDirectoryProvider::FRpcHandler::HandleLazy()"));
+
+    if (!IsValid(Parent)) {
+        Respond(FJsonRpc::Error(InternalError,
+            TEXT("UPassageDirectoryProvider pointer invalid")));
+        return true;
+    }
+
+    // Every method takes an array, whose elements are parsed as they're used
+    TArray<FJsonRpcLazyValue> Items;
+    const bool bIsArray = Params.GetArrayElements(Items);
 
-    if (IsValid(Parent)) {
-        if( Method == TEXT("Joined"))
+    if( Method == TEXT("Joined"))
+    {
+        const auto Object = bIsArray && Items.Num() == 1 ? Items[0].Materialize() : nullptr;
+        if (Object.IsValid() && Object->Type == EJson::Object) {
+            Respond(Parent->Joined(Object->AsObject()));
+        } else
         {
-            if (const auto Array = Params->AsArray(); Array.Num() == 1) {
-                Promise.SetValue(Parent->Joined(Array[0]->AsObject()));
-            } else
-            {
-				Promise.SetValue(
-                    FJsonRpc::Error(InvalidParams,
-                    TEXT("Expected a single Participant object")));
-            }
+			Respond(
+                FJsonRpc::Error(InvalidParams,
+                TEXT("Expected a single Participant object")));
+        }
+    }
+    else if (Method == TEXT("AddParticipants")
+        || Method == TEXT("RemoveParticipants")
+        || Method == TEXT("UpdateParticipants"))
+    {
+        if (!bIsArray) {
+            Respond(FJsonRpc::Error(InvalidParams, TEXT("Expected an array")));
         }
         else if (Method == TEXT("AddParticipants")) {
-            Promise.SetValue(Parent->AddParticipants(Params->AsArray()));
+            Respond(Parent->AddParticipants(Items));
         }
         else if (Method == TEXT("RemoveParticipants")) {
-            Promise.SetValue(Parent->RemoveParticipants(Params->AsArray()));
-        }
-        else if (Method == TEXT("UpdateParticipants")) {
-            Promise.SetValue(Parent->UpdateParticipants(Params->AsArray()));
+            Respond(Parent->RemoveParticipants(Items));
         }
         else {
-            Promise.SetValue(FJsonRpc::Error(MethodNotFound,
-                TEXT("No method named '") + Method + TEXT("'")));
+            Respond(Parent->UpdateParticipants(Items));
         }
     }
     else {
-        Promise.SetValue(FJsonRpc::Error(InternalError,
-            TEXT("UPassageDirectoryProvider pointer invalid")));
+        Respond(FJsonRpc::Error(MethodNotFound,
+            TEXT("No method named '") + Method + TEXT("'")));
     }
 
-    return Promise.GetFuture().Share();
+    return true;
 }
\ No newline at end of file
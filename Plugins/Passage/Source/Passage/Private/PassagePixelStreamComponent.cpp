@@ -90,7 +90,7 @@ void UPassagePixelStreamComponent::OnInputEvent(const FString& Descriptor)
 		{
 			if (FString Data; MsgObject->TryGetStringField("data", Data))
 			{
-				PixelStreamChannel->OnMessage.Broadcast(Data);
+				PixelStreamChannel->BroadcastMessage(MoveTemp(Data));
 			}
 			else
 			{
@@ -183,6 +183,122 @@ void UPassageUtils::UpdateVideoTexture(UTexture2D* VideoTexture, uint8* ImgData,
 	);
 }
 
+void UPassageUtils::UpdateVideoTexture(UTexture2D* VideoTexture, const uint8* ImgData,
+	const uint32 Width, const uint32 Height, TFunction<void()> OnUpdated)
+{
+	const auto Regions =
+		new FUpdateTextureRegion2D(0, 0, 0, 0, Width, Height);
+
+	VideoTexture->UpdateTextureRegions(
+		0,
+		1,
+		Regions,
+		Width * 4u,
+		4u,
+		const_cast<uint8*>(ImgData), // only read, despite the signature
+		[OnUpdated = MoveTemp(OnUpdated)](const uint8* ImgData, const FUpdateTextureRegion2D* Regions)
+		{
+			delete Regions;
+			OnUpdated();
+		}
+	);
+}
+
+UTexture2D* UPassageUtils::CreateI420VideoTexture(const uint32 Width, const uint32 Height)
+{
+	const uint32 LumaLength = Width * Height;
+	const uint32 ImgDataLength = LumaLength * 3 / 2;
+
+	const auto Texture2D = UTexture2D::CreateTransient(
+		Width, Height * 3 / 2, PF_G8);
+	// The material does the conversion, so it needs the raw values, and
+	// filtering would blend the U and V halves of a row at their seam
+	Texture2D->SRGB = false;
+	Texture2D->Filter = TF_Nearest;
+	Texture2D->UpdateResource();
+
+	// Black is Y = 16 with neutral chroma
+	uint8* ImgData = new uint8[ImgDataLength];
+	FMemory::Memset(ImgData, 16, LumaLength);
+	FMemory::Memset(ImgData + LumaLength, 128, ImgDataLength - LumaLength);
+
+	UpdateI420VideoTexture(Texture2D, ImgData, Width, Height, [ImgData]()
+		{
+			delete[] ImgData;
+		});
+
+	return Texture2D;
+}
+
+void UPassageUtils::UpdateI420VideoTexture(UTexture2D* VideoTexture, const uint8* ImgData,
+	const uint32 Width, const uint32 Height, TFunction<void()> OnUpdated)
+{
+	const auto Regions =
+		new FUpdateTextureRegion2D(0, 0, 0, 0, Width, Height * 3 / 2);
+
+	VideoTexture->UpdateTextureRegions(
+		0,
+		1,
+		Regions,
+		Width, // one byte per texel
+		1u,
+		const_cast<uint8*>(ImgData), // only read, despite the signature
+		[OnUpdated = MoveTemp(OnUpdated)](const uint8* ImgData, const FUpdateTextureRegion2D* Regions)
+		{
+			delete Regions;
+			OnUpdated();
+		}
+	);
+}
+
+void UPassageUtils::PackI420(const uint8* DataY, const int32 StrideY,
+	const uint8* DataU, const int32 StrideU,
+	const uint8* DataV, const int32 StrideV,
+	const uint32 Width, const uint32 Height, uint8* Dest)
+{
+	// Plain row copies, which Memcpy already vectorizes
+	for (uint32 Row = 0; Row < Height; ++Row)
+	{
+		FMemory::Memcpy(Dest, DataY + Row * StrideY, Width);
+		Dest += Width;
+	}
+
+	const uint32 ChromaWidth = Width / 2;
+	for (uint32 Row = 0; Row < Height / 2; ++Row)
+	{
+		FMemory::Memcpy(Dest, DataU + Row * StrideU, ChromaWidth);
+		FMemory::Memcpy(Dest + ChromaWidth, DataV + Row * StrideV, ChromaWidth);
+		Dest += Width;
+	}
+}
+
+void UPassageUtils::ConvertI420ToBGRA(const uint8* DataY, const int32 StrideY,
+	const uint8* DataU, const int32 StrideU,
+	const uint8* DataV, const int32 StrideV,
+	const uint32 Width, const uint32 Height, uint8* Dest)
+{
+	// The same BT.601 limited range conversion as the I420 material, in 8.8
+	// fixed point. Odd sizes round the chroma planes up, so the last column
+	// and row share the chroma sample before them.
+	for (uint32 Row = 0; Row < Height; ++Row)
+	{
+		const uint8* RowY = DataY + Row * StrideY;
+		const uint8* RowU = DataU + (Row / 2) * StrideU;
+		const uint8* RowV = DataV + (Row / 2) * StrideV;
+		for (uint32 Column = 0; Column < Width; ++Column)
+		{
+			const int32 Y = 298 * (RowY[Column] - 16);
+			const int32 U = RowU[Column / 2] - 128;
+			const int32 V = RowV[Column / 2] - 128;
+			Dest[0] = (uint8)FMath::Clamp((Y + 516 * U + 128) >> 8, 0, 255);
+			Dest[1] = (uint8)FMath::Clamp((Y - 100 * U - 208 * V + 128) >> 8, 0, 255);
+			Dest[2] = (uint8)FMath::Clamp((Y + 409 * V + 128) >> 8, 0, 255);
+			Dest[3] = 255;
+			Dest += 4;
+		}
+	}
+}
+
 bool UPassageUtils::WriteArrayToFile(const TArray<uint8>& Bytes, const FString& FilePath)
 {
 	return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
@@ -0,0 +1,158 @@
+#include "AudioJitterBuffer.h"
+#include "CoreMinimal.h"
+
+BEGIN_DEFINE_SPEC(FAudioJitterBufferSpec, "Passage.AudioJitterBuffer",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+
+	// Agora pushes 10 ms chunks and the mixer pulls 1024 samples at a time
+	static constexpr int32 SampleRate = 48000;
+	static constexpr int32 ChunkSize = 480;
+	static constexpr int32 PopSize = 1024;
+
+	/**
+	 * Plays ProducerRate samples per second of a ramp into Buffer against a
+	 * SampleRate consumer for Seconds, and returns the deepest the buffer got
+	 * after it first started playing.
+	 */
+	static int32 Simulate(FAudioJitterBuffer& Buffer, const int32 ProducerRate, const int32 Seconds)
+	{
+		TArray<int16> Chunk;
+		Chunk.SetNumUninitialized(ChunkSize);
+		TArray<int16> Out;
+		Out.SetNumUninitialized(PopSize);
+
+		int64 Produced = 0;
+		int64 Consumed = 0;
+		int16 Next = 0;
+		int32 MaxDepth = 0;
+
+		// Step through time in producer chunks and pop whenever the consumer
+		// is due, so the two sides drift apart just as mismatched clocks do.
+		const int64 TotalSamples = (int64)SampleRate * Seconds;
+		while (Consumed < TotalSamples)
+		{
+			if (Produced * SampleRate <= Consumed * ProducerRate)
+			{
+				for (int16& Sample : Chunk)
+				{
+					Sample = Next++;
+				}
+				Buffer.Push(Chunk.GetData(), ChunkSize);
+				Produced += ChunkSize;
+			}
+			else
+			{
+				Buffer.Pop(Out.GetData(), PopSize);
+				Consumed += PopSize;
+				MaxDepth = FMath::Max(MaxDepth, Buffer.GetStats().DepthSamples);
+			}
+		}
+		return MaxDepth;
+	}
+
+END_DEFINE_SPEC(FAudioJitterBufferSpec)
+void FAudioJitterBufferSpec::Define()
+{
+	Describe("Pop()", [this]()
+		{
+			It("should play nothing until the target depth is reached", [this]()
+				{
+					FAudioJitterBuffer Buffer(SampleRate, 20, 100);
+
+					TArray<int16> In;
+					In.Init(1000, ChunkSize);
+					Buffer.Push(In.GetData(), ChunkSize);
+
+					TArray<int16> Out;
+					Out.Init(-1, ChunkSize);
+					Buffer.Pop(Out.GetData(), ChunkSize);
+					TestEqual("Out[0] while priming", Out[0], (int16)0);
+					TestEqual("DepthSamples", Buffer.GetStats().DepthSamples, ChunkSize);
+
+					Buffer.Push(In.GetData(), ChunkSize);
+					Buffer.Pop(Out.GetData(), ChunkSize);
+					TestEqual("Out[0] once primed", Out[0], (int16)1000);
+					TestEqual("Underruns", Buffer.GetStats().Underruns, 0u);
+				});
+
+			It("should fade out and count an underrun when it runs dry", [this]()
+				{
+					FAudioJitterBuffer Buffer(SampleRate, 10, 100);
+
+					TArray<int16> In;
+					In.Init(1000, ChunkSize);
+					Buffer.Push(In.GetData(), ChunkSize);
+
+					TArray<int16> Out;
+					Out.Init(-1, ChunkSize * 2);
+					Buffer.Pop(Out.GetData(), ChunkSize * 2);
+
+					const FAudioJitterBufferStats Stats = Buffer.GetStats();
+					TestEqual("Underruns", Stats.Underruns, 1u);
+					TestEqual("ConcealedSamples", Stats.ConcealedSamples, (uint64)ChunkSize);
+					TestEqual("Last real sample", Out[ChunkSize - 1], (int16)1000);
+					TestTrue("Fading", Out[ChunkSize] > 0 && Out[ChunkSize] < 1000);
+					TestEqual("Silent after the fade", Out[ChunkSize * 2 - 1], (int16)0);
+				});
+		});
+
+	Describe("Push()", [this]()
+		{
+			It("should drop the oldest samples past the maximum depth", [this]()
+				{
+					FAudioJitterBuffer Buffer(SampleRate, 10, 20);
+					TestEqual("GetCapacity()", Buffer.GetCapacity(), 960);
+
+					TArray<int16> In;
+					In.SetNumUninitialized(ChunkSize);
+					for (int16 Chunk = 0; Chunk < 3; ++Chunk)
+					{
+						for (int16& Sample : In)
+						{
+							Sample = Chunk;
+						}
+						Buffer.Push(In.GetData(), ChunkSize);
+					}
+
+					const FAudioJitterBufferStats Stats = Buffer.GetStats();
+					TestEqual("DepthSamples", Stats.DepthSamples, 960);
+					TestEqual("DroppedSamples", Stats.DroppedSamples, (uint64)ChunkSize);
+
+					TArray<int16> Out;
+					Out.SetNumUninitialized(ChunkSize);
+					Buffer.Pop(Out.GetData(), ChunkSize);
+					TestEqual("Oldest remaining chunk", Out[0], (int16)1);
+				});
+		});
+
+	Describe("with skewed clocks", [this]()
+		{
+			It("should stay near the target when the producer runs fast", [this]()
+				{
+					FAudioJitterBuffer Buffer(SampleRate);
+
+					// 1% fast, for ten minutes, would be six seconds of delay
+					// with an unbounded queue.
+					const int32 MaxDepth = Simulate(Buffer, SampleRate * 101 / 100, 600);
+					const FAudioJitterBufferStats Stats = Buffer.GetStats();
+
+					TestTrue("Depth bounded near the target",
+						MaxDepth <= Buffer.GetTargetSamples() + PopSize + ChunkSize);
+					TestTrue("Caught up by stretching", Stats.StretchedSamples > 0);
+					TestEqual("DroppedSamples", Stats.DroppedSamples, (uint64)0);
+					TestEqual("Underruns", Stats.Underruns, 0u);
+				});
+
+			It("should conceal rather than stall when the producer runs slow", [this]()
+				{
+					FAudioJitterBuffer Buffer(SampleRate);
+
+					const int32 MaxDepth = Simulate(Buffer, SampleRate * 99 / 100, 600);
+					const FAudioJitterBufferStats Stats = Buffer.GetStats();
+
+					TestTrue("Depth bounded", MaxDepth <= Buffer.GetCapacity());
+					TestTrue("Underruns", Stats.Underruns > 0);
+					TestTrue("ConcealedSamples", Stats.ConcealedSamples > 0);
+				});
+		});
+}
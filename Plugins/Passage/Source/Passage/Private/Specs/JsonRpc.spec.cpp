@@ -1,5 +1,6 @@
 #include "JsonRpc.h"
 #include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
 
 BEGIN_DEFINE_SPEC(FJsonRpcSpec, "Passage.JsonRpc",
 	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
@@ -23,6 +24,86 @@ public:
 	}
 };
 
+// Resolves its promise later, from another thread, so the FJsonRpc instance
+// has to poll the future and respond on its dispatch executor.
+class FDeferredEchoHandler final : public FJsonRpcHandler
+{
+public:
+	virtual TSharedFuture<FJsonRpcResponse> Handle(
+		FString Method, TSharedPtr<FJsonValue> Params) override
+	{
+		const auto Promise = MakeShared<TPromise<FJsonRpcResponse>>();
+		auto Future = Promise->GetFuture().Share();
+
+		Async(EAsyncExecution::ThreadPool, [Promise, Params]()
+			{
+				FPlatformProcess::Sleep(0.01f);
+				Promise->SetValue({ false, Params, nullptr });
+			});
+
+		return Future;
+	}
+};
+
+// Doesn't resolve its promise until it goes away, so the call can only end
+// with a timeout.
+class FStuckHandler final : public FJsonRpcHandler
+{
+public:
+	virtual ~FStuckHandler() override
+	{
+		// Broken promises trip an assertion
+		Promise.SetValue(FJsonRpc::Error(Closed, TEXT("Handler destroyed")));
+	}
+
+	virtual TSharedFuture<FJsonRpcResponse> Handle(
+		FString Method, TSharedPtr<FJsonValue> Params) override
+	{
+		return Promise.GetFuture().Share();
+	}
+
+private:
+	TPromise<FJsonRpcResponse> Promise;
+};
+
+// Answers through the continuation-style HandleAsync() instead of a future.
+class FCallbackEchoHandler final : public FJsonRpcHandler
+{
+public:
+	virtual TSharedFuture<FJsonRpcResponse> Handle(
+		FString Method, TSharedPtr<FJsonValue> Params) override
+	{
+		TPromise<FJsonRpcResponse> Promise;
+		Promise.SetValue(FJsonRpc::Error(InternalError, TEXT("Handle() should not be called")));
+		return Promise.GetFuture().Share();
+	}
+
+	virtual bool HandleAsync(
+		FString Method, TSharedPtr<FJsonValue> Params, const FJsonRpcRespond& Respond) override
+	{
+		Async(EAsyncExecution::ThreadPool, [Respond, Params]()
+			{
+				Respond({ false, Params, nullptr });
+			});
+		return true;
+	}
+};
+
+// Records what FJsonRpc sends, to check that it encodes UTF-8 itself when
+// the channel asks for it.
+class FUtf8Channel final : public FJsonRpcChannel
+{
+public:
+	virtual void Send(const FString& Message) override { Sent.Add(Message); }
+	virtual void Close(const int32 Code, const FString& Reason) override {}
+
+	virtual bool PrefersUtf8() const override { return true; }
+	virtual void SendUtf8(const TArray<uint8>& Message) override { SentUtf8.Add(Message); }
+
+	TArray<FString> Sent;
+	TArray<TArray<uint8>> SentUtf8;
+};
+
 TSharedPtr<FJsonRpc> NotifyLocal;
 TSharedPtr<FJsonRpc> NotifyRemote;
 
@@ -156,6 +237,170 @@ void FJsonRpcSpec::Define()
 					}
 				});
 
+			It("should round-trip calls over MessagePack", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					for (const EJsonRpcEncoding Encoding : { EJsonRpcEncoding::MessagePack, EJsonRpcEncoding::MatchPeer })
+					{
+						const auto Pair = FJsonRpcPairedChannel::Create(Encoding);
+						const auto Remote = MakeShared<FJsonRpc>(Pair.Remote, MakeShared<FEchoHandler>());
+						const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+
+						const auto Reader = TJsonReaderFactory<>::Create(
+							TEXT(R"({"a": "b", "n": [1, -2, 3.5, true, null]})"));
+						TSharedPtr<FJsonValue> Value;
+						FJsonSerializer::Deserialize(Reader, Value);
+
+						// With MatchPeer the call goes out as JSON, and the
+						// reply is JSON too because neither end has seen
+						// MessagePack yet.
+						const auto Future = Local->Call("anything", Value);
+						if (Future.WaitFor({ 0,0,1 }))
+						{
+							const auto Response = Future.Get();
+							TestFalse("Response.IsError", Response.IsError);
+							const auto Result = Response.Result->AsObject();
+							TestEqual("a", Result->GetStringField("a"), TEXT("b"));
+							const auto& N = Result->GetArrayField("n");
+							TestEqual("N.Num()", N.Num(), 5);
+							TestEqual("N[1]", N[1]->AsNumber(), -2.0);
+							TestEqual("N[2]", N[2]->AsNumber(), 3.5);
+							TestTrue("N[3]", N[3]->AsBool());
+							TestTrue("N[4]", N[4]->IsNull());
+						}
+						else
+						{
+							TestFalse("Wait timed out", true);
+						}
+						TestEqual("Local encoding", Pair.Local->GetEncoding(),
+							Encoding == EJsonRpcEncoding::MatchPeer ? EJsonRpcEncoding::Json : EJsonRpcEncoding::MessagePack);
+					}
+				});
+
+			It("should answer deferred results on each dispatch executor", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					for (const auto Dispatch : { EJsonRpcDispatch::WorkerPool,
+						EJsonRpcDispatch::TaskGraph, EJsonRpcDispatch::Thread })
+					{
+						const auto Pair = FJsonRpcPairedChannel::Create();
+						const auto Remote = MakeShared<FJsonRpc>(Pair.Remote,
+							MakeShared<FDeferredEchoHandler>(), Dispatch);
+						const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+
+						const auto Future = Local->Call("anything", MakeShared<FJsonValueNumber>(7));
+
+						// Drive the polling ourselves rather than count on the ticker
+						const double Deadline = FPlatformTime::Seconds() + 1;
+						while (!Future.WaitFor(FTimespan::FromMilliseconds(10))
+							&& FPlatformTime::Seconds() < Deadline)
+						{
+							Remote->PollHandlers();
+						}
+						if (Future.IsReady())
+						{
+							const auto Response = Future.Get();
+							TestFalse("Response.IsError", Response.IsError);
+							const int32 Number = Response.Result->AsNumber();
+							TestEqual("Result->AsNumber()", 7, Number);
+						}
+						else
+						{
+							TestFalse("Wait timed out", true);
+						}
+					}
+				});
+
+			It("should answer with an error when the handler never resolves", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					const auto Pair = FJsonRpcPairedChannel::Create();
+					const auto Remote = MakeShared<FJsonRpc>(Pair.Remote, MakeShared<FStuckHandler>());
+					const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+					Remote->SetHandlerTimeout(FTimespan::FromMilliseconds(50));
+
+					const auto Future = Local->Call("anything", MakeShared<FJsonValueNull>());
+					const double Deadline = FPlatformTime::Seconds() + 1;
+					while (!Future.WaitFor(FTimespan::FromMilliseconds(10))
+						&& FPlatformTime::Seconds() < Deadline)
+					{
+						Remote->PollHandlers();
+					}
+
+					if (Future.IsReady())
+					{
+						const auto Response = Future.Get();
+						TestTrue("Response.IsError", Response.IsError);
+						const int32 Code = Response.Error->GetNumberField("code");
+						TestEqual("code", Code, StaticCast<int32>(TimedOut));
+					}
+					else
+					{
+						TestFalse("Wait timed out", true);
+					}
+				});
+
+			It("should not lose replies under concurrent calls", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					const auto Pair = FJsonRpcPairedChannel::Create();
+					const auto Remote = MakeShared<FJsonRpc>(Pair.Remote, MakeShared<FEchoHandler>());
+					const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+
+					constexpr int32 NumCallers = 8;
+					constexpr int32 CallsPerCaller = 250;
+					TArray<TSharedFuture<FJsonRpcResponse>> Futures;
+					Futures.SetNum(NumCallers * CallsPerCaller);
+
+					const double Start = FPlatformTime::Seconds();
+					ParallelFor(NumCallers, [&Futures, Local](const int32 Caller)
+						{
+							for (int32 Call = 0; Call < CallsPerCaller; Call++)
+							{
+								const int32 Index = Caller * CallsPerCaller + Call;
+								Futures[Index] = Local->Call("anything", MakeShared<FJsonValueNumber>(Index));
+							}
+						});
+
+					int32 Lost = 0;
+					for (int32 Index = 0; Index < Futures.Num(); Index++)
+					{
+						if (!Futures[Index].WaitFor({ 0,0,10 }))
+						{
+							Lost++;
+							continue;
+						}
+						const int32 Number = Futures[Index].Get().Result->AsNumber();
+						TestEqual("Result->AsNumber()", Number, Index);
+					}
+					const double Elapsed = FPlatformTime::Seconds() - Start;
+
+					TestEqual("Lost replies", Lost, 0);
+					TestEqual("GetPendingCount()", Local->GetPendingCount(), 0);
+					AddInfo(FString::Printf(TEXT("%d calls in %.3f s (%.0f calls/s)"),
+						Futures.Num(), Elapsed, Futures.Num() / Elapsed));
+				});
+
+			It("should respond through HandleAsync", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					const auto Pair = FJsonRpcPairedChannel::Create();
+					const auto Remote = MakeShared<FJsonRpc>(Pair.Remote, MakeShared<FCallbackEchoHandler>());
+					const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+
+					const auto Future = Local->Call("anything", MakeShared<FJsonValueBoolean>(true));
+					if (Future.WaitFor({ 0,0,1 }))
+					{
+						const auto Response = Future.Get();
+						TestFalse("Response.IsError", Response.IsError);
+						TestTrue("Result->AsBool()", Response.Result->AsBool());
+					}
+					else
+					{
+						TestFalse("Wait timed out", true);
+					}
+				});
+
 			LatentIt("should notify delegate", {0,0,5},
 				[this](const FDoneDelegate& Done)
 				{
@@ -177,6 +422,165 @@ void FJsonRpcSpec::Define()
 					NotifyRemote->Notify("methodName", MakeShared<FJsonValueBoolean>(true));
 				});
 
+			It("should resolve with the error reply", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					const auto Pair = FJsonRpcPairedChannel::Create();
+					const auto Remote = MakeShared<FJsonRpc>(Pair.Remote, MakeShared<FJsonRpcEmptyHandler>());
+					const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+
+					const auto Future = Local->Call("missing", MakeShared<FJsonValueNull>());
+					if (Future.WaitFor({ 0,0,1 }))
+					{
+						const auto Response = Future.Get();
+						TestTrue("Response.IsError", Response.IsError);
+						const int32 Code = Response.Error->GetNumberField("code");
+						TestEqual("code", Code, StaticCast<int32>(MethodNotFound));
+						TestEqual("GetPendingCount()", Local->GetPendingCount(), 0);
+					}
+					else
+					{
+						TestFalse("Wait timed out", true);
+					}
+				});
+
+			It("should time out when the remote never answers", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					// No remote FJsonRpc, so nothing ever answers
+					const auto Pair = FJsonRpcPairedChannel::Create();
+					const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+
+					const auto Future = Local->Call("anything", MakeShared<FJsonValueNull>(),
+						FTimespan::FromMilliseconds(50));
+					const auto Forever = Local->Call("anything", MakeShared<FJsonValueNull>());
+					TestEqual("GetPendingCount()", Local->GetPendingCount(), 2);
+
+					FPlatformProcess::Sleep(0.1f);
+					TestTrue("GetOldestPendingAge()",
+						Local->GetOldestPendingAge() >= FTimespan::FromMilliseconds(100));
+					Local->ExpirePending();
+
+					TestTrue("Future.IsReady()", Future.IsReady());
+					if (Future.IsReady())
+					{
+						const int32 Code = Future.Get().Error->GetNumberField("code");
+						TestEqual("code", Code, StaticCast<int32>(TimedOut));
+					}
+					TestFalse("Forever.IsReady()", Forever.IsReady());
+					TestEqual("GetPendingCount()", Local->GetPendingCount(), 1);
+
+					Local->Close();
+					TestTrue("Forever.IsReady()", Forever.IsReady());
+					TestEqual("GetPendingCount()", Local->GetPendingCount(), 0);
+				});
+
+			It("should resolve cancelled calls", EAsyncExecution::ThreadPool,
+				[this]()
+				{
+					const auto Pair = FJsonRpcPairedChannel::Create();
+					const auto Local = MakeShared<FJsonRpc>(Pair.Local, MakeShared<FJsonRpcEmptyHandler>());
+
+					const auto Cancellation = MakeShared<FJsonRpcCancellation>();
+					const auto Future = Local->Call("anything", MakeShared<FJsonValueNull>(),
+						FTimespan::Zero(), Cancellation);
+
+					Local->ExpirePending();
+					TestFalse("Future.IsReady()", Future.IsReady());
+
+					Cancellation->Cancel();
+					Local->ExpirePending();
+					TestTrue("Future.IsReady()", Future.IsReady());
+					if (Future.IsReady())
+					{
+						const int32 Code = Future.Get().Error->GetNumberField("code");
+						TestEqual("code", Code, StaticCast<int32>(Cancelled));
+					}
+				});
+
+			LatentIt("should notify lazy delegate", {0,0,5},
+				[this](const FDoneDelegate& Done)
+				{
+					const auto Pair = FJsonRpcPairedChannel::Create();
+					NotifyRemote = MakeShared<FJsonRpc>(Pair.Remote,
+						MakeShared<FJsonRpcEmptyHandler>());
+					NotifyLocal = MakeShared<FJsonRpc>(Pair.Local,
+						MakeShared<FJsonRpcEmptyHandler>());
+
+					NotifyLocal->OnNotifyLazy().AddLambda(
+						[this, Done](const FString& Method, const FJsonRpcLazyValue& Params)
+						{
+							TestEqual("Method", Method, TEXT("methodName"));
+							TestTrue("Params.HasView()", Params.HasView());
+							const auto Value = Params.Materialize();
+							TestTrue("Materialize()", Value.IsValid() && Value->AsArray().Num() == 2);
+							Done.Execute();
+						});
+
+					const auto Reader = TJsonReaderFactory<>::Create(TEXT("[1, 2]"));
+					TSharedPtr<FJsonValue> Value;
+					FJsonSerializer::Deserialize(Reader, Value);
+					NotifyRemote->Notify("methodName", Value);
+				});
+
+			It("should send UTF-8 to channels that prefer it", [this]()
+				{
+					const auto Channel = MakeShared<FUtf8Channel>();
+					const auto Local = MakeShared<FJsonRpc>(Channel,
+						MakeShared<FJsonRpcEmptyHandler>());
+
+					Local->Notify("methodName", MakeShared<FJsonValueString>(TEXT("caf\u00e9")));
+
+					TestEqual("Sent.Num()", Channel->Sent.Num(), 0);
+					TestEqual("SentUtf8.Num()", Channel->SentUtf8.Num(), 1);
+					if (Channel->SentUtf8.Num() != 1)
+					{
+						return;
+					}
+
+					const TArray<uint8>& Payload = Channel->SentUtf8[0];
+					const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num());
+					const auto Reader = TJsonReaderFactory<>::Create(FString(Converted.Length(), Converted.Get()));
+					TSharedPtr<FJsonObject> Object;
+					TestTrue("Deserialize()", FJsonSerializer::Deserialize(Reader, Object) && Object.IsValid());
+					if (Object.IsValid())
+					{
+						TestEqual("method", Object->GetStringField(TEXT("method")), TEXT("methodName"));
+						TestEqual("params", Object->GetStringField(TEXT("params")), TEXT("caf\u00e9"));
+					}
+
+					Local->Close();
+				});
+
+			It("should send call ids as strings", [this]()
+				{
+					const auto Channel = MakeShared<FUtf8Channel>();
+					const auto Local = MakeShared<FJsonRpc>(Channel,
+						MakeShared<FJsonRpcEmptyHandler>());
+
+					Local->Call("methodName", MakeShared<FJsonValueNull>());
+
+					TestEqual("SentUtf8.Num()", Channel->SentUtf8.Num(), 1);
+					if (Channel->SentUtf8.Num() != 1)
+					{
+						Local->Close();
+						return;
+					}
+
+					const TArray<uint8>& Payload = Channel->SentUtf8[0];
+					const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num());
+					const auto Reader = TJsonReaderFactory<>::Create(FString(Converted.Length(), Converted.Get()));
+					TSharedPtr<FJsonObject> Object;
+					TestTrue("Deserialize()", FJsonSerializer::Deserialize(Reader, Object) && Object.IsValid());
+					if (Object.IsValid())
+					{
+						const TSharedPtr<FJsonValue> Id = Object->TryGetField(TEXT("id"));
+						TestTrue("id is a string", Id.IsValid() && Id->Type == EJson::String);
+					}
+
+					Local->Close();
+				});
+
 			It("should close without crashing", [this]()
 				{
 					const auto Pair = FJsonRpcPairedChannel::Create();
@@ -0,0 +1,140 @@
+#include "JsonRpcEnvelope.h"
+#include "CoreMinimal.h"
+
+BEGIN_DEFINE_SPEC(FJsonRpcEnvelopeSpec, "Passage.JsonRpcEnvelope",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+
+bool Parse(const TCHAR* Text, FJsonRpcEnvelope& OutEnvelope)
+{
+	return FJsonRpcEnvelope::Parse(MakeShared<const FString>(Text), OutEnvelope);
+}
+
+END_DEFINE_SPEC(FJsonRpcEnvelopeSpec)
+void FJsonRpcEnvelopeSpec::Define()
+{
+	Describe("Parse()", [this]()
+		{
+			It("should find the fields of a call without parsing params", [this]()
+				{
+					FJsonRpcEnvelope Envelope;
+					const bool bParsed = Parse(TEXT(R"({"jsonrpc": "2.0", "method": "AddParticipants", )"
+						R"("params": [{"id": "a", "screenName": "}{\"]["}], "id": 42})"), Envelope);
+
+					TestTrue("Parse()", bParsed);
+					TestTrue("bHasMethod", Envelope.bHasMethod);
+					TestEqual("Method", Envelope.Method, TEXT("AddParticipants"));
+					TestFalse("Result.IsSet()", Envelope.Result.IsSet());
+					TestFalse("Error.IsSet()", Envelope.Error.IsSet());
+					TestTrue("Params.HasView()", Envelope.Params.HasView());
+					TestEqual("Params.GetView()", FString(Envelope.Params.GetView()),
+						TEXT(R"([{"id": "a", "screenName": "}{\"]["}])"));
+
+					uint32 Id = 0;
+					TestTrue("GetCallId()", Envelope.GetCallId(Id));
+					TestEqual("Id", Id, 42u);
+
+					const auto Params = Envelope.Params.Materialize();
+					TestTrue("Materialize()", Params.IsValid());
+					if (Params.IsValid())
+					{
+						TestEqual("screenName", Params->AsArray()[0]->AsObject()->GetStringField("screenName"),
+							TEXT(R"(}{"][)"));
+					}
+				});
+
+			It("should read a result and a quoted id", [this]()
+				{
+					FJsonRpcEnvelope Envelope;
+					TestTrue("Parse()", Parse(TEXT(R"( {"id":"7","result":true} )"), Envelope));
+					TestFalse("bHasMethod", Envelope.bHasMethod);
+
+					uint32 Id = 0;
+					TestTrue("GetCallId()", Envelope.GetCallId(Id));
+					TestEqual("Id", Id, 7u);
+
+					const auto Result = Envelope.Result.Materialize();
+					TestTrue("Result->AsBool()", Result.IsValid() && Result->AsBool());
+				});
+
+			It("should unescape the method name", [this]()
+				{
+					FJsonRpcEnvelope Envelope;
+					TestTrue("Parse()", Parse(TEXT(R"({"method":"a\"b","params":null})"), Envelope));
+					TestEqual("Method", Envelope.Method, TEXT("a\"b"));
+					TestTrue("Params.IsNull()", Envelope.Params.IsNull());
+					TestFalse("Id.IsSet()", Envelope.Id.IsSet());
+				});
+
+			It("should leave batches and malformed text to the DOM parser", [this]()
+				{
+					FJsonRpcEnvelope Envelope;
+					TestFalse("batch", Parse(TEXT(R"([{"method":"a","params":[]}])"), Envelope));
+					TestFalse("unterminated", Parse(TEXT(R"({"method":"a","params":[)"), Envelope));
+					TestFalse("trailing", Parse(TEXT(R"({"method":"a"} x)"), Envelope));
+					TestFalse("HEARTBEAT", Parse(TEXT("HEARTBEAT"), Envelope));
+				});
+
+			It("should reject ids that aren't ours", [this]()
+				{
+					uint32 Id = 0;
+					FJsonRpcEnvelope Envelope;
+					Parse(TEXT(R"({"id":null,"error":{}})"), Envelope);
+					TestFalse("null", Envelope.GetCallId(Id));
+					Parse(TEXT(R"({"id":"abc","result":1})"), Envelope);
+					TestFalse("abc", Envelope.GetCallId(Id));
+					Parse(TEXT(R"({"id":99999999999,"result":1})"), Envelope);
+					TestFalse("overflow", Envelope.GetCallId(Id));
+				});
+		});
+
+	Describe("FJsonRpcLazyValue", [this]()
+		{
+			It("should split arrays and find fields without parsing", [this]()
+				{
+					FJsonRpcEnvelope Envelope;
+					TestTrue("Parse()", Parse(TEXT(R"({"method":"m","params":)"
+						R"([ {"screenName":"a,b", "id":"one"}, "t\"wo", [1, 2] ]})"), Envelope));
+
+					TArray<FJsonRpcLazyValue> Items;
+					TestTrue("GetArrayElements()", Envelope.Params.GetArrayElements(Items));
+					TestEqual("Items.Num()", Items.Num(), 3);
+					if (Items.Num() != 3)
+					{
+						return;
+					}
+
+					FString Id;
+					TestTrue("GetField(id)", Items[0].GetField(TEXT("id")).TryGetString(Id));
+					TestEqual("Id", Id, TEXT("one"));
+					FString ScreenName;
+					TestTrue("GetField(ScreenName) ignores case", Items[0].GetField(TEXT("ScreenName")).TryGetString(ScreenName));
+					TestEqual("ScreenName", ScreenName, TEXT("a,b"));
+					TestFalse("GetField(missing)", Items[0].GetField(TEXT("missing")).IsSet());
+					TestFalse("GetField() of a string", Items[1].GetField(TEXT("id")).IsSet());
+
+					FString Escaped;
+					TestTrue("TryGetString() with an escape", Items[1].TryGetString(Escaped));
+					TestEqual("Escaped", Escaped, TEXT(R"(t"wo)"));
+					TestFalse("TryGetString() of an array", Items[2].TryGetString(Escaped));
+					TestEqual("Items[2].GetView()", FString(Items[2].GetView()), TEXT("[1, 2]"));
+
+					TArray<FJsonRpcLazyValue> Empty;
+					TestFalse("GetArrayElements() of an object", Items[0].GetArrayElements(Empty));
+				});
+
+			It("should do the same for values that are already parsed", [this]()
+				{
+					TArray<TSharedPtr<FJsonValue>> Array;
+					const auto Object = MakeShared<FJsonObject>();
+					Object->SetStringField(TEXT("id"), TEXT("one"));
+					Array.Add(MakeShared<FJsonValueObject>(Object));
+					const FJsonRpcLazyValue Value(MakeShared<FJsonValueArray>(Array));
+
+					TArray<FJsonRpcLazyValue> Items;
+					TestTrue("GetArrayElements()", Value.GetArrayElements(Items));
+					FString Id;
+					TestTrue("GetField(id)", Items.Num() == 1 && Items[0].GetField(TEXT("id")).TryGetString(Id));
+					TestEqual("Id", Id, TEXT("one"));
+				});
+		});
+}
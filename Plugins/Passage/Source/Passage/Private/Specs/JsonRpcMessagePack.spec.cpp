@@ -0,0 +1,98 @@
+#include "JsonRpcMessagePack.h"
+#include "CoreMinimal.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+BEGIN_DEFINE_SPEC(FJsonRpcMessagePackSpec, "Passage.JsonRpcMessagePack",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+
+TSharedPtr<FJsonValue> RoundTrip(const TSharedPtr<FJsonValue>& Value)
+{
+	TArray<uint8> Bytes;
+	FJsonRpcMessagePack::Encode(Value, Bytes);
+	return FJsonRpcMessagePack::Decode(Bytes.GetData(), Bytes.Num());
+}
+
+END_DEFINE_SPEC(FJsonRpcMessagePackSpec)
+void FJsonRpcMessagePackSpec::Define()
+{
+	Describe("Encode()", [this]()
+		{
+			It("should use the compact forms for small values", [this]()
+				{
+					TArray<uint8> Bytes;
+					FJsonRpcMessagePack::Encode(MakeShared<FJsonValueNumber>(5), Bytes);
+					FJsonRpcMessagePack::Encode(MakeShared<FJsonValueNumber>(-1), Bytes);
+					FJsonRpcMessagePack::Encode(MakeShared<FJsonValueString>(TEXT("id")), Bytes);
+					FJsonRpcMessagePack::Encode(MakeShared<FJsonValueNull>(), Bytes);
+
+					const TArray<uint8> Expected = { 0x05, 0xff, 0xa2, 'i', 'd', 0xc0 };
+					TestEqual("Bytes", Bytes, Expected);
+				});
+
+			It("should start messages with a byte JSON text never starts with", [this]()
+				{
+					TArray<uint8> Bytes;
+					FJsonRpcMessagePack::Encode(MakeShared<FJsonValueObject>(MakeShared<FJsonObject>()), Bytes);
+					TestTrue("IsMessagePack(map)", FJsonRpcMessagePack::IsMessagePack(Bytes[0]));
+
+					Bytes.Reset();
+					FJsonRpcMessagePack::Encode(MakeShared<FJsonValueArray>(TArray<TSharedPtr<FJsonValue>>()), Bytes);
+					TestTrue("IsMessagePack(array)", FJsonRpcMessagePack::IsMessagePack(Bytes[0]));
+
+					TestFalse("IsMessagePack('{')", FJsonRpcMessagePack::IsMessagePack('{'));
+					TestFalse("IsMessagePack('[')", FJsonRpcMessagePack::IsMessagePack('['));
+					TestFalse("IsMessagePack(' ')", FJsonRpcMessagePack::IsMessagePack(' '));
+				});
+		});
+
+	Describe("Decode()", [this]()
+		{
+			It("should round-trip a JSON-RPC call", [this]()
+				{
+					const auto Reader = TJsonReaderFactory<>::Create(TEXT(R"({"jsonrpc": "2.0", "method": "join", )"
+						R"("params": {"name": "H\u00e9l\u00e8ne", "big": 4294967295, "neg": -40000, "pi": 3.14159, )"
+						R"("tags": ["a", false, null], "empty": {}}, "id": 300})"));
+					TSharedPtr<FJsonValue> Value;
+					FJsonSerializer::Deserialize(Reader, Value);
+
+					const auto Decoded = RoundTrip(Value);
+					TestTrue("Decoded.IsValid()", Decoded.IsValid());
+					if (!Decoded.IsValid())
+					{
+						return;
+					}
+					const auto Object = Decoded->AsObject();
+					TestEqual("method", Object->GetStringField("method"), TEXT("join"));
+					TestEqual("id", Object->GetNumberField("id"), 300.0);
+
+					const auto Params = Object->GetObjectField("params");
+					TestEqual("name", Params->GetStringField("name"), TEXT("H\u00e9l\u00e8ne"));
+					TestEqual("big", Params->GetNumberField("big"), 4294967295.0);
+					TestEqual("neg", Params->GetNumberField("neg"), -40000.0);
+					TestEqual("pi", Params->GetNumberField("pi"), 3.14159);
+					TestEqual("tags.Num()", Params->GetArrayField("tags").Num(), 3);
+					TestTrue("tags[2]", Params->GetArrayField("tags")[2]->IsNull());
+					TestEqual("empty.Num()", Params->GetObjectField("empty")->Values.Num(), 0);
+				});
+
+			It("should reject truncated and trailing data", [this]()
+				{
+					TArray<uint8> Bytes;
+					FJsonRpcMessagePack::Encode(MakeShared<FJsonValueString>(TEXT("hello")), Bytes);
+
+					TestFalse("Truncated", FJsonRpcMessagePack::Decode(Bytes.GetData(), Bytes.Num() - 1).IsValid());
+					Bytes.Add(0xc0);
+					TestFalse("Trailing", FJsonRpcMessagePack::Decode(Bytes.GetData(), Bytes.Num()).IsValid());
+				});
+
+			It("should reject types with no JSON equivalent", [this]()
+				{
+					const uint8 Bin[] = { 0xc4, 0x01, 0x00 };
+					TestFalse("bin 8", FJsonRpcMessagePack::Decode(Bin, sizeof(Bin)).IsValid());
+
+					const uint8 IntKey[] = { 0x81, 0x01, 0x02 };
+					TestFalse("Integer map key", FJsonRpcMessagePack::Decode(IntKey, sizeof(IntKey)).IsValid());
+				});
+		});
+}
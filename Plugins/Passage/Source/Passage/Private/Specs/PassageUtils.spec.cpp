@@ -70,4 +70,24 @@ void FPassageUtilsSpec::Define()
 
 				});
 		});
-}
\ No newline at end of file
+
+	Describe("PackI420", [this]()
+		{
+			It("should put the chroma rows side by side below the luma", [this]()
+				{
+					// A 4x2 frame whose planes have padding at the end of each row
+					const uint8 Y[] = { 1, 2, 3, 4, 0, 0, 5, 6, 7, 8, 0, 0 };
+					const uint8 U[] = { 9, 10, 0 };
+					const uint8 V[] = { 11, 12, 0, 0 };
+
+					uint8 Packed[12];
+					UPassageUtils::PackI420(Y, 6, U, 3, V, 4, 4, 2, Packed);
+
+					const uint8 Expected[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+					for (int32 i = 0; i < 12; ++i)
+					{
+						TestEqual(*FString::Printf(TEXT("Packed[%d]"), i), Packed[i], Expected[i]);
+					}
+				});
+		});
+}
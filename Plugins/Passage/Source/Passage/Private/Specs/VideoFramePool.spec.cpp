@@ -0,0 +1,108 @@
+#include "VideoFramePool.h"
+#include "AgoraVideoChatProvider.h"
+#include "CoreMinimal.h"
+
+BEGIN_DEFINE_SPEC(FVideoFramePoolSpec, "Passage.VideoFramePool",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+END_DEFINE_SPEC(FVideoFramePoolSpec)
+void FVideoFramePoolSpec::Define()
+{
+	Describe("FVideoFramePool", [this]()
+		{
+			It("should only hand out the newest frame", [this]()
+				{
+					FVideoFramePool Pool;
+
+					FVideoFrame* First = Pool.Acquire(2, 2);
+					TestEqual("Data.Num()", First->Data.Num(), 16);
+					First->Data[0] = 1;
+					TestTrue("First Publish()", Pool.Publish(First));
+
+					FVideoFrame* Second = Pool.Acquire(2, 2);
+					Second->Data[0] = 2;
+					TestFalse("Second Publish()", Pool.Publish(Second));
+
+					FVideoFrame* Latest = Pool.TakeLatest();
+					TestTrue("TakeLatest() is the second frame", Latest == Second && Latest->Data[0] == 2);
+					TestNull("TakeLatest() again", Pool.TakeLatest());
+					TestEqual("GetPublishedCount()", Pool.GetPublishedCount(), 2u);
+					TestEqual("GetDroppedCount()", Pool.GetDroppedCount(), 1u);
+
+					Pool.Release(Latest);
+				});
+
+			It("should reuse released frames", [this]()
+				{
+					FVideoFramePool Pool;
+
+					FVideoFrame* Frame = Pool.Acquire(4, 4);
+					const uint8* Data = Frame->Data.GetData();
+					Pool.Release(Frame);
+
+					FVideoFrame* Reused = Pool.Acquire(2, 2);
+					TestTrue("Same frame", Reused == Frame);
+					TestTrue("Same allocation", Reused->Data.GetData() == Data);
+					TestEqual("Width", Reused->Width, 2u);
+					TestEqual("Data.Num()", Reused->Data.Num(), 16);
+					Pool.Release(Reused);
+				});
+
+			It("should size I420 frames for the packed planes", [this]()
+				{
+					FVideoFramePool Pool;
+
+					FVideoFrame* Frame = Pool.Acquire(4, 2, EVideoFrameFormat::I420);
+					TestTrue("Format", Frame->Format == EVideoFrameFormat::I420);
+					TestEqual("Data.Num()", Frame->Data.Num(), 12);
+					Pool.Release(Frame);
+
+					FVideoFrame* Reused = Pool.Acquire(4, 2);
+					TestTrue("Format of the reused frame", Reused->Format == EVideoFrameFormat::BGRA);
+					TestEqual("Data.Num() of the reused frame", Reused->Data.Num(), 32);
+					Pool.Release(Reused);
+				});
+		});
+
+	Describe("FFrameObserver::onRenderVideoFrame()", [this]()
+		{
+			It("should coalesce frames that nobody has taken", [this]()
+				{
+					FFrameObserver Observer;
+
+					const int32 Width = 8;
+					const int32 Height = 4;
+					TArray<uint8> Pixels;
+					Pixels.SetNumZeroed(Width * Height * 4);
+
+					agora::media::base::VideoFrame VideoFrame;
+					VideoFrame.type = agora::media::base::VIDEO_PIXEL_BGRA;
+					VideoFrame.width = Width;
+					VideoFrame.height = Height;
+					VideoFrame.yStride = Width * 4;
+					VideoFrame.yBuffer = Pixels.GetData();
+
+					// Without a Parent there is no game thread consumer, so every
+					// frame but the last should be dropped.
+					for (uint8 i = 1; i <= 10; ++i)
+					{
+						Pixels[0] = i;
+						Observer.onRenderVideoFrame("channel", 42, VideoFrame);
+					}
+
+					const auto Pool = Observer.GetFramePool(42);
+					TestEqual("GetPublishedCount()", Pool->GetPublishedCount(), 10u);
+					TestEqual("GetDroppedCount()", Pool->GetDroppedCount(), 9u);
+
+					FVideoFrame* Latest = Pool->TakeLatest();
+					TestNotNull("TakeLatest()", Latest);
+					if (Latest)
+					{
+						TestEqual("Latest->Width", Latest->Width, (uint32)Width);
+						TestEqual("Latest->Data[0]", Latest->Data[0], (uint8)10);
+						Pool->Release(Latest);
+					}
+
+					TestEqual("Other uid untouched", Observer.GetFramePool(7)->GetPublishedCount(), 0u);
+				});
+		});
+}
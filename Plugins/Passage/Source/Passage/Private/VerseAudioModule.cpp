@@ -6,40 +6,24 @@
 DEFINE_LOG_CATEGORY(LogVerseAudio);
 
 FVerseAudioModule::FVerseAudioModule(
-        webrtc::TaskQueueFactory* TaskQueueFactory,
-        UAudioComponent* AC,
-        USoundWaveProcedural* SW) noexcept
+        webrtc::TaskQueueFactory* TaskQueueFactory) noexcept
 	:
     AudioTransport(nullptr),
 	TaskQueue(TaskQueueFactory->CreateTaskQueue(
                 "FVerseAudioModuleTimer",
         		webrtc::TaskQueueFactory::Priority::NORMAL)),
-    AudioComponent(AC),
-    SoundWave(SW),
     IsPlaying(false),
-    IsStarted(false),
-    ReceivingSilence(false)
+    IsStarted(false)
 {
 }
 
 rtc::scoped_refptr<FVerseAudioModule> FVerseAudioModule::Create(
-        webrtc::TaskQueueFactory* TaskQueueFactory,
-        UAudioComponent* AC)
+        webrtc::TaskQueueFactory* TaskQueueFactory)
 {
     UE_LOG(LogVerseAudio, Log, TEXT("FVerseAudioModule::Create()"));
-    USoundWaveProcedural* SoundWave = NewObject<USoundWaveProcedural>();
-
-    SoundWave->SetSampleRate(SAMPLES_PER_SECOND);
-    SoundWave->NumChannels = CHANNEL_COUNT;
-    SoundWave->SampleByteSize = BYTES_PER_SAMPLE;
-    SoundWave->Duration = INDEFINITELY_LOOPING_DURATION;
-    SoundWave->SoundGroup = SOUNDGROUP_Default;
-
-    AC->SetSound(SoundWave);
 
     rtc::scoped_refptr<FVerseAudioModule> VerseAudioModule(
-            new rtc::RefCountedObject<FVerseAudioModule>(
-                TaskQueueFactory, AC, SoundWave)
+            new rtc::RefCountedObject<FVerseAudioModule>(TaskQueueFactory)
             );
     return VerseAudioModule;
 }
@@ -62,13 +46,9 @@ int32 FVerseAudioModule::StartPlayout()
         IsPlaying = true;
     }
 
-    AsyncTask(ENamedThreads::GameThread, [this]() {
-        SoundWave->ResetAudio();
-        AudioComponent->Play();
-
-        TaskQueue.PostTask([this](){ ScheduleQueueAudioData(); });
-    });
-
+    // The AudioComponents are started by each connection's FVerseAudioSink,
+    // so all that's left here is to start pulling.
+    TaskQueue.PostTask([this](){ SchedulePullAudioData(); });
 
     return 0;
 }
@@ -85,23 +65,6 @@ int32 FVerseAudioModule::StopPlayout()
         IsStarted = false;
     }
 
-    // TODO: why is this doubly wrapped in lambdas? Shouldn't it be sufficient
-    // simply to pos this to the GameThread? Why would we need the TaskQueue to
-    // post this to the game thread?
-
-    // I think we can get away without this for now and avoid crashing on exit
-    // half the time?
-//    auto AC = AudioComponent;
-//    TaskQueue.PostTask([AC]() {
-//		AsyncTask(ENamedThreads::GameThread, [AC]() {
-//			if (IsValid(AC) && AC->IsPlaying())
-//			{
-//                UE_LOG(LogVerseAudio, Log, TEXT("FVerseAudioModule::StopPlayout lambda: AudioComponent->IsPlaying() was true, trying to stop..."));
-//				AC->Stop();
-//			}
-//		});
-//	});
-
     return 0;
 }
 
@@ -117,43 +80,48 @@ bool FVerseAudioModule::Playing() const
 
 
 /**
- * Runs QueueAudioData periodically with a delay so that it runs when there's
+ * Runs PullAudioData periodically with a delay so that it runs when there's
  * data avialable, and returns control to the task queue in between.
  */
-void FVerseAudioModule::ScheduleQueueAudioData()
+void FVerseAudioModule::SchedulePullAudioData()
 {
     rtc::CritScope _cs(&CriticalSection);
 
     if(!IsStarted)
     {
-        UE_LOG(LogVerseAudio, Log, TEXT("FVerseAudioModule::ScheduleQueueAudioData() starting"));
-        NextQueueAudioDataTime = rtc::TimeMillis();
+        UE_LOG(LogVerseAudio, Log, TEXT("FVerseAudioModule::SchedulePullAudioData() starting"));
+        NextPullAudioDataTime = rtc::TimeMillis();
         IsStarted = true;
     }
 
     if(IsPlaying)
     {
-        QueueAudioData();
-        NextQueueAudioDataTime += MS_PER_FRAME;
+        PullAudioData();
+        NextPullAudioDataTime += MS_PER_FRAME;
         const int64_t now = rtc::TimeMillis();
         int64_t delay = 0;
-        if(NextQueueAudioDataTime > now)
+        if(NextPullAudioDataTime > now)
         {
-            delay = NextQueueAudioDataTime - now;
+            delay = NextPullAudioDataTime - now;
         }
         TaskQueue.PostDelayedTask(
-            [this]() { ScheduleQueueAudioData(); },
+            [this]() { SchedulePullAudioData(); },
             int32_t(delay)
         );
     }
     else
     {
-        UE_LOG(LogVerseAudio, Log, TEXT("FVerseAudioModule::ScheduleQueueAudioData() stopping"));
+        UE_LOG(LogVerseAudio, Log, TEXT("FVerseAudioModule::SchedulePullAudioData() stopping"));
     }
 }
 
-void FVerseAudioModule::QueueAudioData()
+void FVerseAudioModule::PullAudioData()
 {
+    if(AudioTransport == nullptr)
+    {
+        return;
+    }
+
     // We don't really care about these values, but the NeedMorePlayData method
     // wants to write to these as output parameters
     size_t nSamplesOut;
@@ -169,28 +137,4 @@ void FVerseAudioModule::QueueAudioData()
             &elapsed_time_ms,
             &ntp_time_ms
             );
-
-    bool FoundNonZero = false;
-    for(size_t i=0; i < SAMPLE_COUNT*BYTES_PER_SAMPLE; i++)
-    {
-        if(AudioData[i] != 0)
-        {
-            FoundNonZero = true;
-        }
-    }
-
-    if(ReceivingSilence && FoundNonZero)
-    {
-        ReceivingSilence = false;
-        UE_LOG(LogVerseAudio, Log,
-            TEXT("FVerseAudioModule::QueueAudioData(): getting audio data"));
-    }
-    else if(!ReceivingSilence && !FoundNonZero)
-    {
-        ReceivingSilence = true;
-        UE_LOG(LogVerseAudio, Log,
-            TEXT("FVerseAudioModule::QueueAudioData(): getting silence"));
-    }
-
-    SoundWave->QueueAudio(AudioData, SAMPLE_COUNT*BYTES_PER_SAMPLE);
 }
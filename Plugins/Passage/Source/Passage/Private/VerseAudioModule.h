@@ -4,12 +4,17 @@
 
 #include "WebRtcGuards.h"
 
-#include "Components/AudioComponent.h"
-#include "Sound/SoundWaveProcedural.h"
-
 
 DECLARE_LOG_CATEGORY_EXTERN(LogVerseAudio, Log, All);
 
+/**
+ * The audio device that the shared PeerConnectionFactory plays out to. It
+ * doesn't play anything itself: every connection routes its remote audio
+ * track to its own UAudioComponent with an FVerseAudioSink, so participants
+ * stay spatialized. WebRTC only decodes and delivers audio to those sinks
+ * while a device is pulling the mix, though, so this pulls it on a 10ms
+ * schedule and throws the mix away.
+ */
 class FVerseAudioModule : public webrtc::AudioDeviceModule
 {
     static constexpr int MS_PER_FRAME = 10;
@@ -22,23 +27,18 @@ class FVerseAudioModule : public webrtc::AudioDeviceModule
 public:
 
     explicit FVerseAudioModule(
-            webrtc::TaskQueueFactory* TaskQueueFactory,
-            UAudioComponent* AudioComponent,
-            USoundWaveProcedural* SoundWave) noexcept;
+            webrtc::TaskQueueFactory* TaskQueueFactory) noexcept;
     ~FVerseAudioModule() = default;
 
     static rtc::scoped_refptr<FVerseAudioModule> Create(
-            webrtc::TaskQueueFactory* TaskQueueFactory,
-            UAudioComponent* AudioComponent);
+            webrtc::TaskQueueFactory* TaskQueueFactory);
 
 
 private:
 
     webrtc::AudioTransport* AudioTransport;
     rtc::TaskQueue TaskQueue;
-    UAudioComponent* AudioComponent;
-    USoundWaveProcedural* SoundWave;
-    int64_t NextQueueAudioDataTime;
+    int64_t NextPullAudioDataTime;
     uint8 AudioData[SAMPLE_COUNT*BYTES_PER_SAMPLE];
 
 
@@ -47,18 +47,15 @@ private:
     // IsPlaying tracks our playing state
     bool IsPlaying;
 
-    // IsStarted helps us track the QueueAudioData schedule
+    // IsStarted helps us track the PullAudioData schedule
     bool IsStarted;
 
-    // Debugging flag to track when we're getting audio or not
-    bool ReceivingSilence;
-
-    // Manages scheduling QueueAudioData repeatedly on the TaskQueue thread
-    void ScheduleQueueAudioData();
+    // Manages scheduling PullAudioData repeatedly on the TaskQueue thread
+    void SchedulePullAudioData();
 
-    // Actually copies audio data from the WebRTC implementation into the 
-    // SoundWave USoundProcedural instance
-    void QueueAudioData();
+    // Has WebRTC mix the remote audio, which feeds each track's sinks along
+    // the way. The mix itself is discarded.
+    void PullAudioData();
 
     // This section implements the webrtc::AudioDeviceModule interface. Almost
     // everything is just statically implemented as a no-op. Anything that has
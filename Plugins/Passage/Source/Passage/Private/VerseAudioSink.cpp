@@ -0,0 +1,91 @@
+// Copyright Enva Division
+
+#include "VerseAudioSink.h"
+#include "VerseAudioModule.h"
+
+FVerseAudioSink::FVerseAudioSink(UAudioComponent* AC)
+    :
+    AudioComponent(AC),
+    SoundWave(NewObject<USoundWaveProcedural>()),
+    ReceivingSilence(false),
+    LoggedUnsupportedFormat(false)
+{
+    SoundWave->SetSampleRate(SAMPLES_PER_SECOND);
+    SoundWave->NumChannels = CHANNEL_COUNT;
+    SoundWave->SampleByteSize = BYTES_PER_SAMPLE;
+    SoundWave->Duration = INDEFINITELY_LOOPING_DURATION;
+    SoundWave->SoundGroup = SOUNDGROUP_Default;
+
+    // The AudioComponent references the SoundWave from here on, which keeps
+    // it from being garbage collected.
+    AudioComponent->SetSound(SoundWave);
+}
+
+void FVerseAudioSink::Start()
+{
+    UE_LOG(LogVerseAudio, Log, TEXT("FVerseAudioSink::Start()"));
+    SoundWave->ResetAudio();
+    AudioComponent->Play();
+}
+
+void FVerseAudioSink::OnData(
+    const void* audio_data,
+    int bits_per_sample,
+    int sample_rate,
+    size_t number_of_channels,
+    size_t number_of_frames)
+{
+    // Opus always decodes to 16 bit samples at 48kHz, which is what the
+    // SoundWave is set up for.
+    if(bits_per_sample != 16 || sample_rate != SAMPLES_PER_SECOND ||
+        (number_of_channels != 1 && number_of_channels != 2))
+    {
+        if(!LoggedUnsupportedFormat)
+        {
+            LoggedUnsupportedFormat = true;
+            UE_LOG(LogVerseAudio, Error,
+                TEXT("FVerseAudioSink::OnData(): unsupported format, %d bits at %dHz with %d channels"),
+                bits_per_sample, sample_rate, (int32)number_of_channels);
+        }
+        return;
+    }
+
+    const int16* Samples = static_cast<const int16*>(audio_data);
+    const int32 SampleCount = (int32)(number_of_frames * CHANNEL_COUNT);
+    if(number_of_channels == 1)
+    {
+        StereoData.SetNumUninitialized(SampleCount, false);
+        for(size_t i = 0; i < number_of_frames; i++)
+        {
+            StereoData[i*2] = Samples[i];
+            StereoData[i*2 + 1] = Samples[i];
+        }
+        Samples = StereoData.GetData();
+    }
+
+    bool FoundNonZero = false;
+    for(int32 i = 0; i < SampleCount; i++)
+    {
+        if(Samples[i] != 0)
+        {
+            FoundNonZero = true;
+            break;
+        }
+    }
+
+    if(ReceivingSilence && FoundNonZero)
+    {
+        ReceivingSilence = false;
+        UE_LOG(LogVerseAudio, Log,
+            TEXT("FVerseAudioSink::OnData(): getting audio data"));
+    }
+    else if(!ReceivingSilence && !FoundNonZero)
+    {
+        ReceivingSilence = true;
+        UE_LOG(LogVerseAudio, Log,
+            TEXT("FVerseAudioSink::OnData(): getting silence"));
+    }
+
+    SoundWave->QueueAudio(reinterpret_cast<const uint8*>(Samples),
+        SampleCount * sizeof(int16));
+}
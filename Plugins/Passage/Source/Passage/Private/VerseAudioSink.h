@@ -0,0 +1,52 @@
+// Copyright Enva Division
+
+#pragma once
+
+#include "WebRtcGuards.h"
+
+#include "Components/AudioComponent.h"
+#include "Sound/SoundWaveProcedural.h"
+
+/**
+ * Plays one remote audio track through a UAudioComponent, so each
+ * participant's voice comes from their own place in the scene even though
+ * all connections share one FVerseAudioModule. Construct and Start() it on the
+ * game thread, then add it to the track with AddSink(...). Remove it from the
+ * track before destroying it.
+ */
+class FVerseAudioSink : public webrtc::AudioTrackSinkInterface
+{
+    static constexpr uint8_t CHANNEL_COUNT = 2;
+    static constexpr int SAMPLES_PER_SECOND = 48000;
+    static constexpr size_t BYTES_PER_SAMPLE = sizeof(int16_t) * CHANNEL_COUNT;
+
+public:
+
+    explicit FVerseAudioSink(UAudioComponent* AudioComponent);
+
+    /** Starts the AudioComponent playing. Must be called on the game thread. */
+    void Start();
+
+    // webrtc::AudioTrackSinkInterface implementation, called on the audio
+    // module's thread every 10ms while playing.
+    void OnData(
+        const void* audio_data,
+        int bits_per_sample,
+        int sample_rate,
+        size_t number_of_channels,
+        size_t number_of_frames) override;
+
+private:
+
+    UAudioComponent* AudioComponent;
+    USoundWaveProcedural* SoundWave;
+
+    // Reused for mono tracks, which are duplicated to both channels
+    TArray<int16> StereoData;
+
+    // Debugging flag to track when we're getting audio or not
+    bool ReceivingSilence;
+
+    // So an unexpected format is only logged once per track
+    bool LoggedUnsupportedFormat;
+};
@@ -2,7 +2,10 @@
 
 #include "VerseConnection.h"
 #include "LogThreadId.h"
-#include "VerseAudioModule.h"
+#include "PassageUtils.h"
+#include "VerseAudioSink.h"
+#include "VerseConnectionFactory.h"
+#include "VideoFramePool.h"
 
 #include <string>
 #include <vector>
@@ -20,6 +23,206 @@
 
 DEFINE_LOG_CATEGORY(LogVerseConnection);
 
+/**
+ * Converts the decoded I420 frames of one remote video track to BGRA, or packs
+ * their planes for the GPU to convert when bPackI420 is set, on a pool thread,
+ * so the WebRTC decoder thread only has to hand over a reference to the frame.
+ * At most one conversion runs at a time; frames that arrive meanwhile replace
+ * each other and only the newest is converted next.
+ * Finished frames go into the stream's FVideoFramePool, and OnFrameReady is
+ * called whenever one is published with no other frame already waiting for
+ * the game thread.
+ */
+class FVerseFrameConverter :
+    public TSharedFromThis<FVerseFrameConverter, ESPMode::ThreadSafe>,
+    public rtc::VideoSinkInterface<webrtc::VideoFrame>
+{
+public:
+
+    FVerseFrameConverter(
+        TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe> InPool,
+        bool bInPackI420,
+        TFunction<void()> InOnFrameReady)
+        :
+        Pool(MoveTemp(InPool)),
+        bPackI420(bInPackI420),
+        OnFrameReady(MoveTemp(InOnFrameReady))
+    {
+    }
+
+    /** Called on the decoder thread. Copying a webrtc::VideoFrame is cheap. */
+    void Submit(const webrtc::VideoFrame& Frame)
+    {
+        {
+            FScopeLock ScopeLock(&Lock);
+            if (Pending.IsSet())
+            {
+                ++SkippedCount;
+            }
+            Pending = Frame;
+            if (bConverting)
+            {
+                return;
+            }
+            bConverting = true;
+        }
+
+        TSharedRef<FVerseFrameConverter, ESPMode::ThreadSafe> Self = AsShared();
+        Async(EAsyncExecution::ThreadPool, [Self]() {
+            Self->ConvertPending();
+        });
+    }
+
+    // rtc::VideoSinkInterface<webrtc::VideoFrame> implementation
+    void OnFrame(const webrtc::VideoFrame& Frame) override
+    {
+        Submit(Frame);
+    }
+
+    /** The number of frames replaced by a newer one before being converted */
+    uint32 GetSkippedCount() const { return SkippedCount; }
+
+private:
+
+    void ConvertPending()
+    {
+        while (true)
+        {
+            TOptional<webrtc::VideoFrame> Frame;
+            {
+                FScopeLock ScopeLock(&Lock);
+                if (!Pending.IsSet())
+                {
+                    bConverting = false;
+                    return;
+                }
+                Frame = MoveTemp(Pending);
+                Pending.Reset();
+            }
+
+            const int Width = Frame->width();
+            const int Height = Frame->height();
+            FVideoFrame* Converted;
+            if (bPackI420 && Width % 2 == 0 && Height % 2 == 0)
+            {
+                // Decoders normally hand out I420 already, so this is free
+                const rtc::scoped_refptr<webrtc::I420BufferInterface> Buffer =
+                    Frame->video_frame_buffer()->ToI420();
+                Converted = Pool->Acquire(Width, Height, EVideoFrameFormat::I420);
+                UPassageUtils::PackI420(
+                    Buffer->DataY(), Buffer->StrideY(),
+                    Buffer->DataU(), Buffer->StrideU(),
+                    Buffer->DataV(), Buffer->StrideV(),
+                    Width, Height, Converted->Data.GetData());
+            }
+            else
+            {
+                Converted = Pool->Acquire(Width, Height);
+
+                // We request ARGB, but this delivers BGRA, which is what
+                // UPassageUtils::CreateVideoTexture creates the texture as.
+                // libyuv picks the SIMD version for the CPU at runtime.
+                webrtc::ConvertFromI420(*Frame, webrtc::VideoType::kARGB, 0,
+                    Converted->Data.GetData());
+            }
+
+            // Let go of the decoder's buffer before the upload is scheduled
+            Frame.Reset();
+
+            if (Pool->Publish(Converted))
+            {
+                OnFrameReady();
+            }
+        }
+    }
+
+    TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe> Pool;
+    const bool bPackI420;
+    TFunction<void()> OnFrameReady;
+
+    FCriticalSection Lock;
+    TOptional<webrtc::VideoFrame> Pending;
+    bool bConverting = false;
+
+    TAtomic<uint32> SkippedCount { 0 };
+};
+
+/**
+ * The sinks of one remote stream, and the receivers whose tracks feed them.
+ * The tracks only hold raw pointers to the sinks, so the sinks are removed
+ * from the tracks before they go away.
+ */
+struct FVerseRemoteStream
+{
+    TArray<rtc::scoped_refptr<webrtc::RtpReceiverInterface>> Receivers;
+
+    TSharedPtr<FVerseAudioSink> AudioSink;
+    rtc::scoped_refptr<webrtc::AudioTrackInterface> AudioTrack;
+
+    TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe> FramePool;
+    TSharedPtr<FVerseFrameConverter, ESPMode::ThreadSafe> FrameConverter;
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> VideoTrack;
+
+    ~FVerseRemoteStream()
+    {
+        DetachAudio();
+        DetachVideo();
+
+        UE_LOG(LogVerseConnection, Verbose,
+            TEXT("~FVerseRemoteStream() published %u frames, dropped %u, skipped %u before conversion"),
+            FramePool->GetPublishedCount(), FramePool->GetDroppedCount(),
+            FrameConverter->GetSkippedCount());
+    }
+
+    void DetachAudio()
+    {
+        if(AudioTrack && AudioSink)
+        {
+            AudioTrack->RemoveSink(AudioSink.Get());
+        }
+        AudioTrack = nullptr;
+    }
+
+    void DetachVideo()
+    {
+        if(VideoTrack)
+        {
+            VideoTrack->RemoveSink(FrameConverter.Get());
+        }
+        VideoTrack = nullptr;
+    }
+
+    /** Detaches Receiver's track if it's one of ours */
+    void DetachReceiver(const rtc::scoped_refptr<webrtc::RtpReceiverInterface>& Receiver)
+    {
+        const auto Track = Receiver->track();
+        if(AudioTrack && AudioTrack.get() == Track.get())
+        {
+            DetachAudio();
+        }
+        if(VideoTrack && VideoTrack.get() == Track.get())
+        {
+            DetachVideo();
+        }
+        Receivers.Remove(Receiver);
+    }
+};
+
+namespace
+{
+    /** The id of the first stream Receiver belongs to, or empty if none */
+    FString GetReceiverStreamId(
+        const rtc::scoped_refptr<webrtc::RtpReceiverInterface>& Receiver)
+    {
+        const std::vector<std::string> StreamIds = Receiver->stream_ids();
+        if(StreamIds.empty())
+        {
+            return FString();
+        }
+        return FString(UTF8_TO_TCHAR(StreamIds[0].c_str()));
+    }
+}
+
 
 webrtc::PeerConnectionInterface::RTCConfiguration UVerseConnection::GetDefaultConfig()
 {
@@ -43,9 +246,6 @@ webrtc::PeerConnectionInterface::RTCConfiguration UVerseConnection::GetDefaultCo
 }
 
 UVerseConnection::UVerseConnection()
-    :
-    AudioComponent(nullptr),
-    Texture2D(nullptr)
 {
     UE_LOG(LogVerseConnection, Log, TEXT("UVerseConnection() constructor"));
  
@@ -55,12 +255,164 @@ UVerseConnection::UVerseConnection()
 
 UVerseConnection::~UVerseConnection()
 {
+    CancelReconnectTimer();
 }
 
 void UVerseConnection::SetAudioComponent(UAudioComponent* AC)
 {
     UE_LOG(LogVerseConnection, Log, TEXT("UVerseConnection::SetAudioComponent()"));
-    AudioComponent = AC;
+    AddStream(FString(), AC);
+}
+
+void UVerseConnection::SetWebRtcContext(TSharedPtr<FVerseWebRtcContext> Context)
+{
+    WebRtcContext = Context;
+}
+
+void UVerseConnection::AddStream(const FString& StreamId, UAudioComponent* AC)
+{
+    UE_LOG(LogVerseConnection, Log,
+        TEXT("UVerseConnection::AddStream('%s')"), *StreamId);
+
+    // Adding a stream again starts over with fresh sinks, but keeps its tracks
+    RemoveStream(StreamId);
+
+    auto Stream = MakeShared<FVerseRemoteStream>();
+    if(IsValid(AC))
+    {
+        Stream->AudioSink = MakeShared<FVerseAudioSink>(AC);
+    }
+    Stream->FramePool = MakeShared<FVideoFramePool, ESPMode::ThreadSafe>();
+
+    // The converter and any upload still in flight may outlive us, so they
+    // only hold a weak pointer back to this connection.
+    TWeakObjectPtr<UVerseConnection> WeakThis(this);
+    TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe> Pool = Stream->FramePool;
+    Stream->FrameConverter = MakeShared<FVerseFrameConverter, ESPMode::ThreadSafe>(
+        Pool,
+        bUploadI420,
+        [WeakThis, StreamId, Pool]() {
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, StreamId, Pool]() {
+                if (UVerseConnection* Connection = WeakThis.Get())
+                {
+                    Connection->UpdateTexture(StreamId, Pool);
+                }
+                else
+                {
+                    Pool->Release(Pool->TakeLatest());
+                }
+            });
+        });
+
+    Streams.Add(StreamId, Stream);
+
+    // The stream without an id takes every track, the others their own
+    TArray<rtc::scoped_refptr<webrtc::RtpReceiverInterface>> Receivers;
+    if(StreamId.IsEmpty())
+    {
+        for(auto& Pair : UnroutedReceivers)
+        {
+            Receivers.Append(Pair.Value);
+        }
+        UnroutedReceivers.Empty();
+    }
+    else
+    {
+        UnroutedReceivers.RemoveAndCopyValue(StreamId, Receivers);
+    }
+
+    for(const auto& Receiver : Receivers)
+    {
+        AttachReceiver(StreamId, *Stream, Receiver);
+    }
+}
+
+void UVerseConnection::RemoveStream(const FString& StreamId)
+{
+    TSharedPtr<FVerseRemoteStream> Stream;
+    if(!Streams.RemoveAndCopyValue(StreamId, Stream))
+    {
+        return;
+    }
+
+    UE_LOG(LogVerseConnection, Log,
+        TEXT("UVerseConnection::RemoveStream('%s')"), *StreamId);
+
+    Stream->DetachAudio();
+    Stream->DetachVideo();
+    for(const auto& Receiver : Stream->Receivers)
+    {
+        UnroutedReceivers.FindOrAdd(GetReceiverStreamId(Receiver)).Add(Receiver);
+    }
+    Textures.Remove(StreamId);
+}
+
+void UVerseConnection::RouteReceiver(
+    rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver)
+{
+    if(TSharedPtr<FVerseRemoteStream>* Default = Streams.Find(FString()))
+    {
+        AttachReceiver(FString(), **Default, Receiver);
+        return;
+    }
+
+    const FString StreamId = GetReceiverStreamId(Receiver);
+    if(TSharedPtr<FVerseRemoteStream>* Stream = Streams.Find(StreamId))
+    {
+        AttachReceiver(StreamId, **Stream, Receiver);
+    }
+    else
+    {
+        UE_LOG(LogVerseConnection, Verbose,
+            TEXT("UVerseConnection::RouteReceiver() holding a track for stream '%s' until it is added"),
+            *StreamId);
+        UnroutedReceivers.FindOrAdd(StreamId).Add(Receiver);
+    }
+}
+
+void UVerseConnection::UnrouteReceiver(
+    rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver)
+{
+    for(auto& Pair : Streams)
+    {
+        Pair.Value->DetachReceiver(Receiver);
+    }
+
+    for(auto It = UnroutedReceivers.CreateIterator(); It; ++It)
+    {
+        It.Value().Remove(Receiver);
+        if(It.Value().Num() == 0)
+        {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void UVerseConnection::AttachReceiver(const FString& StreamId,
+    FVerseRemoteStream& Stream,
+    rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver)
+{
+    Stream.Receivers.AddUnique(Receiver);
+
+    const rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> Track =
+        Receiver->track();
+    if(Track->kind() == webrtc::MediaStreamTrackInterface::kVideoKind)
+    {
+        Stream.DetachVideo();
+        Stream.VideoTrack = static_cast<webrtc::VideoTrackInterface*>(Track.get());
+        Stream.VideoTrack->AddOrUpdateSink(
+            Stream.FrameConverter.Get(), rtc::VideoSinkWants());
+        UE_LOG(LogVerseConnection, VeryVerbose, TEXT("Broadcasting to TextureReadyDelegate"));
+        BroadcastTexture(StreamId, GetStreamTexture(StreamId));
+    }
+    else if(Track->kind() == webrtc::MediaStreamTrackInterface::kAudioKind &&
+        Stream.AudioSink)
+    {
+        Stream.DetachAudio();
+        Stream.AudioTrack = static_cast<webrtc::AudioTrackInterface*>(Track.get());
+        Stream.AudioSink->Start();
+        Stream.AudioTrack->AddSink(Stream.AudioSink.Get());
+    }
 }
 
 // You can read this linearly to get a pretty good idea of the connection
@@ -71,12 +423,31 @@ void UVerseConnection::Connect(FString& Url, FString& InChannelName)
     LogThreadId("UVerseConnection::Connect this must be the game thread");
 
     ChannelName = InChannelName;
+    SessionUrl = Url;
+    bClosing = false;
+    RejoinAttempts = 0;
 
     Status->SetStatus(EConnectionStatus::Connecting);
-    
-    // Setup the AudioComponent, RPC, PeerConnectionFactory, SignalingThread,
-    // PubPc, and SubPc objects.
-    Init(Url);
+
+    StartSession();
+}
+
+void UVerseConnection::StartSession()
+{
+    UE_LOG(LogVerseConnection, Log, TEXT("UVerseConnection::StartSession()"));
+
+    ReconnectState = EVerseReconnectState::None;
+    const uint32 Generation = ++SessionGeneration;
+
+    // Setup the RPC, PubPc, and SubPc objects, using the shared
+    // PeerConnectionFactory and SignalingThread.
+    WS = nullptr;
+    Init(SessionUrl);
+    if(!WS || !PubPc || !SubPc)
+    {
+        Status->SetStatus(EConnectionStatus::Failed);
+        return;
+    }
 
     // Once we have the RPC connection established (the WebSocket is open),
     // then we can automatically proceed with creating the offer. These lambdas
@@ -86,6 +457,29 @@ void UVerseConnection::Connect(FString& Url, FString& InChannelName)
         CreatePubOffer();
     });
 
+    // Losing the signaling connection means losing the session, since the SFU
+    // forgets about us along with the socket.
+    WS->OnConnectionError().AddWeakLambda(this,
+        [this, Generation](const FString& Error) {
+            if(Generation != SessionGeneration)
+            {
+                return;
+            }
+            UE_LOG(LogVerseConnection, Warning,
+                TEXT("UVerseConnection signaling WebSocket error: %s"), *Error);
+            ScheduleRejoin();
+        });
+    WS->OnClosed().AddWeakLambda(this,
+        [this, Generation](const int32 StatusCode, const FString& Reason, const bool bWasClean) {
+            if(Generation != SessionGeneration)
+            {
+                return;
+            }
+            UE_LOG(LogVerseConnection, Warning,
+                TEXT("UVerseConnection signaling WebSocket closed: %d %s"), StatusCode, *Reason);
+            ScheduleRejoin();
+        });
+
     UE_LOG(LogVerseConnection, VeryVerbose,
             TEXT("Adding lambda for CreatePubLocalDesc"));
     CreatePubLocalDesc->OnSuccessEvent().AddLambda(
@@ -97,13 +491,25 @@ void UVerseConnection::Connect(FString& Url, FString& InChannelName)
         SendJoinRequest(ChannelName);
     });
 
-    RPC->OnNotify().AddLambda([this](FString Method, TSharedPtr<FJsonValue> Params) {
-        if(Method == "offer")
+    // Only the notifications we handle are worth parsing
+    RPC->OnNotifyLazy().AddLambda([this](const FString& Method, const FJsonRpcLazyValue& LazyParams) {
+        if(Method != "offer" && Method != "trickle")
+        {
+            return;
+        }
+
+        const TSharedPtr<FJsonValue> Params = LazyParams.Materialize();
+        if(!Params.IsValid() || Params->Type != EJson::Object)
+        {
+            UE_LOG(LogVerseConnection, Error,
+                TEXT("Unable to parse the params of the '%s' notification"), *Method);
+        }
+        else if(Method == "offer")
         {
             // This is the incomming offer for negotiating the subscribe channel
             HandleSubOffer(Params);
         }
-        else if(Method == "trickle")
+        else
         {
             HandleTrickle(Params);
         }
@@ -124,51 +530,62 @@ void UVerseConnection::Connect(FString& Url, FString& InChannelName)
         SendSubAnswer();
     }); 
 
+    // The observers outlive the sessions, so drop the previous session's
+    // handlers first.
+    SubPcObserver.OnTrackEvent().Clear();
+    SubPcObserver.OnRemoveTrackEvent().Clear();
+    SubPcObserver.OnConnectionChangeEvent().Clear();
+
+    // Every renegotiation can add or remove tracks, each of which is routed
+    // to the stream it belongs to. These arrive on the signaling thread, but
+    // the streams are owned by the game thread, so the routing happens there.
+    TWeakObjectPtr<UVerseConnection> WeakThis(this);
     SubPcObserver.OnTrackEvent().AddLambda(
-        [this](rtc::scoped_refptr<webrtc::RtpTransceiverInterface> Transceiver)
+        [WeakThis, Generation](rtc::scoped_refptr<webrtc::RtpTransceiverInterface> Transceiver)
         {
             UE_LOG(LogVerseConnection, VeryVerbose, TEXT("SubPcObserver.OnTrackEvent() received transceiver"));
-            if(Transceiver->media_type() == cricket::MediaType::MEDIA_TYPE_VIDEO)
-            {
-                webrtc::VideoTrackInterface* Track =
-                    static_cast<webrtc::VideoTrackInterface*>(
-                        Transceiver->receiver()->track().get());
-                Track->AddOrUpdateSink(this, rtc::VideoSinkWants());
-                UE_LOG(LogVerseConnection, VeryVerbose, TEXT("Broadcasting to TextureReadyDelegate"));
-                OnTextureReady.Broadcast(GetTexture2D());
-            }
+            rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver = Transceiver->receiver();
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Generation, Receiver]() {
+                UVerseConnection* Connection = WeakThis.Get();
+                if(Connection == nullptr || Generation != Connection->SessionGeneration)
+                {
+                    return;
+                }
+                Connection->RouteReceiver(Receiver);
+            });
+        }
+    );
+
+    SubPcObserver.OnRemoveTrackEvent().AddLambda(
+        [WeakThis, Generation](rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver)
+        {
+            UE_LOG(LogVerseConnection, VeryVerbose, TEXT("SubPcObserver.OnRemoveTrackEvent() received receiver"));
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Generation, Receiver]() {
+                UVerseConnection* Connection = WeakThis.Get();
+                if(Connection == nullptr || Generation != Connection->SessionGeneration)
+                {
+                    return;
+                }
+                Connection->UnrouteReceiver(Receiver);
+            });
         }
     );
 
     // This connection's Status tracks the state changes of the PeerConnection,
     // specifically the subscriber since that one carries the video data and
-    // the publisher is unused.
+    // the publisher is unused. Reacting to it restarts or tears down the
+    // session, which must not happen on the signaling thread (nor from
+    // within the subscriber's own callback), so it goes to the game thread.
     SubPcObserver.OnConnectionChangeEvent().AddLambda(
-        [this](webrtc::PeerConnectionInterface::PeerConnectionState State) {
-            using StateEnum = webrtc::PeerConnectionInterface::PeerConnectionState;
-            switch (State) {
-            case StateEnum::kNew:
-                // do nothing
-                break;
-            case StateEnum::kConnecting:
-                // do nothing
-                break;
-            case StateEnum::kConnected:
-                Status->SetStatus(EConnectionStatus::Connected);
-                break;
-            case StateEnum::kDisconnected:
-                // presumably we eventually want to reconnect in this condition
-                // but for now we're not handling reconnects
-                break;
-            case StateEnum::kFailed:
-                Status->SetStatus(EConnectionStatus::Failed);
-                break;
-            case StateEnum::kClosed:
-                // this is expected when we close, but we're setting our closed
-                // state in our Close() method, so setting it here would be 
-                // redundant
-                break;
-            }
+        [WeakThis, Generation](webrtc::PeerConnectionInterface::PeerConnectionState State) {
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Generation, State]() {
+                UVerseConnection* Connection = WeakThis.Get();
+                if(Connection == nullptr || Generation != Connection->SessionGeneration)
+                {
+                    return;
+                }
+                Connection->HandleSubConnectionChange(State);
+            });
         }
     );
 
@@ -180,11 +597,27 @@ void UVerseConnection::Close()
 {
     UE_LOG(LogVerseConnection, VeryVerbose, TEXT("UVerseConnection::Close()"));
 
+    bClosing = true;
+    CancelReconnectTimer();
+    ReconnectState = EVerseReconnectState::None;
+
+    TeardownSession();
+
+    Status->SetStatus(EConnectionStatus::Closed);
+}
+
+void UVerseConnection::TeardownSession()
+{
+    UE_LOG(LogVerseConnection, VeryVerbose, TEXT("UVerseConnection::TeardownSession()"));
+
+    // Anything still on its way from this session is ignored from here on
+    ++SessionGeneration;
+
     if(RPC)
     {
         RPC->Close();
         UE_LOG(LogVerseConnection, VeryVerbose,
-            TEXT("UVerseConnection::Close() closed FJsonRpc instance"));
+            TEXT("UVerseConnection::TeardownSession() closed FJsonRpc instance"));
     }
 
     if(WS)
@@ -198,12 +631,223 @@ void UVerseConnection::Close()
         PubPc->Close();
     }
 
+    for(auto& Pair : Streams)
+    {
+        Pair.Value->DetachAudio();
+        Pair.Value->DetachVideo();
+        Pair.Value->Receivers.Empty();
+    }
+    UnroutedReceivers.Empty();
+
     if(SubPc)
     {
         SubPc->Close();
     }
+}
 
-    Status->SetStatus(EConnectionStatus::Closed);
+void UVerseConnection::HandleSubConnectionChange(
+    webrtc::PeerConnectionInterface::PeerConnectionState State)
+{
+    if(bClosing)
+    {
+        return;
+    }
+
+    using StateEnum = webrtc::PeerConnectionInterface::PeerConnectionState;
+    switch (State) {
+    case StateEnum::kNew:
+        // do nothing
+        break;
+    case StateEnum::kConnecting:
+        // do nothing
+        break;
+    case StateEnum::kConnected:
+        if(ReconnectState != EVerseReconnectState::None)
+        {
+            UE_LOG(LogVerseConnection, Log,
+                TEXT("UVerseConnection::HandleSubConnectionChange() recovered"));
+        }
+        CancelReconnectTimer();
+        ReconnectState = EVerseReconnectState::None;
+        RejoinAttempts = 0;
+        Status->SetStatus(EConnectionStatus::Connected);
+        break;
+    case StateEnum::kDisconnected:
+        // This often clears up by itself, so give it a moment before
+        // restarting ICE
+        if(ReconnectState == EVerseReconnectState::None)
+        {
+            ReconnectState = EVerseReconnectState::Disconnected;
+            Status->SetStatus(EConnectionStatus::Reconnecting);
+            SetReconnectTimer(DisconnectedGraceSeconds, &UVerseConnection::RestartIce);
+        }
+        break;
+    case StateEnum::kFailed:
+        if(ReconnectState == EVerseReconnectState::RestartingIce)
+        {
+            ScheduleRejoin();
+        }
+        else if(ReconnectState != EVerseReconnectState::WaitingToRejoin)
+        {
+            RestartIce();
+        }
+        break;
+    case StateEnum::kClosed:
+        // this is expected when we close, but we're setting our closed
+        // state in our Close() method, so setting it here would be 
+        // redundant
+        break;
+    }
+}
+
+void UVerseConnection::RestartIce()
+{
+    UE_LOG(LogVerseConnection, Log, TEXT("UVerseConnection::RestartIce()"));
+
+    ReconnectState = EVerseReconnectState::RestartingIce;
+    Status->SetStatus(EConnectionStatus::Reconnecting);
+    SetReconnectTimer(IceRestartTimeoutSeconds, &UVerseConnection::ScheduleRejoin);
+
+    // Ion only lets us start a negotiation on the publisher, so we restart ICE
+    // with a new publisher offer. The subscriber is marked for a restart too,
+    // which happens with the SFU's next offer for it.
+    SubPc->RestartIce();
+
+    const uint32 Generation = SessionGeneration;
+    CreatePubRestartDesc =
+        new rtc::RefCountedObject<FCreateSessionDescriptionObserver>();
+    SetPubRestartDesc =
+        new rtc::RefCountedObject<FSetSessionDescriptionObserver>();
+
+    CreatePubRestartDesc->OnSuccessEvent().AddLambda(
+        [this, Generation](webrtc::SessionDescriptionInterface* Desc) {
+            if(Generation == SessionGeneration)
+            {
+                PubPc->SetLocalDescription(SetPubRestartDesc, Desc);
+            }
+        });
+
+    SetPubRestartDesc->OnSuccessEvent().AddLambda([this, Generation]() {
+        if(Generation == SessionGeneration)
+        {
+            SendPubRestartOffer();
+        }
+    });
+
+    WebRtcContext->SignalingThread->PostTask(RTC_FROM_HERE, [this]() {
+        using OfferOptions =
+            webrtc::PeerConnectionInterface::RTCOfferAnswerOptions;
+        OfferOptions Options;
+        Options.ice_restart = true;
+
+        PubPc->CreateOffer(CreatePubRestartDesc, Options);
+    });
+}
+
+void UVerseConnection::SendPubRestartOffer()
+{
+    UE_LOG(LogVerseConnection, VeryVerbose, TEXT("UVerseConnection::SendPubRestartOffer()"));
+
+    std::string sdp_string;
+    PubPc->local_description()->ToString(&sdp_string);
+
+    auto OfferObject = MakeShared<FJsonObject>();
+    OfferObject->SetStringField("type", "offer");
+    OfferObject->SetStringField("sdp", UTF8_TO_TCHAR(sdp_string.c_str()));
+
+    auto MsgObject = MakeShared<FJsonObject>();
+    MsgObject->SetObjectField("desc", OfferObject);
+
+    auto MsgValue = MakeShared<FJsonValueObject>(MsgObject);
+    auto Future = RPC->Call("offer", MsgValue, FTimespan::FromSeconds(IceRestartTimeoutSeconds));
+
+    const uint32 Generation = SessionGeneration;
+    TWeakObjectPtr<UVerseConnection> WeakThis(this);
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Generation, Future](){
+        auto Response = Future.Get();
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Generation, Response]() {
+            UVerseConnection* Connection = WeakThis.Get();
+            if(Connection == nullptr || Generation != Connection->SessionGeneration)
+            {
+                return;
+            }
+            if(Response.IsError)
+            {
+                FJsonRpc::Log(Response);
+                Connection->ScheduleRejoin();
+                return;
+            }
+            Connection->SetPubAnswer(Response.Result->AsObject(),
+                TEXT("SendPubRestartOffer()"));
+        });
+    });
+}
+
+void UVerseConnection::ScheduleRejoin()
+{
+    if(bClosing || ReconnectState == EVerseReconnectState::WaitingToRejoin)
+    {
+        return;
+    }
+
+    TeardownSession();
+
+    if(RejoinAttempts >= MaxRejoinAttempts)
+    {
+        UE_LOG(LogVerseConnection, Error,
+            TEXT("UVerseConnection::ScheduleRejoin() giving up after %d attempts"),
+            RejoinAttempts);
+        CancelReconnectTimer();
+        ReconnectState = EVerseReconnectState::None;
+        Status->SetStatus(EConnectionStatus::Failed);
+        return;
+    }
+
+    // Exponential backoff, with half of it random so that everyone who lost
+    // the SFU at the same moment doesn't come back at the same moment too.
+    const float Backoff = FMath::Min(RejoinMaxDelaySeconds,
+        RejoinBaseDelaySeconds * FMath::Pow(2.0f, (float)RejoinAttempts));
+    const float Delay = Backoff * 0.5f + FMath::FRandRange(0.0f, Backoff * 0.5f);
+    RejoinAttempts++;
+
+    UE_LOG(LogVerseConnection, Log,
+        TEXT("UVerseConnection::ScheduleRejoin() attempt %d in %.1f seconds"),
+        RejoinAttempts, Delay);
+
+    ReconnectState = EVerseReconnectState::WaitingToRejoin;
+    Status->SetStatus(EConnectionStatus::Reconnecting);
+    SetReconnectTimer(Delay, &UVerseConnection::Rejoin);
+}
+
+void UVerseConnection::Rejoin()
+{
+    if(!bClosing)
+    {
+        StartSession();
+    }
+}
+
+void UVerseConnection::SetReconnectTimer(
+    const float DelaySeconds, void (UVerseConnection::*Step)())
+{
+    CancelReconnectTimer();
+    ReconnectTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateWeakLambda(this, [this, Step](float DeltaTime)
+        {
+            ReconnectTickerHandle.Reset();
+            (this->*Step)();
+            return false;
+        }),
+        DelaySeconds);
+}
+
+void UVerseConnection::CancelReconnectTimer()
+{
+    if(ReconnectTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(ReconnectTickerHandle);
+        ReconnectTickerHandle.Reset();
+    }
 }
 
 void UVerseConnection::Init(FString& Url)
@@ -226,12 +870,27 @@ void UVerseConnection::Init(FString& Url)
 
     UE_LOG(LogVerseConnection, VeryVerbose, TEXT("UVerseConnection::Init() got through making observer instances"));
 
-    if(AudioComponent == nullptr)
+    if(Streams.Num() == 0)
+    {
+        UE_LOG(LogVerseConnection, Warning,
+            TEXT("UVerseConnection::Init() no streams have been added yet, "
+                "remote tracks will be held until they are."));
+    }
+
+    if(!WebRtcContext)
+    {
+        UE_LOG(LogVerseConnection, Warning,
+            TEXT("UVerseConnection::Init() no WebRTC context was set, creating "
+                "one for this connection alone. Use a UVerseConnectionFactory "
+                "to share one between connections."));
+        WebRtcContext = MakeShared<FVerseWebRtcContext>();
+    }
+
+    if(!WebRtcContext->IsValid())
     {
         UE_LOG(LogVerseConnection, Error,
-            TEXT("UVerseConnection::Connect() Must call "
-                "UVerseConnection::SetAudioComponent(...) before calling "
-                "Connect. Aborting connection."));
+            TEXT("UVerseConnection::Init() the PeerConnectionFactory is not "
+                "available. Aborting connection."));
         return;
     }
 
@@ -239,38 +898,8 @@ void UVerseConnection::Init(FString& Url)
     auto WSC = MakeShared<FJsonRpcWebSocketChannel>(WS);
     auto RpcHandler = MakeShared<FJsonRpcEmptyHandler>();
     RPC = MakeShared<FJsonRpc>(WSC, RpcHandler);
- 
-    SignalingThread = MakeUnique<rtc::Thread>(rtc::SocketServer::CreateDefault());
-    SignalingThread->SetName("PassageSignalingThread", nullptr);
-    
-    bool bStarted  = SignalingThread->Start();
-    UE_LOG(LogVerseConnection, Log, TEXT("UVerseConnection::Init() SignallingThread->Start returned %s"),
-        bStarted ? TEXT("true") : TEXT("false"));
-
-    rtc::InitializeSSL();
-
-    std::unique_ptr<webrtc::TaskQueueFactory> TaskQueueFactory =
-        webrtc::CreateDefaultTaskQueueFactory();
-    AudioModule = FVerseAudioModule::Create(
-        TaskQueueFactory.get(), AudioComponent);
-
-    PeerConnectionFactory = webrtc::CreatePeerConnectionFactory(
-            nullptr, nullptr, SignalingThread.Get(),
-            AudioModule,
-            webrtc::CreateBuiltinAudioEncoderFactory(),
-            webrtc::CreateBuiltinAudioDecoderFactory(),
-            webrtc::CreateBuiltinVideoEncoderFactory(),
-            webrtc::CreateBuiltinVideoDecoderFactory(),
-            nullptr, nullptr
-        ).release();
 
-    if(! PeerConnectionFactory)
-    {
-        UE_LOG(LogVerseConnection, Error, TEXT("Failed to make the PeerConnectionFactory instance"));
-    }
-
-    // Could set options on the PeerConnectionFactory here if we needed to.
-    
+    const auto& PeerConnectionFactory = WebRtcContext->PeerConnectionFactory;
     PubPc = PeerConnectionFactory->CreatePeerConnection(
             GetDefaultConfig(), // default config
             nullptr, nullptr, 
@@ -291,15 +920,15 @@ void UVerseConnection::CreatePubOffer()
 
     UE_LOG(LogVerseConnection, Log,
         TEXT("UVerseConnection::CreatePubOffer() SignalingThread->IsCurrent(): %s"),
-        SignalingThread->IsCurrent() ? TEXT("true") : TEXT("false")
+        WebRtcContext->SignalingThread->IsCurrent() ? TEXT("true") : TEXT("false")
     );
 
-    SignalingThread->PostTask(RTC_FROM_HERE, [this]() {
+    WebRtcContext->SignalingThread->PostTask(RTC_FROM_HERE, [this]() {
         LogThreadId("SignalingThread->PostTask(...) this should be the signaling thread");
 
         UE_LOG(LogVerseConnection, Log,
             TEXT("SignalingThread->PostTask(...) SignalingThread->IsCurrent(): %s"),
-            SignalingThread->IsCurrent() ? TEXT("true") : TEXT("false")
+            WebRtcContext->SignalingThread->IsCurrent() ? TEXT("true") : TEXT("false")
         );
 
         // We only need the default options
@@ -313,9 +942,14 @@ void UVerseConnection::CreatePubOffer()
 
 UTexture2D* UVerseConnection::GetTexture2D()
 {
-    if(Texture2D)
+    return GetStreamTexture(FString());
+}
+
+UTexture2D* UVerseConnection::GetStreamTexture(const FString& StreamId)
+{
+    if(UTexture2D** Found = Textures.Find(StreamId))
     {
-        return Texture2D;
+        return *Found;
     }
     else
     {
@@ -326,7 +960,7 @@ UTexture2D* UVerseConnection::GetTexture2D()
         // See the call to webrtc::ConfertFromI420(...) for the generator that
         // matches this format. The byte ordering ends up being reversed, for
         // some reason.
-        Texture2D = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
+        UTexture2D* Texture2D = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
         Texture2D->UpdateResource();
 
         // FUpdateTextureRegion2D(DestX, DestY, SrcX, SrcY, Width, Height) 
@@ -355,10 +989,23 @@ UTexture2D* UVerseConnection::GetTexture2D()
             }
             );
 
+        Textures.Add(StreamId, Texture2D);
         return Texture2D;
     }
 }
 
+void UVerseConnection::BroadcastTexture(const FString& StreamId, UTexture2D* Texture)
+{
+    if(StreamId.IsEmpty())
+    {
+        OnTextureReady.Broadcast(Texture);
+    }
+    else
+    {
+        OnStreamTextureReady.Broadcast(StreamId, Texture);
+    }
+}
+
 void UVerseConnection::SendJoinRequest(FString& RemoteId)
 {
     UE_LOG(LogVerseConnection, VeryVerbose, TEXT("UVerseConnection::SendJoinRequest()"));
@@ -391,44 +1038,61 @@ void UVerseConnection::SendJoinRequest(FString& RemoteId)
     FJsonSerializer::Serialize(MsgObject, Writer);
 
     auto MsgValue = MakeShared<FJsonValueObject>(MsgObject);
-    auto Future = RPC->Call("join", MsgValue);
-
-    Async(EAsyncExecution::ThreadPool, [this, Future](){
+    // The SFU answers quickly or not at all, and the lambda below blocks a
+    // pool thread until it does, so don't let it wait forever.
+    auto Future = RPC->Call("join", MsgValue, FTimespan::FromSeconds(30));
+
+    // A failed join is retried like any other lost session
+    const uint32 Generation = SessionGeneration;
+    TWeakObjectPtr<UVerseConnection> WeakThis(this);
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Generation, Future](){
         auto Response = Future.Get();
-        if (Response.IsError) {
-            FJsonRpc::Log(Response);
-            return;
-        }
-        auto ResultValue = Response.Result;
-        auto Result = ResultValue->AsObject();
-        UE_LOG(LogVerseConnection, VeryVerbose,
-            TEXT("UVerseConnection::SendJoinRequest(): received result from"
-                " JSON-RPC `join` call"));
-
-        // get the SDP field, we know it's an answer
-        FString SDP;
-        if(Result->TryGetStringField("sdp", SDP))
-        {
-            const std::string sdp_string(TCHAR_TO_UTF8(*SDP));
-            webrtc::SdpParseError Error;
-            webrtc::SessionDescriptionInterface* Desc(
-                    webrtc::CreateSessionDescription(
-                        "answer", sdp_string, &Error));
-
-            // now we set it as the remote description
-            // TODO: do we need to do this on the signaling thread?
-            PubPc->SetRemoteDescription(
-                    SetPubRemoteDesc,
-                    Desc);
-        }
-        else 
-        {
-            UE_LOG(LogVerseConnection, Error, TEXT("UVerseConnection::"
-                "SendJoinRequest(): no sdp field in join response"));
-        }
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Generation, Response]() {
+            UVerseConnection* Connection = WeakThis.Get();
+            if(Connection == nullptr || Generation != Connection->SessionGeneration)
+            {
+                return;
+            }
+            if (Response.IsError) {
+                FJsonRpc::Log(Response);
+                Connection->ScheduleRejoin();
+                return;
+            }
+            UE_LOG(LogVerseConnection, VeryVerbose,
+                TEXT("UVerseConnection::SendJoinRequest(): received result from"
+                    " JSON-RPC `join` call"));
+            Connection->SetPubAnswer(Response.Result->AsObject(),
+                TEXT("SendJoinRequest()"));
+        });
     });
 }
 
+void UVerseConnection::SetPubAnswer(const TSharedPtr<FJsonObject>& Result,
+    const TCHAR* Caller)
+{
+    // get the SDP field, we know it's an answer
+    FString SDP;
+    if(Result.IsValid() && Result->TryGetStringField("sdp", SDP))
+    {
+        const std::string sdp_string(TCHAR_TO_UTF8(*SDP));
+        webrtc::SdpParseError Error;
+        webrtc::SessionDescriptionInterface* Desc(
+                webrtc::CreateSessionDescription(
+                    "answer", sdp_string, &Error));
+
+        // now we set it as the remote description
+        // TODO: do we need to do this on the signaling thread?
+        PubPc->SetRemoteDescription(
+                SetPubRemoteDesc,
+                Desc);
+    }
+    else 
+    {
+        UE_LOG(LogVerseConnection, Error, TEXT("UVerseConnection::"
+            "%s: no sdp field in response"), Caller);
+    }
+}
+
 void UVerseConnection::HandleSubOffer(TSharedPtr<FJsonValue> ParamsValue)
 {
     auto Params = ParamsValue->AsObject();
@@ -457,7 +1121,7 @@ void UVerseConnection::CreateSubAnswer()
     OfferOptions Options;
     Options.offer_to_receive_audio = OfferOptions::kOfferToReceiveMediaTrue;
     Options.offer_to_receive_video = OfferOptions::kOfferToReceiveMediaTrue;
-    SignalingThread->PostTask(RTC_FROM_HERE, [this, Options]() {
+    WebRtcContext->SignalingThread->PostTask(RTC_FROM_HERE, [this, Options]() {
         SubPc->CreateAnswer(
                 CreateSubLocalDesc,
                 Options);
@@ -466,7 +1130,7 @@ void UVerseConnection::CreateSubAnswer()
 
 void UVerseConnection::SetSubAnswer(webrtc::SessionDescriptionInterface* Desc)
 {
-    SignalingThread->PostTask(RTC_FROM_HERE, [this, Desc]() {
+    WebRtcContext->SignalingThread->PostTask(RTC_FROM_HERE, [this, Desc]() {
         SubPc->SetLocalDescription(
                 SetSubLocalDesc,
                 Desc);
@@ -584,42 +1248,60 @@ void UVerseConnection::HandleTrickle(TSharedPtr<FJsonValue> ParamsValue)
     }
 }
 
-void UVerseConnection::OnFrame(const webrtc::VideoFrame& frame)
+void UVerseConnection::UpdateTexture(const FString& StreamId,
+    const TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe>& Pool)
 {
-    //UE_LOG(LogVerseConnection, Log, TEXT("FRAME"));
-    const uint32_t Width = 320;
-    const uint32_t Height = 240;
-    const uint32_t ImgDataLength = 320*240*4;
-    UTexture2D* Texture = GetTexture2D();
-
-    // FUpdateTextureRegion2D(DestX, DestY, SrcX, SrcY, Width, Height) 
-    auto Regions = new FUpdateTextureRegion2D(0, 0, 0, 0, Width, Height);
+    FVideoFrame* Frame = Pool->TakeLatest();
+    if (Frame == nullptr)
+    {
+        return;
+    }
 
-    uint32_t Size = webrtc::CalcBufferSize(
-            webrtc::VideoType::kARGB,
-            frame.width(),
-            frame.height());
-    // TODO: promote this to a class member
-    uint8* ImgData = new uint8[Size];
+    // The stream may have been removed, or added again with a new pool, since
+    // the frame was converted.
+    const TSharedPtr<FVerseRemoteStream>* Stream = Streams.Find(StreamId);
+    if (Stream == nullptr || (*Stream)->FramePool != Pool)
+    {
+        Pool->Release(Frame);
+        return;
+    }
 
-    // We request ARGB, but this seems to deliver BGRA. See the call to
-    // UTexture2D::CreateTransient, which sets how this is interpreted by the
-    // renderer. Somehow it is the reverse byte order, so maybe there are
-    // mismatching assumptions about the ordering of ImgData.
-    webrtc::ConvertFromI420(frame, webrtc::VideoType::kARGB, 0, ImgData);
+    const uint32 FrameWidth = Frame->Width;
+    const uint32 FrameHeight = Frame->Height;
+    const bool bI420 = Frame->Format == EVideoFrameFormat::I420;
+    const uint32 TextureHeight = bI420 ? FrameHeight * 3 / 2 : FrameHeight;
+    const EPixelFormat PixelFormat = bI420 ? PF_G8 : PF_B8G8R8A8;
+
+    // The SFU may switch simulcast layers at any time, so the texture follows
+    // the size of the frames rather than the other way around.
+    UTexture2D* Texture = GetStreamTexture(StreamId);
+    if (Texture->GetSizeX() != FrameWidth || Texture->GetSizeY() != TextureHeight ||
+        Texture->GetPixelFormat() != PixelFormat)
+    {
+        UE_LOG(LogVerseConnection, Verbose,
+            TEXT("UVerseConnection::UpdateTexture() video size of stream '%s' changed from %dx%d to %ux%u%s"),
+            *StreamId, Texture->GetSizeX(), Texture->GetSizeY(), FrameWidth, FrameHeight,
+            bI420 ? TEXT(" I420") : TEXT(""));
+        Texture = bI420
+            ? UPassageUtils::CreateI420VideoTexture(FrameWidth, FrameHeight)
+            : UPassageUtils::CreateVideoTexture(FrameWidth, FrameHeight);
+        Textures.Add(StreamId, Texture);
+        BroadcastTexture(StreamId, Texture);
+    }
 
-    Texture->UpdateTextureRegions(
-        0, // update MipIndex 0, i.e. the most detailed level
-        1, // only update the 0th level, we don't need mipmaps for video
-        Regions,
-        (uint32)320*4, // "pitch" of data", i.e. bytes/pixel * width
-        (uint32)4, // the size of each pixel in bytes
-        ImgData,
-        [](uint8* ImgData, const FUpdateTextureRegion2D* Regions)
-        {
-            delete Regions;
-            delete[] ImgData;
-        }
-        );
+    // The frame goes back to the pool once the render thread has copied it
+    auto OnUpdated = [Pool, Frame]()
+    {
+        Pool->Release(Frame);
+    };
+    if (bI420)
+    {
+        UPassageUtils::UpdateI420VideoTexture(Texture, Frame->Data.GetData(),
+            FrameWidth, FrameHeight, OnUpdated);
+    }
+    else
+    {
+        UPassageUtils::UpdateVideoTexture(Texture, Frame->Data.GetData(),
+            FrameWidth, FrameHeight, OnUpdated);
+    }
 }
-
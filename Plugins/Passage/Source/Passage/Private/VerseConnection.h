@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
 
 #include "WebRtcGuards.h"
 
@@ -16,6 +17,22 @@ DECLARE_LOG_CATEGORY_EXTERN(LogVerseConnection, Log, All);
 
 class IWebSocket;
 class UVerseConnection;
+class FVerseWebRtcContext;
+class FVideoFramePool;
+struct FVerseRemoteStream;
+
+/** Where a UVerseConnection is in recovering from network trouble */
+enum class EVerseReconnectState : uint8
+{
+    /** Connected, or still connecting for the first time */
+    None,
+    /** The subscriber lost its connection, waiting to see if it comes back */
+    Disconnected,
+    /** Waiting for an ICE restart to bring the subscriber back */
+    RestartingIce,
+    /** The session was torn down, waiting to join it again */
+    WaitingToRejoin
+};
 
 /**
  * This class is only used indirectly via the UVerseVideoChatProvider. To use
@@ -27,7 +44,21 @@ class UVerseConnection;
  *
  * At any time you can call the GetTexture2D() method and connect the resulting
  * UTexture2D to a material. That texture will be updated with video data
- * whenever it is available.
+ * whenever it is available. When the remote video changes resolution the
+ * texture is replaced, and OnTextureReady is broadcast again with the new one.
+ *
+ * Alternatively, one connection can carry the media of many remote users in
+ * the same Ion session over a single subscriber PeerConnection. Instead of
+ * SetAudioComponent, call AddStream(...) for each user with the id of the
+ * stream they publish, and listen to OnStreamTextureReady for their textures.
+ * Users can be added and removed at any time; the SFU renegotiates the
+ * subscriber connection as publishers come and go.
+ *
+ * If the network drops out, the connection first waits a few seconds for it
+ * to come back, then tries an ICE restart, and finally tears the session down
+ * and joins it again with an exponential backoff. The Status is Reconnecting
+ * meanwhile. Streams and their textures are kept throughout, so nothing bound
+ * to them has to be set up again.
  *
  * A major assumption made in this implementation is that some other component
  * will handle player presence and identifying users/avatars by a unique
@@ -35,8 +66,7 @@ class UVerseConnection;
  */
 UCLASS()
 class PASSAGE_API UVerseConnection :
-    public UObject,
-    public rtc::VideoSinkInterface<webrtc::VideoFrame>
+    public UObject
 {
     GENERATED_BODY()
 
@@ -48,6 +78,10 @@ public:
     DECLARE_MULTICAST_DELEGATE_OneParam(FOnTextureReady, UTexture2D*)
     FOnTextureReady OnTextureReady;
 
+    /** Like OnTextureReady, for the streams added with AddStream(...) */
+    DECLARE_MULTICAST_DELEGATE_TwoParams(FOnStreamTextureReady, const FString&, UTexture2D*)
+    FOnStreamTextureReady OnStreamTextureReady;
+
     /**
      * Even though this class is not blueprintable, we may want to expose this
      * connection status to blueprint. ConnectionStatus instances are blueprint
@@ -57,12 +91,46 @@ public:
     UConnectionStatus* Status;
 
     /**
-     * You must set the AudioComponent before calling Connect. UObjects must have
-     * default constructors, so this couldn't be a constructor parameter.
+     * You must set the AudioComponent before calling Connect, unless you use
+     * AddStream instead. UObjects must have default constructors, so this
+     * couldn't be a constructor parameter. Every remote track is played
+     * through this AudioComponent and GetTexture2D(), whatever its stream.
      */
     UFUNCTION()
     void SetAudioComponent(UPARAM() UAudioComponent* AudioComponent);
 
+    /**
+     * Routes the remote tracks of the stream with StreamId to AudioComponent
+     * and to a texture announced through OnStreamTextureReady. Tracks that
+     * arrived before the stream was added are picked up immediately.
+     */
+    void AddStream(const FString& StreamId, UAudioComponent* AudioComponent);
+
+    /**
+     * Stops routing the stream's tracks. They stay subscribed in case the
+     * stream is added again, and are dropped once the SFU removes them.
+     */
+    void RemoveStream(const FString& StreamId);
+
+    /** The number of streams added with AddStream or SetAudioComponent */
+    int32 GetStreamCount() const { return Streams.Num(); }
+
+    /**
+     * Uploads the video of the streams added from now on as packed I420
+     * textures, see UPassageUtils::CreateI420VideoTexture, so the material
+     * converts them to RGB instead of a pool thread. Videos with an odd width
+     * or height still come as BGRA.
+     */
+    void SetUploadI420(bool bUpload) { bUploadI420 = bUpload; }
+
+    /**
+     * Sets the WebRTC threads and PeerConnectionFactory to use, which are
+     * shared with the other connections made by the same
+     * UVerseConnectionFactory. Call it before Connect. Without one, Connect
+     * creates a context just for this connection.
+     */
+    void SetWebRtcContext(TSharedPtr<FVerseWebRtcContext> Context);
+
     /**
      * Creates a WebRTC peer connection to the Ion SFU using the Url as the base
      * and appending the RemoteId as the last URL element. Since this signifies
@@ -82,27 +150,33 @@ public:
     void Close();
 
 
-protected:
-
-    // rtc::VideoSinkInterface<webrtc::VideoFrame> implementation
-    void OnFrame(const webrtc::VideoFrame& frame) override;
-
 private:    
     TSharedPtr<IWebSocket> WS;
     TSharedPtr<FJsonRpc> RPC;
-    TUniquePtr<rtc::Thread> SignalingThread;
+    FString SessionUrl;
 
-    UAudioComponent* AudioComponent;
+    /**
+     * Declared before the peer connections so that it is destroyed after them,
+     * since it owns the threads they shut down on.
+     */
+    TSharedPtr<FVerseWebRtcContext> WebRtcContext;
 
-    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> PeerConnectionFactory;
     rtc::scoped_refptr<webrtc::PeerConnectionInterface> PubPc;
     rtc::scoped_refptr<webrtc::PeerConnectionInterface> SubPc;
 
     /**
-     * Each connection uses a different AudioModule instance since the "module"
-     * connects to an Audio Actor in the 3D scene.
+     * The sinks and textures for each stream, keyed by stream id. The stream
+     * added by SetAudioComponent has an empty id and receives every track.
      */
-    rtc::scoped_refptr<webrtc::AudioDeviceModule> AudioModule;
+    TMap<FString, TSharedPtr<FVerseRemoteStream>> Streams;
+
+    /** Remote tracks whose stream hasn't been added (yet), keyed by stream id */
+    TMap<FString, TArray<rtc::scoped_refptr<webrtc::RtpReceiverInterface>>> UnroutedReceivers;
+
+    void RouteReceiver(rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver);
+    void UnrouteReceiver(rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver);
+    void AttachReceiver(const FString& StreamId, FVerseRemoteStream& Stream,
+        rtc::scoped_refptr<webrtc::RtpReceiverInterface> Receiver);
 
     FPeerConnectionObserver PubPcObserver;
     rtc::scoped_refptr<FCreateSessionDescriptionObserver> CreatePubLocalDesc;
@@ -115,6 +189,55 @@ private:
     rtc::scoped_refptr<FSetSessionDescriptionObserver> SetSubLocalDesc;
 
     void Init(FString& Url);
+
+    /**
+     * Runs Init and hooks up the whole negotiation, for the first connection
+     * and for every rejoin after that.
+     */
+    void StartSession();
+
+    /**
+     * Closes the signaling and peer connections of the current session, but
+     * keeps the streams so their tracks can be routed again after a rejoin.
+     */
+    void TeardownSession();
+
+    static constexpr float DisconnectedGraceSeconds = 3.0f;
+    static constexpr float IceRestartTimeoutSeconds = 10.0f;
+    static constexpr float RejoinBaseDelaySeconds = 1.0f;
+    static constexpr float RejoinMaxDelaySeconds = 30.0f;
+    static constexpr int32 MaxRejoinAttempts = 10;
+
+    EVerseReconnectState ReconnectState = EVerseReconnectState::None;
+    int32 RejoinAttempts = 0;
+    bool bClosing = false;
+    bool bUploadI420 = false;
+
+    /**
+     * Bumped with every session so callbacks from a torn down one can tell
+     * they're stale and do nothing.
+     */
+    uint32 SessionGeneration = 0;
+
+    FTSTicker::FDelegateHandle ReconnectTickerHandle;
+
+    rtc::scoped_refptr<FCreateSessionDescriptionObserver> CreatePubRestartDesc;
+    rtc::scoped_refptr<FSetSessionDescriptionObserver> SetPubRestartDesc;
+
+    // Runs on the game thread, for the session that reported the change
+    void HandleSubConnectionChange(
+        webrtc::PeerConnectionInterface::PeerConnectionState State);
+    void RestartIce();
+    void SendPubRestartOffer();
+    void ScheduleRejoin();
+    void Rejoin();
+
+    /** Runs Step on the game thread after DelaySeconds, replacing any pending step */
+    void SetReconnectTimer(float DelaySeconds, void (UVerseConnection::*Step)());
+    void CancelReconnectTimer();
+
+    /** Makes the SDP answer in Result the PubPc's remote description */
+    void SetPubAnswer(const TSharedPtr<FJsonObject>& Result, const TCHAR* Caller);
     void CreatePubOffer();
     void SendJoinRequest(FString& RemoteId);
 
@@ -125,10 +248,21 @@ private:
 
     void HandleTrickle(TSharedPtr<FJsonValue> Params);
 
-    UTexture2D* Texture2D;
+    /** The video texture of each stream, keyed like Streams */
+    UPROPERTY()
+    TMap<FString, UTexture2D*> Textures;
     UTexture2D* GetTexture2D();
+    UTexture2D* GetStreamTexture(const FString& StreamId);
+    void BroadcastTexture(const FString& StreamId, UTexture2D* Texture);
     FString ChannelName;
 
+    /**
+     * Runs on the game thread to upload the newest converted frame of a
+     * stream, replacing its texture first if the frame size has changed.
+     */
+    void UpdateTexture(const FString& StreamId,
+        const TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe>& Pool);
+
     /**
      * We use the same RTCConfiguration for both the PubPc and SubPc, so this
      * returns the common configuration prameters.
@@ -1,12 +1,78 @@
 // Copyright Enva Division
 
 #include "VerseConnectionFactory.h"
+#include "VerseAudioModule.h"
 
 DEFINE_LOG_CATEGORY(LogVerseConnectionFactory);
 
+namespace
+{
+    TUniquePtr<rtc::Thread> StartThread(const char* Name)
+    {
+        auto Thread = MakeUnique<rtc::Thread>(rtc::SocketServer::CreateDefault());
+        Thread->SetName(Name, nullptr);
+        const bool bStarted = Thread->Start();
+        UE_LOG(LogVerseConnectionFactory, Log, TEXT("StartThread() %s->Start returned %s"),
+            UTF8_TO_TCHAR(Name), bStarted ? TEXT("true") : TEXT("false"));
+        return Thread;
+    }
+}
+
+FVerseWebRtcContext::FVerseWebRtcContext()
+{
+    UE_LOG(LogVerseConnectionFactory, Log, TEXT("FVerseWebRtcContext() constructor"));
+
+    rtc::InitializeSSL();
+
+    NetworkThread = StartThread("PassageNetworkThread");
+    WorkerThread = StartThread("PassageWorkerThread");
+    SignalingThread = StartThread("PassageSignalingThread");
+
+    std::unique_ptr<webrtc::TaskQueueFactory> TaskQueueFactory =
+        webrtc::CreateDefaultTaskQueueFactory();
+    AudioModule = FVerseAudioModule::Create(TaskQueueFactory.get());
+
+    PeerConnectionFactory = webrtc::CreatePeerConnectionFactory(
+            NetworkThread.Get(), WorkerThread.Get(), SignalingThread.Get(),
+            AudioModule,
+            webrtc::CreateBuiltinAudioEncoderFactory(),
+            webrtc::CreateBuiltinAudioDecoderFactory(),
+            webrtc::CreateBuiltinVideoEncoderFactory(),
+            webrtc::CreateBuiltinVideoDecoderFactory(),
+            nullptr, nullptr
+        ).release();
+
+    if(! PeerConnectionFactory)
+    {
+        UE_LOG(LogVerseConnectionFactory, Error, TEXT("Failed to make the PeerConnectionFactory instance"));
+    }
+
+    // Could set options on the PeerConnectionFactory here if we needed to.
+}
+
+FVerseWebRtcContext::~FVerseWebRtcContext()
+{
+    UE_LOG(LogVerseConnectionFactory, Log, TEXT("~FVerseWebRtcContext() destructor"));
+
+    // The factory shuts down on its threads, so they have to outlive it
+    PeerConnectionFactory = nullptr;
+    AudioModule = nullptr;
+
+    SignalingThread->Stop();
+    WorkerThread->Stop();
+    NetworkThread->Stop();
+}
+
 UVerseConnection* UVerseConnectionFactory::CreateConnection()
 {
     UE_LOG(LogVerseConnectionFactory, Log, TEXT("UVerseConnectionFactory::CreateConnection()"));
-    // TODO: set any shared resource properties that need initialization
-    return NewObject<UVerseConnection>(this);
+
+    if(!WebRtcContext)
+    {
+        WebRtcContext = MakeShared<FVerseWebRtcContext>();
+    }
+
+    UVerseConnection* Connection = NewObject<UVerseConnection>(this);
+    Connection->SetWebRtcContext(WebRtcContext);
+    return Connection;
 }
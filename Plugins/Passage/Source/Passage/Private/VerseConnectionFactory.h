@@ -10,6 +10,31 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogVerseConnectionFactory, Log, All);
 
+/**
+ * The WebRTC threads, audio device and PeerConnectionFactory that every
+ * UVerseConnection from the same UVerseConnectionFactory shares, so that each
+ * remote participant only costs its own peer connections and tracks. The
+ * connections hold a shared pointer to this, which keeps it alive until the
+ * last of their peer connections has been destroyed.
+ */
+class FVerseWebRtcContext
+{
+public:
+
+    FVerseWebRtcContext();
+    ~FVerseWebRtcContext();
+
+    /** False if the PeerConnectionFactory could not be created */
+    bool IsValid() const { return PeerConnectionFactory != nullptr; }
+
+    TUniquePtr<rtc::Thread> NetworkThread;
+    TUniquePtr<rtc::Thread> WorkerThread;
+    TUniquePtr<rtc::Thread> SignalingThread;
+
+    rtc::scoped_refptr<webrtc::AudioDeviceModule> AudioModule;
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> PeerConnectionFactory;
+};
+
 UCLASS(BlueprintType)
 class PASSAGE_API UVerseConnectionFactory:
     public UObject
@@ -22,6 +47,7 @@ public:
 
 private:
 
-    // TUniquePtr<rtc::Thread> SignalingThread;
+    /** Created with the first connection */
+    TSharedPtr<FVerseWebRtcContext> WebRtcContext;
 
 };
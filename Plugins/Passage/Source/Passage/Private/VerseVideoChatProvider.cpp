@@ -16,6 +16,11 @@ void UVerseVideoChatProvider::AttachMedia_Implementation(
 	UAudioComponent* AudioComponent
 	)
 {
+	if (bShareSessions) {
+		AttachSessionMedia(Participant, Material, ParameterName, AudioComponent);
+		return;
+	}
+
 	FParticipantInfo Info;
 
 	if (ParticipantInfo.Contains(Participant)) {
@@ -27,6 +32,7 @@ void UVerseVideoChatProvider::AttachMedia_Implementation(
 	}
 	else {
 		UVerseConnection* VerseConnection = ConnectionFactory->CreateConnection();
+		VerseConnection->SetUploadI420(bUploadI420);
 		Info = { VerseConnection, Material, ParameterName, AudioComponent };
 		ParticipantInfo.Add(Participant, Info);
 	}
@@ -88,8 +94,13 @@ void UVerseVideoChatProvider::AttachMedia_Implementation(
 void UVerseVideoChatProvider::DetachMedia_Implementation(UParticipant* Participant) {
 	if (IsValid(Participant) && ParticipantInfo.Contains(Participant)) {
 		FParticipantInfo Info = ParticipantInfo[Participant];
-		Info.VerseConnection->Close();
 		ParticipantInfo.Remove(Participant);
+		if (bShareSessions) {
+			RemoveSessionStream(Participant->Id, Info.VerseConnection);
+		}
+		else {
+			Info.VerseConnection->Close();
+		}
 	}
 	else if(IsValid(Participant)) {
 		UE_LOG(LogVerseVideoChatProvider, Error,
@@ -106,4 +117,100 @@ void UVerseVideoChatProvider::DetachMedia_Implementation(UParticipant* Participa
 void UVerseVideoChatProvider::SetUrl(FString& Value)
 {
 	Url = Value;
-}
\ No newline at end of file
+}
+
+void UVerseVideoChatProvider::AttachSessionMedia(
+	UParticipant* Participant,
+	UMaterialInstanceDynamic* Material,
+	const FString& ParameterName,
+	UAudioComponent* AudioComponent
+	)
+{
+	if (!IsValid(Participant) || !IsValid(Material) || ParameterName.IsEmpty() ||
+		!IsValid(AudioComponent)) {
+		UE_LOG(LogVerseVideoChatProvider, Error, TEXT(
+			"VerseVideoChatProvider::AttachSessionMedia(): Invalid Participant, "
+			"Material, MaterialParameter or AudioComponent"
+		));
+		return;
+	}
+
+	if (Url.IsEmpty()) {
+		UE_LOG(LogVerseVideoChatProvider, Error, TEXT(
+			"BaseUrl is empty, unable to initialize connection to Verse video server"
+		));
+		return;
+	}
+
+	UVerseConnection* VerseConnection =
+		GetSessionConnection(Participant->ServerLocation);
+
+	// A participant that moved to another server location leaves the session
+	// of the old one
+	if (const FParticipantInfo* Previous = ParticipantInfo.Find(Participant)) {
+		if (Previous->VerseConnection != VerseConnection) {
+			RemoveSessionStream(Participant->Id, Previous->VerseConnection);
+		}
+	}
+
+	ParticipantInfo.Add(Participant,
+		{ VerseConnection, Material, ParameterName, AudioComponent });
+
+	// Adding the participant's stream again replaces its old components. The
+	// texture arrives through HandleStreamTextureReady.
+	VerseConnection->AddStream(Participant->Id, AudioComponent);
+}
+
+UVerseConnection* UVerseVideoChatProvider::GetSessionConnection(
+	const FString& ServerLocation)
+{
+	if (UVerseConnection** Found = SessionConnections.Find(ServerLocation)) {
+		return *Found;
+	}
+
+	UVerseConnection* VerseConnection = ConnectionFactory->CreateConnection();
+	VerseConnection->SetUploadI420(bUploadI420);
+	VerseConnection->OnStreamTextureReady.AddUObject(
+		this, &UVerseVideoChatProvider::HandleStreamTextureReady);
+	SessionConnections.Add(ServerLocation, VerseConnection);
+
+	FString ChannelName = ServerLocation;
+	UE_LOG(LogVerseVideoChatProvider, Log,
+		TEXT("Connecting to Url '%s' with shared sid '%s'"),
+		*Url, *ChannelName);
+
+	VerseConnection->Connect(Url, ChannelName);
+	return VerseConnection;
+}
+
+void UVerseVideoChatProvider::RemoveSessionStream(
+	const FString& StreamId, UVerseConnection* VerseConnection)
+{
+	// The session stays up for the others on the same server location
+	VerseConnection->RemoveStream(StreamId);
+	if (VerseConnection->GetStreamCount() != 0) {
+		return;
+	}
+
+	VerseConnection->Close();
+	// By connection rather than location, since the participant's
+	// ServerLocation may no longer be the one it was attached with
+	for (auto It = SessionConnections.CreateIterator(); It; ++It) {
+		if (It.Value() == VerseConnection) {
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UVerseVideoChatProvider::HandleStreamTextureReady(
+	const FString& StreamId, UTexture2D* Texture)
+{
+	for (const auto& Pair : ParticipantInfo) {
+		if (IsValid(Pair.Key) && Pair.Key->Id == StreamId &&
+			IsValid(Pair.Value.Material)) {
+			Pair.Value.Material->SetTextureParameterValue(
+				FName(Pair.Value.MaterialParameter),
+				Texture);
+		}
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright Enva Division
+
+#include "VideoFramePool.h"
+
+FVideoFramePool::~FVideoFramePool()
+{
+	// Frames still out with a consumer are the consumer's to release, which
+	// is why whoever uses us keeps a shared pointer to us until then.
+	for (const FVideoFrame* Frame : FreeFrames)
+	{
+		delete Frame;
+	}
+	delete Latest;
+}
+
+FVideoFrame* FVideoFramePool::Acquire(const uint32 Width, const uint32 Height,
+	const EVideoFrameFormat Format)
+{
+	FVideoFrame* Frame = nullptr;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FreeFrames.Num() > 0)
+		{
+			Frame = FreeFrames.Pop(false);
+		}
+	}
+	if (Frame == nullptr)
+	{
+		Frame = new FVideoFrame();
+	}
+
+	// Keeps the allocation when the size is unchanged or smaller
+	Frame->Data.SetNumUninitialized(FVideoFrame::GetDataSize(Width, Height, Format), false);
+	Frame->Width = Width;
+	Frame->Height = Height;
+	Frame->Format = Format;
+	return Frame;
+}
+
+bool FVideoFramePool::Publish(FVideoFrame* Frame)
+{
+	FVideoFrame* Dropped;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Dropped = Latest;
+		Latest = Frame;
+	}
+	++PublishedCount;
+
+	if (Dropped != nullptr)
+	{
+		++DroppedCount;
+		Release(Dropped);
+		return false;
+	}
+	return true;
+}
+
+FVideoFrame* FVideoFramePool::TakeLatest()
+{
+	FScopeLock ScopeLock(&Lock);
+	FVideoFrame* Frame = Latest;
+	Latest = nullptr;
+	return Frame;
+}
+
+void FVideoFramePool::Release(FVideoFrame* Frame)
+{
+	if (Frame == nullptr)
+	{
+		return;
+	}
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FreeFrames.Num() < MaxFreeFrames)
+		{
+			FreeFrames.Push(Frame);
+			return;
+		}
+	}
+	delete Frame;
+}
@@ -0,0 +1,101 @@
+// Copyright Enva Division
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** How the pixels of an FVideoFrame are laid out in its Data */
+enum class EVideoFrameFormat : uint8
+{
+	/** Width x Height pixels of 4 bytes, as PF_B8G8R8A8 */
+	BGRA,
+
+	/**
+	 * The planes of an I420 frame packed into one Width x (Height * 3 / 2)
+	 * single channel image, for the GPU to convert: the Y plane, followed by
+	 * Height / 2 rows that each hold a row of the U plane and then a row of the
+	 * V plane. Width and Height must be even. See
+	 * UPassageUtils::CreateI420VideoTexture.
+	 */
+	I420
+};
+
+/** One decoded video frame, owned by an FVideoFramePool. */
+struct FVideoFrame
+{
+	TArray<uint8> Data;
+	uint32 Width = 0;
+	uint32 Height = 0;
+	EVideoFrameFormat Format = EVideoFrameFormat::BGRA;
+
+	/** The number of bytes of Data for a frame of this size and format */
+	static int32 GetDataSize(const uint32 Width, const uint32 Height, const EVideoFrameFormat Format)
+	{
+		return Format == EVideoFrameFormat::I420 ? Width * Height * 3 / 2 : Width * Height * 4;
+	}
+};
+
+/**
+ * The FVideoFramePool hands out recycled frame buffers to a video decoder
+ * thread for a single remote stream, and keeps only the newest finished frame
+ * for the game thread to pick up. If the game thread falls behind, the frames
+ * it never got to are dropped and counted rather than queued, so a stall
+ * can't make memory grow and a late frame is never shown after a newer one.
+ *
+ * The usual cycle is Acquire() and Publish() on the decoder thread, then
+ * TakeLatest() on the game thread and Release() once the texture upload has
+ * copied the data, which is typically on the render thread. In steady state
+ * that's three buffers, one for each stage, and no allocations.
+ */
+class FVideoFramePool
+{
+public:
+
+	/** The most frames kept for reuse. More are freed when released. */
+	static constexpr int32 MaxFreeFrames = 3;
+
+	FVideoFramePool() = default;
+	~FVideoFramePool();
+
+	/**
+	 * Returns a frame sized for Width x Height pixels in Format for the caller
+	 * to fill, reusing a released one when possible. Pass it to Publish() or
+	 * Release() when done.
+	 */
+	FVideoFrame* Acquire(const uint32 Width, const uint32 Height,
+		const EVideoFrameFormat Format = EVideoFrameFormat::BGRA);
+
+	/**
+	 * Makes Frame the newest frame, dropping the previous one if it was never
+	 * taken.
+	 * @return True if there was no frame waiting before this one, meaning the
+	 * caller should arrange for TakeLatest() to be called. Otherwise a call is
+	 * already on its way and will find this frame instead.
+	 */
+	bool Publish(FVideoFrame* Frame);
+
+	/**
+	 * Takes the newest published frame, or returns nullptr if there hasn't been
+	 * one since the last call. The caller owns the frame until it calls
+	 * Release().
+	 */
+	FVideoFrame* TakeLatest();
+
+	/** Returns a frame to the pool. Safe to call from any thread. */
+	void Release(FVideoFrame* Frame);
+
+	/** The number of frames published so far */
+	uint32 GetPublishedCount() const { return PublishedCount; }
+
+	/** The number of published frames that were replaced before being taken */
+	uint32 GetDroppedCount() const { return DroppedCount; }
+
+private:
+
+	mutable FCriticalSection Lock;
+	TArray<FVideoFrame*> FreeFrames;
+	FVideoFrame* Latest = nullptr;
+
+	TAtomic<uint32> PublishedCount { 0 };
+	TAtomic<uint32> DroppedCount { 0 };
+};
@@ -17,6 +17,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWarningEvent, const FString&, Messa
 
 
 class UAgoraVideoChatProvider;
+class FVideoFramePool;
+class FAudioJitterBuffer;
 
 class FFrameObserver :
 	public agora::media::IAudioFrameObserver,
@@ -61,6 +63,37 @@ public:
 	virtual bool onTranscodedVideoFrame(VideoFrame& videoFrame) override;
 	virtual bool onCaptureVideoFrame(agora::rtc::VIDEO_SOURCE_TYPE sourceType, VideoFrame& videoFrame) override;
 	virtual bool onPreEncodeVideoFrame(agora::rtc::VIDEO_SOURCE_TYPE sourceType, VideoFrame& videoFrame) override;
+
+	/**
+	 * The pool that incoming video frames for a remote user are decoded into,
+	 * created on first use. Safe to call from any thread.
+	 */
+	TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe> GetFramePool(const agora::rtc::uid_t Uid);
+
+	/**
+	 * Forgets the frame pool for a remote user that has left. Frames that are
+	 * still being uploaded keep the pool alive until they're done.
+	 */
+	void RemoveFramePool(const agora::rtc::uid_t Uid);
+
+private:
+
+	FCriticalSection FramePoolsLock;
+	TMap<uint32, TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe>> FramePools;
+
+	/** Remote users whose odd-sized video we've already warned about, guarded by FramePoolsLock */
+	TSet<uint32> OddSizedUids;
+
+	/** True the first time it's called for Uid, until its pool is removed */
+	bool FirstOddSizedFrame(const agora::rtc::uid_t Uid);
+
+	/**
+	 * Runs on the game thread to put the newest frame in Pool onto Uid's
+	 * texture on the Provider. Only one of these is in flight per pool at a time, however
+	 * many frames arrive meanwhile.
+	 */
+	static void UpdateTexture(UAgoraVideoChatProvider* Provider, const uint32 Uid,
+		const TSharedPtr<FVideoFramePool, ESPMode::ThreadSafe>& Pool);
 };
 
 
@@ -147,6 +180,16 @@ public:
 	UPROPERTY(BlueprintAssignable);
 	FWarningEvent OnWarningEvent;
 
+	/**
+	 * When set before Start(), Agora hands over I420 video, which is uploaded
+	 * packed and converted to RGB by the material rather than on the CPU. The
+	 * materials must sample the texture as described by
+	 * UPassageUtils::CreateI420VideoTexture. Videos with an odd width or
+	 * height still arrive as BGRA textures.
+	 */
+	UPROPERTY(EditAnywhere)
+	bool bUploadI420 = false;
+
 	// --------------------------------------------------------
 	//  Implementation of the IRtcEngineEventHandler interface
 	// --------------------------------------------------------
@@ -236,14 +279,14 @@ private:
 	TMap< uint32, UTexture2D* > OfflineTexturesByUid;
 	TMap< uint32, FString > ParameterNamesByUid;
 
-	typedef TSharedPtr< TQueue< TSharedPtr<TArray<uint8>> > > FQueueBuffer;
+	typedef TSharedPtr< FAudioJitterBuffer, ESPMode::ThreadSafe > FAudioBuffer;
 
 	// The same buffer is stored in each of these maps so that we can fill them
 	// when we can identify them by Agora UID, versus the USoundWaveProcedural
-	// pointer, which we can use to find the right queue in the FillAudio
+	// pointer, which we can use to find the right buffer in the FillAudio
 	// method.
-	TMap< USoundWaveProcedural*, FQueueBuffer > BuffersBySoundWave;
-	TMap< uint32, FQueueBuffer > BuffersByUid;
+	TMap< USoundWaveProcedural*, FAudioBuffer > BuffersBySoundWave;
+	TMap< uint32, FAudioBuffer > BuffersByUid;
 
 	// We activate and de-activate the audio components based on whether we're
 	// currently receiving and decoding audio.
@@ -275,7 +318,7 @@ private:
 
 	// This is called by USoundWaveProcedural whenever it needs audio. We keep
 	// a reference to the Wave pointer in BuffersBySoundWave so that we can
-	// find its queue easily.
+	// find its buffer easily.
 	void FillAudio(USoundWaveProcedural* Wave, const int32 SamplesNeeded);
 
 	// Conditionally cleans up if we stopped without an explicit cleanup cue.
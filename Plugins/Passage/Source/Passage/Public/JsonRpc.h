@@ -8,6 +8,11 @@
 // UE4 WebSocket module
 #include "IWebSocket.h"
 
+#include "Containers/Ticker.h"
+
+struct FJsonRpcEnvelope;
+class FJsonRpcPendingTable;
+class FQueuedThreadPool;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogJsonRpc, Log, All);
 
@@ -36,6 +41,13 @@ enum EJsonRpcError {
     /** The FJsonRpc instance was closed before a response could be received */
     Closed = 10,
 
+    /** No response was received before the deadline passed to FJsonRpc::Call,
+     * or, sent to the remote, our handler didn't respond in time */
+    TimedOut = 11,
+
+    /** The call was abandoned through its FJsonRpcCancellation handle */
+    Cancelled = 12,
+
     /** The handler encountered an error and could not complete the procedure call */
     HandlerError = 20,
 };
@@ -57,6 +69,137 @@ struct FJsonRpcResponse {
     TSharedPtr<FJsonObject> Error;
 };
 
+/**
+ * A JSON value that hasn't been parsed yet. Incoming messages are only scanned
+ * far enough to find the envelope fields, so "params", "result" and "error"
+ * arrive as views into the received text. Handlers that can work with the raw
+ * text read GetView(); anything that wants the usual DOM calls Materialize().
+ * A lazy value may also wrap an FJsonValue that has already been parsed, in
+ * which case there is no view and Materialize() just returns it.
+ */
+class PASSAGE_API FJsonRpcLazyValue {
+public:
+    FJsonRpcLazyValue() : Start(0), Len(0) {}
+
+    FJsonRpcLazyValue(const TSharedRef<const FString>& InSource, const int32 InStart, const int32 InLen)
+        : Source(InSource), Start(InStart), Len(InLen) {}
+
+    explicit FJsonRpcLazyValue(const TSharedPtr<FJsonValue>& InValue)
+        : Value(InValue), Start(0), Len(0) {}
+
+    /** False when the field was absent from the message. */
+    bool IsSet() const { return Source.IsValid() || Value.IsValid(); }
+
+    /** True when the field was present and is the JSON literal null. */
+    bool IsNull() const;
+
+    /** True when this value is backed by received text rather than a DOM. */
+    bool HasView() const { return Source.IsValid(); }
+
+    /**
+     * The raw JSON text of the value, without copying. Empty if the value
+     * doesn't have a view.
+     */
+    FStringView GetView() const;
+
+    /**
+     * Parses the value into a DOM. Each call parses again, so hold on to the
+     * result. Returns nullptr if the text is not valid JSON.
+     */
+    TSharedPtr<FJsonValue> Materialize() const;
+
+    /** The value as a string for logging, e.g. a call id. */
+    FString ToString() const;
+
+    /**
+     * Reads a JSON string without building a DOM unless it has escapes.
+     * Returns false if the value is not a string.
+     */
+    bool TryGetString(FString& OutString) const;
+
+    /**
+     * Splits a JSON array into lazy values for its elements, so that each can
+     * be parsed on its own, or not at all. Returns false if the value is not
+     * an array.
+     */
+    bool GetArrayElements(TArray<FJsonRpcLazyValue>& OutElements) const;
+
+    /**
+     * The field of a JSON object with the given name, ignoring case like
+     * FJsonObject does. The result is not set if the field is absent or the
+     * value is not an object.
+     */
+    FJsonRpcLazyValue GetField(const FStringView Name) const;
+
+private:
+    TSharedPtr<const FString> Source;
+    TSharedPtr<FJsonValue> Value;
+    int32 Start;
+    int32 Len;
+};
+
+/**
+ * A handle that lets the caller of FJsonRpc::Call abandon the call. Once
+ * cancelled, the call's future resolves with an EJsonRpcError::Cancelled error
+ * the next time the FJsonRpc instance expires its pending calls, and a late
+ * reply from the remote is treated like any other unmatched response. The same
+ * handle may be shared by several calls to cancel them all at once.
+ */
+class FJsonRpcCancellation {
+public:
+    void Cancel() { bCancelled = true; }
+
+    bool IsCancelled() const { return bCancelled; }
+
+private:
+    TAtomic<bool> bCancelled { false };
+};
+
+/**
+ * The completion callback handed to FJsonRpcHandler::HandleAsync(). It may be
+ * invoked from any thread, and must be invoked exactly once per call.
+ */
+typedef TFunction<void(const FJsonRpcResponse&)> FJsonRpcRespond;
+
+/**
+ * Selects where FJsonRpc sends the response for a handler future that was not
+ * already resolved when the handler returned it. No thread waits on such
+ * futures; the core ticker polls them every frame and hands the ready ones to
+ * this executor. Futures that are ready immediately, which is the common case
+ * for synchronous handlers, and handlers that respond through HandleAsync()
+ * are answered on the thread they resolve on.
+ */
+enum class EJsonRpcDispatch : uint8 {
+    /** Send on a process-wide pool with a fixed number of threads. The size
+     * is read from DispatchThreads in the [JsonRpc] section of Engine.ini. */
+    WorkerPool,
+
+    /** Send on a task graph worker thread. */
+    TaskGraph,
+
+    /** Send on a dedicated thread per response. This was the original
+     * behavior and is kept for compatibility. */
+    Thread,
+};
+
+/**
+ * The wire encoding of JSON-RPC messages on a channel. Whatever a channel
+ * sends, FJsonRpc accepts both encodings inbound, so the two ends of a
+ * channel don't need to agree up front.
+ */
+enum class EJsonRpcEncoding : uint8 {
+    /** JSON text in text frames. This is the default, and what every peer
+     * understands. */
+    Json,
+
+    /** MessagePack in binary frames, for peers known to support it. */
+    MessagePack,
+
+    /** Send JSON until the peer sends a MessagePack message, then switch to
+     * MessagePack for the rest of the channel's life. */
+    MatchPeer,
+};
+
 
 /**
  * The FJsonRpcChannel is an abstract class that helps implement a two-way
@@ -77,6 +220,22 @@ public:
      */
     virtual void Send(const FString& Message) = 0;
 
+    /**
+     * True when the channel carries text as UTF-8, so that FJsonRpc should
+     * serialize straight to UTF-8 and call SendUtf8() rather than Send().
+     */
+    virtual bool PrefersUtf8() const { return false; }
+
+    /**
+     * Send a message that is already encoded as UTF-8 text. The default
+     * converts it and calls Send().
+     */
+    virtual void SendUtf8(const TArray<uint8>& Message)
+    {
+        const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Message.GetData()), Message.Num());
+        Send(FString(Converted.Length(), Converted.Get()));
+    }
+
     /**
 	 * @param Code The error code is one of the standard WebSocket error codes.
 	 * The range 5000+ is open for definition by the application, other values
@@ -91,6 +250,49 @@ public:
      */
     DECLARE_MULTICAST_DELEGATE_OneParam(FChannelMessage, const FString&);
     FChannelMessage OnMessage;
+
+    /**
+     * Like OnMessage, but the listener shares the message rather than borrows
+     * it, so it can hold on to the text without a copy. FJsonRpc listens here.
+     */
+    DECLARE_MULTICAST_DELEGATE_OneParam(FChannelSharedMessage, const TSharedRef<const FString>&);
+    FChannelSharedMessage OnSharedMessage;
+
+    /**
+     * Raises OnSharedMessage and OnMessage for a received text message.
+     * Channels call this rather than broadcast either delegate themselves, so
+     * each listener sees every message once, whichever one it is bound to.
+     */
+    void BroadcastMessage(FString&& Message)
+    {
+        BroadcastMessage(MakeShared<const FString>(MoveTemp(Message)));
+    }
+
+    void BroadcastMessage(const TSharedRef<const FString>& Message)
+    {
+        OnSharedMessage.Broadcast(Message);
+        OnMessage.Broadcast(*Message);
+    }
+
+    /**
+     * The encoding FJsonRpc should use for outbound messages right now. The
+     * default is JSON text; channels that can carry binary messages override
+     * this along with SendBinary().
+     */
+    virtual EJsonRpcEncoding GetEncoding() const { return EJsonRpcEncoding::Json; }
+
+    /**
+     * Send an encoded binary message across the channel. Only called when
+     * GetEncoding() returns EJsonRpcEncoding::MessagePack.
+     */
+    virtual void SendBinary(const TArray<uint8>& Message) { checkNoEntry(); }
+
+    /**
+     * The OnBinaryMessage delegate is called when a binary message is
+     * received from the remote end of the channel.
+     */
+    DECLARE_MULTICAST_DELEGATE_OneParam(FChannelBinaryMessage, const TArray<uint8>&);
+    FChannelBinaryMessage OnBinaryMessage;
 };
 
 /**
@@ -101,13 +303,32 @@ public:
 class FJsonRpcWebSocketChannel : public FJsonRpcChannel
 {
 public:
-    explicit FJsonRpcWebSocketChannel(const TSharedPtr<IWebSocket> InWS);
+    /**
+     * @param InEncoding Anything other than Json makes the channel read raw
+     * frames, so that it can receive MessagePack, and must be chosen before
+     * the WebSocket connects.
+     */
+    explicit FJsonRpcWebSocketChannel(const TSharedPtr<IWebSocket> InWS,
+        const EJsonRpcEncoding InEncoding = EJsonRpcEncoding::Json);
 
     virtual void Send(const FString& Message) override;
 	virtual void Close(const int32 Code, const FString& Reason) override;
+
+    virtual bool PrefersUtf8() const override { return true; }
+    virtual void SendUtf8(const TArray<uint8>& Message) override;
+
+    virtual EJsonRpcEncoding GetEncoding() const override;
+    virtual void SendBinary(const TArray<uint8>& Message) override;
 private:
 
     TSharedPtr<IWebSocket> WS;
+    EJsonRpcEncoding Encoding;
+    TAtomic<bool> bPeerSentBinary;
+
+    /** Collects the frames of a raw message until the last one arrives */
+    TArray<uint8> RawBuffer;
+
+    void OnRawMessage(const void* Data, SIZE_T Size, SIZE_T BytesRemaining);
 };
 
 /**
@@ -131,10 +352,20 @@ public:
         TSharedPtr<FJsonRpcPairedChannel> Remote;
     };
 
-    static FPair Create();
+    /**
+     * @param Encoding What both ends send. MatchPeer on one end is resolved
+     * by the other end sending MessagePack, as over a real connection.
+     */
+    static FPair Create(const EJsonRpcEncoding Encoding = EJsonRpcEncoding::Json);
 
     virtual void Send(const FString& Message) override;
 
+    EJsonRpcEncoding Encoding = EJsonRpcEncoding::Json;
+    TAtomic<bool> bPeerSentBinary { false };
+
+    virtual EJsonRpcEncoding GetEncoding() const override;
+    virtual void SendBinary(const TArray<uint8>& Message) override;
+
     /**
      * Note that for the paired channel, which is used for testing, closing is
      * a no-op.
@@ -194,6 +425,12 @@ public:
 
 	virtual void Close(const int32 Code, const FString& Reason) override;
 
+    virtual bool PrefersUtf8() const override;
+    virtual void SendUtf8(const TArray<uint8>& Message) override;
+
+    virtual EJsonRpcEncoding GetEncoding() const override;
+    virtual void SendBinary(const TArray<uint8>& Message) override;
+
 private:
 	TObjectPtr<UWorld> World;
     TSharedPtr<FJsonRpcChannel> Inner;
@@ -220,6 +457,30 @@ public:
      * a TPromise immediately.
      */
     virtual TSharedFuture<FJsonRpcResponse> Handle(FString Method, TSharedPtr<FJsonValue> Params) = 0;
+
+    /**
+     * A continuation-style alternative to Handle() for handlers that finish
+     * their work asynchronously. Return true to take ownership of the call,
+     * then invoke Respond once the response is ready, so that no thread is
+     * parked waiting on a future. The default implementation returns false,
+     * which makes FJsonRpc fall back to Handle().
+     */
+    virtual bool HandleAsync(FString Method, TSharedPtr<FJsonValue> Params, const FJsonRpcRespond& Respond)
+    {
+        return false;
+    }
+
+    /**
+     * Like HandleAsync(), but receives the params unparsed, which saves
+     * building a DOM for large payloads the handler can read another way.
+     * This is tried first; the default implementation returns false, which
+     * makes FJsonRpc materialize the params and try HandleAsync() and then
+     * Handle().
+     */
+    virtual bool HandleLazy(FString Method, const FJsonRpcLazyValue& Params, const FJsonRpcRespond& Respond)
+    {
+        return false;
+    }
 };
 
 
@@ -258,8 +519,16 @@ class PASSAGE_API FJsonRpc
 {
 public:
 
-    FJsonRpc(const TSharedPtr<FJsonRpcChannel> InChannel, const TSharedPtr<FJsonRpcHandler> InHandler);
-    ~FJsonRpc() {};
+    FJsonRpc(const TSharedPtr<FJsonRpcChannel> InChannel, const TSharedPtr<FJsonRpcHandler> InHandler,
+        const EJsonRpcDispatch InDispatch = EJsonRpcDispatch::WorkerPool);
+    ~FJsonRpc();
+
+    /**
+     * Releases the shared worker pool used by EJsonRpcDispatch::WorkerPool.
+     * Called by the module on shutdown; the pool is recreated on demand if an
+     * FJsonRpc instance dispatches to it afterwards.
+     */
+    static void ShutdownDispatchPool();
 
     /**
      * Close out the RPC session by unwinding any pending promises with errors
@@ -268,6 +537,38 @@ public:
      */
     void Close();
 
+    /**
+     * Resolves every pending call that has passed its deadline or has been
+     * cancelled. This runs automatically on the core ticker, but it's public
+     * so that callers without a ticking engine (tests, for instance) can
+     * drive it themselves.
+     */
+    void ExpirePending();
+
+    /**
+     * Sends the responses of handler futures that have resolved since the
+     * last poll, and a TimedOut error for those that have been waiting longer
+     * than the handler timeout. Like ExpirePending(), this runs automatically
+     * on the core ticker, every frame, but callers without a ticking engine
+     * can drive it themselves.
+     */
+    void PollHandlers();
+
+    /**
+     * How long a handler future may take to resolve before the remote gets a
+     * TimedOut error instead. The default is 30 seconds.
+     */
+    void SetHandlerTimeout(const FTimespan Timeout) { HandlerTimeout = Timeout; }
+
+    /** The number of calls still waiting for a response. */
+    int32 GetPendingCount() const;
+
+    /**
+     * How long the oldest outstanding call has been waiting for a response,
+     * or zero if there is none.
+     */
+    FTimespan GetOldestPendingAge() const;
+
     /**
      * Call is the method to use when you expect a response from the server,
      * or even simply want to check if the call succeeded or resulted in an
@@ -287,9 +588,19 @@ public:
      * is an envelope that indicates whether the call succeeded and has a
      * usable value, or if it failed an contains an error message. Since
      * awaiting a future blocks the thread, you'll need to use the Unreal Async
-     * function to await the future in a non-main thread.
+     * function to await the future in a non-main thread. The future always
+     * resolves: with an error when the remote replies with one, when the
+     * call times out or is cancelled, or when this instance is closed.
+     *
+     * @param Timeout How long to wait for a response before resolving with an
+     * EJsonRpcError::TimedOut error. Zero, the default, waits indefinitely.
+     *
+     * @param Cancellation An optional handle the caller can use to abandon the
+     * call before a response arrives.
      */
-    TSharedFuture<FJsonRpcResponse>Call(const FString Method, const TSharedPtr<FJsonValue> Params);
+    TSharedFuture<FJsonRpcResponse>Call(const FString Method, const TSharedPtr<FJsonValue> Params,
+        const FTimespan Timeout = FTimespan::Zero(),
+        const TSharedPtr<FJsonRpcCancellation> Cancellation = nullptr);
 
     /**
      * Notify is analogous to Call, but it does not expect any response from
@@ -311,6 +622,13 @@ public:
     DECLARE_MULTICAST_DELEGATE_TwoParams(FJsonRpcNotify, FString Method, TSharedPtr<FJsonValue> Params)
     FJsonRpcNotify& OnNotify() { return JsonRpcNotify; }
 
+    /**
+     * The same as OnNotify(), but the params are handed over unparsed. When
+     * only this delegate is bound, no DOM is built for incoming notifications.
+     */
+    DECLARE_MULTICAST_DELEGATE_TwoParams(FJsonRpcNotifyLazy, const FString& Method, const FJsonRpcLazyValue& Params)
+    FJsonRpcNotifyLazy& OnNotifyLazy() { return JsonRpcNotifyLazy; }
+
     /**
      * A convenience function to create an error response when no valid result can
      * be provided to a method invocation. Mainly we'll use this in implementing
@@ -339,15 +657,52 @@ private:
     TSharedPtr<FJsonRpcChannel> Channel;
     TSharedPtr<FJsonRpcHandler> Handler;
 
-    int PendingCounter;
-    TMap< FString, TPromise<FJsonRpcResponse> > Pending;
+    /** The calls we've sent that are still waiting for a response */
+    TUniquePtr<FJsonRpcPendingTable> Pending;
 
-    FCriticalSection CriticalSection;
+    /** How often the core ticker calls ExpirePending() */
+    static constexpr float ExpireIntervalSeconds = 0.1f;
+    FTSTicker::FDelegateHandle ExpireTickerHandle;
 
     FJsonRpcNotify JsonRpcNotify;
+    FJsonRpcNotifyLazy JsonRpcNotifyLazy;
+
+    EJsonRpcDispatch Dispatch;
+
+    /**
+     * The longest we'll wait for a handler future to resolve before answering
+     * the call with a TimedOut error.
+     */
+    FTimespan HandlerTimeout = FTimespan::FromSeconds(30);
+
+    /** A handler future that PollHandlers() is waiting on */
+    struct FAwaitedResponse {
+        TSharedFuture<FJsonRpcResponse> Future;
+        FJsonRpcRespond Respond;
+        double Deadline;
+    };
+
+    FCriticalSection AwaitedLock;
+    TArray<FAwaitedResponse> Awaited;
+    FTSTicker::FDelegateHandle PollTickerHandle;
+
+    /**
+     * Invokes Respond with the value of Future once it resolves. Ready futures
+     * are answered on the calling thread; anything else is polled by
+     * PollHandlers() and answered on the executor selected by Dispatch.
+     */
+    void Await(const TSharedFuture<FJsonRpcResponse>& Future, FJsonRpcRespond Respond);
 
-    void ProcessIncoming(const FString& Message);
+    /** Lazily creates the shared pool used by EJsonRpcDispatch::WorkerPool. */
+    static FQueuedThreadPool& GetDispatchPool();
+
+    void ProcessIncoming(const TSharedRef<const FString>& Message);
+    void ProcessIncomingBinary(const TArray<uint8>& Message);
+
+    /** Handles a parsed message that is either a batch or a single object. */
+    void ProcessValue(const TSharedPtr<FJsonValue>& MsgValue);
     void ProcessSingle(TSharedPtr<FJsonObject>);
+    void ProcessEnvelope(const FJsonRpcEnvelope& Envelope);
 
     FString GetIdAsString(TSharedPtr<FJsonObject>);
 
@@ -395,6 +750,18 @@ private:
      */
     static void SendErrorStatic(TSharedPtr<FJsonRpcChannel> Channel, FJsonRpcResponse Response, TSharedPtr<FJsonValue> Id);
 
+    /**
+     * Sends a handler's response to the call with the given Id, as either a
+     * result or an error message. Static for the same reason as above.
+     */
+    static void SendResponseStatic(TSharedPtr<FJsonRpcChannel> Channel, const FJsonRpcResponse& Response, TSharedPtr<FJsonValue> Id);
+
+    /**
+     * Serializes an outgoing message in whichever encoding the channel asks
+     * for and sends it. Every message we send goes through here.
+     */
+    static void SendObject(const TSharedPtr<FJsonRpcChannel>& Channel, const TSharedRef<FJsonObject>& MsgObject);
+
     /*
      * Pulls the error info out of the response object and sends it with a null
      * "id" field.
@@ -74,13 +74,13 @@ private:
 	 * Participant already exsits (matched by Id), then its properties will be
 	 * updated with the new values.
 	 */
-	FJsonRpcResponse AddParticipants(const TArray< TSharedPtr<FJsonValue> > Data);
+	FJsonRpcResponse AddParticipants(const TArray<FJsonRpcLazyValue>& Data);
 
 	/**
 	 * Receives an array of JSON strings representing the Participant IDs to
 	 * remove. This is a remote procedure called by the server.
 	 */
-	FJsonRpcResponse RemoveParticipants(const TArray< TSharedPtr<FJsonValue> > Data);
+	FJsonRpcResponse RemoveParticipants(const TArray<FJsonRpcLazyValue>& Data);
 
 	/**
 	 * This is also remote procedure called by the server.
@@ -90,7 +90,7 @@ private:
 	 * property name, and property value respectively. The property names are
 	 * "id", "isLocal", "active", "screenName", "serverLocation", and "data".
 	 */
-	FJsonRpcResponse UpdateParticipants(const TArray< TSharedPtr<FJsonValue> > ParticipantObjects);
+	FJsonRpcResponse UpdateParticipants(const TArray<FJsonRpcLazyValue>& ParticipantObjects);
 
 	/**
 	 * This is a helper function for the and and update procedures above.
@@ -110,6 +110,12 @@ public:
 	 */
 	virtual TSharedFuture<FJsonRpcResponse> Handle(FString Method, TSharedPtr<FJsonValue> Params) override;
 
+	/**
+	 * The participant lists can be long, so each entry is only parsed once
+	 * it's needed. Handle() goes through here too.
+	 */
+	virtual bool HandleLazy(FString Method, const FJsonRpcLazyValue& Params, const FJsonRpcRespond& Respond) override;
+
 private:
 	UPassageDirectoryProvider* Parent;
 };
@@ -86,6 +86,68 @@ public:
 	static void UpdateVideoTexture(UTexture2D* VideoTexture, uint8* ImgData,
 	                               const uint32 Width, const uint32 Height);
 
+	/**
+	 * @brief Like the above, but for image data the caller keeps ownership of,
+	 * e.g. a buffer from a pool.
+	 * @param OnUpdated Called once the texture has been updated and ImgData is
+	 * no longer needed. This normally happens on the render thread.
+	 */
+	static void UpdateVideoTexture(UTexture2D* VideoTexture, const uint8* ImgData,
+	                               const uint32 Width, const uint32 Height,
+	                               TFunction<void()> OnUpdated);
+
+	/**
+	 * @brief Creates a texture for video frames uploaded as I420, leaving the
+	 * conversion to RGB to the material instead of the CPU. The three planes
+	 * are packed into one PF_G8 texture of Width x (Height * 3 / 2) texels:
+	 * the Y plane on top, then Height / 2 rows that each hold a row of the U
+	 * plane followed by a row of the V plane. A Custom material node with a
+	 * Texture Object input "Tex" and the texture coordinates "UV" of the
+	 * picture converts it like this (BT.601, limited range, as WebRTC does):
+	 *
+	 *     float Y = Texture2DSample(Tex, TexSampler, float2(UV.x, UV.y * 2 / 3)).r;
+	 *     float2 C = float2(UV.x * 0.5, (UV.y + 2) / 3);
+	 *     float U = Texture2DSample(Tex, TexSampler, C).r - 0.5;
+	 *     float V = Texture2DSample(Tex, TexSampler, C + float2(0.5, 0)).r - 0.5;
+	 *     Y = 1.164 * (Y - 0.0625);
+	 *     float3 RGB = float3(Y + 1.596 * V, Y - 0.391 * U - 0.813 * V, Y + 2.018 * U);
+	 *     return pow(saturate(RGB), 2.2);
+	 *
+	 * @param Width The width of the video, which must be even
+	 * @param Height The height of the video, which must be even
+	 * @return A transient texture, initialized to black
+	 */
+	static UTexture2D* CreateI420VideoTexture(const uint32 Width, const uint32 Height);
+
+	/**
+	 * @brief Like UpdateVideoTexture, for a texture from
+	 * CreateI420VideoTexture and ImgData laid out by PackI420.
+	 * @param Width The width of the video, not of the texture
+	 * @param Height The height of the video, not of the texture
+	 */
+	static void UpdateI420VideoTexture(UTexture2D* VideoTexture, const uint8* ImgData,
+	                                   const uint32 Width, const uint32 Height,
+	                                   TFunction<void()> OnUpdated);
+
+	/**
+	 * @brief Copies the planes of an I420 frame into Dest, in the layout of
+	 * CreateI420VideoTexture. Dest must hold Width * Height * 3 / 2 bytes.
+	 */
+	static void PackI420(const uint8* DataY, const int32 StrideY,
+	                     const uint8* DataU, const int32 StrideU,
+	                     const uint8* DataV, const int32 StrideV,
+	                     const uint32 Width, const uint32 Height, uint8* Dest);
+
+	/**
+	 * @brief Converts an I420 frame of any size to BGRA on the CPU, in the
+	 * layout of CreateVideoTexture, for frames that PackI420 can't take.
+	 * Dest must hold Width * Height * 4 bytes.
+	 */
+	static void ConvertI420ToBGRA(const uint8* DataY, const int32 StrideY,
+	                              const uint8* DataU, const int32 StrideU,
+	                              const uint8* DataV, const int32 StrideV,
+	                              const uint32 Width, const uint32 Height, uint8* Dest);
+
 	//**Write an array to a filePath -Vishal**//
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Passage")
 	static bool WriteArrayToFile(const TArray<uint8>& Bytes, const FString& FilePath);
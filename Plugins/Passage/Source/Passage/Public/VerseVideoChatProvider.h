@@ -56,10 +56,45 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SetUrl(UPARAM(ref) FString& Value);
 
+	/*
+	 * When set, participants on the same server location share one
+	 * connection and its single subscriber PeerConnection, instead of each
+	 * getting a complete session of their own. This requires publishers to
+	 * join the Ion session named by their ServerLocation, and to publish
+	 * their media in a stream whose id is their participant Id.
+	 */
+	UPROPERTY(EditAnywhere)
+	bool bShareSessions = false;
+
+	/*
+	 * When set, video is uploaded as packed I420 and converted to RGB by the
+	 * material rather than on the CPU. The materials must sample the texture
+	 * as described by UPassageUtils::CreateI420VideoTexture.
+	 */
+	UPROPERTY(EditAnywhere)
+	bool bUploadI420 = false;
+
 
 private:
 
 	TMap<UParticipant*, FParticipantInfo> ParticipantInfo;
 	UVerseConnectionFactory* ConnectionFactory;
 
+	/* The shared connections when bShareSessions is set, by server location */
+	UPROPERTY()
+	TMap<FString, UVerseConnection*> SessionConnections;
+
+	void AttachSessionMedia(
+		UParticipant* Participant,
+		UMaterialInstanceDynamic* Material,
+		const FString& ParameterName,
+		UAudioComponent* AudioComponent);
+
+	UVerseConnection* GetSessionConnection(const FString& ServerLocation);
+
+	/* Removes a stream from a shared connection, closing it once it's unused */
+	void RemoveSessionStream(const FString& StreamId, UVerseConnection* VerseConnection);
+
+	void HandleStreamTextureReady(const FString& StreamId, UTexture2D* Texture);
+
 };
\ No newline at end of file
@@ -56,6 +56,7 @@ void FHoloLensWebSocket::Connect()
 					{
 						if (!bIsBinary)
 						{
+							PinnedThis->OnUtf8Message().Broadcast(reinterpret_cast<const UTF8CHAR*>(RawMessage.GetData()), RawMessage.Num() - 1);
 							PinnedThis->OnMessage().Broadcast(UTF8_TO_TCHAR(RawMessage.GetData()));
 						}
 						PinnedThis->OnRawMessage().Broadcast(RawMessage.GetData(), RawMessage.Num() - 1, 0);
@@ -29,6 +29,7 @@ public:
 	virtual FWebSocketClosedEvent& OnClosed() override						{ return ClosedEvent; }
 	virtual FWebSocketMessageEvent& OnMessage() override					{ return MessageEvent; }
 	virtual FWebSocketRawMessageEvent& OnRawMessage() override				{ return RawMessageEvent; }
+	virtual FWebSocketUtf8MessageEvent& OnUtf8Message() override			{ return Utf8MessageEvent; }
 	virtual FWebSocketMessageSentEvent& OnMessageSent() override { return OnMessageSentEvent; }
 
 public:
@@ -51,6 +52,7 @@ private:
 	FWebSocketClosedEvent ClosedEvent;
 	FWebSocketMessageEvent MessageEvent;
 	FWebSocketRawMessageEvent RawMessageEvent;
+	FWebSocketUtf8MessageEvent Utf8MessageEvent;
 	FWebSocketMessageSentEvent OnMessageSentEvent;
 
 	bool bUserClose;
@@ -16,6 +16,15 @@
 #include "HttpModule.h"
 #include "HttpManager.h"
 #include "PlatformHttp.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("PassageWebSockets"), STATGROUP_PassageWebSockets, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Messages Sent"), STAT_PassageWebSockets_MessagesSent, STATGROUP_PassageWebSockets);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes Sent"), STAT_PassageWebSockets_BytesSent, STATGROUP_PassageWebSockets);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Messages Sent Compressed"), STAT_PassageWebSockets_MessagesSentCompressed, STATGROUP_PassageWebSockets);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes Sent Compressed"), STAT_PassageWebSockets_BytesSentCompressed, STATGROUP_PassageWebSockets);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes Received"), STAT_PassageWebSockets_BytesReceived, STATGROUP_PassageWebSockets);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Connections With Deflate"), STAT_PassageWebSockets_DeflateConnections, STATGROUP_PassageWebSockets);
 
 // FPassageLwsSendBuffer 
 FPassageLwsSendBuffer::FPassageLwsSendBuffer(const uint8* Data, SIZE_T Size, bool bInIsBinary)
@@ -25,9 +34,25 @@ FPassageLwsSendBuffer::FPassageLwsSendBuffer(const uint8* Data, SIZE_T Size, boo
 {
 	check((LWS_PRE + Size) < INT32_MAX);
 	check(Data);
-	Payload.Reserve(LWS_PRE + Size);
-	Payload.AddDefaulted(LWS_PRE); // Reserve space for WS header data
-	Payload.Append(Data, Size);
+	FMemory::Memcpy(Reset(static_cast<int32>(Size), bInIsBinary), Data, Size);
+}
+
+FPassageLwsSendBuffer::FPassageLwsSendBuffer()
+	: bIsBinary(false)
+	, BytesWritten(0)
+	, bHasError(false)
+{
+}
+
+uint8* FPassageLwsSendBuffer::Reset(const int32 PayloadSize, const bool bInIsBinary)
+{
+	check(PayloadSize >= 0 && (LWS_PRE + PayloadSize) < INT32_MAX);
+	bIsBinary = bInIsBinary;
+	BytesWritten = 0;
+	bHasError = false;
+	// Keep the allocation, we are likely to be reused for a similarly sized packet
+	Payload.SetNumUninitialized(LWS_PRE + PayloadSize, false); // Space for WS header data, then the payload
+	return Payload.GetData() + LWS_PRE;
 }
 
 int32 FPassageLwsSendBuffer::GetPayloadSize() const
@@ -46,8 +71,8 @@ FPassageLwsReceiveBufferBinary::FPassageLwsReceiveBufferBinary(const uint8* Data
 }
 
 // FPassageLwsReceiveBufferText
-FPassageLwsReceiveBufferText::FPassageLwsReceiveBufferText(FString&& InText)
-	: Text(MoveTemp(InText))
+FPassageLwsReceiveBufferText::FPassageLwsReceiveBufferText(TArray<uint8>&& InUtf8)
+	: Utf8(MoveTemp(InUtf8))
 {
 }
 
@@ -76,6 +101,8 @@ FPassageLwsWebSocket::FPassageLwsWebSocket(const FString& InUrl, const TArray<FS
 	: State(EState::None)
 	, LastGameThreadState(EState::None)
 	, bWasSendQueueEmpty(true)
+	, bSkipCompression(false)
+	, CompressedBytesWritten(0)
 	, LwsConnection(nullptr)
 	, Url(InUrl)
 	, Protocols(InProtocols)
@@ -90,6 +117,12 @@ FPassageLwsWebSocket::~FPassageLwsWebSocket()
 	UE_LOG(LogPassageWebSockets, VeryVerbose, TEXT("FPassageLwsWebSocket[%d]: Destroyed"), Identifier);
 	checkf(LwsConnection == nullptr, TEXT("FPassageLwsWebSocket: Must have closed connection before destruction"));
 	ClearData();
+
+	FPassageLwsSendBuffer* Buffer;
+	while ((Buffer = FreeSendBuffers.Pop()) != nullptr)
+	{
+		delete Buffer;
+	}
 }
 
 void FPassageLwsWebSocket::Connect()
@@ -122,13 +155,14 @@ void FPassageLwsWebSocket::Connect()
 	State = EState::StartConnecting;
 	LastGameThreadState = State; // This is called on the game thread
 
-	bWantsMessageEvents = OnMessage().IsBound();
+	bWantsMessageEvents = OnMessage().IsBound() || OnUtf8Message().IsBound();
 	bWantsRawMessageEvents = OnRawMessage().IsBound();
 	
 	UE_LOG(LogPassageWebSockets, Verbose, TEXT("FPassageLwsWebSocket[%d]::Connect: setting State=%s url=%s bWantsMessageEvents=%d bWantsRawMessageEvents=%d"), Identifier, ToString(State), *Url, (int32)bWantsMessageEvents, (int32)bWantsRawMessageEvents);
 
 	// Clear up any data from previous runs
 	ClearData();
+	Stats = FPassageLwsWebSocketStats();
 
 	FPassageLwsWebSocketsManager& WebSocketsManager = FPassageLwsWebSocketsManager::Get();
 	WebSocketsManager.StartProcessingWebSocket(this);
@@ -155,20 +189,55 @@ void FPassageLwsWebSocket::Close(int32 Code, const FString& Reason)
 		CloseRequest.Code = Code;
 		CloseRequest.Reason = ANSIReason;
 	}
+	FPassageLwsWebSocketsManager::Get().WakeServiceThread();
 }
 
 void FPassageLwsWebSocket::Send(const void* Data, SIZE_T Size, bool bIsBinary)
 {
-	SendQueue.Enqueue(new FPassageLwsSendBuffer(static_cast<const uint8*>(Data), Size, bIsBinary));
+	check(Data);
+	check((LWS_PRE + Size) < INT32_MAX);
+	FPassageLwsSendBuffer* Buffer = AcquireSendBuffer();
+	FMemory::Memcpy(Buffer->Reset(static_cast<int32>(Size), bIsBinary), Data, Size);
+	SendQueue.Enqueue(Buffer);
+	FPassageLwsWebSocketsManager::Get().WakeServiceThread();
 }
 
 void FPassageLwsWebSocket::Send(const FString& Data)
 {
-	FTCHARToUTF8 Converted(*Data);
-	Send((uint8*)Converted.Get(), Converted.Length(), false);
+	// Encode straight into the send buffer rather than through a temporary FTCHARToUTF8
+	const int32 Utf8Length = FPlatformString::ConvertedLength<UTF8CHAR>(*Data, Data.Len());
+	FPassageLwsSendBuffer* Buffer = AcquireSendBuffer();
+	UTF8CHAR* Utf8 = reinterpret_cast<UTF8CHAR*>(Buffer->Reset(Utf8Length, false));
+	FPlatformString::Convert(Utf8, Utf8Length, *Data, Data.Len());
+	SendQueue.Enqueue(Buffer);
+	FPassageLwsWebSocketsManager::Get().WakeServiceThread();
+
 	OnMessageSent().Broadcast(Data);
 }
 
+FPassageLwsSendBuffer* FPassageLwsWebSocket::AcquireSendBuffer()
+{
+	if (FPassageLwsSendBuffer* Buffer = FreeSendBuffers.Pop())
+	{
+		NumFreeSendBuffers.Decrement();
+		return Buffer;
+	}
+	return new FPassageLwsSendBuffer();
+}
+
+void FPassageLwsWebSocket::ReleaseSendBuffer(FPassageLwsSendBuffer* Buffer)
+{
+	if (Buffer->Payload.Max() <= MaxPooledSendBufferSize + (int32)LWS_PRE && NumFreeSendBuffers.GetValue() < MaxFreeSendBuffers)
+	{
+		NumFreeSendBuffers.Increment();
+		FreeSendBuffers.Push(Buffer);
+	}
+	else
+	{
+		delete Buffer;
+	}
+}
+
 void FPassageLwsWebSocket::SendFromQueue()
 {
 	check(LwsConnection);
@@ -193,10 +262,25 @@ void FPassageLwsWebSocket::SendFromQueue()
 		}
 
 		const bool bFinishedSending = bIsDone || !bWriteSuccessful;
+		if (bIsDone)
+		{
+			const int32 PayloadSize = CurrentBuffer->GetPayloadSize();
+			++Stats.MessagesSent;
+			Stats.BytesSent += PayloadSize;
+			INC_DWORD_STAT(STAT_PassageWebSockets_MessagesSent);
+			INC_DWORD_STAT_BY(STAT_PassageWebSockets_BytesSent, PayloadSize);
+			if (Stats.bPerMessageDeflate && !bSkipCompression)
+			{
+				++Stats.MessagesSentCompressed;
+				Stats.BytesSentCompressed += CompressedBytesWritten;
+				INC_DWORD_STAT(STAT_PassageWebSockets_MessagesSentCompressed);
+				INC_DWORD_STAT_BY(STAT_PassageWebSockets_BytesSentCompressed, CompressedBytesWritten);
+			}
+		}
 		if (bFinishedSending)
 		{
 			SendQueue.Dequeue(CurrentBuffer);
-			delete CurrentBuffer;
+			ReleaseSendBuffer(CurrentBuffer);
 		}
 	}
 
@@ -216,7 +300,7 @@ void FPassageLwsWebSocket::ClearData()
 	FPassageLwsSendBuffer* SendBuffer;
 	while (SendQueue.Dequeue(SendBuffer))
 	{
-		delete SendBuffer;
+		ReleaseSendBuffer(SendBuffer);
 	}
 	ReceiveBuffer.Empty(0); // Also clear temporary receive buffer
 	if (CloseRequest.Reason)
@@ -243,6 +327,13 @@ bool FPassageLwsWebSocket::WriteBuffer(FPassageLwsSendBuffer& Buffer)
 		WriteProtocol = LWS_WRITE_TEXT;
 	}
 
+	if (Buffer.BytesWritten == 0)
+	{
+		// Decided once per message, the extension sees every lws_write of it
+		bSkipCompression = Buffer.GetPayloadSize() < FPassageLwsWebSocketsManager::Get().GetPerMessageDeflateThreshold();
+		CompressedBytesWritten = 0;
+	}
+
 	// Payload is modified in the call to lws_write, for libwebsockets to be able to use already allocated memory instead of needing to allocate more
 	uint8* Payload = Buffer.Payload.GetData();
 	const int32 PayloadSize = Buffer.Payload.Num();
@@ -282,13 +373,21 @@ int FPassageLwsWebSocket::LwsCallback(lws* Instance, lws_callback_reasons Reason
 	}
 	case LWS_CALLBACK_CLIENT_RECEIVE:
 	{
-		const SIZE_T BytesLeft = lws_remaining_packet_payload(Instance);
+		// lws_remaining_packet_payload is always 0 while permessage-deflate is inflating a frame, so only report 0 bytes
+		// remaining on the final fragment of the message, as that is what OnRawMessage listeners wait for
+		SIZE_T BytesLeft = 0;
+		if (!lws_is_final_fragment(Instance))
+		{
+			BytesLeft = FMath::Max<SIZE_T>(lws_remaining_packet_payload(Instance), 1);
+		}
+		Stats.BytesReceived += Length;
+		INC_DWORD_STAT_BY(STAT_PassageWebSockets_BytesReceived, Length);
 		UE_LOG(LogPassageWebSockets, VeryVerbose, TEXT("FPassageLwsWebSocket[%d]::LwsCallback: Received LWS_CALLBACK_CLIENT_RECEIVE Length=%d BytesLeft=%d"), Identifier, Length, BytesLeft);
 		bool bWakeGameThread = false;
-		if (bWantsMessageEvents)
+		// Binary frames are only delivered through OnRawMessage
+		if (bWantsMessageEvents && !lws_frame_is_binary(Instance))
 		{
-			FUTF8ToTCHAR Convert((const ANSICHAR*)Data, Length);
-			ReceiveBuffer.Append(Convert.Get(), Convert.Length());
+			ReceiveBuffer.Append(static_cast<const uint8*>(Data), Length);
             //if(BytesLeft == 0)
             if(lws_is_final_fragment(Instance))
 			{
@@ -296,7 +395,7 @@ int FPassageLwsWebSocket::LwsCallback(lws* Instance, lws_callback_reasons Reason
                 UE_LOG(LogPassageWebSockets, VeryVerbose, TEXT("FPassageLwsWebSocket::LwsCallback: lws_is_final_fragment"));
 				bWakeGameThread = true;
 				ReceiveTextQueue.Enqueue(MakeUnique<FPassageLwsReceiveBufferText>(MoveTemp(ReceiveBuffer)));
-				ReceiveBuffer.Empty();
+				ReceiveBuffer.Reset();
 			}
 		}
 		if (bWantsRawMessageEvents)
@@ -555,7 +654,12 @@ void FPassageLwsWebSocket::GameThreadTick()
 		FLwsReceiveBufferTextPtr BufferText;
 		while (ReceiveTextQueue.Dequeue(BufferText))
 		{
-			OnMessage().Broadcast(BufferText->Text);
+			OnUtf8Message().Broadcast(reinterpret_cast<const UTF8CHAR*>(BufferText->Utf8.GetData()), BufferText->Utf8.Num());
+			if (OnMessage().IsBound())
+			{
+				FUTF8ToTCHAR Convert(reinterpret_cast<const ANSICHAR*>(BufferText->Utf8.GetData()), BufferText->Utf8.Num());
+				OnMessage().Broadcast(FString(Convert.Length(), Convert.Get()));
+			}
 		}
 
 		FPassageLwsReceiveBufferBinaryPtr BufferBinary;
@@ -582,6 +686,13 @@ void FPassageLwsWebSocket::GameThreadFinalize()
 
 	UE_LOG(LogPassageWebSockets, Verbose, TEXT("FPassageLwsWebSocket[%d]::GameThreadFinalize: setting State=%s PreviousState=%s"),
 		Identifier, ToString(EState::None), ToString(PreviousState));
+	UE_LOG(LogPassageWebSockets, Verbose, TEXT("FPassageLwsWebSocket[%d]::GameThreadFinalize: bPerMessageDeflate=%d MessagesSent=%d BytesSent=%lld MessagesSentCompressed=%d BytesSentCompressed=%lld BytesReceived=%lld"),
+		Identifier, (int32)Stats.bPerMessageDeflate, Stats.MessagesSent, Stats.BytesSent, Stats.MessagesSentCompressed, Stats.BytesSentCompressed, Stats.BytesReceived);
+	if (Stats.bPerMessageDeflate)
+	{
+		DEC_DWORD_STAT(STAT_PassageWebSockets_DeflateConnections);
+		Stats.bPerMessageDeflate = false;
+	}
 
 	const bool bWasError = (PreviousState == EState::Error);
 	if (bWasError)
@@ -595,6 +706,13 @@ void FPassageLwsWebSocket::GameThreadFinalize()
 	}
 }
 
+void FPassageLwsWebSocket::LwsPerMessageDeflateNegotiated()
+{
+	UE_LOG(LogPassageWebSockets, Verbose, TEXT("FPassageLwsWebSocket[%d]::LwsPerMessageDeflateNegotiated: Server accepted permessage-deflate"), Identifier);
+	Stats.bPerMessageDeflate = true;
+	INC_DWORD_STAT(STAT_PassageWebSockets_DeflateConnections);
+}
+
 bool FPassageLwsWebSocket::LwsThreadInitialize(struct lws_context &LwsContext)
 {
 	check(State == EState::StartConnecting);
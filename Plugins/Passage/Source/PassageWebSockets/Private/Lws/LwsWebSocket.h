@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Containers/Ticker.h"
 #include "Containers/Queue.h"
+#include "Containers/LockFreeList.h"
+#include "HAL/ThreadSafeCounter.h"
 
 #if WITH_WEBSOCKETS && WITH_LIBWEBSOCKETS
 
@@ -34,6 +36,17 @@ struct FPassageLwsSendBuffer
 	 */
 	FPassageLwsSendBuffer(const uint8* Data, const SIZE_T Size, const bool bInIsBinary);
 
+	/** Constructor for an empty buffer, to be filled with Reset() */
+	FPassageLwsSendBuffer();
+
+	/**
+	 * Prepare the buffer to be reused for another packet, keeping its allocation
+	 * @param PayloadSize size of the payload that will be written after the libwebsockets headroom
+	 * @param bInIsBinary Whether or not this should be treated as a binary packet
+	 * @return where the caller should write the payload
+	 */
+	uint8* Reset(const int32 PayloadSize, const bool bInIsBinary);
+
 	/** 
 	 * Get the actual payload size
 	 * Payload includes additional room for libwebsockets to use
@@ -54,7 +67,7 @@ struct FPassageLwsSendBuffer
 	bool HasError() const { return bHasError; }
 
 	/** Whether or not the packet is a binary packet, if not it is treated as a string */
-	const bool bIsBinary;
+	bool bIsBinary;
 	/** Number of bytes from Payload already written */
 	int32 BytesWritten;
 	/** Payload of the packet */
@@ -87,16 +100,33 @@ struct FPassageLwsReceiveBufferText
 {
 	/**
 	 * Constructor
-	 * @param InText The packet contents
+	 * @param InUtf8 The packet contents, as received
 	 */
-	FPassageLwsReceiveBufferText(FString&& InText);
+	FPassageLwsReceiveBufferText(TArray<uint8>&& InUtf8);
 
-	/** Text packet received */
-	const FString Text;
+	/** Text packet received, still UTF-8 encoded.  Converted on the game thread only if OnMessage is bound */
+	const TArray<uint8> Utf8;
 };
 
 typedef TUniquePtr<FPassageLwsReceiveBufferText> FLwsReceiveBufferTextPtr;
 
+/** Counters for one connection, updated on the libwebsockets thread and logged when the connection is finalized */
+struct FPassageLwsWebSocketStats
+{
+	/** Whether the server accepted permessage-deflate for this connection */
+	bool bPerMessageDeflate = false;
+	/** Messages written */
+	int32 MessagesSent = 0;
+	/** Payload bytes written, before any compression */
+	int64 BytesSent = 0;
+	/** Messages written with permessage-deflate */
+	int32 MessagesSentCompressed = 0;
+	/** Bytes of the messages written with permessage-deflate, after compression */
+	int64 BytesSentCompressed = 0;
+	/** Payload bytes received, after any decompression */
+	int64 BytesReceived = 0;
+};
+
 class FPassageLwsWebSocket
 	: public IWebSocket
 	, public TSharedFromThis<FPassageLwsWebSocket>
@@ -153,6 +183,13 @@ public:
 		return RawMessageEvent;
 	}
 
+	/** Delegate called when a web socket text message has been received, without converting it from UTF-8 */
+	DECLARE_DERIVED_EVENT(FPassageLwsWebSocket, IWebSocket::FWebSocketUtf8MessageEvent, FWebSocketUtf8MessageEvent);
+	virtual FWebSocketUtf8MessageEvent& OnUtf8Message() override
+	{
+		return Utf8MessageEvent;
+	}
+
 	DECLARE_DERIVED_EVENT(FPassageLwsWebSocket, IWebSocket::FWebSocketMessageSentEvent, FWebSocketMessageSentEvent);
 	virtual FWebSocketMessageSentEvent& OnMessageSent() override
 	{
@@ -184,6 +221,21 @@ public:
 	 */
 	void LwsThreadTick();
 
+	/** Called on the libwebsockets thread when the server accepts permessage-deflate for our connection */
+	void LwsPerMessageDeflateNegotiated();
+
+	/**
+	 * Whether permessage-deflate should leave the message being written uncompressed, because it is below the
+	 * configured threshold.  Called on the libwebsockets thread from inside lws_write.
+	 */
+	bool LwsShouldSkipCompression() const { return bSkipCompression; }
+
+	/**
+	 * Called on the libwebsockets thread from inside lws_write with the number of bytes permessage-deflate produced
+	 * from the part of the message being written.
+	 */
+	void LwsPayloadCompressed(int32 Size) { CompressedBytesWritten += Size; }
+
 private:
 	/** Constructor */
 	FPassageLwsWebSocket(const FString& Url, const TArray<FString>& Protocols, const FString& UpgradeHeader);
@@ -209,6 +261,12 @@ private:
 	 */
 	bool WriteBuffer(FPassageLwsSendBuffer& Buffer);
 
+	/** Take a send buffer from our pool, or allocate one if the pool is empty.  Safe to call from any thread */
+	FPassageLwsSendBuffer* AcquireSendBuffer();
+
+	/** Return a send buffer that has been sent (or discarded) to our pool, or free it if the pool is full */
+	void ReleaseSendBuffer(FPassageLwsSendBuffer* Buffer);
+
 private:
 
 	/** Critical section to lock access to state and close request variables */
@@ -272,12 +330,22 @@ private:
 	/** Was the send queue empty last time we checked it on our thread? */
 	bool bWasSendQueueEmpty;
 
+	/** Whether the buffer currently being written is too small to be worth compressing */
+	bool bSkipCompression;
+
+	/** Bytes permessage-deflate has produced so far for the buffer currently being written */
+	int64 CompressedBytesWritten;
+
+	/** Counters for the current connection, reset on Connect() */
+	FPassageLwsWebSocketStats Stats;
+
 	// Events
 	FWebSocketConnectedEvent ConnectedEvent;
 	FWebSocketConnectionErrorEvent ConnectionErrorEvent;
 	FWebSocketClosedEvent ClosedEvent;
 	FWebSocketMessageEvent MessageEvent;
 	FWebSocketRawMessageEvent RawMessageEvent;
+	FWebSocketUtf8MessageEvent Utf8MessageEvent;
 	FWebSocketMessageSentEvent OnMessageSentEvent;
 
 	/** libwebsockets connection */
@@ -290,8 +358,8 @@ private:
 	FString UpgradeHeader;
 
 	/**
-	 * Whether or not OnMessage was bound to when Connect() was called.
-	 * For performance reasons if nothing was bound at Connect() time, we will never trigger OnMessage
+	 * Whether or not OnMessage or OnUtf8Message was bound to when Connect() was called.
+	 * For performance reasons if nothing was bound at Connect() time, we will never trigger either of them
 	 */
 	bool bWantsMessageEvents;
 	/**
@@ -300,8 +368,8 @@ private:
 	 */
 	bool bWantsRawMessageEvents;
 
-	/** Buffer of an incomplete packet received */
-	FString ReceiveBuffer;
+	/** Buffer of an incomplete text packet received, kept as UTF-8 so that multi-byte characters may span fragments */
+	TArray<uint8> ReceiveBuffer;
 	/** Received binary fragments, waiting for delegates to be triggered on the game thread */
 	TQueue<FPassageLwsReceiveBufferBinaryPtr, EQueueMode::Spsc> ReceiveBinaryQueue;
 	/** Received text packets, waiting for delegates to be triggered on the game thread */
@@ -309,6 +377,18 @@ private:
 	/** Pending outgoing packets, populated by the game thread and processed on the libwebsockets thread */
 	TQueue<FPassageLwsSendBuffer*, EQueueMode::Spsc> SendQueue;
 
+	/**
+	 * Send buffers that have been written and can be reused for later packets, so that a steady stream of messages
+	 * doesn't allocate.  Filled on the libwebsockets thread and drained by whichever thread calls Send()
+	 */
+	TLockFreePointerListUnordered<FPassageLwsSendBuffer, PLATFORM_CACHE_LINE_SIZE> FreeSendBuffers;
+	/** Number of buffers in FreeSendBuffers */
+	FThreadSafeCounter NumFreeSendBuffers;
+	/** Most buffers we keep in FreeSendBuffers */
+	static constexpr int32 MaxFreeSendBuffers = 32;
+	/** Buffers whose allocation has grown beyond this are freed rather than pooled, so one large message doesn't pin memory */
+	static constexpr int32 MaxPooledSendBufferSize = 64 * 1024;
+
 	// Unique identifier for logging
 	/** Incrementing identifier to give each web socket a unique identifier */
 	static int32 IncrementingIdentifier;
@@ -24,14 +24,9 @@ namespace {
 	static const struct lws_extension LwsExtensions[] = {
 		{
 			"permessage-deflate",
-			lws_extension_callback_pm_deflate,
+			&FPassageLwsWebSocketsManager::StaticPerMessageDeflateCallback,
 			"permessage-deflate; client_max_window_bits"
 		},
-		{
-			"deflate-frame",
-			lws_extension_callback_pm_deflate,
-			"deflate_frame"
-		},
 		// zero terminated:
 		{ nullptr, nullptr, nullptr }
 	};
@@ -53,6 +48,23 @@ FPassageLwsWebSocketsManager::FPassageLwsWebSocketsManager()
 
 	ThreadMinimumSleepTimeInSeconds = 0.0f;
 	GConfig->GetDouble(TEXT("WebSockets.LibWebSockets"), TEXT("ThreadMinimumSleepTimeInSeconds"), ThreadMinimumSleepTimeInSeconds, GEngineIni);
+
+	// Polling at ThreadTargetFrameTimeInSeconds adds up to a frame of latency to every message in each direction, so
+	// by default we block in lws_service and have sockets wake us when they queue work instead.
+	bEventDrivenService = true;
+	GConfig->GetBool(TEXT("WebSockets.LibWebSockets"), TEXT("bEventDrivenService"), bEventDrivenService, GEngineIni);
+
+	ServiceTimeoutInMilliseconds = 1000;
+	GConfig->GetInt(TEXT("WebSockets.LibWebSockets"), TEXT("ServiceTimeoutInMilliseconds"), ServiceTimeoutInMilliseconds, GEngineIni);
+	ServiceTimeoutInMilliseconds = FMath::Max(ServiceTimeoutInMilliseconds, 1);
+
+	// Off by default, as the server has to support it and it costs CPU on both ends
+	bEnablePerMessageDeflate = false;
+	GConfig->GetBool(TEXT("WebSockets.LibWebSockets"), TEXT("bEnablePerMessageDeflate"), bEnablePerMessageDeflate, GEngineIni);
+
+	// Below a few hundred bytes the deflate framing overhead eats most of the saving
+	PerMessageDeflateThreshold = 1024;
+	GConfig->GetInt(TEXT("WebSockets.LibWebSockets"), TEXT("PerMessageDeflateThreshold"), PerMessageDeflateThreshold, GEngineIni);
 }
 
 FPassageLwsWebSocketsManager& FPassageLwsWebSocketsManager::Get()
@@ -140,8 +152,10 @@ void FPassageLwsWebSocketsManager::InitWebSockets(TArrayView<const FString> Prot
 	}
 	
 	// Extensions
-	// TODO:  Investigate why enabling LwsExtensions prevents us from receiving packets larger than 1023 bytes, and also why lws_remaining_packet_payload returns 0 in that case
-	ContextInfo.extensions = nullptr;// LwsExtensions;
+	// Each connection offers permessage-deflate in its handshake, and uses it only if the server accepts.  Received
+	// messages are reassembled by final fragment rather than lws_remaining_packet_payload, which is always 0 while
+	// inflating.
+	ContextInfo.extensions = bEnablePerMessageDeflate ? LwsExtensions : nullptr;
 
 	LwsContext = lws_create_context(&ContextInfo);
 	if (LwsContext == nullptr)
@@ -222,8 +236,16 @@ uint32 FPassageLwsWebSocketsManager::Run()
 {
 	while (!ExitRequest.GetValue())
 	{
+		if (bEventDrivenService)
+		{
+			// lws_service returns as soon as there is network activity or WakeServiceThread is called, so there is
+			// no need to sleep
+			TickInternal(ServiceTimeoutInMilliseconds);
+			continue;
+		}
+
 		double BeginTime = FPlatformTime::Seconds();
-		Tick();
+		TickInternal(0);
 		double EndTime = FPlatformTime::Seconds();
 
 		double TotalTime = EndTime - BeginTime;
@@ -303,6 +325,47 @@ int FPassageLwsWebSocketsManager::StaticCallbackWrapper(lws* Connection, lws_cal
 	return This.CallbackWrapper(Connection, Reason, UserData, Data, Length);
 }
 
+int FPassageLwsWebSocketsManager::StaticPerMessageDeflateCallback(lws_context* Context, const lws_extension* Extension, lws* Connection, lws_extension_callback_reasons Reason, void* User, void* In, size_t Length)
+{
+	FPassageLwsWebSocket* Socket = Connection ? static_cast<FPassageLwsWebSocket*>(lws_wsi_user(Connection)) : nullptr;
+
+	switch (Reason)
+	{
+	case LWS_EXT_CB_CLIENT_CONSTRUCT:
+		if (Socket)
+		{
+			Socket->LwsPerMessageDeflateNegotiated();
+		}
+		break;
+	case LWS_EXT_CB_PAYLOAD_TX:
+	case LWS_EXT_CB_PACKET_TX_PRESEND:
+		// Leaving the payload alone and RSV1 clear sends the message uncompressed, which RFC 7692 allows for any message
+		if (Socket && Socket->LwsShouldSkipCompression())
+		{
+			return 0;
+		}
+		if (Socket && Reason == LWS_EXT_CB_PAYLOAD_TX)
+		{
+			// On return the extension has pointed the buffers in In at its deflated output for this write
+			const int Result = lws_extension_callback_pm_deflate(Context, Extension, Connection, Reason, User, In, Length);
+			if (Result >= 0 && In)
+			{
+#if LWS_LIBRARY_VERSION_NUMBER >= 3002000
+				Socket->LwsPayloadCompressed(static_cast<const lws_ext_pm_deflate_rx_ebufs*>(In)->eb_out.len);
+#else
+				Socket->LwsPayloadCompressed(static_cast<const lws_tokens*>(In)->token_len);
+#endif
+			}
+			return Result;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return lws_extension_callback_pm_deflate(Context, Extension, Connection, Reason, User, In, Length);
+}
+
 int FPassageLwsWebSocketsManager::CallbackWrapper(lws* Connection, lws_callback_reasons Reason, void* UserData, void* Data, size_t Length)
 {
 	FPassageLwsWebSocket* Socket = static_cast<FPassageLwsWebSocket*>(UserData);
@@ -352,6 +415,12 @@ int FPassageLwsWebSocketsManager::CallbackWrapper(lws* Connection, lws_callback_
 }
 
 void FPassageLwsWebSocketsManager::Tick()
+{
+	// We are being ticked from the game thread when multi-threading is disabled, so we must never block
+	TickInternal(0);
+}
+
+void FPassageLwsWebSocketsManager::TickInternal(int ServiceTimeoutMs)
 {
 	QUICK_SCOPE_CYCLE_COUNTER(STAT_FLwsWebSocketsManager_Tick);
 	LLM_SCOPE(ELLMTag::Networking);
@@ -380,7 +449,7 @@ void FPassageLwsWebSocketsManager::Tick()
 	}
 	if (LwsContext)
 	{
-		lws_service(LwsContext, 0);
+		lws_service(LwsContext, ServiceTimeoutMs);
 	}
 	for (FPassageLwsWebSocket* Socket : SocketsDestroyedDuringService)
 	{
@@ -406,6 +475,16 @@ void FPassageLwsWebSocketsManager::StartProcessingWebSocket(FPassageLwsWebSocket
 {
 	Sockets.Emplace(Socket->AsShared());
 	SocketsToStart.Enqueue(Socket);
+	WakeServiceThread();
+}
+
+void FPassageLwsWebSocketsManager::WakeServiceThread()
+{
+	// Only needed when our thread may be blocked in lws_service
+	if (bEventDrivenService && LwsContext)
+	{
+		lws_cancel_service(LwsContext);
+	}
 }
 
 bool FPassageLwsWebSocketsManager::GameThreadTick(float DeltaTime)
@@ -42,6 +42,21 @@ public:
 	 */
 	void StartProcessingWebSocket(FPassageLwsWebSocket* Socket);
 
+	/**
+	 * Wake our thread if it is blocked in lws_service, so that work queued by a socket (a send or a close) is
+	 * picked up straight away rather than at the end of the service timeout.  Safe to call from any thread.
+	 */
+	void WakeServiceThread();
+
+	/** Messages smaller than this many bytes are sent uncompressed even when permessage-deflate is in use */
+	int32 GetPerMessageDeflateThreshold() const { return PerMessageDeflateThreshold; }
+
+	/**
+	 * Extension callback wrapping the permessage-deflate one, to skip compression of small messages.
+	 * Public only so that it can be put in our lws_extension table.
+	 */
+	static int StaticPerMessageDeflateCallback(lws_context* Context, const lws_extension* Extension, lws* Connection, lws_extension_callback_reasons Reason, void* User, void* In, size_t Length);
+
 	// IWebSocketsManager
 	virtual void InitWebSockets(TArrayView<const FString> Protocols) override;
 	virtual void ShutdownWebSockets() override;
@@ -65,6 +80,12 @@ private:
 
 	virtual void Tick() override;
 
+	/**
+	 * Start queued sockets, tick running ones and service libwebsockets once.
+	 * @param ServiceTimeoutMs how long lws_service may block waiting for network activity, 0 to return immediately
+	 */
+	void TickInternal(int ServiceTimeoutMs);
+
 	// FPassageLwsWebSocketsManager
 	/** Game thread tick to flush events etc */
 	bool GameThreadTick(float DeltaTime);
@@ -107,6 +128,19 @@ private:
 	double ThreadTargetFrameTimeInSeconds;
 	/** Minimum time to sleep in our thread's tick, even if the sleep makes us exceed our target frame time */
 	double ThreadMinimumSleepTimeInSeconds;
+
+	/**
+	 * Whether our thread blocks in lws_service until there is network activity or a socket wakes it, rather than
+	 * polling at ThreadTargetFrameTimeInSeconds.
+	 */
+	bool bEventDrivenService;
+	/** The longest our thread blocks in lws_service in event driven mode, which bounds how late lws timers can run */
+	int32 ServiceTimeoutInMilliseconds;
+
+	/** Whether to offer the permessage-deflate extension when connecting */
+	bool bEnablePerMessageDeflate;
+	/** Messages smaller than this many bytes are not compressed */
+	int32 PerMessageDeflateThreshold;
 };
 
 #endif // WITH_WEBSOCKETS && WITH_LIBWEBSOCKETS
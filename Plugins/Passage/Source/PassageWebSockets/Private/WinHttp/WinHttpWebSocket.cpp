@@ -212,6 +212,11 @@ FWinHttpWebSocket::FWebSocketRawMessageEvent& FWinHttpWebSocket::OnRawMessage()
 	return OnRawMessageHandler;
 }
 
+FWinHttpWebSocket::FWebSocketUtf8MessageEvent& FWinHttpWebSocket::OnUtf8Message()
+{
+	return OnUtf8MessageHandler;
+}
+
 FWinHttpWebSocket::FWebSocketMessageSentEvent& FWinHttpWebSocket::OnMessageSent()
 {
 	return OnMessageSentHandler;
@@ -370,6 +375,11 @@ void FWinHttpWebSocket::HandleWebSocketMessage(EWebSocketMessageType MessageType
 {
 	TSharedRef<FWinHttpWebSocket> KeepAlive = AsShared();
 
+	if (MessageType == EWebSocketMessageType::Utf8)
+	{
+		OnUtf8Message().Broadcast(reinterpret_cast<const UTF8CHAR*>(MessagePayload.GetData()), MessagePayload.Num());
+	}
+
 	if (MessageType == EWebSocketMessageType::Utf8 && OnMessage().IsBound())
 	{
 		const FUTF8ToTCHAR TCHARConverter(reinterpret_cast<const ANSICHAR*>(MessagePayload.GetData()), MessagePayload.Num());
@@ -53,6 +53,8 @@ public:
 	virtual FWebSocketMessageEvent& OnMessage() override final;
 	DECLARE_DERIVED_EVENT(FWinHttpWebSocket, IWebSocket::FWebSocketRawMessageEvent, FWebSocketRawMessageEvent);
 	virtual FWebSocketRawMessageEvent& OnRawMessage() override final;
+	DECLARE_DERIVED_EVENT(FWinHttpWebSocket, IWebSocket::FWebSocketUtf8MessageEvent, FWebSocketUtf8MessageEvent);
+	virtual FWebSocketUtf8MessageEvent& OnUtf8Message() override final;
 	DECLARE_DERIVED_EVENT(FWinHttpWebSocket, IWebSocket::FWebSocketMessageSentEvent, FWebSocketMessageSentEvent);
 	virtual FWebSocketMessageSentEvent& OnMessageSent() override final;
 	//~ End IWebSocket Interface
@@ -87,6 +89,7 @@ protected:
 	FWebSocketClosedEvent OnClosedHandler;
 	FWebSocketMessageEvent OnMessageHandler;
 	FWebSocketRawMessageEvent OnRawMessageHandler;
+	FWebSocketUtf8MessageEvent OnUtf8MessageHandler;
 	FWebSocketMessageSentEvent OnMessageSentHandler;
 
 	friend class FWinHttpWebSocketsManager;
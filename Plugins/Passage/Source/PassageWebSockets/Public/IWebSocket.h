@@ -36,6 +36,8 @@ public:
 
 	/**
 	 * Transmit data over the connection.
+	 * With bIsBinary false this sends a text frame, so callers that already have UTF-8 encoded text can send it this
+	 * way without converting it to an FString and back.  OnMessageSent is not triggered.
 	 * @param Data raw binary data to be sent.
 	 * @param Size number of bytes to send.
 	 * @param bIsBinary set to true to send binary frame to the peer instead of text.
@@ -80,6 +82,14 @@ public:
 	DECLARE_EVENT_ThreeParams(IWebSocket, FWebSocketRawMessageEvent, const void* /* Data */, SIZE_T /* Size */, SIZE_T /* BytesRemaining */);
 	virtual FWebSocketRawMessageEvent& OnRawMessage() = 0;
 
+	/**
+	 * Delegate called when a web socket text message has been received, with the payload still UTF-8 encoded and not
+	 * null terminated.  Called once per message, after all its frames have arrived.  Binding only this rather than
+	 * OnMessage saves converting each message to TCHAR.
+	 */
+	DECLARE_EVENT_TwoParams(IWebSocket, FWebSocketUtf8MessageEvent, const UTF8CHAR* /* Data */, SIZE_T /* Size */);
+	virtual FWebSocketUtf8MessageEvent& OnUtf8Message() = 0;
+
 	/**
 	* Delegate called when a web socket text message has been sent.
 	* Assume UTF-8 encoding.
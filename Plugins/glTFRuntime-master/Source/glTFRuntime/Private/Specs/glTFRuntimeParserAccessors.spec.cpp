@@ -0,0 +1,149 @@
+// Copyright 2020-2022, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FglTFRuntimeParserAccessorsSpec, "glTFRuntime.Parser.Accessors",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+
+// random integer components, with the extremes of the type first so the normalization clamp is always hit
+template<typename SourceType>
+TArray<uint8> MakeIntegerBuffer(const int64 Stride, const int64 Count)
+{
+	FRandomStream RandomStream(0x676c5446);
+	TArray<uint8> Bytes;
+	Bytes.SetNumUninitialized(Stride * Count);
+	for (int64 Index = 0; Index < Bytes.Num(); Index++)
+	{
+		Bytes[Index] = static_cast<uint8>(RandomStream.RandRange(0, 255));
+	}
+	const SourceType Lowest = TNumericLimits<SourceType>::Lowest();
+	const SourceType Highest = TNumericLimits<SourceType>::Max();
+	FMemory::Memcpy(Bytes.GetData(), &Lowest, sizeof(SourceType));
+	FMemory::Memcpy(Bytes.GetData() + Stride, &Highest, sizeof(SourceType));
+	return Bytes;
+}
+
+TArray<uint8> MakeFloatBuffer(const int64 Stride, const int64 Count)
+{
+	FRandomStream RandomStream(0x676c5446);
+	TArray<uint8> Bytes;
+	Bytes.SetNumZeroed(Stride * Count);
+	for (int64 Offset = 0; Offset + static_cast<int64>(sizeof(float)) <= Bytes.Num(); Offset += sizeof(float))
+	{
+		const float Value = RandomStream.FRandRange(-1000.0f, 1000.0f);
+		FMemory::Memcpy(Bytes.GetData() + Offset, &Value, sizeof(float));
+	}
+	return Bytes;
+}
+
+// the component as it was decoded one element at a time, before the packed paths
+template<typename SourceType>
+static float ReferenceComponent(const uint8* Source, const bool bNormalized)
+{
+	SourceType Value;
+	FMemory::Memcpy(&Value, Source, sizeof(SourceType));
+	if (!bNormalized || TIsSame<SourceType, float>::Value)
+	{
+		return Value;
+	}
+	if (TIsSame<SourceType, int8>::Value)
+	{
+		return FMath::Max(((float)Value) / 127.f, -1.f);
+	}
+	if (TIsSame<SourceType, uint8>::Value)
+	{
+		return ((float)Value) / 255.f;
+	}
+	if (TIsSame<SourceType, int16>::Value)
+	{
+		return FMath::Max(((float)Value) / 32767.f, -1.f);
+	}
+	return ((float)Value) / 65535.f;
+}
+
+// decodes the accessor and returns how many components differ from the reference, or -1 when it cannot be decoded at all
+template<typename T, typename ComponentType, typename SourceType>
+int32 CountMismatches(const TArray<uint8>& Bytes, const int64 AccessorComponentType, const int64 Stride, const int64 Elements, const int64 Count, const bool bNormalized)
+{
+	FglTFRuntimeBlob Blob;
+	Blob.Data = const_cast<uint8*>(Bytes.GetData());
+	Blob.Num = Bytes.Num();
+
+	TArray<T> Data;
+	Data.SetNumZeroed(Count);
+	if (!FglTFRuntimeParser::DecodeAccessor<T, ComponentType>(Blob, AccessorComponentType, Stride, Elements, Count, bNormalized, Data.GetData()))
+	{
+		return -1;
+	}
+
+	int32 Mismatches = 0;
+	for (int64 ElementIndex = 0; ElementIndex < Count; ElementIndex++)
+	{
+		const ComponentType* Components = reinterpret_cast<const ComponentType*>(&Data[ElementIndex]);
+		for (int64 ComponentIndex = 0; ComponentIndex < Elements; ComponentIndex++)
+		{
+			const float Expected = ReferenceComponent<SourceType>(Bytes.GetData() + ElementIndex * Stride + ComponentIndex * sizeof(SourceType), bNormalized);
+			if (Components[ComponentIndex] != static_cast<ComponentType>(Expected))
+			{
+				Mismatches++;
+			}
+		}
+	}
+	return Mismatches;
+}
+
+END_DEFINE_SPEC(FglTFRuntimeParserAccessorsSpec)
+void FglTFRuntimeParserAccessorsSpec::Define()
+{
+	constexpr int64 Count = 257;
+
+	Describe("DecodeAccessor()", [this, Count]()
+		{
+			It("should copy packed floats as they are", [this, Count]()
+				{
+					TestEqual("VEC3 FVector3f", CountMismatches<FVector3f, float, float>(MakeFloatBuffer(12, Count), 5126, 12, 3, Count, false), 0);
+				});
+
+			It("should convert packed and strided floats to doubles", [this, Count]()
+				{
+					TestEqual("packed VEC3 FVector", CountMismatches<FVector, double, float>(MakeFloatBuffer(12, Count), 5126, 12, 3, Count, false), 0);
+					TestEqual("strided VEC3 FVector", CountMismatches<FVector, double, float>(MakeFloatBuffer(20, Count), 5126, 20, 3, Count, false), 0);
+				});
+
+			It("should normalize BYTE and SHORT like the per element path (KHR_mesh_quantization normals and tangents)", [this, Count]()
+				{
+					// VEC3 BYTE and SHORT are padded to 4 byte strides, so only VEC4 is packed
+					TestEqual("packed VEC4 BYTE", CountMismatches<FVector4, double, int8>(MakeIntegerBuffer<int8>(4, Count), 5120, 4, 4, Count, true), 0);
+					TestEqual("strided VEC3 BYTE", CountMismatches<FVector, double, int8>(MakeIntegerBuffer<int8>(4, Count), 5120, 4, 3, Count, true), 0);
+					TestEqual("packed VEC4 SHORT", CountMismatches<FVector4, double, int16>(MakeIntegerBuffer<int16>(8, Count), 5122, 8, 4, Count, true), 0);
+					TestEqual("strided VEC3 SHORT", CountMismatches<FVector, double, int16>(MakeIntegerBuffer<int16>(8, Count), 5122, 8, 3, Count, true), 0);
+				});
+
+			It("should normalize UNSIGNED_BYTE and UNSIGNED_SHORT like the per element path (texture coordinates and colors)", [this, Count]()
+				{
+					TestEqual("packed VEC2 UNSIGNED_BYTE", CountMismatches<FVector2D, double, uint8>(MakeIntegerBuffer<uint8>(2, Count), 5121, 2, 2, Count, true), 0);
+					TestEqual("strided VEC2 UNSIGNED_BYTE", CountMismatches<FVector2D, double, uint8>(MakeIntegerBuffer<uint8>(4, Count), 5121, 4, 2, Count, true), 0);
+					TestEqual("packed VEC2 UNSIGNED_SHORT", CountMismatches<FVector2D, double, uint16>(MakeIntegerBuffer<uint16>(4, Count), 5123, 4, 2, Count, true), 0);
+					TestEqual("strided VEC2 UNSIGNED_SHORT", CountMismatches<FVector2D, double, uint16>(MakeIntegerBuffer<uint16>(8, Count), 5123, 8, 2, Count, true), 0);
+				});
+
+			It("should keep quantized positions unnormalized (KHR_mesh_quantization)", [this, Count]()
+				{
+					TestEqual("strided VEC3 SHORT", CountMismatches<FVector, double, int16>(MakeIntegerBuffer<int16>(8, Count), 5122, 8, 3, Count, false), 0);
+					TestEqual("strided VEC3 UNSIGNED_BYTE", CountMismatches<FVector, double, uint8>(MakeIntegerBuffer<uint8>(4, Count), 5121, 4, 3, Count, false), 0);
+				});
+
+			It("should decode scalars", [this, Count]()
+				{
+					TestEqual("UNSIGNED_BYTE", CountMismatches<float, float, uint8>(MakeIntegerBuffer<uint8>(1, Count), 5121, 1, 1, Count, true), 0);
+					TestEqual("UNSIGNED_SHORT", CountMismatches<float, float, uint16>(MakeIntegerBuffer<uint16>(2, Count), 5123, 2, 1, Count, true), 0);
+					TestEqual("FLOAT", CountMismatches<float, float, float>(MakeFloatBuffer(4, Count), 5126, 4, 1, Count, false), 0);
+				});
+		});
+}
+
+#endif
@@ -0,0 +1,123 @@
+// Copyright 2020-2022, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+#include "Engine/StaticMesh.h"
+#include "Misc/AutomationTest.h"
+#include "StaticMeshResources.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FglTFRuntimeParserStaticMeshesSpec, "glTFRuntime.Parser.StaticMeshes",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+
+// two indexed quads side by side, one per section, each with 4 vertices and 6 indices
+TArray<FglTFRuntimeMeshLOD> MakeQuadsLOD()
+{
+	TArray<FglTFRuntimeMeshLOD> LODs;
+	FglTFRuntimeMeshLOD& LOD = LODs.AddDefaulted_GetRef();
+	for (int32 QuadIndex = 0; QuadIndex < 2; QuadIndex++)
+	{
+		FglTFRuntimePrimitive& Primitive = LOD.Primitives.AddDefaulted_GetRef();
+		const FVector Offset(QuadIndex * 2, 0, 0);
+		Primitive.Positions = { Offset + FVector(0, 0, 0), Offset + FVector(1, 0, 0), Offset + FVector(1, 1, 0), Offset + FVector(0, 1, 0) };
+		Primitive.Normals.Init(FVector(0, 0, 1), 4);
+		Primitive.Tangents.Init(FVector4(1, 0, 0, 1), 4);
+		Primitive.UVs.Add({ FVector2D(0, 0), FVector2D(1, 0), FVector2D(1, 1), FVector2D(0, 1) });
+		Primitive.Indices = { 0, 1, 2, 0, 2, 3 };
+		Primitive.Material = nullptr;
+	}
+	return LODs;
+}
+
+void TestWeldedQuads(UStaticMesh* StaticMesh)
+{
+	if (!TestNotNull("StaticMesh", StaticMesh) || !TestNotNull("RenderData", StaticMesh->GetRenderData()))
+	{
+		return;
+	}
+
+	const FStaticMeshLODResources& LODResources = StaticMesh->GetRenderData()->LODResources[0];
+	TestEqual("Vertices", static_cast<int32>(LODResources.GetNumVertices()), 8);
+	TestEqual("Indices", LODResources.IndexBuffer.GetNumIndices(), 12);
+	TestFalse("32 bit indices", LODResources.IndexBuffer.Is32Bit());
+
+	if (!TestEqual("Sections", LODResources.Sections.Num(), 2))
+	{
+		return;
+	}
+	// each section only references its own quad
+	TestEqual("Section 0 MinVertexIndex", static_cast<int32>(LODResources.Sections[0].MinVertexIndex), 0);
+	TestEqual("Section 0 MaxVertexIndex", static_cast<int32>(LODResources.Sections[0].MaxVertexIndex), 3);
+	TestEqual("Section 1 MinVertexIndex", static_cast<int32>(LODResources.Sections[1].MinVertexIndex), 4);
+	TestEqual("Section 1 MaxVertexIndex", static_cast<int32>(LODResources.Sections[1].MaxVertexIndex), 7);
+
+	TArray<uint32> Indices;
+	LODResources.IndexBuffer.GetCopy(Indices);
+	for (int32 Index = 0; Index < Indices.Num(); Index++)
+	{
+		const FStaticMeshSection& Section = LODResources.Sections[Index < 6 ? 0 : 1];
+		TestTrue(FString::Printf(TEXT("Index %d in its section range"), Index), Indices[Index] >= Section.MinVertexIndex && Indices[Index] <= Section.MaxVertexIndex);
+	}
+}
+
+END_DEFINE_SPEC(FglTFRuntimeParserStaticMeshesSpec)
+void FglTFRuntimeParserStaticMeshesSpec::Define()
+{
+	Describe("LoadStaticMeshFromRuntimeLODs()", [this]()
+		{
+			It("should keep one vertex per index without bWeldVertices", [this]()
+				{
+					TSharedPtr<FglTFRuntimeParser> Parser = FglTFRuntimeParser::FromString(TEXT(R"({ "asset": { "version": "2.0" } })"), FglTFRuntimeConfig());
+					if (!TestTrue("FromString()", Parser.IsValid()))
+					{
+						return;
+					}
+
+					FglTFRuntimeStaticMeshConfig StaticMeshConfig;
+					StaticMeshConfig.bAllowCPUAccess = true;
+					const TArray<FglTFRuntimeMeshLOD> LODs = MakeQuadsLOD();
+					UStaticMesh* StaticMesh = Parser->LoadStaticMeshFromRuntimeLODs(LODs, StaticMeshConfig);
+					if (!TestNotNull("StaticMesh", StaticMesh) || !TestNotNull("RenderData", StaticMesh->GetRenderData()))
+					{
+						return;
+					}
+
+					const FStaticMeshLODResources& LODResources = StaticMesh->GetRenderData()->LODResources[0];
+					TestEqual("Vertices", static_cast<int32>(LODResources.GetNumVertices()), 12);
+					TestEqual("Indices", LODResources.IndexBuffer.GetNumIndices(), 12);
+				});
+
+			It("should weld the shared vertices of each quad with bWeldVertices", [this]()
+				{
+					TSharedPtr<FglTFRuntimeParser> Parser = FglTFRuntimeParser::FromString(TEXT(R"({ "asset": { "version": "2.0" } })"), FglTFRuntimeConfig());
+					if (!TestTrue("FromString()", Parser.IsValid()))
+					{
+						return;
+					}
+
+					FglTFRuntimeStaticMeshConfig StaticMeshConfig;
+					StaticMeshConfig.bAllowCPUAccess = true;
+					StaticMeshConfig.bWeldVertices = true;
+					const TArray<FglTFRuntimeMeshLOD> LODs = MakeQuadsLOD();
+					TestWeldedQuads(Parser->LoadStaticMeshFromRuntimeLODs(LODs, StaticMeshConfig));
+				});
+
+			It("should keep the sections ranges when bOptimizeVertexCache reorders the welded vertices", [this]()
+				{
+					TSharedPtr<FglTFRuntimeParser> Parser = FglTFRuntimeParser::FromString(TEXT(R"({ "asset": { "version": "2.0" } })"), FglTFRuntimeConfig());
+					if (!TestTrue("FromString()", Parser.IsValid()))
+					{
+						return;
+					}
+
+					FglTFRuntimeStaticMeshConfig StaticMeshConfig;
+					StaticMeshConfig.bAllowCPUAccess = true;
+					StaticMeshConfig.bWeldVertices = true;
+					StaticMeshConfig.bOptimizeVertexCache = true;
+					const TArray<FglTFRuntimeMeshLOD> LODs = MakeQuadsLOD();
+					TestWeldedQuads(Parser->LoadStaticMeshFromRuntimeLODs(LODs, StaticMeshConfig));
+				});
+		});
+}
+
+#endif
@@ -0,0 +1,258 @@
+// Copyright 2020-2022, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FglTFRuntimeParserTextureCompressionSpec, "glTFRuntime.Parser.TextureCompression",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+
+// a single BGRA mip, filled by Texel(Index, Pixel) for each of its texels
+TArray<FglTFRuntimeMipMap> MakeMip(const int32 Width, const int32 Height, TFunctionRef<void(const int32, uint8*)> Texel)
+{
+	TArray<FglTFRuntimeMipMap> Mips;
+	FglTFRuntimeMipMap& MipMap = Mips.Add_GetRef(FglTFRuntimeMipMap(0));
+	MipMap.Width = Width;
+	MipMap.Height = Height;
+	MipMap.Pixels.AddUninitialized(Width * Height * 4);
+	for (int32 Index = 0; Index < Width * Height; Index++)
+	{
+		Texel(Index, MipMap.Pixels.GetData() + Index * 4);
+	}
+	return Mips;
+}
+
+TArray<FglTFRuntimeMipMap> CompressMip(const int32 Width, const int32 Height, TFunctionRef<void(const int32, uint8*)> Texel, const TextureCompressionSettings Compression = TextureCompressionSettings::TC_Default)
+{
+	TArray<FglTFRuntimeMipMap> Mips = MakeMip(Width, Height, Texel);
+	FglTFRuntimeImagesConfig ImagesConfig;
+	ImagesConfig.bBlockCompress = true;
+	ImagesConfig.Compression = Compression;
+	FglTFRuntimeParser::CompressMips(Mips, ImagesConfig);
+	return Mips;
+}
+
+static uint16 ReadUInt16(const uint8* Data)
+{
+	return Data[0] | (Data[1] << 8);
+}
+
+// the RGB colors of the 16 texels of a BC1 block, as a decoder sees them
+static void DecodeBC1(const uint8* Block, int32 Colors[16][3])
+{
+	const uint16 Color0 = ReadUInt16(Block);
+	const uint16 Color1 = ReadUInt16(Block + 2);
+	int32 Palette[4][3];
+	for (int32 Endpoint = 0; Endpoint < 2; Endpoint++)
+	{
+		const uint16 Value = Endpoint == 0 ? Color0 : Color1;
+		const int32 R = (Value >> 11) & 0x1F;
+		const int32 G = (Value >> 5) & 0x3F;
+		const int32 B = Value & 0x1F;
+		Palette[Endpoint][0] = (R << 3) | (R >> 2);
+		Palette[Endpoint][1] = (G << 2) | (G >> 4);
+		Palette[Endpoint][2] = (B << 3) | (B >> 2);
+	}
+	for (int32 Channel = 0; Channel < 3; Channel++)
+	{
+		if (Color0 > Color1)
+		{
+			Palette[2][Channel] = (2 * Palette[0][Channel] + Palette[1][Channel]) / 3;
+			Palette[3][Channel] = (Palette[0][Channel] + 2 * Palette[1][Channel]) / 3;
+		}
+		else
+		{
+			Palette[2][Channel] = (Palette[0][Channel] + Palette[1][Channel]) / 2;
+			Palette[3][Channel] = 0;
+		}
+	}
+
+	const uint32 Indices = Block[4] | (Block[5] << 8) | (Block[6] << 16) | (static_cast<uint32>(Block[7]) << 24);
+	for (int32 Index = 0; Index < 16; Index++)
+	{
+		const uint32 PaletteIndex = (Indices >> (Index * 2)) & 0x3;
+		Colors[Index][0] = Palette[PaletteIndex][0];
+		Colors[Index][1] = Palette[PaletteIndex][1];
+		Colors[Index][2] = Palette[PaletteIndex][2];
+	}
+}
+
+// the values of the 16 texels of a BC4 block, as a decoder sees them
+static void DecodeBC4(const uint8* Block, int32 Values[16])
+{
+	int32 Palette[8];
+	Palette[0] = Block[0];
+	Palette[1] = Block[1];
+	if (Block[0] > Block[1])
+	{
+		for (int32 Step = 1; Step < 7; Step++)
+		{
+			Palette[Step + 1] = ((7 - Step) * Block[0] + Step * Block[1]) / 7;
+		}
+	}
+	else
+	{
+		for (int32 Step = 1; Step < 5; Step++)
+		{
+			Palette[Step + 1] = ((5 - Step) * Block[0] + Step * Block[1]) / 5;
+		}
+		Palette[6] = 0;
+		Palette[7] = 255;
+	}
+
+	uint64 Indices = 0;
+	for (int32 Byte = 0; Byte < 6; Byte++)
+	{
+		Indices |= static_cast<uint64>(Block[2 + Byte]) << (Byte * 8);
+	}
+	for (int32 Index = 0; Index < 16; Index++)
+	{
+		Values[Index] = Palette[(Indices >> (Index * 3)) & 0x7];
+	}
+}
+
+// the largest difference between the decoded block and the RGB channels of the source texels
+static int32 MaxBC1Error(const uint8* Block, const TArray64<uint8>& Pixels)
+{
+	int32 Colors[16][3];
+	DecodeBC1(Block, Colors);
+	int32 MaxError = 0;
+	for (int32 Index = 0; Index < 16; Index++)
+	{
+		// RGB against BGRA
+		MaxError = FMath::Max(MaxError, FMath::Abs(Colors[Index][0] - Pixels[Index * 4 + 2]));
+		MaxError = FMath::Max(MaxError, FMath::Abs(Colors[Index][1] - Pixels[Index * 4 + 1]));
+		MaxError = FMath::Max(MaxError, FMath::Abs(Colors[Index][2] - Pixels[Index * 4]));
+	}
+	return MaxError;
+}
+
+// the largest difference between the decoded block and one channel (BGRA offset) of the source texels
+static int32 MaxBC4Error(const uint8* Block, const TArray64<uint8>& Pixels, const int32 Channel)
+{
+	int32 Values[16];
+	DecodeBC4(Block, Values);
+	int32 MaxError = 0;
+	for (int32 Index = 0; Index < 16; Index++)
+	{
+		MaxError = FMath::Max(MaxError, FMath::Abs(Values[Index] - Pixels[Index * 4 + Channel]));
+	}
+	return MaxError;
+}
+
+END_DEFINE_SPEC(FglTFRuntimeParserTextureCompressionSpec)
+void FglTFRuntimeParserTextureCompressionSpec::Define()
+{
+	Describe("CompressMips()", [this]()
+		{
+			It("should encode a solid color as BC1 with equal endpoints and zero indices", [this]()
+				{
+					auto Solid = [](const int32 Index, uint8* Pixel)
+					{
+						Pixel[0] = 40;
+						Pixel[1] = 120;
+						Pixel[2] = 200;
+						Pixel[3] = 255;
+					};
+					const TArray<FglTFRuntimeMipMap> Source = MakeMip(4, 4, Solid);
+					const TArray<FglTFRuntimeMipMap> Mips = CompressMip(4, 4, Solid);
+
+					TestTrue("PixelFormat", Mips[0].PixelFormat == EPixelFormat::PF_DXT1);
+					if (!TestEqual("Pixels.Num()", static_cast<int32>(Mips[0].Pixels.Num()), 8))
+					{
+						return;
+					}
+					const uint8* Block = Mips[0].Pixels.GetData();
+					TestTrue("Color0 == Color1", ReadUInt16(Block) == ReadUInt16(Block + 2));
+					TestEqual("Indices", static_cast<int32>(Block[4] | Block[5] | Block[6] | Block[7]), 0);
+					// 5 bits of red and blue, 6 of green
+					TestTrue("Decoded error", MaxBC1Error(Block, Source[0].Pixels) <= 4);
+				});
+
+			It("should decode a BC1 gradient within the error of its four colors", [this]()
+				{
+					auto Gradient = [](const int32 Index, uint8* Pixel)
+					{
+						Pixel[0] = Pixel[1] = Pixel[2] = Index * 17;
+						Pixel[3] = 255;
+					};
+					const TArray<FglTFRuntimeMipMap> Source = MakeMip(4, 4, Gradient);
+					const TArray<FglTFRuntimeMipMap> Mips = CompressMip(4, 4, Gradient);
+
+					TestTrue("PixelFormat", Mips[0].PixelFormat == EPixelFormat::PF_DXT1);
+					if (!TestEqual("Pixels.Num()", static_cast<int32>(Mips[0].Pixels.Num()), 8))
+					{
+						return;
+					}
+					const uint8* Block = Mips[0].Pixels.GetData();
+					// Color0 > Color1 is the four colors mode
+					TestTrue("Color0 > Color1", ReadUInt16(Block) > ReadUInt16(Block + 2));
+					// the palette steps are 85 apart
+					TestTrue("Decoded error", MaxBC1Error(Block, Source[0].Pixels) <= 43);
+				});
+
+			It("should select DXT5 for translucent texels, with ordered alpha endpoints", [this]()
+				{
+					auto Fade = [](const int32 Index, uint8* Pixel)
+					{
+						Pixel[0] = 10;
+						Pixel[1] = 20;
+						Pixel[2] = 30;
+						Pixel[3] = Index * 16;
+					};
+					const TArray<FglTFRuntimeMipMap> Source = MakeMip(4, 4, Fade);
+					const TArray<FglTFRuntimeMipMap> Mips = CompressMip(4, 4, Fade);
+
+					TestTrue("PixelFormat", Mips[0].PixelFormat == EPixelFormat::PF_DXT5);
+					if (!TestEqual("Pixels.Num()", static_cast<int32>(Mips[0].Pixels.Num()), 16))
+					{
+						return;
+					}
+					const uint8* Block = Mips[0].Pixels.GetData();
+					// Alpha0 > Alpha1 is the eight values mode
+					TestEqual("Alpha0", static_cast<int32>(Block[0]), 240);
+					TestEqual("Alpha1", static_cast<int32>(Block[1]), 0);
+					// the palette steps are 240 / 7 apart
+					TestTrue("Decoded alpha error", MaxBC4Error(Block, Source[0].Pixels, 3) <= 18);
+					TestTrue("Decoded color error", MaxBC1Error(Block + 8, Source[0].Pixels) <= 4);
+				});
+
+			It("should select BC5 for normal maps, with ordered endpoints for both channels", [this]()
+				{
+					auto Normals = [](const int32 Index, uint8* Pixel)
+					{
+						Pixel[0] = 255;
+						Pixel[1] = 64 + (Index % 4) * 32;
+						Pixel[2] = 255 - Index * 8;
+						Pixel[3] = 255;
+					};
+					const TArray<FglTFRuntimeMipMap> Source = MakeMip(4, 4, Normals);
+					const TArray<FglTFRuntimeMipMap> Mips = CompressMip(4, 4, Normals, TextureCompressionSettings::TC_Normalmap);
+
+					TestTrue("PixelFormat", Mips[0].PixelFormat == EPixelFormat::PF_BC5);
+					if (!TestEqual("Pixels.Num()", static_cast<int32>(Mips[0].Pixels.Num()), 16))
+					{
+						return;
+					}
+					const uint8* Block = Mips[0].Pixels.GetData();
+					TestTrue("Red0 > Red1", Block[0] > Block[1]);
+					TestTrue("Green0 > Green1", Block[8] > Block[9]);
+					TestTrue("Decoded red error", MaxBC4Error(Block, Source[0].Pixels, 2) <= 9);
+					TestTrue("Decoded green error", MaxBC4Error(Block + 8, Source[0].Pixels, 1) <= 7);
+				});
+
+			It("should leave textures that are not made of whole blocks uncompressed", [this]()
+				{
+					const TArray<FglTFRuntimeMipMap> Mips = CompressMip(6, 4, [](const int32 Index, uint8* Pixel)
+						{
+							FMemory::Memset(Pixel, 255, 4);
+						});
+
+					TestTrue("PixelFormat", Mips[0].PixelFormat == EPixelFormat::PF_B8G8R8A8);
+					TestEqual("Pixels.Num()", static_cast<int32>(Mips[0].Pixels.Num()), 6 * 4 * 4);
+				});
+		});
+}
+
+#endif
@@ -0,0 +1,50 @@
+// Copyright 2020-2022, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FglTFRuntimeParserTexturesSpec, "glTFRuntime.Parser.Textures",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::EditorContext)
+
+// a 1x1 PNG as the fallback source, and a KTX2 image that no transcoder can read
+const TCHAR* BasisuWithFallback = TEXT(R"({
+	"asset": { "version": "2.0" },
+	"extensionsUsed": ["KHR_texture_basisu"],
+	"textures": [{ "source": 0, "extensions": { "KHR_texture_basisu": { "source": 1 } } }],
+	"images": [
+		{ "uri": "data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR42mP8z8BQDwAEhQGAhKmMIQAAAABJRU5ErkJggg==" },
+		{ "uri": "data:image/ktx2;base64,bm90IGEga3R4Mg==", "mimeType": "image/ktx2" }
+	]
+})");
+
+END_DEFINE_SPEC(FglTFRuntimeParserTexturesSpec)
+void FglTFRuntimeParserTexturesSpec::Define()
+{
+	Describe("LoadTexture()", [this]()
+		{
+			It("should load the source image when the KHR_texture_basisu one cannot be used", [this]()
+				{
+					TSharedPtr<FglTFRuntimeParser> Parser = FglTFRuntimeParser::FromString(BasisuWithFallback, FglTFRuntimeConfig());
+					if (!TestTrue("FromString()", Parser.IsValid()))
+					{
+						return;
+					}
+
+					TArray<FglTFRuntimeMipMap> Mips;
+					FglTFRuntimeTextureSampler Sampler;
+					Parser->LoadTexture(0, Mips, true, FglTFRuntimeMaterialsConfig(), Sampler);
+
+					if (!TestTrue("Mips.Num() > 0", Mips.Num() > 0))
+					{
+						return;
+					}
+					TestEqual("Width", Mips[0].Width, 1);
+					TestEqual("Height", Mips[0].Height, 1);
+					TestTrue("PixelFormat", Mips[0].PixelFormat == EPixelFormat::PF_B8G8R8A8);
+				});
+		});
+}
+
+#endif
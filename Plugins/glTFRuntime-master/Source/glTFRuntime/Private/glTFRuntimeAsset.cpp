@@ -630,6 +630,7 @@ UTexture2D* UglTFRuntimeAsset::LoadImage(const int32 ImageIndex, const FglTFRunt
 		Mip.Width = Width;
 		Mip.Height = Height;
 		TArray<FglTFRuntimeMipMap> Mips = { Mip };
+		FglTFRuntimeParser::CompressMips(Mips, ImagesConfig);
 		return Parser->BuildTexture(this, Mips, ImagesConfig, FglTFRuntimeTextureSampler());
 	}
 
@@ -654,6 +655,7 @@ UTexture2D* UglTFRuntimeAsset::LoadImageFromBlob(const FglTFRuntimeImagesConfig&
 		Mip.Width = Width;
 		Mip.Height = Height;
 		TArray<FglTFRuntimeMipMap> Mips = { Mip };
+		FglTFRuntimeParser::CompressMips(Mips, ImagesConfig);
 		return Parser->BuildTexture(this, Mips, ImagesConfig, FglTFRuntimeTextureSampler());
 	}
 
@@ -760,7 +762,7 @@ bool UglTFRuntimeAsset::GetNodeGPUInstancingTransforms(const int32 NodeIndex, TA
 	TArray<FVector4> Rotations;
 	TArray<FVector> Scales;
 
-	if (Parser->BuildFromAccessorField(InstancingExtensionAttributes.ToSharedRef(), "TRANSLATION", Translations, { 3 }, { 5126 }, false, [](FVector V) { return V; }, INDEX_NONE))
+	if (Parser->BuildFromAccessorField(InstancingExtensionAttributes.ToSharedRef(), "TRANSLATION", Translations, { 3 }, { 5126 }, false, nullptr, INDEX_NONE))
 	{
 		Transforms.AddUninitialized(Translations.Num());
 		for (int32 Index = 0; Index < Translations.Num(); Index++)
@@ -769,7 +771,7 @@ bool UglTFRuntimeAsset::GetNodeGPUInstancingTransforms(const int32 NodeIndex, TA
 		}
 	}
 
-	if (Parser->BuildFromAccessorField(InstancingExtensionAttributes.ToSharedRef(), "ROTATION", Rotations, { 4 }, { 5126, 5120, 5122 }, true, [](FVector4 Q) { return Q; }, INDEX_NONE))
+	if (Parser->BuildFromAccessorField(InstancingExtensionAttributes.ToSharedRef(), "ROTATION", Rotations, { 4 }, { 5126, 5120, 5122 }, true, nullptr, INDEX_NONE))
 	{
 		if (Transforms.Num() == 0)
 		{
@@ -786,7 +788,7 @@ bool UglTFRuntimeAsset::GetNodeGPUInstancingTransforms(const int32 NodeIndex, TA
 		}
 	}
 
-	if (Parser->BuildFromAccessorField(InstancingExtensionAttributes.ToSharedRef(), "SCALE", Scales, { 3 }, { 5126 }, false, [](FVector V) { return V; }, INDEX_NONE))
+	if (Parser->BuildFromAccessorField(InstancingExtensionAttributes.ToSharedRef(), "SCALE", Scales, { 3 }, { 5126 }, false, nullptr, INDEX_NONE))
 	{
 		if (Transforms.Num() == 0)
 		{
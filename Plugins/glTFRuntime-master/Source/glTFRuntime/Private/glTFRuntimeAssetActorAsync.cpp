@@ -5,6 +5,7 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Engine/StaticMeshSocket.h"
+#include "Async/Async.h"
 
 // Sets default values
 AglTFRuntimeAssetActorAsync::AglTFRuntimeAssetActorAsync()
@@ -16,6 +17,9 @@ AglTFRuntimeAssetActorAsync::AglTFRuntimeAssetActorAsync()
 	RootComponent = AssetRoot;
 
 	bShowWhileLoading = true;
+	MaxConcurrentMeshLoads = 0;
+	FinalizeTimeBudgetMs = 5;
+	NumMeshLoadsInFlight = 0;
 }
 
 // Called when the game starts or when spawned
@@ -25,6 +29,7 @@ void AglTFRuntimeAssetActorAsync::BeginPlay()
 
 	if (!Asset)
 	{
+		SetActorTickEnabled(false);
 		return;
 	}
 
@@ -48,9 +53,41 @@ void AglTFRuntimeAssetActorAsync::BeginPlay()
 		}
 	}
 
+	LoadedMeshes = MakeShared<FglTFRuntimeAssetActorMeshLoadQueue, ESPMode::ThreadSafe>();
 	LoadNextMeshAsync();
 }
 
+void AglTFRuntimeAssetActorAsync::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!LoadedMeshes)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	TSharedPtr<FglTFRuntimeAssetActorMeshLoad, ESPMode::ThreadSafe> MeshLoad;
+	while (LoadedMeshes->Dequeue(MeshLoad))
+	{
+		FinalizeMeshLoad(MeshLoad.ToSharedRef());
+		LoadNextMeshAsync();
+
+		if ((FPlatformTime::Seconds() - StartTime) * 1000 >= FinalizeTimeBudgetMs)
+		{
+			break;
+		}
+	}
+
+	if (MeshesToLoad.Num() == 0 && NumMeshLoadsInFlight == 0)
+	{
+		LoadedMeshes.Reset();
+		SetActorTickEnabled(false);
+		ScenesLoaded();
+	}
+}
+
 void AglTFRuntimeAssetActorAsync::ProcessNode(USceneComponent* NodeParentComponent, const FName SocketName, FglTFRuntimeNode& Node)
 {
 	// skip bones/joints
@@ -129,89 +166,127 @@ void AglTFRuntimeAssetActorAsync::ProcessNode(USceneComponent* NodeParentCompone
 
 void AglTFRuntimeAssetActorAsync::LoadNextMeshAsync()
 {
-	if (MeshesToLoad.Num() == 0)
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset->GetParser();
+	if (!Parser)
 	{
+		MeshesToLoad.Empty();
 		return;
 	}
 
-	auto It = MeshesToLoad.CreateIterator();
-	if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(It->Key))
-	{
-		CurrentPrimitiveComponent = StaticMeshComponent;
-		if (StaticMeshConfig.Outer == nullptr)
-		{
-			StaticMeshConfig.Outer = StaticMeshComponent;
-		}
-		FglTFRuntimeStaticMeshAsync Delegate;
-		Delegate.BindDynamic(this, &AglTFRuntimeAssetActorAsync::LoadStaticMeshAsync);
-		Asset->LoadStaticMeshAsync(It->Value.MeshIndex, Delegate, StaticMeshConfig);
-	}
-	else if (USkeletalMeshComponent* SkeletalMeshComponent = Cast<USkeletalMeshComponent>(It->Key))
-	{
-		CurrentPrimitiveComponent = SkeletalMeshComponent;
-		FglTFRuntimeSkeletalMeshAsync Delegate;
-		Delegate.BindDynamic(this, &AglTFRuntimeAssetActorAsync::LoadSkeletalMeshAsync);
-		Asset->LoadSkeletalMeshAsync(It->Value.MeshIndex, It->Value.SkinIndex, Delegate, SkeletalMeshConfig);
-	}
-}
+	const int32 MaxMeshLoads = MaxConcurrentMeshLoads > 0 ? MaxConcurrentMeshLoads : FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
 
-void AglTFRuntimeAssetActorAsync::LoadStaticMeshAsync(UStaticMesh* StaticMesh)
-{
-	if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(CurrentPrimitiveComponent))
+	while (MeshesToLoad.Num() > 0 && NumMeshLoadsInFlight < MaxMeshLoads)
 	{
-		DiscoveredStaticMeshComponents.Add(StaticMeshComponent, StaticMesh);
-		if (bShowWhileLoading)
-		{
-			StaticMeshComponent->SetStaticMesh(StaticMesh);
-		}
+		auto It = MeshesToLoad.CreateIterator();
+		TSharedRef<FglTFRuntimeAssetActorMeshLoad, ESPMode::ThreadSafe> MeshLoad = MakeShared<FglTFRuntimeAssetActorMeshLoad, ESPMode::ThreadSafe>();
+		MeshLoad->PrimitiveComponent = It->Key;
+		MeshLoad->Node = It->Value;
+		It.RemoveCurrent();
 
-		if (StaticMesh && !StaticMeshConfig.ExportOriginalPivotToSocket.IsEmpty())
+		// the contexts create their meshes, so they need to be built on the game thread
+		if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(MeshLoad->PrimitiveComponent))
 		{
-			UStaticMeshSocket* DeltaSocket = StaticMesh->FindSocket(FName(StaticMeshConfig.ExportOriginalPivotToSocket));
-			if (DeltaSocket)
+			if (StaticMeshConfig.Outer == nullptr)
+			{
+				StaticMeshConfig.Outer = StaticMeshComponent;
+			}
+
+			if (UStaticMesh* CachedStaticMesh = Parser->GetCachedStaticMesh(MeshLoad->Node.MeshIndex, StaticMeshConfig))
 			{
-				FTransform NewTransform = StaticMeshComponent->GetRelativeTransform();
-				FVector DeltaLocation = -DeltaSocket->RelativeLocation * NewTransform.GetScale3D();
-				DeltaLocation = NewTransform.GetRotation().RotateVector(DeltaLocation);
-				NewTransform.AddToTranslation(DeltaLocation);
-				StaticMeshComponent->SetRelativeTransform(NewTransform);
+				OnStaticMeshLoaded(StaticMeshComponent, CachedStaticMesh);
+				continue;
 			}
+
+			MeshLoad->StaticMeshContext = MakeShared<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe>(Parser.ToSharedRef(), StaticMeshConfig);
+		}
+		else if (Cast<USkeletalMeshComponent>(MeshLoad->PrimitiveComponent))
+		{
+			MeshLoad->SkeletalMeshContext = MakeShared<FglTFRuntimeSkeletalMeshContext, ESPMode::ThreadSafe>(Parser.ToSharedRef(), SkeletalMeshConfig);
+			MeshLoad->SkeletalMeshContext->SkinIndex = MeshLoad->Node.SkinIndex;
+		}
+		else
+		{
+			continue;
 		}
 
+		NumMeshLoadsInFlight++;
+
+		TSharedPtr<FglTFRuntimeAssetActorMeshLoadQueue, ESPMode::ThreadSafe> Queue = LoadedMeshes;
+		Async(EAsyncExecution::ThreadPool, [Parser, MeshLoad, Queue]()
+			{
+				// no GC guard here: the mesh was created with its context on the game thread and the context references it,
+				// while materials are built on the game thread (which we would deadlock waiting for) and the parser
+				// references them until the context is finalized
+				if (MeshLoad->StaticMeshContext)
+				{
+					Parser->LoadStaticMeshIntoContext(MeshLoad->Node.MeshIndex, MeshLoad->StaticMeshContext.ToSharedRef());
+				}
+				else
+				{
+					Parser->LoadSkeletalMeshIntoContext(MeshLoad->Node.MeshIndex, MeshLoad->SkeletalMeshContext.ToSharedRef());
+				}
+
+				Queue->Enqueue(MeshLoad);
+			});
 	}
+}
+
+void AglTFRuntimeAssetActorAsync::FinalizeMeshLoad(TSharedRef<FglTFRuntimeAssetActorMeshLoad, ESPMode::ThreadSafe> MeshLoad)
+{
+	NumMeshLoadsInFlight--;
 
-	MeshesToLoad.Remove(CurrentPrimitiveComponent);
-	if (MeshesToLoad.Num() > 0)
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset->GetParser();
+
+	if (MeshLoad->StaticMeshContext)
 	{
-		LoadNextMeshAsync();
+		UStaticMesh* StaticMesh = Parser->FinalizeStaticMeshContext(MeshLoad->Node.MeshIndex, MeshLoad->StaticMeshContext.ToSharedRef());
+		OnStaticMeshLoaded(Cast<UStaticMeshComponent>(MeshLoad->PrimitiveComponent), StaticMesh);
 	}
-	// trigger event
-	else
+	else if (MeshLoad->SkeletalMeshContext)
 	{
-		ScenesLoaded();
+		USkeletalMesh* SkeletalMesh = Parser->FinalizeSkeletalMeshContext(MeshLoad->SkeletalMeshContext.ToSharedRef());
+		OnSkeletalMeshLoaded(Cast<USkeletalMeshComponent>(MeshLoad->PrimitiveComponent), SkeletalMesh);
 	}
 }
 
-void AglTFRuntimeAssetActorAsync::LoadSkeletalMeshAsync(USkeletalMesh* SkeletalMesh)
+void AglTFRuntimeAssetActorAsync::OnStaticMeshLoaded(UStaticMeshComponent* StaticMeshComponent, UStaticMesh* StaticMesh)
 {
-	if (USkeletalMeshComponent* SkeletalMeshComponent = Cast<USkeletalMeshComponent>(CurrentPrimitiveComponent))
+	if (!IsValid(StaticMeshComponent))
+	{
+		return;
+	}
+
+	DiscoveredStaticMeshComponents.Add(StaticMeshComponent, StaticMesh);
+	if (bShowWhileLoading)
+	{
+		StaticMeshComponent->SetStaticMesh(StaticMesh);
+	}
+
+	if (StaticMesh && !StaticMeshConfig.ExportOriginalPivotToSocket.IsEmpty())
 	{
-		DiscoveredSkeletalMeshComponents.Add(SkeletalMeshComponent, SkeletalMesh);
-		if (bShowWhileLoading)
+		UStaticMeshSocket* DeltaSocket = StaticMesh->FindSocket(FName(StaticMeshConfig.ExportOriginalPivotToSocket));
+		if (DeltaSocket)
 		{
-			SkeletalMeshComponent->SetSkeletalMesh(SkeletalMesh);
+			FTransform NewTransform = StaticMeshComponent->GetRelativeTransform();
+			FVector DeltaLocation = -DeltaSocket->RelativeLocation * NewTransform.GetScale3D();
+			DeltaLocation = NewTransform.GetRotation().RotateVector(DeltaLocation);
+			NewTransform.AddToTranslation(DeltaLocation);
+			StaticMeshComponent->SetRelativeTransform(NewTransform);
 		}
 	}
+}
 
-	MeshesToLoad.Remove(CurrentPrimitiveComponent);
-	if (MeshesToLoad.Num() > 0)
+void AglTFRuntimeAssetActorAsync::OnSkeletalMeshLoaded(USkeletalMeshComponent* SkeletalMeshComponent, USkeletalMesh* SkeletalMesh)
+{
+	if (!IsValid(SkeletalMeshComponent))
 	{
-		LoadNextMeshAsync();
+		return;
 	}
-	// trigger event
-	else
+
+	DiscoveredSkeletalMeshComponents.Add(SkeletalMeshComponent, SkeletalMesh);
+	if (bShowWhileLoading)
 	{
-		ScenesLoaded();
+		SkeletalMeshComponent->SetSkeletalMesh(SkeletalMesh);
 	}
 }
 
@@ -4,7 +4,12 @@
 #include "Runtime/Launch/Resources/Version.h"
 #include "Engine/Texture2D.h"
 #include "Misc/FileHelper.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFileManager.h"
 #include "Serialization/JsonSerializer.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
 #include "Animation/Skeleton.h"
 #include "Materials/Material.h"
 #if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 1
@@ -67,14 +72,34 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromFilename(const FString& F
 		}
 	}
 
-	TArray64<uint8> Content;
-	if (!FFileHelper::LoadFileToArray(Content, *TruePath))
+	TSharedPtr<FglTFRuntimeParser> Parser = nullptr;
+	bool bLoaded = false;
+
+	if (LoaderConfig.bMemoryMapFiles)
 	{
-		UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to load file %s"), *Filename);
-		return nullptr;
+		TSharedPtr<FglTFRuntimeMappedFile> FileMapping = MakeShared<FglTFRuntimeMappedFile>();
+		if (FileMapping->Open(TruePath))
+		{
+			Parser = FromData(FileMapping->GetData(), FileMapping->Num(), LoaderConfig, FileMapping);
+			bLoaded = true;
+		}
+		else
+		{
+			UE_LOG(LogGLTFRuntime, Warning, TEXT("Unable to map file %s, loading it instead"), *Filename);
+		}
 	}
 
-	TSharedPtr<FglTFRuntimeParser> Parser = FromData(Content.GetData(), Content.Num(), LoaderConfig);
+	if (!bLoaded)
+	{
+		TArray64<uint8> Content;
+		if (!FFileHelper::LoadFileToArray(Content, *TruePath))
+		{
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to load file %s"), *Filename);
+			return nullptr;
+		}
+
+		Parser = FromData(Content.GetData(), Content.Num(), LoaderConfig);
+	}
 
 	if (Parser && LoaderConfig.bAllowExternalFiles)
 	{
@@ -85,10 +110,13 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromFilename(const FString& F
 	return Parser;
 }
 
-TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromData(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig)
+TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromData(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeMappedFile> InMappedFile)
 {
 	SCOPED_NAMED_EVENT(FglTFRuntimeParser_FromData, FColor::Magenta);
 
+	// the disk cache is keyed on the data as we received it
+	const FString CacheDirectory = LoaderConfig.bUseDiskCache && !LoaderConfig.bAsBlob ? GetDiskCacheDirectory(DataPtr, DataNum, LoaderConfig, InMappedFile.Get()) : FString();
+
 	// required for Gzip;
 	TArray<uint8> UncompressedData;
 
@@ -172,6 +200,8 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromData(const uint8* DataPtr
 
 		DataPtr = UncompressedData.GetData();
 		DataNum = *GzipOriginalSize;
+		// the data no longer lives in the mapping
+		InMappedFile = nullptr;
 	}
 
 	// Zip archive ?
@@ -218,6 +248,7 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromData(const uint8* DataPtr
 		{
 			DataPtr = UnzippedData.GetData();
 			DataNum = UnzippedData.Num();
+			InMappedFile = nullptr;
 		}
 	}
 
@@ -231,26 +262,30 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromData(const uint8* DataPtr
 		return NewParser;
 	}
 
+	TSharedPtr<FglTFRuntimeParser> Parser = nullptr;
+
 	// detect binary format
-	if (DataNum > 20)
+	if (DataNum > 20 &&
+		DataPtr[0] == 0x67 &&
+		DataPtr[1] == 0x6C &&
+		DataPtr[2] == 0x54 &&
+		DataPtr[3] == 0x46)
 	{
-		if (DataPtr[0] == 0x67 &&
-			DataPtr[1] == 0x6C &&
-			DataPtr[2] == 0x54 &&
-			DataPtr[3] == 0x46)
-		{
-			return FromBinary(DataPtr, DataNum, LoaderConfig, ZipFile);
-		}
+		Parser = FromBinary(DataPtr, DataNum, LoaderConfig, ZipFile, InMappedFile);
 	}
-
-	if (DataNum > 0 && DataNum <= INT32_MAX)
+	else if (DataNum > 0 && DataNum <= INT32_MAX)
 	{
 		FString JsonData;
 		FFileHelper::BufferToString(JsonData, DataPtr, (int32)DataNum);
-		return FromString(JsonData, LoaderConfig, ZipFile);
+		Parser = FromString(JsonData, LoaderConfig, ZipFile);
 	}
 
-	return nullptr;
+	if (Parser)
+	{
+		Parser->DiskCacheDirectory = CacheDirectory;
+	}
+
+	return Parser;
 }
 
 TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromString(const FString& JsonData, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile)
@@ -286,17 +321,20 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromString(const FString& Jso
 		}
 		Parser->DefaultPrefixForUnnamedNodes = LoaderConfig.PrefixForUnnamedNodes;
 		Parser->ZipFile = InZipFile;
+		Parser->bMemoryMapFiles = LoaderConfig.bMemoryMapFiles;
 	}
 
 	return Parser;
 }
 
-TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromBinary(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile)
+TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromBinary(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile, TSharedPtr<FglTFRuntimeMappedFile> InMappedFile)
 {
 	SCOPED_NAMED_EVENT(FglTFRuntimeParser_FromBinary, FColor::Magenta);
 
 	FString JsonData;
 	TArray64<uint8> BinaryBuffer;
+	const uint8* MappedBinaryData = nullptr;
+	int64 MappedBinaryNum = 0;
 
 	bool bJsonFound = false;
 	bool bBinaryFound = false;
@@ -328,7 +366,16 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromBinary(const uint8* DataP
 		else if (*ChunkType == 0x004E4942 && !bBinaryFound)
 		{
 			bBinaryFound = true;
-			BinaryBuffer.Append(&DataPtr[BlobIndex], *ChunkLength);
+			// when the file is mapped, just reference the chunk
+			if (InMappedFile)
+			{
+				MappedBinaryData = &DataPtr[BlobIndex];
+				MappedBinaryNum = *ChunkLength;
+			}
+			else
+			{
+				BinaryBuffer.Append(&DataPtr[BlobIndex], *ChunkLength);
+			}
 		}
 
 		BlobIndex += *ChunkLength;
@@ -345,7 +392,14 @@ TSharedPtr<FglTFRuntimeParser> FglTFRuntimeParser::FromBinary(const uint8* DataP
 	{
 		if (bBinaryFound)
 		{
-			Parser->SetBinaryBuffer(BinaryBuffer);
+			if (InMappedFile)
+			{
+				Parser->SetBinaryBuffer(InMappedFile, MappedBinaryData, MappedBinaryNum);
+			}
+			else
+			{
+				Parser->SetBinaryBuffer(MoveTemp(BinaryBuffer));
+			}
 		}
 	}
 
@@ -1054,7 +1108,10 @@ bool FglTFRuntimeParser::LoadJointByName(const int64 RootBoneIndex, const FStrin
 void FglTFRuntimeParser::AddError(const FString& ErrorContext, const FString& ErrorMessage)
 {
 	FString FullMessage = ErrorContext + ": " + ErrorMessage;
-	Errors.Add(FullMessage);
+	{
+		FScopeLock Lock(&CachesLock);
+		Errors.Add(FullMessage);
+	}
 	UE_LOG(LogGLTFRuntime, Error, TEXT("%s"), *FullMessage);
 	if (OnError.IsBound())
 	{
@@ -2379,6 +2436,129 @@ bool FglTFRuntimeParser::LoadPrimitive(TSharedRef<FJsonObject> JsonPrimitiveObje
 		return false;
 	}
 
+	// the disk cache can only replace the attributes decoding when nobody is going to alter it
+	uint64 DiskCacheItemHash = 0;
+	if (!DiskCacheDirectory.IsEmpty() && !OnPreLoadedPrimitive.IsBound())
+	{
+		DiskCacheItemHash = GetDiskCacheItemHash(JsonPrimitiveObject, FString::Printf(TEXT("%lld"), Primitive.AdditionalBufferView));
+	}
+
+	bool bLoadedFromDiskCache = false;
+	TArray<uint8> CachedAttributes;
+	if (DiskCacheItemHash != 0 && LoadFromDiskCache("primitive", DiskCacheItemHash, CachedAttributes))
+	{
+		FMemoryReader Reader(CachedAttributes);
+		bLoadedFromDiskCache = SerializePrimitiveAttributes(Reader, Primitive);
+	}
+
+	if (!bLoadedFromDiskCache)
+	{
+		if (!LoadPrimitiveAttributes(JsonPrimitiveObject, Primitive))
+		{
+			return false;
+		}
+
+		if (DiskCacheItemHash != 0)
+		{
+			FMemoryWriter Writer(CachedAttributes);
+			if (SerializePrimitiveAttributes(Writer, Primitive))
+			{
+				SaveToDiskCache("primitive", DiskCacheItemHash, CachedAttributes);
+			}
+		}
+	}
+
+	Primitive.Material = UMaterial::GetDefaultMaterial(MD_Surface);
+
+	if (!MaterialsConfig.bSkipLoad)
+	{
+		int64 MaterialIndex = INDEX_NONE;
+		if (!MaterialsConfig.Variant.IsEmpty() && MaterialsVariants.Contains(MaterialsConfig.Variant))
+		{
+			int32 WantedIndex = MaterialsVariants.IndexOfByKey(MaterialsConfig.Variant);
+			TArray<TSharedRef<FJsonObject>> VariantsMappings = GetJsonObjectArrayFromExtension(JsonPrimitiveObject, "KHR_materials_variants", "mappings");
+			bool bMappingFound = false;
+			for (TSharedRef<FJsonObject> VariantsMapping : VariantsMappings)
+			{
+				const TArray<TSharedPtr<FJsonValue>>* Variants;
+				if (VariantsMapping->TryGetArrayField("variants", Variants))
+				{
+					for (TSharedPtr<FJsonValue> Variant : (*Variants))
+					{
+						int64 VariantIndex;
+						if (Variant->TryGetNumber(VariantIndex) && VariantIndex == WantedIndex)
+						{
+							MaterialIndex = VariantsMapping->GetNumberField("material");
+							bMappingFound = true;
+							break;
+						}
+					}
+				}
+				if (bMappingFound)
+				{
+					break;
+				}
+			}
+		}
+
+		if (MaterialIndex == INDEX_NONE)
+		{
+			if (!JsonPrimitiveObject->TryGetNumberField("material", MaterialIndex))
+			{
+				MaterialIndex = INDEX_NONE;
+			}
+		}
+
+		if (MaterialIndex != INDEX_NONE)
+		{
+			Primitive.Material = LoadMaterial(MaterialIndex, MaterialsConfig, Primitive.Colors.Num() > 0, Primitive.MaterialName);
+			if (!Primitive.Material)
+			{
+				AddError("LoadPrimitive()", FString::Printf(TEXT("Unable to load material %lld"), MaterialIndex));
+				return false;
+			}
+			Primitive.bHasMaterial = true;
+		}
+		// special case for primitives without a material but with a color buffer
+		else if (Primitive.Colors.Num() > 0)
+		{
+			Primitive.Material = BuildVertexColorOnlyMaterial(MaterialsConfig);
+		}
+	}
+
+	OnLoadedPrimitive.Broadcast(AsShared(), JsonPrimitiveObject, Primitive);
+
+	return true;
+}
+
+bool FglTFRuntimeParser::LoadPrimitiveAttributes(TSharedRef<FJsonObject> JsonPrimitiveObject, FglTFRuntimePrimitive& Primitive)
+{
+	const TSharedPtr<FJsonObject>* JsonAttributesObject;
+	if (!JsonPrimitiveObject->TryGetObjectField("attributes", JsonAttributesObject))
+	{
+		AddError("LoadPrimitive()", "No attributes array available");
+		return false;
+	}
+
+	// a Draco bufferView is decoded into additional bufferViews matching the attributes accessors (unless an OnPreLoadedPrimitive handler already did it)
+	if (Primitive.AdditionalBufferView <= INDEX_NONE)
+	{
+		TSharedPtr<FJsonObject> JsonDracoObject = GetJsonObjectExtension(JsonPrimitiveObject, "KHR_draco_mesh_compression");
+#if WITH_GLTFRUNTIME_DRACO
+		if (JsonDracoObject && !DecompressDraco(JsonPrimitiveObject, JsonDracoObject.ToSharedRef(), Primitive.AdditionalBufferView))
+		{
+			return false;
+		}
+#else
+		// without a decoder fall back to the uncompressed accessors, only an asset requiring the extension has none
+		if (JsonDracoObject && ExtensionsRequired.Contains("KHR_draco_mesh_compression"))
+		{
+			AddError("LoadPrimitive()", "KHR_draco_mesh_compression is required but not available in this build, add the Draco library to Source/ThirdParty/draco or install glTFRuntimeDraco");
+			return false;
+		}
+#endif
+	}
+
 	const bool bHasMeshQuantization = ExtensionsRequired.Contains("KHR_mesh_quantization");
 
 	TArray<int64> SupportedPositionComponentTypes = { 5126 };
@@ -2424,7 +2604,7 @@ bool FglTFRuntimeParser::LoadPrimitive(TSharedRef<FJsonObject> JsonPrimitiveObje
 	{
 		TArray<FVector2D> UV;
 		if (!BuildFromAccessorField(JsonAttributesObject->ToSharedRef(), "TEXCOORD_0", UV,
-			{ 2 }, SupportedTexCoordComponentTypes, true, [&](FVector2D Value) -> FVector2D {return FVector2D(Value.X, Value.Y); }, Primitive.AdditionalBufferView))
+			{ 2 }, SupportedTexCoordComponentTypes, true, nullptr, Primitive.AdditionalBufferView))
 		{
 			AddError("LoadPrimitive()", "Error loading TEXCOORD_0");
 			return false;
@@ -2437,7 +2617,7 @@ bool FglTFRuntimeParser::LoadPrimitive(TSharedRef<FJsonObject> JsonPrimitiveObje
 	{
 		TArray<FVector2D> UV;
 		if (!BuildFromAccessorField(JsonAttributesObject->ToSharedRef(), "TEXCOORD_1", UV,
-			{ 2 }, SupportedTexCoordComponentTypes, true, [&](FVector2D Value) -> FVector2D {return FVector2D(Value.X, Value.Y); }, Primitive.AdditionalBufferView))
+			{ 2 }, SupportedTexCoordComponentTypes, true, nullptr, Primitive.AdditionalBufferView))
 		{
 			AddError("LoadPrimitive()", "Error loading TEXCOORD_1");
 			return false;
@@ -2664,72 +2844,14 @@ bool FglTFRuntimeParser::LoadPrimitive(TSharedRef<FJsonObject> JsonPrimitiveObje
 		Primitive.Indices = FanIndices;
 	}
 
-	Primitive.Material = UMaterial::GetDefaultMaterial(MD_Surface);
-
-	if (!MaterialsConfig.bSkipLoad)
-	{
-		int64 MaterialIndex = INDEX_NONE;
-		if (!MaterialsConfig.Variant.IsEmpty() && MaterialsVariants.Contains(MaterialsConfig.Variant))
-		{
-			int32 WantedIndex = MaterialsVariants.IndexOfByKey(MaterialsConfig.Variant);
-			TArray<TSharedRef<FJsonObject>> VariantsMappings = GetJsonObjectArrayFromExtension(JsonPrimitiveObject, "KHR_materials_variants", "mappings");
-			bool bMappingFound = false;
-			for (TSharedRef<FJsonObject> VariantsMapping : VariantsMappings)
-			{
-				const TArray<TSharedPtr<FJsonValue>>* Variants;
-				if (VariantsMapping->TryGetArrayField("variants", Variants))
-				{
-					for (TSharedPtr<FJsonValue> Variant : (*Variants))
-					{
-						int64 VariantIndex;
-						if (Variant->TryGetNumber(VariantIndex) && VariantIndex == WantedIndex)
-						{
-							MaterialIndex = VariantsMapping->GetNumberField("material");
-							bMappingFound = true;
-							break;
-						}
-					}
-				}
-				if (bMappingFound)
-				{
-					break;
-				}
-			}
-		}
-
-		if (MaterialIndex == INDEX_NONE)
-		{
-			if (!JsonPrimitiveObject->TryGetNumberField("material", MaterialIndex))
-			{
-				MaterialIndex = INDEX_NONE;
-			}
-		}
-
-		if (MaterialIndex != INDEX_NONE)
-		{
-			Primitive.Material = LoadMaterial(MaterialIndex, MaterialsConfig, Primitive.Colors.Num() > 0, Primitive.MaterialName);
-			if (!Primitive.Material)
-			{
-				AddError("LoadPrimitive()", FString::Printf(TEXT("Unable to load material %lld"), MaterialIndex));
-				return false;
-			}
-			Primitive.bHasMaterial = true;
-		}
-		// special case for primitives without a material but with a color buffer
-		else if (Primitive.Colors.Num() > 0)
-		{
-			Primitive.Material = BuildVertexColorOnlyMaterial(MaterialsConfig);
-		}
-	}
-
-	OnLoadedPrimitive.Broadcast(AsShared(), JsonPrimitiveObject, Primitive);
-
 	return true;
 }
 
 
 bool FglTFRuntimeParser::GetBuffer(const int32 Index, FglTFRuntimeBlob& Blob)
 {
+	FScopeLock Lock(&CachesLock);
+
 	if (Index < 0)
 	{
 		return false;
@@ -2742,6 +2864,12 @@ bool FglTFRuntimeParser::GetBuffer(const int32 Index, FglTFRuntimeBlob& Blob)
 		return true;
 	}
 
+	if (Index == 0 && MappedBinaryBuffer.Num > 0)
+	{
+		Blob = MappedBinaryBuffer;
+		return true;
+	}
+
 	// first check cache
 	if (BuffersCache.Contains(Index))
 	{
@@ -2750,6 +2878,13 @@ bool FglTFRuntimeParser::GetBuffer(const int32 Index, FglTFRuntimeBlob& Blob)
 		return true;
 	}
 
+	if (MappedBuffersCache.Contains(Index))
+	{
+		Blob.Data = const_cast<uint8*>(MappedBuffersCache[Index]->GetData());
+		Blob.Num = MappedBuffersCache[Index]->Num();
+		return true;
+	}
+
 	const TArray<TSharedPtr<FJsonValue>>* JsonBuffers;
 
 	// no buffers ?
@@ -2787,7 +2922,7 @@ bool FglTFRuntimeParser::GetBuffer(const int32 Index, FglTFRuntimeBlob& Blob)
 		TArray64<uint8> Base64Data;
 		if (ParseBase64Uri(Uri, Base64Data))
 		{
-			BuffersCache.Add(Index, Base64Data);
+			BuffersCache.Add(Index, MoveTemp(Base64Data));
 			Blob.Data = BuffersCache[Index].GetData();
 			Blob.Num = BuffersCache[Index].Num();
 			return true;
@@ -2800,7 +2935,7 @@ bool FglTFRuntimeParser::GetBuffer(const int32 Index, FglTFRuntimeBlob& Blob)
 		TArray64<uint8> ZipData;
 		if (ZipFile->GetFileContent(Uri, ZipData))
 		{
-			BuffersCache.Add(Index, ZipData);
+			BuffersCache.Add(Index, MoveTemp(ZipData));
 			Blob.Data = BuffersCache[Index].GetData();
 			Blob.Num = BuffersCache[Index].Num();
 			return true;
@@ -2810,10 +2945,22 @@ bool FglTFRuntimeParser::GetBuffer(const int32 Index, FglTFRuntimeBlob& Blob)
 	// fallback
 	if (!BaseDirectory.IsEmpty())
 	{
+		if (bMemoryMapFiles)
+		{
+			TSharedPtr<FglTFRuntimeMappedFile> BufferMappedFile = MakeShared<FglTFRuntimeMappedFile>();
+			if (BufferMappedFile->Open(FPaths::Combine(BaseDirectory, Uri)))
+			{
+				MappedBuffersCache.Add(Index, BufferMappedFile);
+				Blob.Data = const_cast<uint8*>(BufferMappedFile->GetData());
+				Blob.Num = BufferMappedFile->Num();
+				return true;
+			}
+		}
+
 		TArray64<uint8> FileData;
 		if (FFileHelper::LoadFileToArray(FileData, *FPaths::Combine(BaseDirectory, Uri)))
 		{
-			BuffersCache.Add(Index, FileData);
+			BuffersCache.Add(Index, MoveTemp(FileData));
 			Blob.Data = BuffersCache[Index].GetData();
 			Blob.Num = BuffersCache[Index].Num();
 			return true;
@@ -2847,6 +2994,8 @@ bool FglTFRuntimeParser::ParseBase64Uri(const FString& Uri, TArray64<uint8>& Byt
 
 bool FglTFRuntimeParser::GetBufferView(const int32 Index, FglTFRuntimeBlob& Blob, int64& Stride)
 {
+	FScopeLock Lock(&CachesLock);
+
 	TSharedPtr<FJsonObject> JsonBufferViewObject = GetJsonObjectFromRootIndex("bufferViews", Index);
 	if (!JsonBufferViewObject)
 	{
@@ -2942,6 +3091,7 @@ bool FglTFRuntimeParser::GetBufferView(const int32 Index, FglTFRuntimeBlob& Blob
 
 bool FglTFRuntimeParser::GetAccessor(const int32 Index, int64& ComponentType, int64& Stride, int64& Elements, int64& ElementSize, int64& Count, bool& bNormalized, FglTFRuntimeBlob& Blob, const FglTFRuntimeBlob* AdditionalBufferView)
 {
+	FScopeLock Lock(&CachesLock);
 
 	TSharedPtr<FJsonObject> JsonAccessorObject = GetJsonObjectFromRootIndex("accessors", Index);
 	if (!JsonAccessorObject)
@@ -3029,7 +3179,12 @@ bool FglTFRuntimeParser::GetAccessor(const int32 Index, int64& ComponentType, in
 
 		if (ZeroBuffer.Num() < FinalSize)
 		{
-			ZeroBuffer.AddZeroed(FinalSize - ZeroBuffer.Num());
+			// another thread may still be reading the smaller one
+			if (ZeroBuffer.Num() > 0)
+			{
+				RetiredZeroBuffers.Add(MoveTemp(ZeroBuffer));
+			}
+			ZeroBuffer.AddZeroed(FinalSize);
 		}
 		Blob.Data = ZeroBuffer.GetData();
 		Blob.Num = FinalSize;
@@ -3265,8 +3420,11 @@ int64 FglTFRuntimeParser::GetTypeSize(const FString& Type) const
 
 void FglTFRuntimeParser::AddReferencedObjects(FReferenceCollector& Collector)
 {
+	// loading threads insert into the caches, but never hold the lock while waiting for the game thread
+	FScopeLock Lock(&CachesLock);
 	Collector.AddReferencedObjects(StaticMeshesCache);
 	Collector.AddReferencedObjects(MaterialsCache);
+	Collector.AddReferencedObjects(MaterialsInFlight);
 	Collector.AddReferencedObjects(SkeletonsCache);
 	Collector.AddReferencedObjects(SkeletalMeshesCache);
 	Collector.AddReferencedObjects(TexturesCache);
@@ -3488,6 +3646,35 @@ bool FglTFRuntimeParser::GetMorphTargetNames(const int32 MeshIndex, TArray<FName
 	return true;
 }
 
+FglTFRuntimeMappedFile::~FglTFRuntimeMappedFile()
+{
+	Region.Reset();
+	Handle.Reset();
+}
+
+bool FglTFRuntimeMappedFile::Open(const FString& InFilename)
+{
+	Filename = FPaths::ConvertRelativePathToFull(InFilename);
+	Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!Handle || Handle->GetFileSize() <= 0)
+	{
+		return false;
+	}
+
+	Region.Reset(Handle->MapRegion(0, Handle->GetFileSize()));
+	return Region.IsValid();
+}
+
+const uint8* FglTFRuntimeMappedFile::GetData() const
+{
+	return Region ? Region->GetMappedPtr() : nullptr;
+}
+
+int64 FglTFRuntimeMappedFile::Num() const
+{
+	return Region ? Region->GetMappedSize() : 0;
+}
+
 bool FglTFRuntimeZipFile::FromData(const uint8* DataPtr, const int64 DataNum)
 {
 	Data.Append(DataPtr, DataNum);
@@ -3732,6 +3919,187 @@ FVector FglTFRuntimeParser::ComputeTangentYWithW(const FVector Normal, const FVe
 	return (Normal ^ TangetX) * W;
 }
 
+void FglTFRuntimeParser::GenerateTangentSpaces(const TArray<FglTFRuntimePrimitive>& Primitives, const EglTFRuntimeTangentSpaceGenerationMethod Method, const EglTFRuntimeNormalsGenerationStrategy NormalsGenerationStrategy, const EglTFRuntimeTangentsGenerationStrategy TangentsGenerationStrategy, const bool bReverseWinding, TArray<FglTFRuntimePrimitiveTangentSpace>& TangentSpaces)
+{
+	SCOPED_NAMED_EVENT(FglTFRuntimeParser_GenerateTangentSpaces, FColor::Magenta);
+
+	TangentSpaces.Empty();
+	TangentSpaces.SetNum(Primitives.Num());
+
+	if (Method == EglTFRuntimeTangentSpaceGenerationMethod::PerFace)
+	{
+		return;
+	}
+
+	ParallelFor(Primitives.Num(), [&](const int32 PrimitiveIndex)
+		{
+			const FglTFRuntimePrimitive& Primitive = Primitives[PrimitiveIndex];
+			FglTFRuntimePrimitiveTangentSpace& TangentSpace = TangentSpaces[PrimitiveIndex];
+
+			const int32 NumVertices = Primitive.Positions.Num();
+			const int32 NumTriangles = Primitive.Indices.Num() / 3;
+			if (NumTriangles == 0 || (Primitive.Indices.Num() % 3) != 0)
+			{
+				return;
+			}
+
+			const bool bGenerateNormals = NormalsGenerationStrategy == EglTFRuntimeNormalsGenerationStrategy::Always ||
+				(NormalsGenerationStrategy == EglTFRuntimeNormalsGenerationStrategy::IfMissing && Primitive.Normals.Num() < NumVertices);
+			const bool bHasNormals = bGenerateNormals || Primitive.Normals.Num() >= NumVertices;
+			const bool bHasUVs = Primitive.UVs.Num() > 0 && Primitive.UVs[0].Num() >= NumVertices;
+			const bool bGenerateTangents = bHasNormals && bHasUVs && (TangentsGenerationStrategy == EglTFRuntimeTangentsGenerationStrategy::Always ||
+				(TangentsGenerationStrategy == EglTFRuntimeTangentsGenerationStrategy::IfMissing && Primitive.Tangents.Num() < NumVertices));
+
+			if (!bGenerateNormals && !bGenerateTangents)
+			{
+				return;
+			}
+
+			// vertex -> triangle corners adjacency
+			TArray<int32> AdjacencyOffsets;
+			AdjacencyOffsets.SetNumZeroed(NumVertices + 1);
+			for (const uint32 Index : Primitive.Indices)
+			{
+				if (Index >= static_cast<uint32>(NumVertices))
+				{
+					return;
+				}
+				AdjacencyOffsets[Index + 1]++;
+			}
+			for (int32 VertexIndex = 0; VertexIndex < NumVertices; VertexIndex++)
+			{
+				AdjacencyOffsets[VertexIndex + 1] += AdjacencyOffsets[VertexIndex];
+			}
+
+			TArray<int32> Adjacency;
+			Adjacency.SetNumUninitialized(Primitive.Indices.Num());
+			{
+				TArray<int32> Cursors(AdjacencyOffsets.GetData(), NumVertices);
+				for (int32 Corner = 0; Corner < Primitive.Indices.Num(); Corner++)
+				{
+					Adjacency[Cursors[Primitive.Indices[Corner]]++] = Corner;
+				}
+			}
+
+			// per triangle data (the face normal is area weighted as its length is twice the triangle area)
+			TArray<FVector> FaceNormals;
+			TArray<FVector> FaceTangents;
+			TArray<FVector> FaceBitangents;
+			TArray<float> CornerAngles;
+			FaceNormals.SetNumUninitialized(NumTriangles);
+			CornerAngles.SetNumUninitialized(NumTriangles * 3);
+			if (bGenerateTangents)
+			{
+				FaceTangents.SetNumUninitialized(NumTriangles);
+				FaceBitangents.SetNumUninitialized(NumTriangles);
+			}
+
+			ParallelFor(NumTriangles, [&](const int32 TriangleIndex)
+				{
+					const uint32 Index0 = Primitive.Indices[TriangleIndex * 3];
+					const uint32 Index1 = Primitive.Indices[TriangleIndex * 3 + 1];
+					const uint32 Index2 = Primitive.Indices[TriangleIndex * 3 + 2];
+
+					const FVector DeltaPosition0 = Primitive.Positions[Index1] - Primitive.Positions[Index0];
+					const FVector DeltaPosition1 = Primitive.Positions[Index2] - Primitive.Positions[Index0];
+					const FVector DeltaPosition2 = Primitive.Positions[Index2] - Primitive.Positions[Index1];
+
+					// same orientation as the per face normals
+					const FVector FaceNormal = FVector::CrossProduct(DeltaPosition1, DeltaPosition0);
+					FaceNormals[TriangleIndex] = bReverseWinding ? -FaceNormal : FaceNormal;
+
+					auto Angle = [](const FVector& A, const FVector& B)
+					{
+						return static_cast<float>(FMath::Acos(FMath::Clamp<double>(FVector::DotProduct(A.GetSafeNormal(), B.GetSafeNormal()), -1.0, 1.0)));
+					};
+					CornerAngles[TriangleIndex * 3] = Angle(DeltaPosition0, DeltaPosition1);
+					CornerAngles[TriangleIndex * 3 + 1] = Angle(-DeltaPosition0, DeltaPosition2);
+					CornerAngles[TriangleIndex * 3 + 2] = PI - CornerAngles[TriangleIndex * 3] - CornerAngles[TriangleIndex * 3 + 1];
+
+					if (bGenerateTangents)
+					{
+						const FVector2D DeltaUV0 = Primitive.UVs[0][Index1] - Primitive.UVs[0][Index0];
+						const FVector2D DeltaUV1 = Primitive.UVs[0][Index2] - Primitive.UVs[0][Index0];
+						const float Determinant = DeltaUV0.X * DeltaUV1.Y - DeltaUV0.Y * DeltaUV1.X;
+						if (FMath::Abs(Determinant) > SMALL_NUMBER)
+						{
+							// only the directions matter, the vertex tangents are angle weighted like MikkTSpace does
+							FaceTangents[TriangleIndex] = ((DeltaPosition0 * DeltaUV1.Y - DeltaPosition1 * DeltaUV0.Y) / Determinant).GetSafeNormal();
+							FaceBitangents[TriangleIndex] = ((DeltaPosition1 * DeltaUV0.X - DeltaPosition0 * DeltaUV1.X) / Determinant).GetSafeNormal();
+						}
+						else
+						{
+							FaceTangents[TriangleIndex] = FVector::ZeroVector;
+							FaceBitangents[TriangleIndex] = FVector::ZeroVector;
+						}
+					}
+				});
+
+			if (bGenerateNormals)
+			{
+				TangentSpace.Normals.SetNumUninitialized(NumVertices);
+			}
+			if (bGenerateTangents)
+			{
+				TangentSpace.Tangents.SetNumUninitialized(NumVertices);
+			}
+
+			ParallelFor(NumVertices, [&](const int32 VertexIndex)
+				{
+					FVector Normal;
+					if (bGenerateNormals)
+					{
+						Normal = FVector::ZeroVector;
+						for (int32 AdjacencyIndex = AdjacencyOffsets[VertexIndex]; AdjacencyIndex < AdjacencyOffsets[VertexIndex + 1]; AdjacencyIndex++)
+						{
+							const int32 Corner = Adjacency[AdjacencyIndex];
+							if (Method == EglTFRuntimeTangentSpaceGenerationMethod::AngleWeighted)
+							{
+								Normal += FaceNormals[Corner / 3].GetSafeNormal() * CornerAngles[Corner];
+							}
+							else
+							{
+								Normal += FaceNormals[Corner / 3];
+							}
+						}
+						Normal.Normalize();
+						TangentSpace.Normals[VertexIndex] = Normal;
+					}
+					else
+					{
+						Normal = Primitive.Normals[VertexIndex].GetSafeNormal();
+					}
+
+					if (!bGenerateTangents)
+					{
+						return;
+					}
+
+					// project every corner tangent on the vertex normal plane before averaging
+					FVector Tangent = FVector::ZeroVector;
+					FVector Bitangent = FVector::ZeroVector;
+					for (int32 AdjacencyIndex = AdjacencyOffsets[VertexIndex]; AdjacencyIndex < AdjacencyOffsets[VertexIndex + 1]; AdjacencyIndex++)
+					{
+						const int32 Corner = Adjacency[AdjacencyIndex];
+						const FVector& FaceTangent = FaceTangents[Corner / 3];
+						Tangent += (FaceTangent - Normal * FVector::DotProduct(Normal, FaceTangent)).GetSafeNormal() * CornerAngles[Corner];
+						Bitangent += FaceBitangents[Corner / 3] * CornerAngles[Corner];
+					}
+
+					Tangent = (Tangent - Normal * FVector::DotProduct(Normal, Tangent)).GetSafeNormal();
+					if (Tangent.IsZero())
+					{
+						FVector Unused;
+						Normal.FindBestAxisVectors(Tangent, Unused);
+					}
+
+					// W matches the handedness of the per face tangents (1 unless the UVs are mirrored)
+					const float W = FVector::DotProduct(FVector::CrossProduct(Normal, Tangent), Bitangent) > 0 ? -1 : 1;
+					TangentSpace.Tangents[VertexIndex] = FVector4(Tangent, W);
+				});
+		});
+}
+
 TArray<TSharedRef<FJsonObject>> FglTFRuntimeParser::GetMeshes() const
 {
 	TArray<TSharedRef<FJsonObject>> Meshes;
@@ -3818,6 +4186,8 @@ const FglTFRuntimeBlob* FglTFRuntimeParser::GetAdditionalBufferView(const int64
 		return nullptr;
 	}
 
+	FScopeLock Lock(&CachesLock);
+
 	const TMap<FString, FglTFRuntimeBlob>* Value = AdditionalBufferViewsCache.Find(Index);
 	if (!Value)
 	{
@@ -3841,6 +4211,8 @@ void FglTFRuntimeParser::AddAdditionalBufferView(const int64 Index, const FStrin
 		return;
 	}
 
+	FScopeLock Lock(&CachesLock);
+
 	if (!AdditionalBufferViewsCache.Contains(Index))
 	{
 		AdditionalBufferViewsCache.Add(Index);
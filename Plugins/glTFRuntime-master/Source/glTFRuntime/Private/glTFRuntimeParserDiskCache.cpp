@@ -0,0 +1,341 @@
+// Copyright 2020-2023, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+#include "Hash/CityHash.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace glTFRuntimeDiskCache
+{
+	constexpr uint32 Magic = 0x43526667; // 'gfRC'
+	// bump it whenever the format of the cached items changes
+	constexpr uint32 Version = 3;
+
+	uint64 Hash(const uint8* Data, const int64 Num, uint64 Seed)
+	{
+		// CityHash only takes 32 bit lengths
+		constexpr int64 ChunkSize = 1024 * 1024 * 1024;
+		int64 Offset = 0;
+		do
+		{
+			const int64 Len = FMath::Min(Num - Offset, ChunkSize);
+			Seed = CityHash64WithSeed(reinterpret_cast<const char*>(Data + Offset), static_cast<uint32>(Len), Seed);
+			Offset += Len;
+		} while (Offset < Num);
+		return Seed;
+	}
+
+	template<typename T>
+	uint64 HashValue(const T& Value, const uint64 Seed)
+	{
+		return Hash(reinterpret_cast<const uint8*>(&Value), sizeof(T), Seed);
+	}
+
+	uint64 HashString(const FString& String, const uint64 Seed)
+	{
+		FTCHARToUTF8 Utf8String(*String);
+		return Hash(reinterpret_cast<const uint8*>(Utf8String.Get()), Utf8String.Length(), Seed);
+	}
+
+	// a changed file gets a new size or timestamp, and this only reads the file metadata
+	uint64 HashFileStat(const FString& Filename, uint64 Seed)
+	{
+		IFileManager& FileManager = IFileManager::Get();
+		Seed = HashValue(FileManager.FileSize(*Filename), Seed);
+		return HashValue(FileManager.GetTimeStamp(*Filename).GetTicks(), Seed);
+	}
+
+	bool SerializeHeader(FArchive& Archive)
+	{
+		uint32 FileMagic = Magic;
+		uint32 FileVersion = Version;
+		// the vectors are stored as is, so float and double builds cannot share the cache
+		uint32 VectorSize = sizeof(FVector);
+		Archive << FileMagic;
+		Archive << FileVersion;
+		Archive << VectorSize;
+		if (Archive.IsError() || FileMagic != Magic || FileVersion != Version || VectorSize != sizeof(FVector))
+		{
+			Archive.SetError();
+			return false;
+		}
+		return true;
+	}
+
+	template<typename T, typename AllocatorType>
+	bool SerializeRawArray(FArchive& Archive, TArray<T, AllocatorType>& Items)
+	{
+		int64 Num = Items.Num();
+		Archive << Num;
+		if (Archive.IsLoading())
+		{
+			if (Archive.IsError() || Num < 0 || Num > TNumericLimits<typename TArray<T, AllocatorType>::SizeType>::Max() || Num * static_cast<int64>(sizeof(T)) > Archive.TotalSize() - Archive.Tell())
+			{
+				Archive.SetError();
+				return false;
+			}
+			Items.SetNumUninitialized(static_cast<typename TArray<T, AllocatorType>::SizeType>(Num));
+		}
+		Archive.Serialize(Items.GetData(), Num * sizeof(T));
+		return !Archive.IsError();
+	}
+
+	template<typename T>
+	bool SerializeRawArrays(FArchive& Archive, TArray<TArray<T>>& Items)
+	{
+		int32 Num = Items.Num();
+		Archive << Num;
+		if (Archive.IsLoading())
+		{
+			if (Archive.IsError() || Num < 0 || Num > Archive.TotalSize() - Archive.Tell())
+			{
+				Archive.SetError();
+				return false;
+			}
+			Items.SetNum(Num);
+		}
+		for (TArray<T>& Item : Items)
+		{
+			if (!SerializeRawArray(Archive, Item))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+FString FglTFRuntimeParser::GetDiskCacheDirectory(const uint8* DataPtr, const int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, const FglTFRuntimeMappedFile* InMappedFile)
+{
+	SCOPED_NAMED_EVENT(FglTFRuntimeParser_GetDiskCacheDirectory, FColor::Magenta);
+
+	// hashing a mapped file would page all of it in, defeating the mapping, so it is keyed on its path, size and timestamp
+	uint64 ContentHash = 0;
+	if (InMappedFile && InMappedFile->GetData() == DataPtr)
+	{
+		ContentHash = glTFRuntimeDiskCache::HashString(InMappedFile->GetFilename(), ContentHash);
+		ContentHash = glTFRuntimeDiskCache::HashFileStat(InMappedFile->GetFilename(), ContentHash);
+	}
+	else
+	{
+		ContentHash = glTFRuntimeDiskCache::Hash(DataPtr, DataNum, ContentHash);
+	}
+
+	// the decoded data depends on the scene basis and scale too
+	const FMatrix SceneBasis = LoaderConfig.GetMatrix();
+	const float SceneScale = LoaderConfig.SceneScale;
+	ContentHash = glTFRuntimeDiskCache::Hash(reinterpret_cast<const uint8*>(&SceneBasis.M[0][0]), sizeof(SceneBasis.M), ContentHash);
+	ContentHash = glTFRuntimeDiskCache::HashValue(SceneScale, ContentHash);
+
+	const FString BaseDirectory = LoaderConfig.DiskCacheDirectory.IsEmpty() ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("glTFRuntime"), TEXT("DiskCache")) : LoaderConfig.DiskCacheDirectory;
+	return FPaths::Combine(BaseDirectory, FString::Printf(TEXT("%016llx"), ContentHash));
+}
+
+uint64 FglTFRuntimeParser::GetDiskCacheItemHash(TSharedRef<FJsonObject> JsonObject, const FString& Suffix) const
+{
+	FString Json;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Json);
+	if (!FJsonSerializer::Serialize(JsonObject, JsonWriter))
+	{
+		return 0;
+	}
+
+	Json += TEXT(" ") + Suffix;
+
+	// the item may come from any of the external files, so all of them are part of its key
+	return glTFRuntimeDiskCache::HashString(Json, GetDiskCacheExternalFilesHash());
+}
+
+uint64 FglTFRuntimeParser::GetDiskCacheExternalFilesHash() const
+{
+	FScopeLock Lock(&CachesLock);
+
+	if (DiskCacheExternalFilesHash.IsSet())
+	{
+		return DiskCacheExternalFilesHash.GetValue();
+	}
+
+	// zip members are already covered by the archive content, data uris by the json
+	uint64 ExternalFilesHash = 0;
+	if (!BaseDirectory.IsEmpty())
+	{
+		for (const TCHAR* FieldName : { TEXT("buffers"), TEXT("images") })
+		{
+			const TArray<TSharedPtr<FJsonValue>>* JsonItems;
+			if (!Root->TryGetArrayField(FieldName, JsonItems))
+			{
+				continue;
+			}
+
+			for (const TSharedPtr<FJsonValue>& JsonItem : *JsonItems)
+			{
+				const TSharedPtr<FJsonObject>* JsonItemObject;
+				FString Uri;
+				if (!JsonItem->TryGetObject(JsonItemObject) || !(*JsonItemObject)->TryGetStringField("uri", Uri) || Uri.StartsWith("data:"))
+				{
+					continue;
+				}
+
+				if (ZipFile && ZipFile->FileExists(Uri))
+				{
+					continue;
+				}
+
+				ExternalFilesHash = glTFRuntimeDiskCache::HashFileStat(FPaths::Combine(BaseDirectory, Uri), ExternalFilesHash);
+			}
+		}
+	}
+
+	DiskCacheExternalFilesHash = ExternalFilesHash;
+	return ExternalFilesHash;
+}
+
+bool FglTFRuntimeParser::LoadFromDiskCache(const FString& Category, const uint64 ItemHash, TArray<uint8>& Data) const
+{
+	SCOPED_NAMED_EVENT(FglTFRuntimeParser_LoadFromDiskCache, FColor::Magenta);
+
+	const FString Filename = FPaths::Combine(DiskCacheDirectory, FString::Printf(TEXT("%s_%016llx.bin"), *Category, ItemHash));
+	return FFileHelper::LoadFileToArray(Data, *Filename, FILEREAD_Silent);
+}
+
+void FglTFRuntimeParser::SaveToDiskCache(const FString& Category, const uint64 ItemHash, const TArray<uint8>& Data) const
+{
+	SCOPED_NAMED_EVENT(FglTFRuntimeParser_SaveToDiskCache, FColor::Magenta);
+
+	IFileManager& FileManager = IFileManager::Get();
+	if (!FileManager.MakeDirectory(*DiskCacheDirectory, true))
+	{
+		UE_LOG(LogGLTFRuntime, Warning, TEXT("Unable to create disk cache directory %s"), *DiskCacheDirectory);
+		return;
+	}
+
+	// write to a temporary file first, so concurrent loaders never see a partial item
+	const FString Filename = FPaths::Combine(DiskCacheDirectory, FString::Printf(TEXT("%s_%016llx.bin"), *Category, ItemHash));
+	const FString TempFilename = FPaths::Combine(DiskCacheDirectory, FGuid::NewGuid().ToString() + TEXT(".tmp"));
+	if (!FFileHelper::SaveArrayToFile(Data, *TempFilename))
+	{
+		UE_LOG(LogGLTFRuntime, Warning, TEXT("Unable to write disk cache item %s"), *TempFilename);
+		return;
+	}
+
+	if (!FileManager.Move(*Filename, *TempFilename, true, true))
+	{
+		FileManager.Delete(*TempFilename, false, true, true);
+	}
+}
+
+bool FglTFRuntimeParser::SerializePrimitiveAttributes(FArchive& Archive, FglTFRuntimePrimitive& Primitive)
+{
+	if (Archive.IsLoading())
+	{
+		Primitive.Positions.Empty();
+		Primitive.Normals.Empty();
+		Primitive.Tangents.Empty();
+		Primitive.UVs.Empty();
+		Primitive.Indices.Empty();
+		Primitive.Joints.Empty();
+		Primitive.Weights.Empty();
+		Primitive.Colors.Empty();
+		Primitive.MorphTargets.Empty();
+	}
+
+	bool bSuccess = glTFRuntimeDiskCache::SerializeHeader(Archive) &&
+		glTFRuntimeDiskCache::SerializeRawArray(Archive, Primitive.Positions) &&
+		glTFRuntimeDiskCache::SerializeRawArray(Archive, Primitive.Normals) &&
+		glTFRuntimeDiskCache::SerializeRawArray(Archive, Primitive.Tangents) &&
+		glTFRuntimeDiskCache::SerializeRawArrays(Archive, Primitive.UVs) &&
+		glTFRuntimeDiskCache::SerializeRawArray(Archive, Primitive.Indices) &&
+		glTFRuntimeDiskCache::SerializeRawArrays(Archive, Primitive.Joints) &&
+		glTFRuntimeDiskCache::SerializeRawArrays(Archive, Primitive.Weights) &&
+		glTFRuntimeDiskCache::SerializeRawArray(Archive, Primitive.Colors);
+
+	if (bSuccess)
+	{
+		int32 NumMorphTargets = Primitive.MorphTargets.Num();
+		Archive << NumMorphTargets;
+		if (Archive.IsLoading())
+		{
+			if (Archive.IsError() || NumMorphTargets < 0 || NumMorphTargets > Archive.TotalSize() - Archive.Tell())
+			{
+				Archive.SetError();
+				NumMorphTargets = 0;
+			}
+			Primitive.MorphTargets.SetNum(NumMorphTargets);
+		}
+
+		for (FglTFRuntimeMorphTarget& MorphTarget : Primitive.MorphTargets)
+		{
+			Archive << MorphTarget.Name;
+			if (!glTFRuntimeDiskCache::SerializeRawArray(Archive, MorphTarget.Positions) ||
+				!glTFRuntimeDiskCache::SerializeRawArray(Archive, MorphTarget.Normals))
+			{
+				break;
+			}
+		}
+
+		bSuccess = !Archive.IsError();
+	}
+
+	if (!bSuccess && Archive.IsLoading())
+	{
+		Primitive.Positions.Empty();
+		Primitive.Normals.Empty();
+		Primitive.Tangents.Empty();
+		Primitive.UVs.Empty();
+		Primitive.Indices.Empty();
+		Primitive.Joints.Empty();
+		Primitive.Weights.Empty();
+		Primitive.Colors.Empty();
+		Primitive.MorphTargets.Empty();
+	}
+
+	return bSuccess;
+}
+
+bool FglTFRuntimeParser::SerializeMips(FArchive& Archive, const int32 TextureIndex, TArray<FglTFRuntimeMipMap>& Mips)
+{
+	if (!glTFRuntimeDiskCache::SerializeHeader(Archive))
+	{
+		return false;
+	}
+
+	int32 NumMips = Mips.Num();
+	Archive << NumMips;
+	if (Archive.IsLoading() && (Archive.IsError() || NumMips < 0 || NumMips > 32))
+	{
+		Archive.SetError();
+		return false;
+	}
+
+	TArray<FglTFRuntimeMipMap> LoadedMips;
+	for (int32 MipIndex = 0; MipIndex < NumMips; MipIndex++)
+	{
+		FglTFRuntimeMipMap& MipMap = Archive.IsLoading() ? LoadedMips.Add_GetRef(FglTFRuntimeMipMap(TextureIndex)) : Mips[MipIndex];
+		Archive << MipMap.Width;
+		Archive << MipMap.Height;
+		uint8 PixelFormat = static_cast<uint8>(MipMap.PixelFormat);
+		Archive << PixelFormat;
+		if (PixelFormat >= EPixelFormat::PF_MAX)
+		{
+			Archive.SetError();
+			return false;
+		}
+		MipMap.PixelFormat = static_cast<EPixelFormat>(PixelFormat);
+		if (!glTFRuntimeDiskCache::SerializeRawArray(Archive, MipMap.Pixels))
+		{
+			return false;
+		}
+	}
+
+	if (Archive.IsLoading() && !Archive.IsError())
+	{
+		Mips.Append(MoveTemp(LoadedMips));
+	}
+
+	return !Archive.IsError();
+}
@@ -0,0 +1,206 @@
+// Copyright 2020-2023, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+
+#if WITH_GLTFRUNTIME_DRACO
+THIRD_PARTY_INCLUDES_START
+#include "draco/compression/decode.h"
+THIRD_PARTY_INCLUDES_END
+#endif
+
+namespace glTFRuntimeDraco
+{
+	// decoded bufferViews are exposed as additional bufferViews, far from the indices used by OnPreLoadedPrimitive handlers
+	constexpr int64 AdditionalBufferViewBase = 1LL << 40;
+
+#if WITH_GLTFRUNTIME_DRACO
+	template<typename T>
+	void CopyAttribute(const draco::PointAttribute* Attribute, const int64 NumPoints, const int64 Elements, uint8* Data)
+	{
+		T* Values = reinterpret_cast<T*>(Data);
+		for (int64 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+		{
+			Attribute->ConvertValue<T>(Attribute->mapped_index(draco::PointIndex(static_cast<uint32>(PointIndex))), static_cast<int8_t>(Elements), Values + PointIndex * Elements);
+		}
+	}
+
+	template<typename T>
+	void CopyIndices(const draco::Mesh& Mesh, uint8* Data)
+	{
+		T* Values = reinterpret_cast<T*>(Data);
+		for (uint32 FaceIndex = 0; FaceIndex < Mesh.num_faces(); FaceIndex++)
+		{
+			const draco::Mesh::Face& Face = Mesh.face(draco::FaceIndex(FaceIndex));
+			Values[FaceIndex * 3] = static_cast<T>(Face[0].value());
+			Values[FaceIndex * 3 + 1] = static_cast<T>(Face[1].value());
+			Values[FaceIndex * 3 + 2] = static_cast<T>(Face[2].value());
+		}
+	}
+#endif
+}
+
+bool FglTFRuntimeParser::DecompressDraco(TSharedRef<FJsonObject> JsonPrimitiveObject, TSharedRef<FJsonObject> JsonDracoObject, int64& AdditionalBufferView)
+{
+	SCOPED_NAMED_EVENT(FglTFRuntimeParser_DecompressDraco, FColor::Magenta);
+
+#if WITH_GLTFRUNTIME_DRACO
+	int64 BufferViewIndex;
+	if (!JsonDracoObject->TryGetNumberField("bufferView", BufferViewIndex))
+	{
+		AddError("DecompressDraco()", "Missing bufferView in KHR_draco_mesh_compression");
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>* JsonDracoAttributesObject;
+	if (!JsonDracoObject->TryGetObjectField("attributes", JsonDracoAttributesObject))
+	{
+		AddError("DecompressDraco()", "Missing attributes in KHR_draco_mesh_compression");
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>* JsonAttributesObject;
+	if (!JsonPrimitiveObject->TryGetObjectField("attributes", JsonAttributesObject))
+	{
+		AddError("DecompressDraco()", "No attributes array available");
+		return false;
+	}
+
+	const int64 DracoAdditionalBufferView = glTFRuntimeDraco::AdditionalBufferViewBase + BufferViewIndex;
+
+	// primitives sharing the same Draco bufferView decode it only once
+	{
+		FScopeLock Lock(&CachesLock);
+		if (AdditionalBufferViewsCache.Contains(DracoAdditionalBufferView))
+		{
+			AdditionalBufferView = DracoAdditionalBufferView;
+			return true;
+		}
+	}
+
+	FglTFRuntimeBlob Blob;
+	int64 Stride = 0;
+	if (!GetBufferView(BufferViewIndex, Blob, Stride))
+	{
+		AddError("DecompressDraco()", FString::Printf(TEXT("Unable to get bufferView %lld"), BufferViewIndex));
+		return false;
+	}
+
+	draco::DecoderBuffer DecoderBuffer;
+	DecoderBuffer.Init(reinterpret_cast<const char*>(Blob.Data), static_cast<size_t>(Blob.Num));
+
+	draco::Decoder Decoder;
+	draco::StatusOr<std::unique_ptr<draco::Mesh>> DecoderStatus = Decoder.DecodeMeshFromBuffer(&DecoderBuffer);
+	if (!DecoderStatus.ok())
+	{
+		AddError("DecompressDraco()", FString::Printf(TEXT("Unable to decode Draco mesh: %s"), UTF8_TO_TCHAR(DecoderStatus.status().error_msg())));
+		return false;
+	}
+
+	const std::unique_ptr<draco::Mesh> Mesh = std::move(DecoderStatus).value();
+	const int64 NumPoints = Mesh->num_points();
+
+	TMap<FString, TArray64<uint8>> DecodedAttributes;
+
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*JsonDracoAttributesObject)->Values)
+	{
+		int64 AccessorIndex;
+		if (!(*JsonAttributesObject)->TryGetNumberField(Pair.Key, AccessorIndex))
+		{
+			continue;
+		}
+
+		TSharedPtr<FJsonObject> JsonAccessorObject = GetJsonObjectFromRootIndex("accessors", AccessorIndex);
+		int64 ComponentType;
+		int64 Count;
+		FString Type;
+		if (!JsonAccessorObject || !JsonAccessorObject->TryGetNumberField("componentType", ComponentType) || !JsonAccessorObject->TryGetNumberField("count", Count) || !JsonAccessorObject->TryGetStringField("type", Type))
+		{
+			AddError("DecompressDraco()", FString::Printf(TEXT("Invalid accessor %lld for Draco attribute %s"), AccessorIndex, *Pair.Key));
+			return false;
+		}
+
+		const int64 ElementSize = GetComponentTypeSize(ComponentType);
+		const int64 Elements = GetTypeSize(Type);
+		const draco::PointAttribute* Attribute = Mesh->GetAttributeByUniqueId(static_cast<uint32>(Pair.Value->AsNumber()));
+		if (!Attribute || ElementSize == 0 || Elements == 0 || Count != NumPoints)
+		{
+			AddError("DecompressDraco()", FString::Printf(TEXT("Draco attribute %s does not match its accessor"), *Pair.Key));
+			return false;
+		}
+
+		// decode straight to the accessor layout, so the usual attributes loading can read it
+		TArray64<uint8>& Data = DecodedAttributes.Add(Pair.Key);
+		Data.AddUninitialized(Count * Elements * ElementSize);
+		switch (ComponentType)
+		{
+		case 5120:
+			glTFRuntimeDraco::CopyAttribute<int8>(Attribute, NumPoints, Elements, Data.GetData());
+			break;
+		case 5121:
+			glTFRuntimeDraco::CopyAttribute<uint8>(Attribute, NumPoints, Elements, Data.GetData());
+			break;
+		case 5122:
+			glTFRuntimeDraco::CopyAttribute<int16>(Attribute, NumPoints, Elements, Data.GetData());
+			break;
+		case 5123:
+			glTFRuntimeDraco::CopyAttribute<uint16>(Attribute, NumPoints, Elements, Data.GetData());
+			break;
+		case 5125:
+			glTFRuntimeDraco::CopyAttribute<uint32>(Attribute, NumPoints, Elements, Data.GetData());
+			break;
+		default:
+			glTFRuntimeDraco::CopyAttribute<float>(Attribute, NumPoints, Elements, Data.GetData());
+			break;
+		}
+	}
+
+	int64 IndicesAccessorIndex;
+	if (JsonPrimitiveObject->TryGetNumberField("indices", IndicesAccessorIndex))
+	{
+		TSharedPtr<FJsonObject> JsonAccessorObject = GetJsonObjectFromRootIndex("accessors", IndicesAccessorIndex);
+		int64 ComponentType;
+		int64 Count;
+		if (!JsonAccessorObject || !JsonAccessorObject->TryGetNumberField("componentType", ComponentType) || !JsonAccessorObject->TryGetNumberField("count", Count) || Count != static_cast<int64>(Mesh->num_faces()) * 3)
+		{
+			AddError("DecompressDraco()", "Draco faces do not match the indices accessor");
+			return false;
+		}
+
+		TArray64<uint8>& Data = DecodedAttributes.Add("indices");
+		Data.AddUninitialized(Count * GetComponentTypeSize(ComponentType));
+		if (ComponentType == 5121)
+		{
+			glTFRuntimeDraco::CopyIndices<uint8>(*Mesh, Data.GetData());
+		}
+		else if (ComponentType == 5123)
+		{
+			glTFRuntimeDraco::CopyIndices<uint16>(*Mesh, Data.GetData());
+		}
+		else if (ComponentType == 5125)
+		{
+			glTFRuntimeDraco::CopyIndices<uint32>(*Mesh, Data.GetData());
+		}
+		else
+		{
+			AddError("DecompressDraco()", FString::Printf(TEXT("Invalid component type for indices: %lld"), ComponentType));
+			return false;
+		}
+	}
+
+	FScopeLock Lock(&CachesLock);
+	// another thread could have decoded it in the meantime
+	if (!AdditionalBufferViewsCache.Contains(DracoAdditionalBufferView))
+	{
+		for (const TPair<FString, TArray64<uint8>>& Pair : DecodedAttributes)
+		{
+			AddAdditionalBufferViewData(DracoAdditionalBufferView, Pair.Key, Pair.Value);
+		}
+	}
+
+	AdditionalBufferView = DracoAdditionalBufferView;
+	return true;
+#else
+	AddError("DecompressDraco()", "KHR_draco_mesh_compression is not available in this build, add the Draco library to Source/ThirdParty/draco or install glTFRuntimeDraco");
+	return false;
+#endif
+}
@@ -0,0 +1,281 @@
+// Copyright 2020-2023, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+#include "PixelFormat.h"
+#include "RenderUtils.h"
+
+#if WITH_GLTFRUNTIME_BASISU
+THIRD_PARTY_INCLUDES_START
+#include "basisu_transcoder.h"
+THIRD_PARTY_INCLUDES_END
+#endif
+
+namespace glTFRuntimeKTX2
+{
+	constexpr uint8 Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	constexpr int64 HeaderSize = 80;
+	constexpr int64 LevelIndexItemSize = 24;
+
+	struct FHeader
+	{
+		uint32 VkFormat;
+		uint32 TypeSize;
+		uint32 PixelWidth;
+		uint32 PixelHeight;
+		uint32 PixelDepth;
+		uint32 LayerCount;
+		uint32 FaceCount;
+		uint32 LevelCount;
+		uint32 SupercompressionScheme;
+	};
+
+	struct FLevel
+	{
+		uint64 ByteOffset;
+		uint64 ByteLength;
+		uint64 UncompressedByteLength;
+	};
+
+	// the subset of VkFormat we can upload as is
+	EPixelFormat GetPixelFormat(const uint32 VkFormat, bool& bSwizzleRGBA)
+	{
+		bSwizzleRGBA = false;
+		switch (VkFormat)
+		{
+		case 37: // VK_FORMAT_R8G8B8A8_UNORM
+		case 43: // VK_FORMAT_R8G8B8A8_SRGB
+			bSwizzleRGBA = true;
+			return EPixelFormat::PF_B8G8R8A8;
+		case 44: // VK_FORMAT_B8G8R8A8_UNORM
+		case 50: // VK_FORMAT_B8G8R8A8_SRGB
+			return EPixelFormat::PF_B8G8R8A8;
+		case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		case 132: // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+		case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+		case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+			return EPixelFormat::PF_DXT1;
+		case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+		case 138: // VK_FORMAT_BC3_SRGB_BLOCK
+			return EPixelFormat::PF_DXT5;
+		case 139: // VK_FORMAT_BC4_UNORM_BLOCK
+			return EPixelFormat::PF_BC4;
+		case 141: // VK_FORMAT_BC5_UNORM_BLOCK
+			return EPixelFormat::PF_BC5;
+		case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+		case 146: // VK_FORMAT_BC7_SRGB_BLOCK
+			return EPixelFormat::PF_BC7;
+		default:
+			break;
+		}
+		return EPixelFormat::PF_Unknown;
+	}
+
+	int64 GetMipSize(const EPixelFormat PixelFormat, const int32 Width, const int32 Height)
+	{
+		const FPixelFormatInfo& Info = GPixelFormats[PixelFormat];
+		return static_cast<int64>(FMath::DivideAndRoundUp(Width, Info.BlockSizeX)) * FMath::DivideAndRoundUp(Height, Info.BlockSizeY) * Info.BlockBytes;
+	}
+
+	void SwizzleRGBA(TArray64<uint8>& Pixels)
+	{
+		for (int64 Index = 0; Index + 3 < Pixels.Num(); Index += 4)
+		{
+			Swap(Pixels[Index], Pixels[Index + 2]);
+		}
+	}
+
+	// block compressed textures need whole blocks in the top level
+	bool CanUseBlockFormat(const EPixelFormat PixelFormat, const int32 Width, const int32 Height)
+	{
+		const FPixelFormatInfo& Info = GPixelFormats[PixelFormat];
+		return Info.Supported && (Width % Info.BlockSizeX) == 0 && (Height % Info.BlockSizeY) == 0;
+	}
+}
+
+bool FglTFRuntimeParser::IsKTX2(const TArray64<uint8>& Blob)
+{
+	return Blob.Num() >= glTFRuntimeKTX2::HeaderSize && FMemory::Memcmp(Blob.GetData(), glTFRuntimeKTX2::Identifier, sizeof(glTFRuntimeKTX2::Identifier)) == 0;
+}
+
+bool FglTFRuntimeParser::LoadKTX2Mips(const int32 TextureIndex, const TArray64<uint8>& Blob, TArray<FglTFRuntimeMipMap>& Mips, const FglTFRuntimeImagesConfig& ImagesConfig, const bool bAllowBlockCompressed)
+{
+	SCOPED_NAMED_EVENT(FglTFRuntimeParser_LoadKTX2Mips, FColor::Magenta);
+
+	if (!IsKTX2(Blob))
+	{
+		AddError("LoadKTX2Mips()", "Invalid KTX2 identifier");
+		return false;
+	}
+
+	glTFRuntimeKTX2::FHeader Header;
+	FMemory::Memcpy(&Header, Blob.GetData() + sizeof(glTFRuntimeKTX2::Identifier), sizeof(Header));
+
+	if (Header.PixelWidth == 0 || Header.PixelHeight == 0 || Header.PixelDepth > 1 || Header.LayerCount > 1 || Header.FaceCount > 1)
+	{
+		AddError("LoadKTX2Mips()", "Only 2D KTX2 textures are supported");
+		return false;
+	}
+
+	const int32 NumLevels = FMath::Max<int32>(Header.LevelCount, 1);
+	if (Blob.Num() < glTFRuntimeKTX2::HeaderSize + NumLevels * glTFRuntimeKTX2::LevelIndexItemSize)
+	{
+		AddError("LoadKTX2Mips()", "Truncated KTX2 level index");
+		return false;
+	}
+
+	// skip the levels over the configured max size, they are already there
+	auto IsLevelTooBig = [&ImagesConfig](const int32 Width, const int32 Height)
+	{
+		return (ImagesConfig.MaxWidth > 0 && Width > ImagesConfig.MaxWidth) || (ImagesConfig.MaxHeight > 0 && Height > ImagesConfig.MaxHeight);
+	};
+
+	// Basis Universal payloads (ETC1S or UASTC) have no VkFormat
+	if (Header.VkFormat == 0)
+	{
+#if WITH_GLTFRUNTIME_BASISU
+		static const bool bBasisInitialized = []()
+		{
+			basist::basisu_transcoder_init();
+			return true;
+		}();
+		(void)bBasisInitialized;
+
+		basist::ktx2_transcoder Transcoder;
+		if (!Transcoder.init(Blob.GetData(), static_cast<uint32>(Blob.Num())) || !Transcoder.start_transcoding())
+		{
+			AddError("LoadKTX2Mips()", "Unable to initialize Basis Universal transcoder");
+			return false;
+		}
+
+		const int32 Width = Transcoder.get_width();
+		const int32 Height = Transcoder.get_height();
+
+		// pick the best format the RHI can sample directly, falling back to raw pixels
+		basist::transcoder_texture_format TargetFormat = basist::transcoder_texture_format::cTFRGBA32;
+		EPixelFormat PixelFormat = EPixelFormat::PF_B8G8R8A8;
+		if (bAllowBlockCompressed)
+		{
+			if (Transcoder.is_uastc() && glTFRuntimeKTX2::CanUseBlockFormat(EPixelFormat::PF_BC7, Width, Height))
+			{
+				TargetFormat = basist::transcoder_texture_format::cTFBC7_RGBA;
+				PixelFormat = EPixelFormat::PF_BC7;
+			}
+			else if (Transcoder.get_has_alpha() && glTFRuntimeKTX2::CanUseBlockFormat(EPixelFormat::PF_DXT5, Width, Height))
+			{
+				TargetFormat = basist::transcoder_texture_format::cTFBC3_RGBA;
+				PixelFormat = EPixelFormat::PF_DXT5;
+			}
+			else if (!Transcoder.get_has_alpha() && glTFRuntimeKTX2::CanUseBlockFormat(EPixelFormat::PF_DXT1, Width, Height))
+			{
+				TargetFormat = basist::transcoder_texture_format::cTFBC1_RGB;
+				PixelFormat = EPixelFormat::PF_DXT1;
+			}
+			else if (glTFRuntimeKTX2::CanUseBlockFormat(EPixelFormat::PF_ASTC_4x4, Width, Height))
+			{
+				TargetFormat = basist::transcoder_texture_format::cTFASTC_4x4_RGBA;
+				PixelFormat = EPixelFormat::PF_ASTC_4x4;
+			}
+		}
+
+		const uint32 BytesPerBlockOrPixel = basist::basis_get_bytes_per_block_or_pixel(TargetFormat);
+		const bool bUncompressed = basist::basis_transcoder_format_is_uncompressed(TargetFormat);
+
+		TArray<FglTFRuntimeMipMap> TranscodedMips;
+		for (uint32 LevelIndex = 0; LevelIndex < Transcoder.get_levels(); LevelIndex++)
+		{
+			basist::ktx2_image_level_info LevelInfo;
+			if (!Transcoder.get_image_level_info(LevelInfo, LevelIndex, 0, 0))
+			{
+				AddError("LoadKTX2Mips()", FString::Printf(TEXT("Unable to get KTX2 level %u"), LevelIndex));
+				return false;
+			}
+
+			if (IsLevelTooBig(LevelInfo.m_orig_width, LevelInfo.m_orig_height) && LevelIndex + 1 < Transcoder.get_levels())
+			{
+				continue;
+			}
+
+			const uint32 NumBlocksOrPixels = bUncompressed ? LevelInfo.m_orig_width * LevelInfo.m_orig_height : LevelInfo.m_total_blocks;
+
+			FglTFRuntimeMipMap MipMap(TextureIndex);
+			MipMap.Width = LevelInfo.m_orig_width;
+			MipMap.Height = LevelInfo.m_orig_height;
+			MipMap.PixelFormat = PixelFormat;
+			MipMap.Pixels.AddUninitialized(static_cast<int64>(NumBlocksOrPixels) * BytesPerBlockOrPixel);
+			if (!Transcoder.transcode_image_level(LevelIndex, 0, 0, MipMap.Pixels.GetData(), NumBlocksOrPixels, TargetFormat))
+			{
+				AddError("LoadKTX2Mips()", FString::Printf(TEXT("Unable to transcode KTX2 level %u"), LevelIndex));
+				return false;
+			}
+
+			if (bUncompressed)
+			{
+				glTFRuntimeKTX2::SwizzleRGBA(MipMap.Pixels);
+			}
+
+			TranscodedMips.Add(MoveTemp(MipMap));
+		}
+
+		Mips.Append(MoveTemp(TranscodedMips));
+		return true;
+#else
+		AddError("LoadKTX2Mips()", "Basis Universal KTX2 textures are not available in this build, add the transcoder library to Source/ThirdParty/basisu");
+		return false;
+#endif
+	}
+
+	if (Header.SupercompressionScheme != 0)
+	{
+		AddError("LoadKTX2Mips()", FString::Printf(TEXT("Unsupported KTX2 supercompression scheme %u"), Header.SupercompressionScheme));
+		return false;
+	}
+
+	bool bSwizzleRGBA = false;
+	const EPixelFormat PixelFormat = glTFRuntimeKTX2::GetPixelFormat(Header.VkFormat, bSwizzleRGBA);
+	if (PixelFormat == EPixelFormat::PF_Unknown)
+	{
+		AddError("LoadKTX2Mips()", FString::Printf(TEXT("Unsupported KTX2 VkFormat %u"), Header.VkFormat));
+		return false;
+	}
+
+	if (PixelFormat != EPixelFormat::PF_B8G8R8A8 && (!bAllowBlockCompressed || !glTFRuntimeKTX2::CanUseBlockFormat(PixelFormat, Header.PixelWidth, Header.PixelHeight)))
+	{
+		AddError("LoadKTX2Mips()", FString::Printf(TEXT("KTX2 pixel format %s cannot be used here"), GPixelFormats[PixelFormat].Name));
+		return false;
+	}
+
+	TArray<FglTFRuntimeMipMap> LoadedMips;
+	for (int32 LevelIndex = 0; LevelIndex < NumLevels; LevelIndex++)
+	{
+		const int32 Width = FMath::Max<int32>(Header.PixelWidth >> LevelIndex, 1);
+		const int32 Height = FMath::Max<int32>(Header.PixelHeight >> LevelIndex, 1);
+		if (IsLevelTooBig(Width, Height) && LevelIndex + 1 < NumLevels)
+		{
+			continue;
+		}
+
+		glTFRuntimeKTX2::FLevel Level;
+		FMemory::Memcpy(&Level, Blob.GetData() + glTFRuntimeKTX2::HeaderSize + LevelIndex * glTFRuntimeKTX2::LevelIndexItemSize, sizeof(Level));
+
+		const int64 MipSize = glTFRuntimeKTX2::GetMipSize(PixelFormat, Width, Height);
+		if (Level.ByteLength < static_cast<uint64>(MipSize) || Level.ByteOffset + MipSize > static_cast<uint64>(Blob.Num()))
+		{
+			AddError("LoadKTX2Mips()", FString::Printf(TEXT("Invalid KTX2 level %d"), LevelIndex));
+			return false;
+		}
+
+		FglTFRuntimeMipMap MipMap(TextureIndex);
+		MipMap.Width = Width;
+		MipMap.Height = Height;
+		MipMap.PixelFormat = PixelFormat;
+		MipMap.Pixels.Append(Blob.GetData() + Level.ByteOffset, MipSize);
+		if (bSwizzleRGBA)
+		{
+			glTFRuntimeKTX2::SwizzleRGBA(MipMap.Pixels);
+		}
+		LoadedMips.Add(MoveTemp(MipMap));
+	}
+
+	Mips.Append(MoveTemp(LoadedMips));
+	return true;
+}
@@ -2,6 +2,7 @@
 
 #include "glTFRuntimeParser.h"
 #include "Runtime/Launch/Resources/Version.h"
+#include "Async/ParallelFor.h"
 #include "Engine/Texture2D.h"
 #include "IImageWrapperModule.h"
 #include "IImageWrapper.h"
@@ -16,9 +17,134 @@
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Math/UnrealMathUtility.h"
 #include "Modules/ModuleManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
 #include "TextureResource.h"
 
 
+namespace glTFRuntimeMipMaps
+{
+	struct FTaps
+	{
+		int32 First;
+		int32 Num;
+		float Weights[3];
+	};
+
+	// every destination texel averages the source area it covers: two texels, or up to three when the source size is odd
+	void ComputeTaps(const int32 SrcSize, const int32 DstSize, TArray<FTaps>& Taps)
+	{
+		const double Scale = static_cast<double>(SrcSize) / DstSize;
+		Taps.SetNumUninitialized(DstSize);
+		for (int32 Index = 0; Index < DstSize; Index++)
+		{
+			const double Start = Index * Scale;
+			const double End = Start + Scale;
+			FTaps& Tap = Taps[Index];
+			Tap.First = FMath::FloorToInt(Start);
+			Tap.Num = 0;
+			for (int32 SrcIndex = Tap.First; SrcIndex < SrcSize && SrcIndex < End && Tap.Num < 3; SrcIndex++)
+			{
+				const double Coverage = FMath::Min<double>(SrcIndex + 1, End) - FMath::Max<double>(SrcIndex, Start);
+				Tap.Weights[Tap.Num++] = static_cast<float>(Coverage / Scale);
+			}
+		}
+	}
+
+	const uint8* GetLinearToSRGBTable()
+	{
+		static const TArray<uint8> Table = []()
+		{
+			TArray<uint8> NewTable;
+			NewTable.AddUninitialized(4096);
+			for (int32 Index = 0; Index < 4096; Index++)
+			{
+				const float Value = Index / 4095.0f;
+				const float SRGBValue = Value <= 0.0031308f ? Value * 12.92f : 1.055f * FMath::Pow(Value, 1.0f / 2.4f) - 0.055f;
+				NewTable[Index] = static_cast<uint8>(FMath::Clamp(FMath::RoundToInt(SRGBValue * 255.0f), 0, 255));
+			}
+			return NewTable;
+		}();
+		return Table.GetData();
+	}
+
+	// BGRA8 to BGRA8, averaging color in linear space for sRGB textures
+	void Downsample(const uint8* Src, const int32 SrcWidth, const int32 SrcHeight, uint8* Dst, const int32 DstWidth, const int32 DstHeight, const bool bSRGB)
+	{
+		const int64 SrcPitch = static_cast<int64>(SrcWidth) * 4;
+		const EParallelForFlags ParallelForFlags = DstWidth * DstHeight < 64 * 64 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+
+		if (!bSRGB && (SrcWidth == DstWidth * 2 || SrcWidth == 1) && (SrcHeight == DstHeight * 2 || SrcHeight == 1))
+		{
+			// plain 2x2 box in integers, simple enough for the compiler to vectorize
+			const int32 NextTexel = SrcWidth > 1 ? 4 : 0;
+			ParallelFor(DstHeight, [&](const int32 Y)
+				{
+					const uint8* Row0 = Src + FMath::Min(Y * 2, SrcHeight - 1) * SrcPitch;
+					const uint8* Row1 = Src + FMath::Min(Y * 2 + 1, SrcHeight - 1) * SrcPitch;
+					uint8* Out = Dst + static_cast<int64>(Y) * DstWidth * 4;
+					for (int32 X = 0; X < DstWidth * 4; X += 4)
+					{
+						const uint8* Texel0 = Row0 + X * 2;
+						const uint8* Texel1 = Row1 + X * 2;
+						for (int32 Channel = 0; Channel < 4; Channel++)
+						{
+							Out[X + Channel] = static_cast<uint8>((Texel0[Channel] + Texel0[NextTexel + Channel] + Texel1[Channel] + Texel1[NextTexel + Channel] + 2) >> 2);
+						}
+					}
+				}, ParallelForFlags);
+			return;
+		}
+
+		TArray<FTaps> TapsX;
+		TArray<FTaps> TapsY;
+		ComputeTaps(SrcWidth, DstWidth, TapsX);
+		ComputeTaps(SrcHeight, DstHeight, TapsY);
+
+		const uint8* LinearToSRGB = GetLinearToSRGBTable();
+
+		ParallelFor(DstHeight, [&](const int32 Y)
+			{
+				const FTaps& TapY = TapsY[Y];
+				uint8* Out = Dst + static_cast<int64>(Y) * DstWidth * 4;
+				for (int32 X = 0; X < DstWidth; X++)
+				{
+					const FTaps& TapX = TapsX[X];
+					float Accumulator[4] = { 0, 0, 0, 0 };
+					for (int32 IndexY = 0; IndexY < TapY.Num; IndexY++)
+					{
+						const uint8* Row = Src + (TapY.First + IndexY) * SrcPitch;
+						for (int32 IndexX = 0; IndexX < TapX.Num; IndexX++)
+						{
+							const uint8* Texel = Row + (TapX.First + IndexX) * 4;
+							const float Weight = TapY.Weights[IndexY] * TapX.Weights[IndexX];
+							if (bSRGB)
+							{
+								Accumulator[0] += FLinearColor::sRGBToLinearTable[Texel[0]] * Weight;
+								Accumulator[1] += FLinearColor::sRGBToLinearTable[Texel[1]] * Weight;
+								Accumulator[2] += FLinearColor::sRGBToLinearTable[Texel[2]] * Weight;
+							}
+							else
+							{
+								Accumulator[0] += Texel[0] * (Weight / 255.0f);
+								Accumulator[1] += Texel[1] * (Weight / 255.0f);
+								Accumulator[2] += Texel[2] * (Weight / 255.0f);
+							}
+							Accumulator[3] += Texel[3] * (Weight / 255.0f);
+						}
+					}
+
+					for (int32 Channel = 0; Channel < 3; Channel++)
+					{
+						const float Value = FMath::Clamp(Accumulator[Channel], 0.0f, 1.0f);
+						Out[X * 4 + Channel] = bSRGB ? LinearToSRGB[FMath::RoundToInt(Value * 4095.0f)] : static_cast<uint8>(FMath::RoundToInt(Value * 255.0f));
+					}
+					Out[X * 4 + 3] = static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(Accumulator[3], 0.0f, 1.0f) * 255.0f));
+				}
+			}, ParallelForFlags);
+	}
+}
+
 UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index, const FString& MaterialName, TSharedRef<FJsonObject> JsonMaterialObject, const FglTFRuntimeMaterialsConfig& MaterialsConfig, const bool bUseVertexColors)
 {
 	SCOPED_NAMED_EVENT(FglTFRuntimeParser_LoadMaterial_Internal, FColor::Magenta);
@@ -105,7 +231,7 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 		}
 	};
 
-	auto GetMaterialTexture = [this, MaterialsConfig](const TSharedRef<FJsonObject> JsonMaterialObject, const FString& ParamName, const bool sRGB, UTexture2D*& ParamTextureCache, TArray<FglTFRuntimeMipMap>& ParamMips, FglTFRuntimeTextureTransform& ParamTransform, FglTFRuntimeTextureSampler& Sampler) -> const TSharedPtr<FJsonObject>
+	auto GetMaterialTexture = [this, MaterialsConfig](const TSharedRef<FJsonObject> JsonMaterialObject, const FString& ParamName, const bool sRGB, const TEnumAsByte<TextureCompressionSettings> Compression, UTexture2D*& ParamTextureCache, TArray<FglTFRuntimeMipMap>& ParamMips, FglTFRuntimeTextureTransform& ParamTransform, FglTFRuntimeTextureSampler& Sampler) -> const TSharedPtr<FJsonObject>
 	{
 		const TSharedPtr<FJsonObject>* JsonTextureObject;
 		if (JsonMaterialObject->TryGetObjectField(ParamName, JsonTextureObject))
@@ -141,6 +267,14 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 			}
 
 			ParamTextureCache = LoadTexture(TextureIndex, ParamMips, sRGB, MaterialsConfig, Sampler);
+			if (!ParamTextureCache && MaterialsConfig.ImagesConfig.bBlockCompress)
+			{
+				// compress here, as BuildMaterial() runs in the game thread
+				FglTFRuntimeImagesConfig ImagesConfig = MaterialsConfig.ImagesConfig;
+				ImagesConfig.Compression = Compression;
+				ImagesConfig.bSRGB = sRGB;
+				CompressMips(ParamMips, ImagesConfig);
+			}
 			return *JsonTextureObject;
 		}
 		return nullptr;
@@ -150,7 +284,7 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 	if (JsonMaterialObject->TryGetObjectField("pbrMetallicRoughness", JsonPBRObject))
 	{
 		GetMaterialVector(JsonPBRObject->ToSharedRef(), "baseColorFactor", 4, RuntimeMaterial.bHasBaseColorFactor, RuntimeMaterial.BaseColorFactor);
-		GetMaterialTexture(JsonPBRObject->ToSharedRef(), "baseColorTexture", true, RuntimeMaterial.BaseColorTextureCache, RuntimeMaterial.BaseColorTextureMips, RuntimeMaterial.BaseColorTransform, RuntimeMaterial.BaseColorSampler);
+		GetMaterialTexture(JsonPBRObject->ToSharedRef(), "baseColorTexture", true, TextureCompressionSettings::TC_Default, RuntimeMaterial.BaseColorTextureCache, RuntimeMaterial.BaseColorTextureMips, RuntimeMaterial.BaseColorTransform, RuntimeMaterial.BaseColorSampler);
 
 		if ((*JsonPBRObject)->TryGetNumberField("metallicFactor", RuntimeMaterial.MetallicFactor))
 		{
@@ -162,19 +296,19 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 			RuntimeMaterial.bHasRoughnessFactor = true;
 		}
 
-		GetMaterialTexture(JsonPBRObject->ToSharedRef(), "metallicRoughnessTexture", false, RuntimeMaterial.MetallicRoughnessTextureCache, RuntimeMaterial.MetallicRoughnessTextureMips, RuntimeMaterial.MetallicRoughnessTransform, RuntimeMaterial.MetallicRoughnessSampler);
+		GetMaterialTexture(JsonPBRObject->ToSharedRef(), "metallicRoughnessTexture", false, TextureCompressionSettings::TC_Default, RuntimeMaterial.MetallicRoughnessTextureCache, RuntimeMaterial.MetallicRoughnessTextureMips, RuntimeMaterial.MetallicRoughnessTransform, RuntimeMaterial.MetallicRoughnessSampler);
 	}
 
-	if (const TSharedPtr<FJsonObject> JsonNormalTexture = GetMaterialTexture(JsonMaterialObject, "normalTexture", false, RuntimeMaterial.NormalTextureCache, RuntimeMaterial.NormalTextureMips, RuntimeMaterial.NormalTransform, RuntimeMaterial.NormalSampler))
+	if (const TSharedPtr<FJsonObject> JsonNormalTexture = GetMaterialTexture(JsonMaterialObject, "normalTexture", false, TextureCompressionSettings::TC_Normalmap, RuntimeMaterial.NormalTextureCache, RuntimeMaterial.NormalTextureMips, RuntimeMaterial.NormalTransform, RuntimeMaterial.NormalSampler))
 	{
 		JsonNormalTexture->TryGetNumberField("scale", RuntimeMaterial.NormalTextureScale);
 	}
 
-	GetMaterialTexture(JsonMaterialObject, "occlusionTexture", false, RuntimeMaterial.OcclusionTextureCache, RuntimeMaterial.OcclusionTextureMips, RuntimeMaterial.OcclusionTransform, RuntimeMaterial.OcclusionSampler);
+	GetMaterialTexture(JsonMaterialObject, "occlusionTexture", false, TextureCompressionSettings::TC_Default, RuntimeMaterial.OcclusionTextureCache, RuntimeMaterial.OcclusionTextureMips, RuntimeMaterial.OcclusionTransform, RuntimeMaterial.OcclusionSampler);
 
 	GetMaterialVector(JsonMaterialObject, "emissiveFactor", 3, RuntimeMaterial.bHasEmissiveFactor, RuntimeMaterial.EmissiveFactor);
 
-	GetMaterialTexture(JsonMaterialObject, "emissiveTexture", true, RuntimeMaterial.EmissiveTextureCache, RuntimeMaterial.EmissiveTextureMips, RuntimeMaterial.EmissiveTransform, RuntimeMaterial.EmissiveSampler);
+	GetMaterialTexture(JsonMaterialObject, "emissiveTexture", true, TextureCompressionSettings::TC_Default, RuntimeMaterial.EmissiveTextureCache, RuntimeMaterial.EmissiveTextureMips, RuntimeMaterial.EmissiveTransform, RuntimeMaterial.EmissiveSampler);
 
 	const TSharedPtr<FJsonObject>* JsonExtensions;
 	if (JsonMaterialObject->TryGetObjectField("extensions", JsonExtensions))
@@ -184,7 +318,7 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 		if ((*JsonExtensions)->TryGetObjectField("KHR_materials_pbrSpecularGlossiness", JsonPbrSpecularGlossiness))
 		{
 			GetMaterialVector(JsonPbrSpecularGlossiness->ToSharedRef(), "diffuseFactor", 4, RuntimeMaterial.bHasDiffuseFactor, RuntimeMaterial.DiffuseFactor);
-			GetMaterialTexture(JsonPbrSpecularGlossiness->ToSharedRef(), "diffuseTexture", true, RuntimeMaterial.DiffuseTextureCache, RuntimeMaterial.DiffuseTextureMips, RuntimeMaterial.DiffuseTransform, RuntimeMaterial.DiffuseSampler);
+			GetMaterialTexture(JsonPbrSpecularGlossiness->ToSharedRef(), "diffuseTexture", true, TextureCompressionSettings::TC_Default, RuntimeMaterial.DiffuseTextureCache, RuntimeMaterial.DiffuseTextureMips, RuntimeMaterial.DiffuseTransform, RuntimeMaterial.DiffuseSampler);
 
 			GetMaterialVector(JsonPbrSpecularGlossiness->ToSharedRef(), "specularFactor", 3, RuntimeMaterial.bHasSpecularFactor, RuntimeMaterial.SpecularFactor);
 
@@ -193,7 +327,7 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 				RuntimeMaterial.bHasGlossinessFactor = true;
 			}
 
-			GetMaterialTexture(JsonPbrSpecularGlossiness->ToSharedRef(), "specularGlossinessTexture", true, RuntimeMaterial.SpecularGlossinessTextureCache, RuntimeMaterial.SpecularGlossinessTextureMips, RuntimeMaterial.SpecularGlossinessTransform, RuntimeMaterial.SpecularGlossinessSampler);
+			GetMaterialTexture(JsonPbrSpecularGlossiness->ToSharedRef(), "specularGlossinessTexture", true, TextureCompressionSettings::TC_Default, RuntimeMaterial.SpecularGlossinessTextureCache, RuntimeMaterial.SpecularGlossinessTextureMips, RuntimeMaterial.SpecularGlossinessTransform, RuntimeMaterial.SpecularGlossinessSampler);
 
 			RuntimeMaterial.bKHR_materials_pbrSpecularGlossiness = true;
 		}
@@ -206,7 +340,7 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 			{
 				RuntimeMaterial.bHasTransmissionFactor = true;
 			}
-			GetMaterialTexture(JsonMaterialTransmission->ToSharedRef(), "transmissionTexture", false, RuntimeMaterial.TransmissionTextureCache, RuntimeMaterial.TransmissionTextureMips, RuntimeMaterial.TransmissionTransform, RuntimeMaterial.TransmissionSampler);
+			GetMaterialTexture(JsonMaterialTransmission->ToSharedRef(), "transmissionTexture", false, TextureCompressionSettings::TC_Default, RuntimeMaterial.TransmissionTextureCache, RuntimeMaterial.TransmissionTextureMips, RuntimeMaterial.TransmissionTransform, RuntimeMaterial.TransmissionSampler);
 
 			RuntimeMaterial.bKHR_materials_transmission = true;
 		}
@@ -272,6 +406,11 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial_Internal(const int32 Index,
 				return;
 			}
 	Material = BuildMaterial(Index, MaterialName, RuntimeMaterial, MaterialsConfig, bUseVertexColors);
+			// nothing references it until the mesh is finalized, and the loading thread holds no GC guard
+			if (Material)
+			{
+				MaterialsInFlight.Add(Material);
+			}
 		}, TStatId(), nullptr, ENamedThreads::GameThread);
 	FTaskGraphInterface::Get().WaitUntilTaskCompletes(Task);
 
@@ -284,7 +423,7 @@ UTexture2D* FglTFRuntimeParser::BuildTexture(UObject* Outer, const TArray<FglTFR
 	FTexturePlatformData* PlatformData = new FTexturePlatformData();
 	PlatformData->SizeX = Mips[0].Width;
 	PlatformData->SizeY = Mips[0].Height;
-	PlatformData->PixelFormat = EPixelFormat::PF_B8G8R8A8;
+	PlatformData->PixelFormat = Mips[0].PixelFormat;
 
 #if ENGINE_MAJOR_VERSION > 4
 	Texture->SetPlatformData(PlatformData);
@@ -347,7 +486,10 @@ UTexture2D* FglTFRuntimeParser::BuildTexture(UObject* Outer, const TArray<FglTFR
 
 	Texture->UpdateResource();
 
-	TexturesCache.Add(Mips[0].TextureIndex, Texture);
+	{
+		FScopeLock Lock(&CachesLock);
+		TexturesCache.Add(Mips[0].TextureIndex, Texture);
+	}
 
 	return Texture;
 }
@@ -584,6 +726,19 @@ bool FglTFRuntimeParser::LoadImageFromBlob(TArray64<uint8>& Blob, TSharedRef<FJs
 		return true;
 	}
 
+	if (IsKTX2(Blob))
+	{
+		TArray<FglTFRuntimeMipMap> Mips;
+		if (!LoadKTX2Mips(INDEX_NONE, Blob, Mips, ImagesConfig, false) || Mips.Num() == 0)
+		{
+			return false;
+		}
+		UncompressedBytes = MoveTemp(Mips[0].Pixels);
+		Width = Mips[0].Width;
+		Height = Mips[0].Height;
+		return true;
+	}
+
 	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
 
 	EImageFormat ImageFormat = ImageWrapperModule.DetectImageFormat(Blob.GetData(), Blob.Num());
@@ -652,9 +807,12 @@ UTexture2D* FglTFRuntimeParser::LoadTexture(const int32 TextureIndex, TArray<Fgl
 	}
 
 	// first check cache
-	if (TexturesCache.Contains(TextureIndex))
 	{
-		return TexturesCache[TextureIndex];
+		FScopeLock Lock(&CachesLock);
+		if (UTexture2D** CachedTexture = TexturesCache.Find(TextureIndex))
+		{
+			return *CachedTexture;
+		}
 	}
 
 	const TArray<TSharedPtr<FJsonValue>>* JsonTextures;
@@ -677,6 +835,21 @@ UTexture2D* FglTFRuntimeParser::LoadTexture(const int32 TextureIndex, TArray<Fgl
 
 	int64 ImageIndex;
 	if (!JsonTextureObject->TryGetNumberField("source", ImageIndex))
+	{
+		ImageIndex = INDEX_NONE;
+	}
+
+	// KTX2 images take precedence over the fallback one, but only when we can transcode them
+	int64 FallbackImageIndex = INDEX_NONE;
+#if WITH_GLTFRUNTIME_BASISU
+	const int64 BasisuImageIndex = GetJsonExtensionObjectIndex(JsonTextureObject.ToSharedRef(), "KHR_texture_basisu", "source", INDEX_NONE);
+	if (BasisuImageIndex > INDEX_NONE && BasisuImageIndex != ImageIndex)
+	{
+		FallbackImageIndex = ImageIndex;
+		ImageIndex = BasisuImageIndex;
+	}
+#endif
+	if (ImageIndex < 0)
 	{
 		return nullptr;
 	}
@@ -686,96 +859,44 @@ UTexture2D* FglTFRuntimeParser::LoadTexture(const int32 TextureIndex, TArray<Fgl
 		return MaterialsConfig.ImagesOverrideMap[ImageIndex];
 	}
 
-	TArray64<uint8> UncompressedBytes;
-	constexpr EPixelFormat PixelFormat = EPixelFormat::PF_B8G8R8A8;
-	int32 Width = 0;
-	int32 Height = 0;
-	if (!LoadImage(ImageIndex, UncompressedBytes, Width, Height, MaterialsConfig.ImagesConfig))
+	// the disk cache can only replace the image decoding when nobody is going to alter the pixels
+	uint64 DiskCacheItemHash = 0;
+	if (!DiskCacheDirectory.IsEmpty() && !OnTexturePixels.IsBound() && !OnLoadedTexturePixels.IsBound())
 	{
-		return nullptr;
+		DiskCacheItemHash = GetDiskCacheItemHash(JsonTextureObject.ToSharedRef(), FString::Printf(TEXT("%d %d %d %d"), sRGB, MaterialsConfig.bGeneratesMipMaps, MaterialsConfig.ImagesConfig.MaxWidth, MaterialsConfig.ImagesConfig.MaxHeight));
 	}
 
-	OnLoadedTexturePixels.Broadcast(AsShared(), JsonTextureObject.ToSharedRef(), Width, Height, reinterpret_cast<FColor*>(UncompressedBytes.GetData()));
-
-	if (Width > 0 && Height > 0 &&
-		(Width % GPixelFormats[PixelFormat].BlockSizeX) == 0 &&
-		(Height % GPixelFormats[PixelFormat].BlockSizeY) == 0)
+	bool bLoadedFromDiskCache = false;
+	TArray<uint8> CachedMips;
+	if (DiskCacheItemHash != 0 && LoadFromDiskCache("texture", DiskCacheItemHash, CachedMips))
 	{
+		FMemoryReader Reader(CachedMips);
+		bLoadedFromDiskCache = SerializeMips(Reader, TextureIndex, Mips);
+	}
 
-		// limit image size
-		if (MaterialsConfig.ImagesConfig.MaxWidth > 0 || MaterialsConfig.ImagesConfig.MaxHeight > 0)
+	if (!bLoadedFromDiskCache)
+	{
+		bool bLoadedMips = LoadTextureMips(TextureIndex, ImageIndex, JsonTextureObject.ToSharedRef(), Mips, sRGB, MaterialsConfig);
+		// a KTX2 image the transcoder does not understand can still have a fallback image
+		if (!bLoadedMips && FallbackImageIndex > INDEX_NONE)
 		{
-			const int32 NewWidth = MaterialsConfig.ImagesConfig.MaxWidth > 0 ? MaterialsConfig.ImagesConfig.MaxWidth : Width;
-			const int32 NewHeight = MaterialsConfig.ImagesConfig.MaxHeight > 0 ? MaterialsConfig.ImagesConfig.MaxHeight : Height;
-			TArray64<FColor> ResizedPixels;
-			ResizedPixels.AddUninitialized(NewWidth * NewHeight);
-#if ENGINE_MAJOR_VERSION >= 5
-			FImageUtils::ImageResize(Width, Height, TArrayView<FColor>(reinterpret_cast<FColor*>(UncompressedBytes.GetData()), UncompressedBytes.Num()), NewWidth, NewHeight, ResizedPixels, sRGB, false);
-#else
-			FImageUtils::ImageResize(Width, Height, TArrayView<FColor>(reinterpret_cast<FColor*>(UncompressedBytes.GetData()), UncompressedBytes.Num()), NewWidth, NewHeight, ResizedPixels, sRGB);
-#endif
-			Width = NewWidth;
-			Height = NewHeight;
-			UncompressedBytes.Empty(ResizedPixels.Num() * 4);
-			UncompressedBytes.Append(reinterpret_cast<uint8*>(ResizedPixels.GetData()), ResizedPixels.Num() * 4);
+			UE_LOG(LogGLTFRuntime, Warning, TEXT("Unable to load KHR_texture_basisu image %lld, falling back to image %lld"), ImageIndex, FallbackImageIndex);
+			Mips.Empty();
+			bLoadedMips = LoadTextureMips(TextureIndex, FallbackImageIndex, JsonTextureObject.ToSharedRef(), Mips, sRGB, MaterialsConfig);
 		}
-
-		int32 NumOfMips = 1;
-
-		TArray64<FColor> UncompressedColors;
-
-		if (MaterialsConfig.bGeneratesMipMaps && FMath::IsPowerOfTwo(Width) && FMath::IsPowerOfTwo(Height))
+		if (!bLoadedMips)
 		{
-			NumOfMips = FMath::FloorLog2(FMath::Max(Width, Height)) + 1;
-
-			for (int32 MipY = 0; MipY < Height; MipY++)
-			{
-				for (int32 MipX = 0; MipX < Width; MipX++)
-				{
-					int64 MipColorIndex = ((MipY * Width) + MipX) * 4;
-					uint8 MipColorB = UncompressedBytes[MipColorIndex];
-					uint8 MipColorG = UncompressedBytes[MipColorIndex + 1];
-					uint8 MipColorR = UncompressedBytes[MipColorIndex + 2];
-					uint8 MipColorA = UncompressedBytes[MipColorIndex + 3];
-					UncompressedColors.Add(FColor(MipColorR, MipColorG, MipColorB, MipColorA));
-				}
-			}
+			return nullptr;
 		}
 
-		int32 MipWidth = Width;
-		int32 MipHeight = Height;
-
-		for (int32 MipIndex = 0; MipIndex < NumOfMips; MipIndex++)
+		if (DiskCacheItemHash != 0)
 		{
-			FglTFRuntimeMipMap MipMap(TextureIndex);
-			MipMap.Width = MipWidth;
-			MipMap.Height = MipHeight;
-
-			// Resize Image
-			if (MipIndex > 0)
+			FMemoryWriter Writer(CachedMips);
+			if (SerializeMips(Writer, TextureIndex, Mips))
 			{
-				TArray64<FColor> ResizedMipData;
-				ResizedMipData.AddUninitialized(MipWidth * MipHeight);
-				FImageUtils::ImageResize(Width, Height, UncompressedColors, MipWidth, MipHeight, ResizedMipData, sRGB);
-				for (FColor& Color : ResizedMipData)
-				{
-					MipMap.Pixels.Add(Color.B);
-					MipMap.Pixels.Add(Color.G);
-					MipMap.Pixels.Add(Color.R);
-					MipMap.Pixels.Add(Color.A);
-				}
+				SaveToDiskCache("texture", DiskCacheItemHash, CachedMips);
 			}
-			else
-			{
-				MipMap.Pixels = UncompressedBytes;
-			}
-
-			Mips.Add(MipMap);
-
-			MipWidth = FMath::Max(MipWidth / 2, 1);
-			MipHeight = FMath::Max(MipHeight / 2, 1);
 		}
-
 	}
 
 	int64 SamplerIndex;
@@ -846,6 +967,97 @@ UTexture2D* FglTFRuntimeParser::LoadTexture(const int32 TextureIndex, TArray<Fgl
 	return nullptr;
 }
 
+bool FglTFRuntimeParser::LoadTextureMips(const int32 TextureIndex, const int32 ImageIndex, TSharedRef<FJsonObject> JsonTextureObject, TArray<FglTFRuntimeMipMap>& Mips, const bool sRGB, const FglTFRuntimeMaterialsConfig& MaterialsConfig)
+{
+	// KTX2 images come with their own mips, possibly already block compressed
+	TSharedPtr<FJsonObject> JsonImageObject = GetJsonObjectFromRootIndex("images", ImageIndex);
+	FString MimeType;
+	if (JsonImageObject && JsonImageObject->TryGetStringField("mimeType", MimeType) && MimeType == "image/ktx2" && !OnTexturePixels.IsBound())
+	{
+		TArray64<uint8> Bytes;
+		if (!GetJsonObjectBytes(JsonImageObject.ToSharedRef(), Bytes))
+		{
+			AddError("LoadTextureMips()", FString::Printf(TEXT("Unable to load image %d"), ImageIndex));
+			return false;
+		}
+		return LoadKTX2Mips(TextureIndex, Bytes, Mips, MaterialsConfig.ImagesConfig, true);
+	}
+
+	TArray64<uint8> UncompressedBytes;
+	constexpr EPixelFormat PixelFormat = EPixelFormat::PF_B8G8R8A8;
+	int32 Width = 0;
+	int32 Height = 0;
+	if (!LoadImage(ImageIndex, UncompressedBytes, Width, Height, MaterialsConfig.ImagesConfig))
+	{
+		return false;
+	}
+
+	OnLoadedTexturePixels.Broadcast(AsShared(), JsonTextureObject, Width, Height, reinterpret_cast<FColor*>(UncompressedBytes.GetData()));
+
+	if (Width > 0 && Height > 0 &&
+		(Width % GPixelFormats[PixelFormat].BlockSizeX) == 0 &&
+		(Height % GPixelFormats[PixelFormat].BlockSizeY) == 0)
+	{
+
+		// limit image size
+		if (MaterialsConfig.ImagesConfig.MaxWidth > 0 || MaterialsConfig.ImagesConfig.MaxHeight > 0)
+		{
+			const int32 NewWidth = MaterialsConfig.ImagesConfig.MaxWidth > 0 ? MaterialsConfig.ImagesConfig.MaxWidth : Width;
+			const int32 NewHeight = MaterialsConfig.ImagesConfig.MaxHeight > 0 ? MaterialsConfig.ImagesConfig.MaxHeight : Height;
+			TArray64<FColor> ResizedPixels;
+			ResizedPixels.AddUninitialized(NewWidth * NewHeight);
+#if ENGINE_MAJOR_VERSION >= 5
+			FImageUtils::ImageResize(Width, Height, TArrayView<FColor>(reinterpret_cast<FColor*>(UncompressedBytes.GetData()), UncompressedBytes.Num()), NewWidth, NewHeight, ResizedPixels, sRGB, false);
+#else
+			FImageUtils::ImageResize(Width, Height, TArrayView<FColor>(reinterpret_cast<FColor*>(UncompressedBytes.GetData()), UncompressedBytes.Num()), NewWidth, NewHeight, ResizedPixels, sRGB);
+#endif
+			Width = NewWidth;
+			Height = NewHeight;
+			UncompressedBytes.Empty(ResizedPixels.Num() * 4);
+			UncompressedBytes.Append(reinterpret_cast<uint8*>(ResizedPixels.GetData()), ResizedPixels.Num() * 4);
+		}
+
+		int32 NumOfMips = 1;
+		if (MaterialsConfig.bGeneratesMipMaps)
+		{
+			NumOfMips = FMath::FloorLog2(FMath::Max(Width, Height)) + 1;
+		}
+
+		// each level is filtered from the previous one, so keep them all in place
+		Mips.Reserve(Mips.Num() + NumOfMips);
+
+		FglTFRuntimeMipMap& BaseMipMap = Mips.Add_GetRef(FglTFRuntimeMipMap(TextureIndex));
+		BaseMipMap.Width = Width;
+		BaseMipMap.Height = Height;
+		BaseMipMap.Pixels = MoveTemp(UncompressedBytes);
+
+		for (int32 MipIndex = 1; MipIndex < NumOfMips; MipIndex++)
+		{
+			const FglTFRuntimeMipMap& PreviousMipMap = Mips.Last();
+
+			FglTFRuntimeMipMap MipMap(TextureIndex);
+			MipMap.Width = FMath::Max(PreviousMipMap.Width / 2, 1);
+			MipMap.Height = FMath::Max(PreviousMipMap.Height / 2, 1);
+			MipMap.Pixels.SetNumUninitialized(static_cast<int64>(MipMap.Width) * MipMap.Height * 4);
+
+			glTFRuntimeMipMaps::Downsample(PreviousMipMap.Pixels.GetData(), PreviousMipMap.Width, PreviousMipMap.Height, MipMap.Pixels.GetData(), MipMap.Width, MipMap.Height, sRGB);
+
+			Mips.Add(MoveTemp(MipMap));
+		}
+	}
+
+	return true;
+}
+
+void FglTFRuntimeParser::ReleaseMaterialsInFlight(const FglTFRuntimeMeshLOD& LOD)
+{
+	check(IsInGameThread());
+	for (const FglTFRuntimePrimitive& Primitive : LOD.Primitives)
+	{
+		MaterialsInFlight.Remove(Primitive.Material);
+	}
+}
+
 UMaterialInterface* FglTFRuntimeParser::LoadMaterial(const int32 Index, const FglTFRuntimeMaterialsConfig& MaterialsConfig, const bool bUseVertexColors, FString& MaterialName)
 {
 	if (Index < 0)
@@ -858,14 +1070,18 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial(const int32 Index, const Fg
 		return MaterialsConfig.MaterialsOverrideMap[Index];
 	}
 
-	// first check cache
-	if (CanReadFromCache(MaterialsConfig.CacheMode) && MaterialsCache.Contains(Index))
+	// first check cache, only the caches are locked as building the material waits for the game thread, which can need the lock too (AddError())
+	if (CanReadFromCache(MaterialsConfig.CacheMode))
 	{
-		if (MaterialsNameCache.Contains(MaterialsCache[Index]))
+		FScopeLock Lock(&CachesLock);
+		if (UMaterialInterface** CachedMaterial = MaterialsCache.Find(Index))
 		{
-			MaterialName = MaterialsNameCache[MaterialsCache[Index]];
+			if (const FString* CachedMaterialName = MaterialsNameCache.Find(*CachedMaterial))
+			{
+				MaterialName = *CachedMaterialName;
+			}
+			return *CachedMaterial;
 		}
-		return MaterialsCache[Index];
 	}
 
 	const TArray<TSharedPtr<FJsonValue>>* JsonMaterials;
@@ -907,8 +1123,13 @@ UMaterialInterface* FglTFRuntimeParser::LoadMaterial(const int32 Index, const Fg
 
 	if (CanWriteToCache(MaterialsConfig.CacheMode))
 	{
-		MaterialsNameCache.Add(Material, MaterialName);
-		MaterialsCache.Add(Index, Material);
+		FScopeLock Lock(&CachesLock);
+		// another thread may have built the same material in the meantime, the first one stays cached
+		if (!MaterialsCache.Contains(Index))
+		{
+			MaterialsNameCache.Add(Material, MaterialName);
+			MaterialsCache.Add(Index, Material);
+		}
 	}
 
 	return Material;
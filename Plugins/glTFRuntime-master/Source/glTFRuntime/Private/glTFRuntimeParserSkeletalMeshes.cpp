@@ -305,6 +305,9 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 		LOD.bHasTangents = true;
 		LOD.bHasNormals = true;
 
+		GenerateTangentSpaces(LOD.RuntimeLOD->Primitives, SkeletalMeshContext->SkeletalMeshConfig.TangentSpaceGenerationMethod, SkeletalMeshContext->SkeletalMeshConfig.NormalsGenerationStrategy, SkeletalMeshContext->SkeletalMeshConfig.TangentsGenerationStrategy, false, LOD.TangentSpaces);
+		int32 PrimitiveIndex = 0;
+
 		TArray<SkeletalMeshImportData::FVertex> Wedges;
 		TArray<SkeletalMeshImportData::FTriangle> Triangles;
 		TArray<SkeletalMeshImportData::FRawBoneInfluence> Influences;
@@ -320,6 +323,10 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 			int32 Base = Points.Num();
 			Points.Append(Primitive.Positions);
 
+			const FglTFRuntimePrimitiveTangentSpace& TangentSpace = LOD.TangentSpaces[PrimitiveIndex++];
+			const TArray<FVector>& Normals = TangentSpace.Normals.Num() > 0 ? TangentSpace.Normals : Primitive.Normals;
+			const TArray<FVector4>& Tangents = TangentSpace.Tangents.Num() > 0 ? TangentSpace.Tangents : Primitive.Tangents;
+
 			int32 TriangleIndex = 0;
 			TSet<TPair<int32, int32>> InfluencesMap;
 
@@ -399,16 +406,16 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 					Triangle.WedgeIndex[1] = WedgeIndex - 1;
 					Triangle.WedgeIndex[2] = WedgeIndex;
 
-					if (Primitive.Normals.Num() > 0 && !bForceNormalsGeneration)
+					if (Normals.Num() > 0 && (!bForceNormalsGeneration || TangentSpace.Normals.Num() > 0))
 					{
 #if ENGINE_MAJOR_VERSION > 4
-						Triangle.TangentZ[0] = FVector3f(Primitive.Normals[Primitive.Indices[i - 2]]);
-						Triangle.TangentZ[1] = FVector3f(Primitive.Normals[Primitive.Indices[i - 1]]);
-						Triangle.TangentZ[2] = FVector3f(Primitive.Normals[Primitive.Indices[i]]);
+						Triangle.TangentZ[0] = FVector3f(Normals[Primitive.Indices[i - 2]]);
+						Triangle.TangentZ[1] = FVector3f(Normals[Primitive.Indices[i - 1]]);
+						Triangle.TangentZ[2] = FVector3f(Normals[Primitive.Indices[i]]);
 #else
-						Triangle.TangentZ[0] = Primitive.Normals[Primitive.Indices[i - 2]];
-						Triangle.TangentZ[1] = Primitive.Normals[Primitive.Indices[i - 1]];
-						Triangle.TangentZ[2] = Primitive.Normals[Primitive.Indices[i]];
+						Triangle.TangentZ[0] = Normals[Primitive.Indices[i - 2]];
+						Triangle.TangentZ[1] = Normals[Primitive.Indices[i - 1]];
+						Triangle.TangentZ[2] = Normals[Primitive.Indices[i]];
 #endif
 
 					}
@@ -436,16 +443,16 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 						LOD.bHasNormals = false;
 					}
 
-					if (Primitive.Tangents.Num() > 0)
+					if (Tangents.Num() > 0)
 					{
 #if ENGINE_MAJOR_VERSION > 4
-						Triangle.TangentX[0] = FVector3f(FVector(Primitive.Tangents[Primitive.Indices[i - 2]]));
-						Triangle.TangentX[1] = FVector3f(FVector(Primitive.Tangents[Primitive.Indices[i - 1]]));
-						Triangle.TangentX[2] = FVector3f(FVector(Primitive.Tangents[Primitive.Indices[i]]));
+						Triangle.TangentX[0] = FVector3f(FVector(Tangents[Primitive.Indices[i - 2]]));
+						Triangle.TangentX[1] = FVector3f(FVector(Tangents[Primitive.Indices[i - 1]]));
+						Triangle.TangentX[2] = FVector3f(FVector(Tangents[Primitive.Indices[i]]));
 #else
-						Triangle.TangentX[0] = Primitive.Tangents[Primitive.Indices[i - 2]];
-						Triangle.TangentX[1] = Primitive.Tangents[Primitive.Indices[i - 1]];
-						Triangle.TangentX[2] = Primitive.Tangents[Primitive.Indices[i]];
+						Triangle.TangentX[0] = Tangents[Primitive.Indices[i - 2]];
+						Triangle.TangentX[1] = Tangents[Primitive.Indices[i - 1]];
+						Triangle.TangentX[2] = Tangents[Primitive.Indices[i]];
 #endif
 					}
 					else
@@ -632,6 +639,11 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 		LOD.bHasTangents = true;
 		LOD.bHasNormals = true;
 
+		GenerateTangentSpaces(LOD.RuntimeLOD->Primitives, SkeletalMeshContext->SkeletalMeshConfig.TangentSpaceGenerationMethod, SkeletalMeshContext->SkeletalMeshConfig.NormalsGenerationStrategy, SkeletalMeshContext->SkeletalMeshConfig.TangentsGenerationStrategy, false, LOD.TangentSpaces);
+		// when every primitive got generated vertex normals/tangents there is no need for the per face ones
+		bool bGeneratedNormals = true;
+		bool bGeneratedTangents = true;
+
 		FSkeletalMeshLODRenderData* LodRenderData = new FSkeletalMeshLODRenderData();
 		int32 LODIndex = SkeletalMeshContext->SkeletalMesh->GetResourceForRendering()->LODRenderData.Add(LodRenderData);
 
@@ -666,6 +678,12 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 		{
 			FglTFRuntimePrimitive& Primitive = LOD.RuntimeLOD->Primitives[PrimitiveIndex];
 
+			const FglTFRuntimePrimitiveTangentSpace& TangentSpace = LOD.TangentSpaces[PrimitiveIndex];
+			const TArray<FVector>& Normals = TangentSpace.Normals.Num() > 0 ? TangentSpace.Normals : Primitive.Normals;
+			const TArray<FVector4>& Tangents = TangentSpace.Tangents.Num() > 0 ? TangentSpace.Tangents : Primitive.Tangents;
+			bGeneratedNormals &= TangentSpace.Normals.Num() > 0;
+			bGeneratedTangents &= TangentSpace.Tangents.Num() > 0;
+
 			new(&LodRenderData->RenderSections[PrimitiveIndex]) FSkelMeshRenderSection();
 			FSkelMeshRenderSection& MeshSection = LodRenderData->RenderSections[PrimitiveIndex];
 
@@ -703,12 +721,12 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 				ModelVertex.TangentX = FVector::ZeroVector;
 				ModelVertex.TangentZ = FVector::ZeroVector;
 #endif
-				if (Index < Primitive.Normals.Num())
+				if (Index < Normals.Num())
 				{
 #if ENGINE_MAJOR_VERSION > 4
-					ModelVertex.TangentZ = FVector3f(FVector(Primitive.Normals[Index]));
+					ModelVertex.TangentZ = FVector3f(FVector(Normals[Index]));
 #else
-					ModelVertex.TangentZ = Primitive.Normals[Index];
+					ModelVertex.TangentZ = Normals[Index];
 #endif
 				}
 				else
@@ -716,12 +734,12 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 					LOD.bHasNormals = false;
 				}
 
-				if (Index < Primitive.Tangents.Num())
+				if (Index < Tangents.Num())
 				{
 #if ENGINE_MAJOR_VERSION > 4
-					ModelVertex.TangentX = FVector4f(Primitive.Tangents[Index]);
+					ModelVertex.TangentX = FVector4f(Tangents[Index]);
 #else
-					ModelVertex.TangentX = Primitive.Tangents[Index];
+					ModelVertex.TangentX = Tangents[Index];
 #endif
 				}
 				else
@@ -825,7 +843,7 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 			}
 		}
 
-		if (SkeletalMeshContext->SkeletalMeshConfig.NormalsGenerationStrategy == EglTFRuntimeNormalsGenerationStrategy::Always)
+		if (SkeletalMeshContext->SkeletalMeshConfig.NormalsGenerationStrategy == EglTFRuntimeNormalsGenerationStrategy::Always && !bGeneratedNormals)
 		{
 			LOD.bHasNormals = false;
 		}
@@ -834,7 +852,7 @@ USkeletalMesh* FglTFRuntimeParser::CreateSkeletalMeshFromLODs(TSharedRef<FglTFRu
 			LOD.bHasNormals = true;
 		}
 
-		if (SkeletalMeshContext->SkeletalMeshConfig.TangentsGenerationStrategy == EglTFRuntimeTangentsGenerationStrategy::Always)
+		if (SkeletalMeshContext->SkeletalMeshConfig.TangentsGenerationStrategy == EglTFRuntimeTangentsGenerationStrategy::Always && !bGeneratedTangents)
 		{
 			LOD.bHasTangents = false;
 		}
@@ -1495,23 +1513,46 @@ void FglTFRuntimeParser::LoadSkeletalMeshAsync(const int32 MeshIndex, const int3
 		{
 			FglTFRuntimeSkeletalMeshContextFinalizer AsyncFinalizer(SkeletalMeshContext, AsyncCallback);
 
+			LoadSkeletalMeshIntoContext(MeshIndex, SkeletalMeshContext);
+		});
+}
+
+bool FglTFRuntimeParser::LoadSkeletalMeshIntoContext(const int32 MeshIndex, TSharedRef<FglTFRuntimeSkeletalMeshContext, ESPMode::ThreadSafe> SkeletalMeshContext)
+{
 	TSharedPtr<FJsonObject> JsonMeshObject = GetJsonObjectFromRootIndex("meshes", MeshIndex);
 	if (!JsonMeshObject)
 	{
 		AddError("LoadSkeletalMeshAsync()", FString::Printf(TEXT("Unable to find Mesh with index %d"), MeshIndex));
-		return;
+		return false;
 	}
 
 	FglTFRuntimeMeshLOD* LOD = nullptr;
 	if (!LoadMeshIntoMeshLOD(JsonMeshObject.ToSharedRef(), LOD, SkeletalMeshContext->SkeletalMeshConfig.MaterialsConfig))
 	{
-		return;
+		return false;
 	}
 
 	SkeletalMeshContext->LODs.Add(LOD);
 
 	SkeletalMeshContext->SkeletalMesh = CreateSkeletalMeshFromLODs(SkeletalMeshContext);
-		});
+	return SkeletalMeshContext->SkeletalMesh != nullptr;
+}
+
+USkeletalMesh* FglTFRuntimeParser::FinalizeSkeletalMeshContext(TSharedRef<FglTFRuntimeSkeletalMeshContext, ESPMode::ThreadSafe> SkeletalMeshContext)
+{
+	for (const FglTFRuntimeSkeletalMeshLOD& LOD : SkeletalMeshContext->LODs)
+	{
+		if (LOD.RuntimeLOD)
+		{
+			ReleaseMaterialsInFlight(*LOD.RuntimeLOD);
+		}
+	}
+
+	if (SkeletalMeshContext->SkeletalMesh)
+	{
+		SkeletalMeshContext->SkeletalMesh = FinalizeSkeletalMeshWithLODs(SkeletalMeshContext);
+	}
+	return SkeletalMeshContext->SkeletalMesh;
 }
 
 USkeletalMesh* FglTFRuntimeParser::LoadSkeletalMeshLODs(const TArray<int32>&MeshIndices, const int32 SkinIndex, const FglTFRuntimeSkeletalMeshConfig & SkeletalMeshConfig)
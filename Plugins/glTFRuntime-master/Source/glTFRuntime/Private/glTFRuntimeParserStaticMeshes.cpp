@@ -13,6 +13,249 @@
 #include "PhysicsEngine/BodySetup.h"
 #include "Runtime/Launch/Resources/Version.h"
 #include "StaticMeshResources.h"
+#include "UObject/GarbageCollection.h"
+
+namespace glTFRuntimeStaticMeshes
+{
+	uint32 HashBuildVertex(const FStaticMeshBuildVertex& Vertex, const int32 NumUVs, const bool bHasVertexColors)
+	{
+		// FNV-1a over the attributes actually in use (the other UV channels are left uninitialized)
+		uint32 Hash = 2166136261u;
+		auto HashWords = [&Hash](const void* Data, const int32 Size)
+		{
+			const uint32* Words = reinterpret_cast<const uint32*>(Data);
+			for (int32 WordIndex = 0; WordIndex < Size / 4; WordIndex++)
+			{
+				Hash = (Hash ^ Words[WordIndex]) * 16777619u;
+			}
+		};
+
+		HashWords(&Vertex.Position, sizeof(Vertex.Position));
+		HashWords(&Vertex.TangentX, sizeof(Vertex.TangentX));
+		HashWords(&Vertex.TangentY, sizeof(Vertex.TangentY));
+		HashWords(&Vertex.TangentZ, sizeof(Vertex.TangentZ));
+		HashWords(Vertex.UVs, sizeof(Vertex.UVs[0]) * NumUVs);
+		if (bHasVertexColors)
+		{
+			HashWords(&Vertex.Color, sizeof(Vertex.Color));
+		}
+		return Hash;
+	}
+
+	bool BuildVerticesAreEqual(const FStaticMeshBuildVertex& A, const FStaticMeshBuildVertex& B, const int32 NumUVs, const bool bHasVertexColors)
+	{
+		return FMemory::Memcmp(&A.Position, &B.Position, sizeof(A.Position)) == 0 &&
+			FMemory::Memcmp(&A.TangentX, &B.TangentX, sizeof(A.TangentX)) == 0 &&
+			FMemory::Memcmp(&A.TangentY, &B.TangentY, sizeof(A.TangentY)) == 0 &&
+			FMemory::Memcmp(&A.TangentZ, &B.TangentZ, sizeof(A.TangentZ)) == 0 &&
+			FMemory::Memcmp(A.UVs, B.UVs, sizeof(A.UVs[0]) * NumUVs) == 0 &&
+			(!bHasVertexColors || A.Color == B.Color);
+	}
+
+	// Merges bitwise identical vertices, rewriting the indices; the surviving vertices keep their first use order
+	void WeldVertices(TArray<FStaticMeshBuildVertex>& Vertices, TArray<uint32>& Indices, const int32 NumUVs, const bool bHasVertexColors)
+	{
+		const int32 NumBuckets = FMath::RoundUpToPowerOfTwo(FMath::Max(Vertices.Num() * 2, 16));
+		TArray<int32> Buckets;
+		Buckets.Init(INDEX_NONE, NumBuckets);
+
+		TArray<FStaticMeshBuildVertex> WeldedVertices;
+		WeldedVertices.Reserve(Vertices.Num());
+
+		TArray<int32> Remap;
+		Remap.Init(INDEX_NONE, Vertices.Num());
+
+		for (uint32& Index : Indices)
+		{
+			if (Remap[Index] == INDEX_NONE)
+			{
+				const FStaticMeshBuildVertex& Vertex = Vertices[Index];
+				// open addressing with linear probing, the table is never more than half full
+				uint32 Bucket = HashBuildVertex(Vertex, NumUVs, bHasVertexColors) & (NumBuckets - 1);
+				while (Buckets[Bucket] != INDEX_NONE && !BuildVerticesAreEqual(WeldedVertices[Buckets[Bucket]], Vertex, NumUVs, bHasVertexColors))
+				{
+					Bucket = (Bucket + 1) & (NumBuckets - 1);
+				}
+
+				if (Buckets[Bucket] == INDEX_NONE)
+				{
+					Buckets[Bucket] = WeldedVertices.Add(Vertex);
+				}
+				Remap[Index] = Buckets[Bucket];
+			}
+			Index = Remap[Index];
+		}
+
+		Vertices = MoveTemp(WeldedVertices);
+	}
+
+	// Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+	void OptimizeSectionForVertexCache(TArray<uint32>& Indices, const int32 FirstIndex, const int32 NumTriangles, TArray<int32>& LocalVertices)
+	{
+		constexpr int32 CacheSize = 16;
+
+		if (NumTriangles < 2)
+		{
+			return;
+		}
+
+		uint32* SectionIndices = Indices.GetData() + FirstIndex;
+		const int32 NumIndices = NumTriangles * 3;
+
+		// map the section vertices to a compact range
+		TArray<uint32> GlobalVertices;
+		TArray<uint32> Triangles;
+		Triangles.SetNumUninitialized(NumIndices);
+		for (int32 Index = 0; Index < NumIndices; Index++)
+		{
+			int32& LocalVertex = LocalVertices[SectionIndices[Index]];
+			if (LocalVertex == INDEX_NONE)
+			{
+				LocalVertex = GlobalVertices.Add(SectionIndices[Index]);
+			}
+			Triangles[Index] = LocalVertex;
+		}
+		for (const uint32 GlobalVertex : GlobalVertices)
+		{
+			LocalVertices[GlobalVertex] = INDEX_NONE;
+		}
+
+		const int32 NumVertices = GlobalVertices.Num();
+
+		// vertex -> triangles adjacency
+		TArray<int32> Live;
+		Live.SetNumZeroed(NumVertices);
+		for (const uint32 Vertex : Triangles)
+		{
+			Live[Vertex]++;
+		}
+
+		TArray<int32> AdjacencyOffsets;
+		AdjacencyOffsets.SetNumUninitialized(NumVertices + 1);
+		AdjacencyOffsets[0] = 0;
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			AdjacencyOffsets[Vertex + 1] = AdjacencyOffsets[Vertex] + Live[Vertex];
+		}
+
+		TArray<int32> Adjacency;
+		Adjacency.SetNumUninitialized(NumIndices);
+		{
+			TArray<int32> Cursors(AdjacencyOffsets.GetData(), NumVertices);
+			for (int32 Index = 0; Index < NumIndices; Index++)
+			{
+				Adjacency[Cursors[Triangles[Index]]++] = Index / 3;
+			}
+		}
+
+		TArray<int32> CacheTimestamps;
+		CacheTimestamps.SetNumZeroed(NumVertices);
+		TBitArray<> EmittedTriangles(false, NumTriangles);
+		TArray<int32> DeadEnd;
+		TArray<int32> Candidates;
+
+		TArray<uint32> OptimizedIndices;
+		OptimizedIndices.Reserve(NumIndices);
+
+		int32 Timestamp = CacheSize + 1;
+		int32 Cursor = 0;
+		int32 Fanning = 0;
+		while (Fanning >= 0)
+		{
+			Candidates.Reset();
+			for (int32 AdjacencyIndex = AdjacencyOffsets[Fanning]; AdjacencyIndex < AdjacencyOffsets[Fanning + 1]; AdjacencyIndex++)
+			{
+				const int32 Triangle = Adjacency[AdjacencyIndex];
+				if (EmittedTriangles[Triangle])
+				{
+					continue;
+				}
+
+				for (int32 Corner = 0; Corner < 3; Corner++)
+				{
+					const int32 Vertex = Triangles[Triangle * 3 + Corner];
+					OptimizedIndices.Add(GlobalVertices[Vertex]);
+					DeadEnd.Push(Vertex);
+					Candidates.Add(Vertex);
+					Live[Vertex]--;
+					if (Timestamp - CacheTimestamps[Vertex] > CacheSize)
+					{
+						CacheTimestamps[Vertex] = Timestamp++;
+					}
+				}
+				EmittedTriangles[Triangle] = true;
+			}
+
+			// prefer the candidate that will still be in the cache once all of its triangles are emitted
+			Fanning = INDEX_NONE;
+			int32 BestPriority = -1;
+			for (const int32 Vertex : Candidates)
+			{
+				if (Live[Vertex] > 0)
+				{
+					int32 Priority = 0;
+					if (Timestamp - CacheTimestamps[Vertex] + 2 * Live[Vertex] <= CacheSize)
+					{
+						Priority = Timestamp - CacheTimestamps[Vertex];
+					}
+					if (Priority > BestPriority)
+					{
+						BestPriority = Priority;
+						Fanning = Vertex;
+					}
+				}
+			}
+
+			if (Fanning == INDEX_NONE)
+			{
+				while (DeadEnd.Num() > 0)
+				{
+					const int32 Vertex = DeadEnd.Pop(false);
+					if (Live[Vertex] > 0)
+					{
+						Fanning = Vertex;
+						break;
+					}
+				}
+			}
+
+			if (Fanning == INDEX_NONE)
+			{
+				while (Cursor < NumVertices && Live[Cursor] == 0)
+				{
+					Cursor++;
+				}
+				if (Cursor < NumVertices)
+				{
+					Fanning = Cursor;
+				}
+			}
+		}
+
+		FMemory::Memcpy(SectionIndices, OptimizedIndices.GetData(), NumIndices * sizeof(uint32));
+	}
+
+	// Renumbers the vertices in first use order, so the vertex fetches follow the index buffer
+	void OptimizeVerticesForFetch(TArray<FStaticMeshBuildVertex>& Vertices, TArray<uint32>& Indices)
+	{
+		TArray<int32> Remap;
+		Remap.Init(INDEX_NONE, Vertices.Num());
+
+		TArray<FStaticMeshBuildVertex> OptimizedVertices;
+		OptimizedVertices.Reserve(Vertices.Num());
+
+		for (uint32& Index : Indices)
+		{
+			if (Remap[Index] == INDEX_NONE)
+			{
+				Remap[Index] = OptimizedVertices.Add(Vertices[Index]);
+			}
+			Index = Remap[Index];
+		}
+
+		Vertices = MoveTemp(OptimizedVertices);
+	}
+}
 
 FglTFRuntimeStaticMeshContext::FglTFRuntimeStaticMeshContext(TSharedRef<FglTFRuntimeParser> InParser, const FglTFRuntimeStaticMeshConfig& InStaticMeshConfig) :
 	Parser(InParser),
@@ -61,41 +304,70 @@ void FglTFRuntimeParser::LoadStaticMeshAsync(const int32 MeshIndex, FglTFRuntime
 
 	Async(EAsyncExecution::Thread, [this, StaticMeshContext, MeshIndex, AsyncCallback]()
 		{
-
-			TSharedPtr<FJsonObject> JsonMeshObject = GetJsonObjectFromRootIndex("meshes", MeshIndex);
-			if (JsonMeshObject)
-			{
-
-				FglTFRuntimeMeshLOD* LOD = nullptr;
-				if (LoadMeshIntoMeshLOD(JsonMeshObject.ToSharedRef(), LOD, StaticMeshContext->StaticMeshConfig.MaterialsConfig))
-				{
-					StaticMeshContext->LODs.Add(LOD);
-
-					StaticMeshContext->StaticMesh = LoadStaticMesh_Internal(StaticMeshContext);
-				}
-			}
+			LoadStaticMeshIntoContext(MeshIndex, StaticMeshContext);
 
 			FGraphEventRef Task = FFunctionGraphTask::CreateAndDispatchWhenReady([MeshIndex, StaticMeshContext, AsyncCallback]()
 				{
-					if (StaticMeshContext->StaticMesh)
-					{
-						StaticMeshContext->StaticMesh = StaticMeshContext->Parser->FinalizeStaticMesh(StaticMeshContext);
-					}
-
-					if (StaticMeshContext->StaticMesh)
-					{
-						if (StaticMeshContext->Parser->CanWriteToCache(StaticMeshContext->StaticMeshConfig.CacheMode))
-						{
-							StaticMeshContext->Parser->StaticMeshesCache.Add(MeshIndex, StaticMeshContext->StaticMesh);
-						}
-					}
-
-					AsyncCallback.ExecuteIfBound(StaticMeshContext->StaticMesh);
+					AsyncCallback.ExecuteIfBound(StaticMeshContext->Parser->FinalizeStaticMeshContext(MeshIndex, StaticMeshContext));
 				}, TStatId(), nullptr, ENamedThreads::GameThread);
 			FTaskGraphInterface::Get().WaitUntilTaskCompletes(Task);
 		});
 }
 
+bool FglTFRuntimeParser::LoadStaticMeshIntoContext(const int32 MeshIndex, TSharedRef<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe> StaticMeshContext)
+{
+	TSharedPtr<FJsonObject> JsonMeshObject = GetJsonObjectFromRootIndex("meshes", MeshIndex);
+	if (JsonMeshObject)
+	{
+		FglTFRuntimeMeshLOD* LOD = nullptr;
+		if (LoadMeshIntoMeshLOD(JsonMeshObject.ToSharedRef(), LOD, StaticMeshContext->StaticMeshConfig.MaterialsConfig))
+		{
+			StaticMeshContext->LODs.Add(LOD);
+
+			StaticMeshContext->StaticMesh = LoadStaticMesh_Internal(StaticMeshContext);
+			return StaticMeshContext->StaticMesh != nullptr;
+		}
+	}
+
+	StaticMeshContext->StaticMesh = nullptr;
+	return false;
+}
+
+UStaticMesh* FglTFRuntimeParser::FinalizeStaticMeshContext(const int32 MeshIndex, TSharedRef<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe> StaticMeshContext)
+{
+	for (const FglTFRuntimeMeshLOD* LOD : StaticMeshContext->LODs)
+	{
+		ReleaseMaterialsInFlight(*LOD);
+	}
+
+	if (StaticMeshContext->StaticMesh)
+	{
+		StaticMeshContext->StaticMesh = FinalizeStaticMesh(StaticMeshContext);
+	}
+
+	if (StaticMeshContext->StaticMesh)
+	{
+		if (CanWriteToCache(StaticMeshContext->StaticMeshConfig.CacheMode))
+		{
+			StaticMeshesCache.Add(MeshIndex, StaticMeshContext->StaticMesh);
+		}
+	}
+
+	return StaticMeshContext->StaticMesh;
+}
+
+UStaticMesh* FglTFRuntimeParser::GetCachedStaticMesh(const int32 MeshIndex, const FglTFRuntimeStaticMeshConfig& StaticMeshConfig) const
+{
+	if (CanReadFromCache(StaticMeshConfig.CacheMode))
+	{
+		if (UStaticMesh* const* StaticMesh = StaticMeshesCache.Find(MeshIndex))
+		{
+			return *StaticMesh;
+		}
+	}
+	return nullptr;
+}
+
 UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe> StaticMeshContext)
 {
 	SCOPED_NAMED_EVENT(FglTFRuntimeParser_LoadStaticMesh_Internal, FColor::Magenta);
@@ -159,6 +431,9 @@ UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntime
 
 		int32 AdditionalTransformsPrimitiveIndex = 0; // used only when applying additional transforms
 
+		TArray<FglTFRuntimePrimitiveTangentSpace> TangentSpaces;
+		GenerateTangentSpaces(LOD->Primitives, StaticMeshConfig.TangentSpaceGenerationMethod, StaticMeshConfig.NormalsGenerationStrategy, StaticMeshConfig.TangentsGenerationStrategy, StaticMeshConfig.bReverseWinding, TangentSpaces);
+
 		for (const FglTFRuntimePrimitive& Primitive : LOD->Primitives)
 		{
 			FName MaterialName = FName(FString::Printf(TEXT("LOD_%d_Section_%d_%s"), CurrentLODIndex, StaticMeshContext->StaticMaterials.Num(), *Primitive.MaterialName));
@@ -206,6 +481,10 @@ UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntime
 			bool bMissingTangents = false;
 			bool bMissingIgnore = false;
 
+			const FglTFRuntimePrimitiveTangentSpace& TangentSpace = TangentSpaces[SectionIndex];
+			const TArray<FVector>& Normals = TangentSpace.Normals.Num() > 0 ? TangentSpace.Normals : Primitive.Normals;
+			const TArray<FVector4>& Tangents = TangentSpace.Tangents.Num() > 0 ? TangentSpace.Tangents : Primitive.Tangents;
+
 			LODIndices.AddUninitialized(NumVertexInstancesPerSection);
 
 			// Geometry generation
@@ -222,14 +501,14 @@ UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntime
 				StaticMeshVertex.Position = GetSafeValue(Primitive.Positions, VertexIndex, FVector::ZeroVector, bMissingIgnore);
 #endif
 
-				FVector4 TangentX = GetSafeValue(Primitive.Tangents, VertexIndex, FVector4(0, 0, 0, 1), bMissingTangents);
+				FVector4 TangentX = GetSafeValue(Tangents, VertexIndex, FVector4(0, 0, 0, 1), bMissingTangents);
 #if ENGINE_MAJOR_VERSION > 4
 				StaticMeshVertex.TangentX = FVector4f(TangentX);
-				StaticMeshVertex.TangentZ = FVector3f(GetSafeValue(Primitive.Normals, VertexIndex, FVector::ZeroVector, bMissingNormals));
+				StaticMeshVertex.TangentZ = FVector3f(GetSafeValue(Normals, VertexIndex, FVector::ZeroVector, bMissingNormals));
 				StaticMeshVertex.TangentY = FVector3f(ComputeTangentYWithW(FVector(StaticMeshVertex.TangentZ), FVector(StaticMeshVertex.TangentX), TangentX.W * TangentsDirection));
 #else
 				StaticMeshVertex.TangentX = TangentX;
-				StaticMeshVertex.TangentZ = GetSafeValue(Primitive.Normals, VertexIndex, FVector::ZeroVector, bMissingNormals);
+				StaticMeshVertex.TangentZ = GetSafeValue(Normals, VertexIndex, FVector::ZeroVector, bMissingNormals);
 				StaticMeshVertex.TangentY = ComputeTangentYWithW(StaticMeshVertex.TangentZ, StaticMeshVertex.TangentX, TangentX.W * TangentsDirection);
 #endif
 
@@ -296,7 +575,8 @@ UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntime
 
 			const bool bCanGenerateNormals = (bMissingNormals && StaticMeshConfig.NormalsGenerationStrategy == EglTFRuntimeNormalsGenerationStrategy::IfMissing) ||
 				StaticMeshConfig.NormalsGenerationStrategy == EglTFRuntimeNormalsGenerationStrategy::Always;
-			if (bCanGenerateNormals && (NumVertexInstancesPerSection % 3) == 0)
+			// the per face normals are only used when no vertex normals have been generated
+			if (bCanGenerateNormals && TangentSpace.Normals.Num() == 0 && (NumVertexInstancesPerSection % 3) == 0)
 			{
 				for (int32 VertexInstanceSectionIndex = 0; VertexInstanceSectionIndex < NumVertexInstancesPerSection; VertexInstanceSectionIndex += 3)
 				{
@@ -330,7 +610,7 @@ UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntime
 			const bool bCanGenerateTangents = (bMissingTangents && StaticMeshConfig.TangentsGenerationStrategy == EglTFRuntimeTangentsGenerationStrategy::IfMissing) ||
 				StaticMeshConfig.TangentsGenerationStrategy == EglTFRuntimeTangentsGenerationStrategy::Always;
 			// recompute tangents if required (need normals and uvs)
-			if (bCanGenerateTangents && !bMissingNormals && Primitive.UVs.Num() > 0 && (NumVertexInstancesPerSection % 3) == 0)
+			if (bCanGenerateTangents && TangentSpace.Tangents.Num() == 0 && !bMissingNormals && Primitive.UVs.Num() > 0 && (NumVertexInstancesPerSection % 3) == 0)
 			{
 				for (int32 VertexInstanceSectionIndex = 0; VertexInstanceSectionIndex < NumVertexInstancesPerSection; VertexInstanceSectionIndex += 3)
 				{
@@ -451,6 +731,37 @@ UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntime
 			}
 				}
 
+		if (StaticMeshConfig.bWeldVertices)
+		{
+			glTFRuntimeStaticMeshes::WeldVertices(StaticMeshBuildVertices, LODIndices, NumUVs, bHasVertexColors);
+
+			if (StaticMeshConfig.bOptimizeVertexCache)
+			{
+				TArray<int32> LocalVertices;
+				LocalVertices.Init(INDEX_NONE, StaticMeshBuildVertices.Num());
+				for (const FStaticMeshSection& Section : Sections)
+				{
+					glTFRuntimeStaticMeshes::OptimizeSectionForVertexCache(LODIndices, Section.FirstIndex, Section.NumTriangles, LocalVertices);
+				}
+				glTFRuntimeStaticMeshes::OptimizeVerticesForFetch(StaticMeshBuildVertices, LODIndices);
+			}
+		}
+
+		for (FStaticMeshSection& Section : Sections)
+		{
+			Section.MinVertexIndex = MAX_uint32;
+			Section.MaxVertexIndex = 0;
+			for (uint32 Index = Section.FirstIndex; Index < Section.FirstIndex + Section.NumTriangles * 3; Index++)
+			{
+				Section.MinVertexIndex = FMath::Min(Section.MinVertexIndex, LODIndices[Index]);
+				Section.MaxVertexIndex = FMath::Max(Section.MaxVertexIndex, LODIndices[Index]);
+			}
+			if (Section.MinVertexIndex > Section.MaxVertexIndex)
+			{
+				Section.MinVertexIndex = 0;
+			}
+		}
+
 		if (CurrentLODIndex == 0)
 		{
 			BoundingBox.GetCenterAndExtents(StaticMeshContext->BoundingBoxAndSphere.Origin, StaticMeshContext->BoundingBoxAndSphere.BoxExtent);
@@ -477,13 +788,19 @@ UStaticMesh* FglTFRuntimeParser::LoadStaticMesh_Internal(TSharedRef<FglTFRuntime
 		{
 			LODResources.IndexBuffer = FRawStaticIndexBuffer(true);
 			}
-		LODResources.IndexBuffer.SetIndices(LODIndices, EIndexBufferStride::Force32Bit);
+		// 16 bit indices whenever the LOD has less than 64k vertices
+		LODResources.IndexBuffer.SetIndices(LODIndices, EIndexBufferStride::AutoDetect);
 
 #if WITH_EDITOR
 		if (StaticMeshConfig.bGenerateStaticMeshDescription)
 		{
-			FStaticMeshSourceModel& SourceModel = StaticMesh->AddSourceModel();
-			FMeshDescription* MeshDescription = StaticMesh->CreateMeshDescription(CurrentLODIndex);
+			FMeshDescription* MeshDescription;
+			{
+				// the source model creates its bulk data subobjects, which must not race with GC on another thread
+				FGCScopeGuard GCScopeGuard;
+				StaticMesh->AddSourceModel();
+				MeshDescription = StaticMesh->CreateMeshDescription(CurrentLODIndex);
+			}
 			FStaticMeshAttributes StaticMeshAttributes(*MeshDescription);
 #if ENGINE_MAJOR_VERSION > 4
 
@@ -748,10 +1065,13 @@ bool FglTFRuntimeParser::LoadStaticMeshes(TArray<UStaticMesh*>& StaticMeshes, co
 
 bool FglTFRuntimeParser::LoadMeshIntoMeshLOD(TSharedRef<FJsonObject> JsonMeshObject, FglTFRuntimeMeshLOD*& LOD, const FglTFRuntimeMaterialsConfig& MaterialsConfig)
 {
-	if (LODsCache.Contains(JsonMeshObject))
 	{
-		LOD = &LODsCache[JsonMeshObject];
-		return true;
+		FScopeLock Lock(&CachesLock);
+		if (TUniquePtr<FglTFRuntimeMeshLOD>* CachedLOD = LODsCache.Find(JsonMeshObject))
+		{
+			LOD = CachedLOD->Get();
+			return true;
+		}
 	}
 
 	TArray<FglTFRuntimePrimitive> Primitives;
@@ -760,11 +1080,15 @@ bool FglTFRuntimeParser::LoadMeshIntoMeshLOD(TSharedRef<FJsonObject> JsonMeshObj
 		return false;
 	}
 
-	FglTFRuntimeMeshLOD NewLOD;
-	NewLOD.Primitives = MoveTemp(Primitives);
-
-	FglTFRuntimeMeshLOD& CachedLOD = LODsCache.Add(JsonMeshObject, MoveTemp(NewLOD));
-	LOD = &CachedLOD;
+	FScopeLock Lock(&CachesLock);
+	// another thread may have loaded the same mesh in the meantime
+	TUniquePtr<FglTFRuntimeMeshLOD>& CachedLOD = LODsCache.FindOrAdd(JsonMeshObject);
+	if (!CachedLOD)
+	{
+		CachedLOD = MakeUnique<FglTFRuntimeMeshLOD>();
+		CachedLOD->Primitives = MoveTemp(Primitives);
+	}
+	LOD = CachedLOD.Get();
 	return true;
 }
 
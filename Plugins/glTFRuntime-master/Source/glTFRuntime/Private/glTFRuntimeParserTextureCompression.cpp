@@ -0,0 +1,302 @@
+// Copyright 2020-2023, Roberto De Ioris.
+
+#include "glTFRuntimeParser.h"
+#include "Async/ParallelFor.h"
+#include "PixelFormat.h"
+#include "RenderUtils.h"
+
+namespace glTFRuntimeTextureCompression
+{
+	// gathers a 4x4 block of BGRA texels, clamping at the borders of small mips
+	void FetchBlock(const uint8* Pixels, const int32 Width, const int32 Height, const int32 BlockX, const int32 BlockY, uint8 Block[16][4])
+	{
+		for (int32 Y = 0; Y < 4; Y++)
+		{
+			const int32 PixelY = FMath::Min(BlockY * 4 + Y, Height - 1);
+			for (int32 X = 0; X < 4; X++)
+			{
+				const int32 PixelX = FMath::Min(BlockX * 4 + X, Width - 1);
+				FMemory::Memcpy(Block[Y * 4 + X], Pixels + (static_cast<int64>(PixelY) * Width + PixelX) * 4, 4);
+			}
+		}
+	}
+
+	uint16 To565(const float Color[3])
+	{
+		const int32 R = FMath::Clamp(FMath::RoundToInt(Color[0] * 31.0f / 255.0f), 0, 31);
+		const int32 G = FMath::Clamp(FMath::RoundToInt(Color[1] * 63.0f / 255.0f), 0, 63);
+		const int32 B = FMath::Clamp(FMath::RoundToInt(Color[2] * 31.0f / 255.0f), 0, 31);
+		return static_cast<uint16>((R << 11) | (G << 5) | B);
+	}
+
+	void From565(const uint16 Value, int32 Color[3])
+	{
+		const int32 R = (Value >> 11) & 0x1F;
+		const int32 G = (Value >> 5) & 0x3F;
+		const int32 B = Value & 0x1F;
+		Color[0] = (R << 3) | (R >> 2);
+		Color[1] = (G << 2) | (G >> 4);
+		Color[2] = (B << 3) | (B >> 2);
+	}
+
+	// BC1 in four colors mode, with the endpoints fitted along the principal axis of the block colors
+	void EncodeBC1(const uint8 Block[16][4], uint8* Out)
+	{
+		float Colors[16][3];
+		float Mean[3] = { 0, 0, 0 };
+		for (int32 Index = 0; Index < 16; Index++)
+		{
+			// BGRA to RGB
+			Colors[Index][0] = Block[Index][2];
+			Colors[Index][1] = Block[Index][1];
+			Colors[Index][2] = Block[Index][0];
+			Mean[0] += Colors[Index][0];
+			Mean[1] += Colors[Index][1];
+			Mean[2] += Colors[Index][2];
+		}
+		Mean[0] /= 16;
+		Mean[1] /= 16;
+		Mean[2] /= 16;
+
+		float Covariance[6] = { 0, 0, 0, 0, 0, 0 };
+		for (int32 Index = 0; Index < 16; Index++)
+		{
+			const float R = Colors[Index][0] - Mean[0];
+			const float G = Colors[Index][1] - Mean[1];
+			const float B = Colors[Index][2] - Mean[2];
+			Covariance[0] += R * R;
+			Covariance[1] += R * G;
+			Covariance[2] += R * B;
+			Covariance[3] += G * G;
+			Covariance[4] += G * B;
+			Covariance[5] += B * B;
+		}
+
+		// a few power iterations are more than enough for 16 texels
+		float Axis[3] = { 1, 1, 1 };
+		for (int32 Iteration = 0; Iteration < 8; Iteration++)
+		{
+			const float X = Covariance[0] * Axis[0] + Covariance[1] * Axis[1] + Covariance[2] * Axis[2];
+			const float Y = Covariance[1] * Axis[0] + Covariance[3] * Axis[1] + Covariance[4] * Axis[2];
+			const float Z = Covariance[2] * Axis[0] + Covariance[4] * Axis[1] + Covariance[5] * Axis[2];
+			const float Length = FMath::Max3(FMath::Abs(X), FMath::Abs(Y), FMath::Abs(Z));
+			if (Length <= KINDA_SMALL_NUMBER)
+			{
+				break;
+			}
+			Axis[0] = X / Length;
+			Axis[1] = Y / Length;
+			Axis[2] = Z / Length;
+		}
+
+		const float AxisLengthSquared = Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2];
+		float MinProjection = 0;
+		float MaxProjection = 0;
+		for (int32 Index = 0; Index < 16; Index++)
+		{
+			const float Projection = ((Colors[Index][0] - Mean[0]) * Axis[0] + (Colors[Index][1] - Mean[1]) * Axis[1] + (Colors[Index][2] - Mean[2]) * Axis[2]) / AxisLengthSquared;
+			MinProjection = FMath::Min(MinProjection, Projection);
+			MaxProjection = FMath::Max(MaxProjection, Projection);
+		}
+
+		float MaxColor[3];
+		float MinColor[3];
+		for (int32 Channel = 0; Channel < 3; Channel++)
+		{
+			MaxColor[Channel] = Mean[Channel] + Axis[Channel] * MaxProjection;
+			MinColor[Channel] = Mean[Channel] + Axis[Channel] * MinProjection;
+		}
+
+		uint16 Color0 = To565(MaxColor);
+		uint16 Color1 = To565(MinColor);
+		// Color0 > Color1 selects the four colors mode
+		if (Color0 < Color1)
+		{
+			Swap(Color0, Color1);
+		}
+
+		uint32 Indices = 0;
+		if (Color0 != Color1)
+		{
+			int32 Palette[4][3];
+			From565(Color0, Palette[0]);
+			From565(Color1, Palette[1]);
+			for (int32 Channel = 0; Channel < 3; Channel++)
+			{
+				Palette[2][Channel] = (2 * Palette[0][Channel] + Palette[1][Channel]) / 3;
+				Palette[3][Channel] = (Palette[0][Channel] + 2 * Palette[1][Channel]) / 3;
+			}
+
+			for (int32 Index = 0; Index < 16; Index++)
+			{
+				uint32 BestIndex = 0;
+				float BestDistance = MAX_flt;
+				for (uint32 PaletteIndex = 0; PaletteIndex < 4; PaletteIndex++)
+				{
+					const float R = Colors[Index][0] - Palette[PaletteIndex][0];
+					const float G = Colors[Index][1] - Palette[PaletteIndex][1];
+					const float B = Colors[Index][2] - Palette[PaletteIndex][2];
+					const float Distance = R * R + G * G + B * B;
+					if (Distance < BestDistance)
+					{
+						BestDistance = Distance;
+						BestIndex = PaletteIndex;
+					}
+				}
+				Indices |= BestIndex << (Index * 2);
+			}
+		}
+
+		Out[0] = Color0 & 0xFF;
+		Out[1] = Color0 >> 8;
+		Out[2] = Color1 & 0xFF;
+		Out[3] = Color1 >> 8;
+		Out[4] = Indices & 0xFF;
+		Out[5] = (Indices >> 8) & 0xFF;
+		Out[6] = (Indices >> 16) & 0xFF;
+		Out[7] = Indices >> 24;
+	}
+
+	// BC4 (one channel) in eight values mode, used for the BC3 alpha and the BC5 channels
+	void EncodeBC4(const uint8 Values[16], uint8* Out)
+	{
+		uint8 MinValue = 255;
+		uint8 MaxValue = 0;
+		for (int32 Index = 0; Index < 16; Index++)
+		{
+			MinValue = FMath::Min(MinValue, Values[Index]);
+			MaxValue = FMath::Max(MaxValue, Values[Index]);
+		}
+
+		uint64 Indices = 0;
+		if (MinValue != MaxValue)
+		{
+			int32 Palette[8];
+			Palette[0] = MaxValue;
+			Palette[1] = MinValue;
+			for (int32 Step = 1; Step < 7; Step++)
+			{
+				Palette[Step + 1] = ((7 - Step) * MaxValue + Step * MinValue) / 7;
+			}
+
+			for (int32 Index = 0; Index < 16; Index++)
+			{
+				uint64 BestIndex = 0;
+				int32 BestDistance = MAX_int32;
+				for (uint64 PaletteIndex = 0; PaletteIndex < 8; PaletteIndex++)
+				{
+					const int32 Distance = FMath::Abs(Values[Index] - Palette[PaletteIndex]);
+					if (Distance < BestDistance)
+					{
+						BestDistance = Distance;
+						BestIndex = PaletteIndex;
+					}
+				}
+				Indices |= BestIndex << (Index * 3);
+			}
+		}
+
+		Out[0] = MaxValue;
+		Out[1] = MinValue;
+		for (int32 Byte = 0; Byte < 6; Byte++)
+		{
+			Out[2 + Byte] = (Indices >> (Byte * 8)) & 0xFF;
+		}
+	}
+
+	void EncodeBlock(const EPixelFormat PixelFormat, const uint8 Block[16][4], uint8* Out)
+	{
+		uint8 Values[16];
+		if (PixelFormat == EPixelFormat::PF_DXT1)
+		{
+			EncodeBC1(Block, Out);
+		}
+		else if (PixelFormat == EPixelFormat::PF_DXT5)
+		{
+			for (int32 Index = 0; Index < 16; Index++)
+			{
+				Values[Index] = Block[Index][3];
+			}
+			EncodeBC4(Values, Out);
+			EncodeBC1(Block, Out + 8);
+		}
+		else if (PixelFormat == EPixelFormat::PF_BC5)
+		{
+			// red then green, from BGRA
+			for (int32 Index = 0; Index < 16; Index++)
+			{
+				Values[Index] = Block[Index][2];
+			}
+			EncodeBC4(Values, Out);
+			for (int32 Index = 0; Index < 16; Index++)
+			{
+				Values[Index] = Block[Index][1];
+			}
+			EncodeBC4(Values, Out + 8);
+		}
+	}
+}
+
+void FglTFRuntimeParser::CompressMips(TArray<FglTFRuntimeMipMap>& Mips, const FglTFRuntimeImagesConfig& ImagesConfig)
+{
+	SCOPED_NAMED_EVENT(FglTFRuntimeParser_CompressMips, FColor::Magenta);
+
+	if (!ImagesConfig.bBlockCompress || Mips.Num() == 0 || Mips[0].PixelFormat != EPixelFormat::PF_B8G8R8A8)
+	{
+		return;
+	}
+
+	// smaller mips are padded, but the top one must be made of whole blocks
+	if (Mips[0].Width % 4 != 0 || Mips[0].Height % 4 != 0)
+	{
+		return;
+	}
+
+	EPixelFormat PixelFormat = EPixelFormat::PF_DXT1;
+	if (ImagesConfig.Compression == TextureCompressionSettings::TC_Normalmap)
+	{
+		PixelFormat = EPixelFormat::PF_BC5;
+	}
+	else
+	{
+		const TArray64<uint8>& Pixels = Mips[0].Pixels;
+		for (int64 Index = 3; Index < Pixels.Num(); Index += 4)
+		{
+			if (Pixels[Index] < 255)
+			{
+				PixelFormat = EPixelFormat::PF_DXT5;
+				break;
+			}
+		}
+	}
+
+	if (!GPixelFormats[PixelFormat].Supported)
+	{
+		UE_LOG(LogGLTFRuntime, Warning, TEXT("Pixel format %s is not supported, leaving texture uncompressed"), GPixelFormats[PixelFormat].Name);
+		return;
+	}
+
+	const int32 BlockBytes = GPixelFormats[PixelFormat].BlockBytes;
+
+	for (FglTFRuntimeMipMap& MipMap : Mips)
+	{
+		const int32 BlocksX = FMath::DivideAndRoundUp(MipMap.Width, 4);
+		const int32 BlocksY = FMath::DivideAndRoundUp(MipMap.Height, 4);
+
+		TArray64<uint8> CompressedPixels;
+		CompressedPixels.AddUninitialized(static_cast<int64>(BlocksX) * BlocksY * BlockBytes);
+
+		ParallelFor(BlocksY, [&](const int32 BlockY)
+			{
+				uint8 Block[16][4];
+				for (int32 BlockX = 0; BlockX < BlocksX; BlockX++)
+				{
+					glTFRuntimeTextureCompression::FetchBlock(MipMap.Pixels.GetData(), MipMap.Width, MipMap.Height, BlockX, BlockY, Block);
+					glTFRuntimeTextureCompression::EncodeBlock(PixelFormat, Block, CompressedPixels.GetData() + (static_cast<int64>(BlockY) * BlocksX + BlockX) * BlockBytes);
+				}
+			}, BlocksX * BlocksY < 64 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+		MipMap.Pixels = MoveTemp(CompressedPixels);
+		MipMap.PixelFormat = PixelFormat;
+	}
+}
@@ -5,8 +5,19 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "glTFRuntimeAsset.h"
+#include "Containers/Queue.h"
 #include "glTFRuntimeAssetActorAsync.generated.h"
 
+struct FglTFRuntimeAssetActorMeshLoad
+{
+	UPrimitiveComponent* PrimitiveComponent = nullptr;
+	FglTFRuntimeNode Node;
+	TSharedPtr<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe> StaticMeshContext;
+	TSharedPtr<FglTFRuntimeSkeletalMeshContext, ESPMode::ThreadSafe> SkeletalMeshContext;
+};
+
+typedef TQueue<TSharedPtr<FglTFRuntimeAssetActorMeshLoad, ESPMode::ThreadSafe>, EQueueMode::Mpsc> FglTFRuntimeAssetActorMeshLoadQueue;
+
 UCLASS()
 class GLTFRUNTIME_API AglTFRuntimeAssetActorAsync : public AActor
 {
@@ -20,6 +31,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void Tick(float DeltaTime) override;
+
 	virtual void ProcessNode(USceneComponent* NodeParentComponent, const FName SocketName, FglTFRuntimeNode& Node);
 
 	template<typename T>
@@ -51,6 +64,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Meta = (ExposeOnSpawn = true), Category = "glTFRuntime")
 	bool bShowWhileLoading;
 
+	// How many meshes are loaded in parallel on the thread pool (0 means one per worker thread)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Meta = (ExposeOnSpawn = true), Category = "glTFRuntime")
+	int32 MaxConcurrentMeshLoads;
+
+	// How long to spend per frame finalizing loaded meshes on the game thread (at least one mesh is finalized every frame)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Meta = (ExposeOnSpawn = true), Category = "glTFRuntime")
+	float FinalizeTimeBudgetMs;
+
 private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category="glTFRuntime")
 	USceneComponent* AssetRoot;
@@ -59,14 +80,15 @@ private:
 
 	void LoadNextMeshAsync();
 
-	UFUNCTION()
-	void LoadStaticMeshAsync(UStaticMesh* StaticMesh);
+	void FinalizeMeshLoad(TSharedRef<FglTFRuntimeAssetActorMeshLoad, ESPMode::ThreadSafe> MeshLoad);
+
+	void OnStaticMeshLoaded(UStaticMeshComponent* StaticMeshComponent, UStaticMesh* StaticMesh);
 
-	UFUNCTION()
-	void LoadSkeletalMeshAsync(USkeletalMesh* SkeletalMesh);
+	void OnSkeletalMeshLoaded(USkeletalMeshComponent* SkeletalMeshComponent, USkeletalMesh* SkeletalMesh);
 
-	// this is safe to share between game and async threads because everything is sequential
-	UPrimitiveComponent* CurrentPrimitiveComponent;
+	// contexts are only touched by a worker until it queues them back into LoadedMeshes
+	int32 NumMeshLoadsInFlight;
+	TSharedPtr<FglTFRuntimeAssetActorMeshLoadQueue, ESPMode::ThreadSafe> LoadedMeshes;
 
 	double LoadingStartTime;
 
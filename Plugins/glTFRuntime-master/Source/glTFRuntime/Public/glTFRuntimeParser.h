@@ -74,6 +74,17 @@ enum class EglTFRuntimeTangentsGenerationStrategy : uint8
 	Always
 };
 
+UENUM()
+enum class EglTFRuntimeTangentSpaceGenerationMethod : uint8
+{
+	// one normal per triangle, computed while building the vertices
+	PerFace,
+	// area weighted vertex normals
+	Smooth,
+	// angle weighted vertex normals
+	AngleWeighted
+};
+
 UENUM()
 enum class EglTFRuntimeMorphTargetsDuplicateStrategy : uint8
 {
@@ -166,6 +177,18 @@ struct FglTFRuntimeConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
 	FString PrefixForUnnamedNodes;
 
+	// Map files into memory instead of reading them, so the GLB binary chunk and external buffers are only paged in when accessed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	bool bMemoryMapFiles;
+
+	// Store the decoded mesh attributes and texture mips on disk, keyed by the asset content (or path, size and timestamp of a memory mapped file, which would otherwise be paged in whole just to hash it), the size and timestamp of its external buffers and images, and the scene basis/scale, so loading the same asset again skips accessors and images decoding (nothing is ever evicted)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	bool bUseDiskCache;
+
+	// Where to store the disk cache (defaults to Saved/glTFRuntime/DiskCache)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	FString DiskCacheDirectory;
+
 	FglTFRuntimeConfig()
 	{
 		TransformBaseType = EglTFRuntimeTransformBaseType::Default;
@@ -179,6 +202,8 @@ struct FglTFRuntimeConfig
 		RuntimeContextObject = nullptr;
 		bAsBlob = false;
 		PrefixForUnnamedNodes = "node";
+		bMemoryMapFiles = false;
+		bUseDiskCache = false;
 	}
 
 	FMatrix GetMatrix() const
@@ -376,6 +401,10 @@ struct FglTFRuntimeImagesConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
 	int32 MaxHeight;
 
+	// Encode textures to BC formats before uploading them: BC5 for normal maps, BC3 for textures with alpha, BC1 for everything else (sizes must be multiple of 4)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	bool bBlockCompress;
+
 	FglTFRuntimeImagesConfig()
 	{
 		Compression = TextureCompressionSettings::TC_Default;
@@ -383,6 +412,7 @@ struct FglTFRuntimeImagesConfig
 		bSRGB = false;
 		MaxWidth = 0;
 		MaxHeight = 0;
+		bBlockCompress = false;
 	}
 };
 
@@ -531,6 +561,9 @@ struct FglTFRuntimeStaticMeshConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
 	EglTFRuntimeTangentsGenerationStrategy TangentsGenerationStrategy;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	EglTFRuntimeTangentSpaceGenerationMethod TangentSpaceGenerationMethod;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
 	bool bReverseTangents;
 
@@ -543,6 +576,14 @@ struct FglTFRuntimeStaticMeshConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
 	bool bBuildNavCollision;
 
+	// merge vertices with identical attributes instead of keeping one vertex per index
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	bool bWeldVertices;
+
+	// reorder triangles and vertices for the post-transform cache (requires bWeldVertices)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	bool bOptimizeVertexCache;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
 	TMap<FString, FString> CustomConfigMap;
 
@@ -574,10 +615,13 @@ struct FglTFRuntimeStaticMeshConfig
 		PivotPosition = EglTFRuntimePivotPosition::Asset;
 		NormalsGenerationStrategy = EglTFRuntimeNormalsGenerationStrategy::IfMissing;
 		TangentsGenerationStrategy = EglTFRuntimeTangentsGenerationStrategy::IfMissing;
+		TangentSpaceGenerationMethod = EglTFRuntimeTangentSpaceGenerationMethod::PerFace;
 		bReverseTangents = false;
 		bUseHighPrecisionUVs = false;
 		bGenerateStaticMeshDescription = false;
 		bBuildNavCollision = false;
+		bWeldVertices = false;
+		bOptimizeVertexCache = false;
 	}
 };
 
@@ -846,6 +890,9 @@ struct FglTFRuntimeSkeletalMeshConfig
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
 	EglTFRuntimeTangentsGenerationStrategy TangentsGenerationStrategy;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime")
+	EglTFRuntimeTangentSpaceGenerationMethod TangentSpaceGenerationMethod;
+
 	FglTFRuntimeSkeletalMeshConfig()
 	{
 		CacheMode = EglTFRuntimeCacheMode::ReadWrite;
@@ -868,6 +915,7 @@ struct FglTFRuntimeSkeletalMeshConfig
 		bAddVirtualBones = false;
 		NormalsGenerationStrategy = EglTFRuntimeNormalsGenerationStrategy::IfMissing;
 		TangentsGenerationStrategy = EglTFRuntimeTangentsGenerationStrategy::IfMissing;
+		TangentSpaceGenerationMethod = EglTFRuntimeTangentSpaceGenerationMethod::PerFace;
 	}
 };
 
@@ -1075,6 +1123,13 @@ struct FglTFRuntimePrimitive
 	}
 };
 
+// normals and tangents generated for a primitive (empty when the primitive ones are used as is)
+struct FglTFRuntimePrimitiveTangentSpace
+{
+	TArray<FVector> Normals;
+	TArray<FVector4> Tangents;
+};
+
 struct FglTFRuntimeSkeletalMeshLOD
 {
 	// non-const here as the SkeletalMesh parser could modify internal bones mappings
@@ -1084,6 +1139,9 @@ struct FglTFRuntimeSkeletalMeshLOD
 	bool bHasTangents;
 	bool bHasUV;
 
+	// one item for each RuntimeLOD primitive
+	TArray<FglTFRuntimePrimitiveTangentSpace> TangentSpaces;
+
 #if WITH_EDITOR
 	FSkeletalMeshImportData ImportData;
 #endif
@@ -1211,11 +1269,13 @@ struct FglTFRuntimeMipMap
 	TArray64<uint8> Pixels;
 	int32 Width;
 	int32 Height;
+	EPixelFormat PixelFormat;
 
 	FglTFRuntimeMipMap(const int32 InTextureIndex) : TextureIndex(InTextureIndex)
 	{
 		Width = 0;
 		Height = 0;
+		PixelFormat = EPixelFormat::PF_B8G8R8A8;
 	}
 };
 
@@ -1372,6 +1432,27 @@ protected:
 	FArrayReader Data;
 };
 
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+class FglTFRuntimeMappedFile
+{
+public:
+	~FglTFRuntimeMappedFile();
+
+	bool Open(const FString& Filename);
+
+	const uint8* GetData() const;
+	int64 Num() const;
+	const FString& GetFilename() const { return Filename; }
+
+protected:
+	FString Filename;
+	// Region must be released before Handle, so it is declared after it
+	TUniquePtr<IMappedFileHandle> Handle;
+	TUniquePtr<IMappedFileRegion> Region;
+};
+
 USTRUCT(BlueprintType)
 struct FglTFRuntimeAudioEmitter
 {
@@ -1439,9 +1520,9 @@ public:
 	FglTFRuntimeParser(TSharedRef<FJsonObject> JsonObject, const FMatrix& InSceneBasis, float InSceneScale);
 
 	static TSharedPtr<FglTFRuntimeParser> FromFilename(const FString& Filename, const FglTFRuntimeConfig& LoaderConfig);
-	static TSharedPtr<FglTFRuntimeParser> FromBinary(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile = nullptr);
+	static TSharedPtr<FglTFRuntimeParser> FromBinary(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile = nullptr, TSharedPtr<FglTFRuntimeMappedFile> InMappedFile = nullptr);
 	static TSharedPtr<FglTFRuntimeParser> FromString(const FString& JsonData, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile = nullptr);
-	static TSharedPtr<FglTFRuntimeParser> FromData(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig);
+	static TSharedPtr<FglTFRuntimeParser> FromData(const uint8* DataPtr, int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeMappedFile> InMappedFile = nullptr);
 
 	static FORCEINLINE TSharedPtr<FglTFRuntimeParser> FromBinary(const TArray<uint8> Data, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile = nullptr) { return FromBinary(Data.GetData(), Data.Num(), LoaderConfig, InZipFile); }
 	static FORCEINLINE TSharedPtr<FglTFRuntimeParser> FromBinary(const TArray64<uint8> Data, const FglTFRuntimeConfig& LoaderConfig, TSharedPtr<FglTFRuntimeZipFile> InZipFile = nullptr) { return FromBinary(Data.GetData(), Data.Num(), LoaderConfig, InZipFile); }
@@ -1489,6 +1570,16 @@ public:
 
 	void LoadStaticMeshLODsAsync(const TArray<int32>& MeshIndices, FglTFRuntimeStaticMeshAsync AsyncCallback, const FglTFRuntimeStaticMeshConfig& StaticMeshConfig);
 
+	// The async loaders split in two, for callers scheduling many meshes themselves: create the context on the game thread,
+	// load it on any thread (concurrently with other meshes of the same asset), then finalize it back on the game thread.
+	// The caller is responsible for keeping the context's mesh referenced until it is finalized.
+	bool LoadStaticMeshIntoContext(const int32 MeshIndex, TSharedRef<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe> StaticMeshContext);
+	UStaticMesh* FinalizeStaticMeshContext(const int32 MeshIndex, TSharedRef<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe> StaticMeshContext);
+	bool LoadSkeletalMeshIntoContext(const int32 MeshIndex, TSharedRef<FglTFRuntimeSkeletalMeshContext, ESPMode::ThreadSafe> SkeletalMeshContext);
+	USkeletalMesh* FinalizeSkeletalMeshContext(TSharedRef<FglTFRuntimeSkeletalMeshContext, ESPMode::ThreadSafe> SkeletalMeshContext);
+
+	UStaticMesh* GetCachedStaticMesh(const int32 MeshIndex, const FglTFRuntimeStaticMeshConfig& StaticMeshConfig) const;
+
 	USkeletalMesh* LoadSkeletalMeshLODs(const TArray<int32>& MeshIndices, const int32 SkinIndex, const FglTFRuntimeSkeletalMeshConfig& SkeletalMeshConfig);
 
 	USkeletalMesh* LoadSkeletalMeshRecursive(const FString& NodeName, const int32 SkinIndex, const TArray<FString>& ExcludeNodes, const FglTFRuntimeSkeletalMeshConfig& SkeletalMeshConfig);
@@ -1523,6 +1614,7 @@ public:
 
 	bool LoadPrimitives(TSharedRef<FJsonObject> JsonMeshObject, TArray<FglTFRuntimePrimitive>& Primitives, const FglTFRuntimeMaterialsConfig& MaterialsConfig);
 	bool LoadPrimitive(TSharedRef<FJsonObject> JsonPrimitiveObject, FglTFRuntimePrimitive& Primitive, const FglTFRuntimeMaterialsConfig& MaterialsConfig);
+	bool LoadPrimitiveAttributes(TSharedRef<FJsonObject> JsonPrimitiveObject, FglTFRuntimePrimitive& Primitive);
 
 	void AddError(const FString& ErrorContext, const FString& ErrorMessage);
 	void ClearErrors();
@@ -1544,6 +1636,19 @@ public:
 		BinaryBuffer = InBinaryBuffer;
 	}
 
+	void SetBinaryBuffer(TArray64<uint8>&& InBinaryBuffer)
+	{
+		BinaryBuffer = MoveTemp(InBinaryBuffer);
+	}
+
+	// The binary chunk is referenced in place and InMappedFile is kept alive for as long as the parser
+	void SetBinaryBuffer(TSharedPtr<FglTFRuntimeMappedFile> InMappedFile, const uint8* InData, const int64 InNum)
+	{
+		MappedFile = InMappedFile;
+		MappedBinaryBuffer.Data = const_cast<uint8*>(InData);
+		MappedBinaryBuffer.Num = InNum;
+	}
+
 	bool LoadStaticMeshIntoProceduralMeshComponent(const int32 MeshIndex, UProceduralMeshComponent* ProceduralMeshComponent, const FglTFRuntimeProceduralMeshConfig& ProceduralMeshConfig);
 
 	USkeletalMesh* FinalizeSkeletalMeshWithLODs(TSharedRef<FglTFRuntimeSkeletalMeshContext, ESPMode::ThreadSafe> SkeletalMeshContext);
@@ -1573,8 +1678,12 @@ public:
 	TArray<FString> ExtensionsRequired;
 
 	bool LoadImage(const int32 ImageIndex, TArray64<uint8>& UncompressedBytes, int32& Width, int32& Height, const FglTFRuntimeImagesConfig& ImagesConfig);
+	bool LoadTextureMips(const int32 TextureIndex, const int32 ImageIndex, TSharedRef<FJsonObject> JsonTextureObject, TArray<FglTFRuntimeMipMap>& Mips, const bool sRGB, const FglTFRuntimeMaterialsConfig& MaterialsConfig);
 	bool LoadImageFromBlob(TArray64<uint8>& Blob, TSharedRef<FJsonObject> JsonImageObject, TArray64<uint8>& UncompressedBytes, int32& Width, int32& Height, const FglTFRuntimeImagesConfig& ImagesConfig);
+	bool LoadKTX2Mips(const int32 TextureIndex, const TArray64<uint8>& Blob, TArray<FglTFRuntimeMipMap>& Mips, const FglTFRuntimeImagesConfig& ImagesConfig, const bool bAllowBlockCompressed);
+	static bool IsKTX2(const TArray64<uint8>& Blob);
 	UTexture2D* BuildTexture(UObject* Outer, const TArray<FglTFRuntimeMipMap>& Mips, const FglTFRuntimeImagesConfig& ImagesConfig, const FglTFRuntimeTextureSampler& Sampler);
+	static void CompressMips(TArray<FglTFRuntimeMipMap>& Mips, const FglTFRuntimeImagesConfig& ImagesConfig);
 
 	TArray<FString> MaterialsVariants;
 
@@ -1608,6 +1717,8 @@ public:
 	template<typename T>
 	void AddAdditionalBufferViewData(const int64 Index, const FString& Name, const T* Data, const int64 Num)
 	{
+		FScopeLock Lock(&CachesLock);
+
 		TArray64<uint8> NewArray;
 		NewArray.Append(reinterpret_cast<const uint8*>(Data), Num);
 
@@ -1682,13 +1793,36 @@ protected:
 
 	TMap<UMaterialInterface*, FString> MaterialsNameCache;
 
+	// materials built on the game thread for a mesh loading on another one, referenced until the mesh is finalized
+	TSet<UMaterialInterface*> MaterialsInFlight;
+	void ReleaseMaterialsInFlight(const FglTFRuntimeMeshLOD& LOD);
+
 	TArray<FglTFRuntimeNode> AllNodesCache;
 	bool bAllNodesCached;
 
-	TMap<TSharedRef<FJsonObject>, FglTFRuntimeMeshLOD> LODsCache;
+	TMap<TSharedRef<FJsonObject>, TUniquePtr<FglTFRuntimeMeshLOD>> LODsCache;
 
 	TArray64<uint8> BinaryBuffer;
 
+	TSharedPtr<FglTFRuntimeMappedFile> MappedFile;
+	FglTFRuntimeBlob MappedBinaryBuffer;
+	TMap<int32, TSharedPtr<FglTFRuntimeMappedFile>> MappedBuffersCache;
+	bool bMemoryMapFiles = false;
+
+	// the disk cache is disabled when empty, otherwise it is the directory for this asset content
+	FString DiskCacheDirectory;
+
+	// external files only get stat'ed on first use, as the base directory is known only after FromData()
+	mutable TOptional<uint64> DiskCacheExternalFilesHash;
+
+	static FString GetDiskCacheDirectory(const uint8* DataPtr, const int64 DataNum, const FglTFRuntimeConfig& LoaderConfig, const FglTFRuntimeMappedFile* InMappedFile);
+	uint64 GetDiskCacheExternalFilesHash() const;
+	bool LoadFromDiskCache(const FString& Category, const uint64 ItemHash, TArray<uint8>& Data) const;
+	void SaveToDiskCache(const FString& Category, const uint64 ItemHash, const TArray<uint8>& Data) const;
+	uint64 GetDiskCacheItemHash(TSharedRef<FJsonObject> JsonObject, const FString& Suffix) const;
+	static bool SerializePrimitiveAttributes(FArchive& Archive, FglTFRuntimePrimitive& Primitive);
+	static bool SerializeMips(FArchive& Archive, const int32 TextureIndex, TArray<FglTFRuntimeMipMap>& Mips);
+
 	bool LoadMeshIntoMeshLOD(TSharedRef<FJsonObject> JsonMeshObject, FglTFRuntimeMeshLOD*& LOD, const FglTFRuntimeMaterialsConfig& MaterialsConfig);
 
 	UStaticMesh* LoadStaticMesh_Internal(TSharedRef<FglTFRuntimeStaticMeshContext, ESPMode::ThreadSafe> StaticMeshContext);
@@ -1751,10 +1885,11 @@ protected:
 	void CopySkeletonRotationsFrom(FReferenceSkeleton& RefSkeleton, const FReferenceSkeleton& SrcRefSkeleton);
 	void AddSkeletonDeltaTranforms(FReferenceSkeleton& RefSkeleton, const TMap<FString, FTransform>& Transforms);
 
-	bool CanReadFromCache(const EglTFRuntimeCacheMode CacheMode) { return CacheMode == EglTFRuntimeCacheMode::Read || CacheMode == EglTFRuntimeCacheMode::ReadWrite; }
-	bool CanWriteToCache(const EglTFRuntimeCacheMode CacheMode) { return CacheMode == EglTFRuntimeCacheMode::Write || CacheMode == EglTFRuntimeCacheMode::ReadWrite; }
+	bool CanReadFromCache(const EglTFRuntimeCacheMode CacheMode) const { return CacheMode == EglTFRuntimeCacheMode::Read || CacheMode == EglTFRuntimeCacheMode::ReadWrite; }
+	bool CanWriteToCache(const EglTFRuntimeCacheMode CacheMode) const { return CacheMode == EglTFRuntimeCacheMode::Write || CacheMode == EglTFRuntimeCacheMode::ReadWrite; }
 
 	bool DecompressMeshOptimizer(const FglTFRuntimeBlob& Blob, const int64 Stride, const int64 Elements, const FString& Mode, const FString& Filter, TArray64<uint8>& UncompressedBytes);
+	bool DecompressDraco(TSharedRef<FJsonObject> JsonPrimitiveObject, TSharedRef<FJsonObject> JsonDracoObject, int64& AdditionalBufferView);
 
 	FMatrix SceneBasis;
 	float SceneScale;
@@ -1783,6 +1918,121 @@ public:
 		return FTransform(SceneBasis.Inverse() * M * SceneBasis);
 	}
 
+	template<typename SourceType, bool bNormalized>
+	static FORCEINLINE float DecodeAccessorComponent(const SourceType Value)
+	{
+		if constexpr (!bNormalized || TIsSame<SourceType, float>::Value)
+		{
+			return Value;
+		}
+		else if constexpr (TIsSame<SourceType, int8>::Value)
+		{
+			return FMath::Max(((float)Value) / 127.f, -1.f);
+		}
+		else if constexpr (TIsSame<SourceType, uint8>::Value)
+		{
+			return ((float)Value) / 255.f;
+		}
+		else if constexpr (TIsSame<SourceType, int16>::Value)
+		{
+			return FMath::Max(((float)Value) / 32767.f, -1.f);
+		}
+		else
+		{
+			return ((float)Value) / 65535.f;
+		}
+	}
+
+	// Decodes Count elements of Elements components each into Data, which must already have room for them.
+	// When both sides are tightly packed the whole accessor is converted as one flat array of components, which the compiler can vectorize,
+	// and when no conversion is needed at all it becomes a single copy.
+	template<typename T, typename ComponentType, typename SourceType, bool bNormalized>
+	static void DecodeAccessor(const uint8* Source, const int64 Stride, const int64 Elements, const int64 Count, T* Data)
+	{
+		const bool bPacked = Stride == (int64)sizeof(SourceType) * Elements && (int64)sizeof(T) == (int64)sizeof(ComponentType) * Elements;
+		if (bPacked)
+		{
+			const int64 NumComponents = Count * Elements;
+			if constexpr (TIsSame<SourceType, ComponentType>::Value && (!bNormalized || TIsSame<SourceType, float>::Value))
+			{
+				FMemory::Memcpy(Data, Source, NumComponents * sizeof(SourceType));
+			}
+			else
+			{
+				const SourceType* SourceComponents = reinterpret_cast<const SourceType*>(Source);
+				ComponentType* Components = reinterpret_cast<ComponentType*>(Data);
+				for (int64 ComponentIndex = 0; ComponentIndex < NumComponents; ComponentIndex++)
+				{
+					Components[ComponentIndex] = DecodeAccessorComponent<SourceType, bNormalized>(SourceComponents[ComponentIndex]);
+				}
+			}
+			return;
+		}
+
+		for (int64 ElementIndex = 0; ElementIndex < Count; ElementIndex++)
+		{
+			const SourceType* Ptr = reinterpret_cast<const SourceType*>(Source + ElementIndex * Stride);
+			if constexpr (TIsSame<T, ComponentType>::Value)
+			{
+				Data[ElementIndex] = DecodeAccessorComponent<SourceType, bNormalized>(*Ptr);
+			}
+			else
+			{
+				T Value;
+				for (int32 i = 0; i < Elements; i++)
+				{
+					Value[i] = DecodeAccessorComponent<SourceType, bNormalized>(Ptr[i]);
+				}
+				Data[ElementIndex] = Value;
+			}
+		}
+	}
+
+	template<typename T, typename ComponentType, typename SourceType>
+	static void DecodeAccessor(const uint8* Source, const int64 Stride, const int64 Elements, const int64 Count, const bool bNormalized, T* Data)
+	{
+		if (bNormalized)
+		{
+			DecodeAccessor<T, ComponentType, SourceType, true>(Source, Stride, Elements, Count, Data);
+		}
+		else
+		{
+			DecodeAccessor<T, ComponentType, SourceType, false>(Source, Stride, Elements, Count, Data);
+		}
+	}
+
+	template<typename T, typename ComponentType>
+	static bool DecodeAccessor(const FglTFRuntimeBlob& Blob, const int64 AccessorComponentType, const int64 Stride, const int64 Elements, const int64 Count, const bool bNormalized, T* Data)
+	{
+		switch (AccessorComponentType)
+		{
+		// FLOAT
+		case 5126:
+			DecodeAccessor<T, ComponentType, float>(Blob.Data, Stride, Elements, Count, bNormalized, Data);
+			return true;
+		// BYTE
+		case 5120:
+			DecodeAccessor<T, ComponentType, int8>(Blob.Data, Stride, Elements, Count, bNormalized, Data);
+			return true;
+		// UNSIGNED_BYTE
+		case 5121:
+			DecodeAccessor<T, ComponentType, uint8>(Blob.Data, Stride, Elements, Count, bNormalized, Data);
+			return true;
+		// SHORT
+		case 5122:
+			DecodeAccessor<T, ComponentType, int16>(Blob.Data, Stride, Elements, Count, bNormalized, Data);
+			return true;
+		// UNSIGNED_SHORT
+		case 5123:
+			DecodeAccessor<T, ComponentType, uint16>(Blob.Data, Stride, Elements, Count, bNormalized, Data);
+			return true;
+		default:
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Unsupported type %d"), AccessorComponentType);
+			return false;
+		}
+	}
+
+	// Pass nullptr as the Filter to skip the per-element filtering pass entirely
 	template<typename T, typename Callback>
 	bool BuildFromAccessorField(TSharedRef<FJsonObject> JsonObject, const FString& Name, TArray<T>& Data, const TArray<int64>& SupportedElements, const TArray<int64>& SupportedTypes, bool bNormalized, Callback Filter, const int64 AdditionalBufferView)
 	{
@@ -1795,9 +2045,12 @@ public:
 		FglTFRuntimeBlob Blob;
 		int64 ComponentType = 0, Stride = 0, Elements = 0, ElementSize = 0, Count = 0;
 		bool bOverrideNormalized = false;
-		if (!GetAccessor(AccessorIndex, ComponentType, Stride, Elements, ElementSize, Count, bOverrideNormalized, Blob, GetAdditionalBufferView(AdditionalBufferView, Name)))
 		{
-			return false;
+			FScopeLock Lock(&CachesLock);
+			if (!GetAccessor(AccessorIndex, ComponentType, Stride, Elements, ElementSize, Count, bOverrideNormalized, Blob, GetAdditionalBufferView(AdditionalBufferView, Name)))
+			{
+				return false;
+			}
 		}
 
 		if (bOverrideNormalized)
@@ -1815,64 +2068,20 @@ public:
 			return false;
 		}
 
+		const int64 Offset = Data.Num();
 		Data.AddUninitialized(Count);
-		for (int64 ElementIndex = 0; ElementIndex < Count; ElementIndex++)
+		typedef typename TDecay<decltype(DeclVal<T&>()[0])>::Type FComponentType;
+		if (!DecodeAccessor<T, FComponentType>(Blob, ComponentType, Stride, Elements, Count, bNormalized, Data.GetData() + Offset))
 		{
-			int64 Index = ElementIndex * Stride;
-			T Value;
-			// FLOAT
-			if (ComponentType == 5126)
-			{
-				float* Ptr = (float*)&(Blob.Data[Index]);
-				for (int32 i = 0; i < Elements; i++)
-				{
-					Value[i] = Ptr[i];
-				}
-			}
-			// BYTE
-			else if (ComponentType == 5120)
-			{
-				int8* Ptr = (int8*)&(Blob.Data[Index]);
-				for (int32 i = 0; i < Elements; i++)
-				{
-					Value[i] = bNormalized ? FMath::Max(((float)Ptr[i]) / 127.f, -1.f) : Ptr[i];
-				}
+			return false;
+		}
 
-			}
-			// UNSIGNED_BYTE
-			else if (ComponentType == 5121)
-			{
-				uint8* Ptr = (uint8*)&(Blob.Data[Index]);
-				for (int32 i = 0; i < Elements; i++)
-				{
-					Value[i] = bNormalized ? ((float)Ptr[i]) / 255.f : Ptr[i];
-				}
-			}
-			// SHORT
-			else if (ComponentType == 5122)
-			{
-				int16* Ptr = (int16*)&(Blob.Data[Index]);
-				for (int32 i = 0; i < Elements; i++)
-				{
-					Value[i] = bNormalized ? FMath::Max(((float)Ptr[i]) / 32767.f, -1.f) : Ptr[i];
-				}
-			}
-			// UNSIGNED_SHORT
-			else if (ComponentType == 5123)
-			{
-				uint16* Ptr = (uint16*)&(Blob.Data[Index]);
-				for (int32 i = 0; i < Elements; i++)
-				{
-					Value[i] = bNormalized ? ((float)Ptr[i]) / 65535.f : Ptr[i];
-				}
-			}
-			else
+		if constexpr (!TIsSame<Callback, TYPE_OF_NULLPTR>::Value)
+		{
+			for (int64 ElementIndex = Offset; ElementIndex < Data.Num(); ElementIndex++)
 			{
-				UE_LOG(LogGLTFRuntime, Error, TEXT("Unsupported type %d"), ComponentType);
-				return false;
+				Data[ElementIndex] = Filter(Data[ElementIndex]);
 			}
-
-			Data[ElementIndex] = Filter(Value);
 		}
 
 		return true;
@@ -1891,9 +2100,12 @@ public:
 		int64 ComponentType, Stride, Elements, ElementSize, Count;
 		bool bOverrideNormalized = false;
 
-		if (!GetAccessor(AccessorIndex, ComponentType, Stride, Elements, ElementSize, Count, bOverrideNormalized, Blob, GetAdditionalBufferView(AdditionalBufferView, Name)))
 		{
-			return false;
+			FScopeLock Lock(&CachesLock);
+			if (!GetAccessor(AccessorIndex, ComponentType, Stride, Elements, ElementSize, Count, bOverrideNormalized, Blob, GetAdditionalBufferView(AdditionalBufferView, Name)))
+			{
+				return false;
+			}
 		}
 
 		if (bOverrideNormalized)
@@ -1911,48 +2123,19 @@ public:
 			return false;
 		}
 
+		const int64 Offset = Data.Num();
 		Data.AddUninitialized(Count);
-		for (int64 ElementIndex = 0; ElementIndex < Count; ElementIndex++)
+		if (!DecodeAccessor<T, T>(Blob, ComponentType, Stride, Elements, Count, bNormalized, Data.GetData() + Offset))
 		{
-			int64 Index = ElementIndex * Stride;
-			T Value;
-			// FLOAT
-			if (ComponentType == 5126)
-			{
-				float* Ptr = (float*)&(Blob.Data[Index]);
-				Value = *Ptr;
-			}
-			// BYTE
-			else if (ComponentType == 5120)
-			{
-				int8* Ptr = (int8*)&(Blob.Data[Index]);
-				Value = bNormalized ? FMath::Max(((float)(*Ptr)) / 127.f, -1.f) : *Ptr;
-			}
-			// UNSIGNED_BYTE
-			else if (ComponentType == 5121)
-			{
-				uint8* Ptr = (uint8*)&(Blob.Data[Index]);
-				Value = bNormalized ? ((float)(*Ptr)) / 255.f : *Ptr;
-			}
-			// SHORT
-			else if (ComponentType == 5122)
-			{
-				int16* Ptr = (int16*)&(Blob.Data[Index]);
-				Value = bNormalized ? FMath::Max(((float)(*Ptr)) / 32767.f, -1.f) : *Ptr;
-			}
-			// UNSIGNED_SHORT
-			else if (ComponentType == 5123)
-			{
-				uint16* Ptr = (uint16*)&(Blob.Data[Index]);
-				Value = bNormalized ? ((float)(*Ptr)) / 65535.f : *Ptr;
-			}
-			else
+			return false;
+		}
+
+		if constexpr (!TIsSame<Callback, TYPE_OF_NULLPTR>::Value)
+		{
+			for (int64 ElementIndex = Offset; ElementIndex < Data.Num(); ElementIndex++)
 			{
-				UE_LOG(LogGLTFRuntime, Error, TEXT("Unsupported type %d"), ComponentType);
-				return false;
+				Data[ElementIndex] = Filter(Data[ElementIndex]);
 			}
-
-			Data[ElementIndex] = Filter(Value);
 		}
 
 		return true;
@@ -1961,13 +2144,13 @@ public:
 	template<typename T>
 	bool BuildFromAccessorField(TSharedRef<FJsonObject> JsonObject, const FString& Name, TArray<T>& Data, const TArray<int64>& SupportedElements, const TArray<int64>& SupportedTypes, const bool bNormalized, const int64 AdditionalBufferView)
 	{
-		return BuildFromAccessorField(JsonObject, Name, Data, SupportedElements, SupportedTypes, bNormalized, [&](T InValue) -> T {return InValue; }, AdditionalBufferView);
+		return BuildFromAccessorField(JsonObject, Name, Data, SupportedElements, SupportedTypes, bNormalized, nullptr, AdditionalBufferView);
 	}
 
 	template<typename T>
 	bool BuildFromAccessorField(TSharedRef<FJsonObject> JsonObject, const FString& Name, TArray<T>& Data, const TArray<int64>& SupportedTypes, const bool bNormalized, const int64 AdditionalBufferView)
 	{
-		return BuildFromAccessorField(JsonObject, Name, Data, SupportedTypes, bNormalized, [&](T InValue) -> T {return InValue; }, AdditionalBufferView);
+		return BuildFromAccessorField(JsonObject, Name, Data, SupportedTypes, bNormalized, nullptr, AdditionalBufferView);
 	}
 
 
@@ -2011,9 +2194,16 @@ protected:
 	FVector ComputeTangentY(const FVector Normal, const FVector TangetX);
 	FVector ComputeTangentYWithW(const FVector Normal, const FVector TangetX, const float W);
 
+	void GenerateTangentSpaces(const TArray<FglTFRuntimePrimitive>& Primitives, const EglTFRuntimeTangentSpaceGenerationMethod Method, const EglTFRuntimeNormalsGenerationStrategy NormalsGenerationStrategy, const EglTFRuntimeTangentsGenerationStrategy TangentsGenerationStrategy, const bool bReverseWinding, TArray<FglTFRuntimePrimitiveTangentSpace>& TangentSpaces);
+
 	TArray64<uint8> ZeroBuffer;
+	TArray<TArray64<uint8>> RetiredZeroBuffers;
 	TMap<int32, TArray64<uint8>> SparseAccessorsCache;
 
+	// Guards the buffer, accessor, LOD, material and error caches, so meshes can be loaded on several threads at once.
+	// It is recursive, and only held while looking things up, never while decoding attributes.
+	mutable FCriticalSection CachesLock;
+
 	TMap<int64, TMap<FString, FglTFRuntimeBlob>> AdditionalBufferViewsCache;
 	TArray<TArray64<uint8>> AdditionalBufferViewsData;
 
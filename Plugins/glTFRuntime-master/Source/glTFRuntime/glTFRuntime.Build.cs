@@ -1,5 +1,6 @@
 // Copyright 2020, Roberto De Ioris.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class glTFRuntime : ModuleRules
@@ -56,10 +57,49 @@ public class glTFRuntime : ModuleRules
         }
 
 
+        // KHR_draco_mesh_compression is decoded natively when the Draco library is available in Source/ThirdParty/draco
+        AddOptionalThirdPartyLibrary(Target, "draco", "draco", "WITH_GLTFRUNTIME_DRACO");
+        // Basis Universal KTX2 textures are transcoded when the basisu transcoder is available in Source/ThirdParty/basisu
+        AddOptionalThirdPartyLibrary(Target, "basisu", "basisu_transcoder", "WITH_GLTFRUNTIME_BASISU");
+
         DynamicallyLoadedModuleNames.AddRange(
             new string[]
             {
             }
             );
     }
+
+    // expects headers in include/ and a static library in lib/<Platform>/
+    private void AddOptionalThirdPartyLibrary(ReadOnlyTargetRules Target, string Name, string LibraryName, string Definition)
+    {
+        string LibraryPath = Path.Combine(PluginDirectory, "Source", "ThirdParty", Name);
+        string Library = null;
+        if (Target.Platform == UnrealTargetPlatform.Win64)
+        {
+            Library = Path.Combine(LibraryPath, "lib", "Win64", LibraryName + ".lib");
+        }
+        else if (Target.Platform == UnrealTargetPlatform.Linux)
+        {
+            Library = Path.Combine(LibraryPath, "lib", "Linux", "lib" + LibraryName + ".a");
+        }
+        else if (Target.Platform == UnrealTargetPlatform.Mac)
+        {
+            Library = Path.Combine(LibraryPath, "lib", "Mac", "lib" + LibraryName + ".a");
+        }
+        else if (Target.Platform == UnrealTargetPlatform.Android)
+        {
+            Library = Path.Combine(LibraryPath, "lib", "Android", "arm64-v8a", "lib" + LibraryName + ".a");
+        }
+
+        if (Library != null && File.Exists(Library))
+        {
+            PrivateIncludePaths.Add(Path.Combine(LibraryPath, "include"));
+            PublicAdditionalLibraries.Add(Library);
+            PrivateDefinitions.Add(Definition + "=1");
+        }
+        else
+        {
+            PrivateDefinitions.Add(Definition + "=0");
+        }
+    }
 }